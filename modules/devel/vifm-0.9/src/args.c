@@ -47,26 +47,29 @@ static void process_general_args(args_t *args);
 static void show_help_msg(const char wrong_arg[]);
 static void show_version_msg(void);
 static void process_non_general_args(args_t *args);
+static void eval_remote_expr(const char server[], const char expr[]);
 static void quit_on_arg_parsing(int code);
 
 /* Command line arguments definition for getopt_long(). */
 static struct option long_opts[] = {
-	{ "logging",      optional_argument, .flag = NULL, .val = 'l' },
-	{ "no-configs",   no_argument,       .flag = NULL, .val = 'n' },
-	{ "select",       required_argument, .flag = NULL, .val = 's' },
-	{ "choose-files", required_argument, .flag = NULL, .val = 'F' },
-	{ "choose-dir",   required_argument, .flag = NULL, .val = 'D' },
-	{ "delimiter",    required_argument, .flag = NULL, .val = 'd' },
-	{ "on-choose",    required_argument, .flag = NULL, .val = 'o' },
+	{ "logging",         optional_argument, .flag = NULL, .val = 'l' },
+	{ "no-configs",      no_argument,       .flag = NULL, .val = 'n' },
+	{ "select",          required_argument, .flag = NULL, .val = 's' },
+	{ "choose-files",    required_argument, .flag = NULL, .val = 'F' },
+	{ "choose-dir",      required_argument, .flag = NULL, .val = 'D' },
+	{ "delimiter",       required_argument, .flag = NULL, .val = 'd' },
+	{ "on-choose",       required_argument, .flag = NULL, .val = 'o' },
+	{ "profile-startup", required_argument, .flag = NULL, .val = 'P' },
 
 #ifdef ENABLE_REMOTE_CMDS
-	{ "server-list",  no_argument,       .flag = NULL, .val = 'L' },
-	{ "server-name",  required_argument, .flag = NULL, .val = 'N' },
-	{ "remote",       no_argument,       .flag = NULL, .val = 'r' },
+	{ "server-list",     no_argument,       .flag = NULL, .val = 'L' },
+	{ "server-name",     required_argument, .flag = NULL, .val = 'N' },
+	{ "remote",          no_argument,       .flag = NULL, .val = 'r' },
+	{ "remote-expr",     required_argument, .flag = NULL, .val = 'R' },
 #endif
 
-	{ "help",         no_argument,       .flag = NULL, .val = 'h' },
-	{ "version",      no_argument,       .flag = NULL, .val = 'v' },
+	{ "help",            no_argument,       .flag = NULL, .val = 'h' },
+	{ "version",         no_argument,       .flag = NULL, .val = 'v' },
 
 	{ }
 };
@@ -108,6 +111,9 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 			case 'r': /* --remote <args>... */
 				args->remote_cmds = argv + optind;
 				return;
+			case 'R': /* --remote-expr <expr> */
+				args->remote_expr = optarg;
+				break;
 
 			case 'h': /* -h, --help */
 				/* Only first one of -v and -h should take effect. */
@@ -137,6 +143,9 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 			case 'n': /* --no-configs */
 				args->no_configs = 1;
 				break;
+			case 'P': /* --profile-startup <path> */
+				parse_path(dir, optarg, args->startup_profile);
+				break;
 
 			case 's': /* --select <path> */
 				handle_arg_or_fail(optarg, 1, dir, args);
@@ -394,6 +403,9 @@ show_help_msg(const char wrong_arg[])
 	puts("    log path is specified and permissions allow to open it for");
 	puts("    writing, then logging of early initialization (before value of");
 	puts("    $VIFM is determined) is put there.\n");
+	puts("  vifm --profile-startup <path>");
+	puts("    write timings of startup phases, sourced commands, directory loads");
+	puts("    and redraws to the file in Chrome's trace-event format.\n");
 
 #ifdef ENABLE_REMOTE_CMDS
 	puts("  vifm --server-list");
@@ -402,6 +414,8 @@ show_help_msg(const char wrong_arg[])
 	puts("    name of target or this instance.\n");
 	puts("  vifm --remote");
 	puts("    passes all arguments that left in command line to active vifm server.\n");
+	puts("  vifm --remote-expr <expr>");
+	puts("    evaluates <expr> in active vifm server and prints its value.\n");
 #endif
 	puts("  vifm -c <command> | +<command>");
 	puts("    run <command> on startup.\n");
@@ -446,6 +460,12 @@ process_non_general_args(args_t *args)
 		return;
 	}
 
+	if(args->remote_expr != NULL)
+	{
+		eval_remote_expr(args->server_name, args->remote_expr);
+		return;
+	}
+
 	if(args->file_picker)
 	{
 		vim_get_list_file_path(args->chosen_files_out,
@@ -472,6 +492,33 @@ process_non_general_args(args_t *args)
 	}
 }
 
+/* Asks server to evaluate the expression and prints result. */
+static void
+eval_remote_expr(const char server[], const char expr[])
+{
+	char *request[] = { "expr", (char *)expr, NULL };
+	strlist_t reply = ipc_request(server, request);
+
+	if(reply.nitems == 2 && strcmp(reply.items[0], "ok") == 0)
+	{
+		puts(reply.items[1]);
+		free_string_array(reply.items, reply.nitems);
+		quit_on_arg_parsing(EXIT_SUCCESS);
+		return;
+	}
+
+	if(reply.nitems == 2 && strcmp(reply.items[0], "error") == 0)
+	{
+		fprintf(stderr, "%s\n", reply.items[1]);
+	}
+	else
+	{
+		fprintf(stderr, "%s\n", "Evaluating remote expression failed.");
+	}
+	free_string_array(reply.items, reply.nitems);
+	quit_on_arg_parsing(EXIT_FAILURE);
+}
+
 /* Quits during argument parsing when it's allowed (e.g. not for remote
  * commands). */
 static void
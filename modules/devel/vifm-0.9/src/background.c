@@ -23,25 +23,25 @@
 #include <windows.h>
 #endif
 
-#include <fcntl.h> /* open() */
+#include <fcntl.h> /* FD_CLOEXEC F_GETFL F_SETFD F_SETFL O_NONBLOCK fcntl()
+                       open() */
 #include <sys/stat.h> /* O_RDONLY */
 #include <sys/types.h> /* pid_t ssize_t */
 #ifndef _WIN32
-#include <sys/select.h> /* FD_* select */
-#include <sys/time.h> /* timeval */
 #include <sys/wait.h> /* WEXITSTATUS() waitpid() */
 #endif
-#include <signal.h> /* kill() */
-#include <unistd.h> /* select() */
+#include <signal.h> /* kill() sig_atomic_t */
+#include <unistd.h> /* pipe() read() write() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* errno */
-#include <stddef.h> /* NULL wchar_t */
-#include <stdlib.h> /* EXIT_FAILURE _Exit() free() malloc() */
-#include <string.h> /* memcpy() */
+#include <errno.h> /* EAGAIN EINTR EWOULDBLOCK errno */
+#include <stddef.h> /* NULL size_t wchar_t */
+#include <stdlib.h> /* EXIT_FAILURE _Exit() calloc() free() malloc() */
+#include <string.h> /* memset() */
 
 #include "cfg/config.h"
 #include "compat/pthread.h"
+#include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/cancellation.h"
 #include "ui/statusline.h"
@@ -50,9 +50,11 @@
 #include "utils/fs.h"
 #include "utils/log.h"
 #include "utils/path.h"
+#include "utils/selector.h"
 #include "utils/str.h"
 #include "utils/utils.h"
 #include "cmd_completion.h"
+#include "event_loop.h"
 #include "status.h"
 
 /**
@@ -72,13 +74,18 @@
  *
  * On non-Windows systems background thread reads data from error streams of
  * external applications, which are then displayed by main thread.  This thread
- * maintains its own list of jobs (via err_next field), which is added to by
- * building a temporary list with new_err_jobs pointing to its head.  Every job
- * that has associated external process has the following life cycle:
+ * waits on error streams of all jobs at once and maintains its own index of
+ * jobs by descriptors of their streams.  New jobs are passed to it via a
+ * temporary list with new_err_jobs pointing to its head, it's notified about
+ * them and about finished processes through a pipe.  Every job that has
+ * associated external process has the following life cycle:
  *  1. Created by main thread and passed to error thread through new_err_jobs.
  *  2. Either gets marked by signal handler or its stream reaches EOF.
  *  3. It's in_use flag is reset.
  *  4. Main thread frees corresponding entry.
+ *
+ * Finished processes are looked up by their ids in a hash table.  Main thread
+ * examines the list of jobs only after something has changed.
  */
 
 /* Turns pointer (P) to field (F) of a structure (S) to address of that
@@ -99,6 +106,10 @@
 #define NO_JOB_ID INVALID_HANDLE_VALUE
 #endif
 
+/* Message to error thread about availability of new jobs.  Other messages are
+ * descriptors of streams of jobs which processes have finished. */
+#define NEW_JOBS_MSG (-1)
+
 /* Structure with passed to background_task_bootstrap() so it can perform
  * correct initialization/cleanup. */
 typedef struct
@@ -109,11 +120,23 @@ typedef struct
 }
 background_task_args;
 
+static void mark_jobs_changed(void);
 static void job_check(bg_job_t *const job);
 static void job_free(bg_job_t *const job);
+static int pid_index_add(bg_job_t *job);
+static void pid_index_remove(const bg_job_t *job);
+static bg_job_t * pid_index_find(pid_t pid);
+static size_t pid_index_slot(pid_t pid);
 #ifndef _WIN32
+static int start_error_thread(void);
+static int make_notify_pipe(int fds[2]);
+static void notify_error_thread(int msg);
 static void * error_thread(void *p);
-static int update_job_list(bg_job_t **jobs, fd_set *set);
+static void process_notifications(selector_t *selector);
+static void watch_new_jobs(selector_t *selector);
+static void watch_job(selector_t *selector, bg_job_t *job);
+static void unwatch_job(selector_t *selector, bg_job_t *job);
+static int read_job_errors(bg_job_t *job);
 static void report_error_msg(const char title[], const char text[]);
 static void append_error_msg(bg_job_t *job, const char err_msg[]);
 static bg_job_t * add_background_job(pid_t pid, const char cmd[], int fd,
@@ -129,13 +152,33 @@ static int bg_op_cancel(bg_op_t *bg_op);
 
 bg_job_t *bg_jobs = NULL;
 
+/* Whether state of any job might have changed since last bg_check().  Set from
+ * other threads and signal handler. */
+static volatile sig_atomic_t jobs_changed;
+
+/* Jobs of external processes indexed by process id.  Open addressing with
+ * linear probing, size is a power of two.  Modified only with SIGCHLD blocked,
+ * so signal handler never sees it in an inconsistent state. */
+static bg_job_t **pid_index;
+/* Number of slots in pid_index. */
+static size_t pid_index_size;
+/* Number of jobs in pid_index. */
+static size_t pid_index_count;
+
 #ifndef _WIN32
 /* Head of list of newly started jobs. */
 static bg_job_t *new_err_jobs;
 /* Mutex to protect new_err_jobs. */
 static pthread_mutex_t new_err_jobs_lock = PTHREAD_MUTEX_INITIALIZER;
-/* Conditional variable to signal availability of new jobs in new_err_jobs. */
-static pthread_cond_t new_err_jobs_cond = PTHREAD_COND_INITIALIZER;
+/* Pipe for messages to error thread, 0 is read end and 1 is write end. */
+static int err_notify_pipe[2] = { -1, -1 };
+/* Whether error thread is running. */
+static int error_thread_started;
+/* Jobs which streams error thread reads indexed by descriptors of the streams.
+ * Used only by error thread. */
+static bg_job_t **err_jobs;
+/* Number of elements in err_jobs array. */
+static int err_jobs_len;
 #endif
 
 /* Thread local storage for bg_job_t associated with active thread. */
@@ -145,35 +188,129 @@ void
 bg_init(void)
 {
 #ifndef _WIN32
-	pthread_t id;
-	const int err = pthread_create(&id, NULL, &error_thread, NULL);
-	assert(err == 0);
-	(void)err;
+	/* Reinitialization (e.g., in tests) reuses thread that is already there. */
+	if(!error_thread_started)
+	{
+		error_thread_started = (start_error_thread() == 0);
+	}
+	if(!error_thread_started)
+	{
+		LOG_ERROR_MSG("Error streams of background jobs won't be read");
+	}
 #endif
 
 	/* Initialize state for the main thread. */
 	set_current_job(NULL);
 }
 
-void
-bg_process_finished_cb(pid_t pid, int exit_code)
+#ifndef _WIN32
+/* Creates notification pipe and starts error thread.  Returns zero on success
+ * and non-zero otherwise. */
+static int
+start_error_thread(void)
 {
-	bg_job_t *job;
+	pthread_t id;
+	selector_t *selector;
 
-	/* Mark any finished jobs. */
-	job = bg_jobs;
-	while(job != NULL)
+	if(make_notify_pipe(err_notify_pipe) != 0)
 	{
-		if(job->pid == pid)
+		return 1;
+	}
+
+	selector = selector_alloc(1);
+	if(selector == NULL ||
+			selector_add(selector, err_notify_pipe[0], SEL_READ) != 0 ||
+			pthread_create(&id, NULL, &error_thread, selector) != 0)
+	{
+		selector_free(selector);
+		close(err_notify_pipe[0]);
+		close(err_notify_pipe[1]);
+		err_notify_pipe[0] = -1;
+		err_notify_pipe[1] = -1;
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Creates pipe that doesn't block and isn't inherited by child processes.
+ * Returns zero on success and non-zero otherwise. */
+static int
+make_notify_pipe(int fds[2])
+{
+	int i;
+
+	if(pipe(fds) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Failed to create pipe");
+		return 1;
+	}
+
+	for(i = 0; i < 2; ++i)
+	{
+		const int flags = fcntl(fds[i], F_GETFL);
+		if(flags == -1 || fcntl(fds[i], F_SETFL, flags | O_NONBLOCK) == -1 ||
+				fcntl(fds[i], F_SETFD, FD_CLOEXEC) == -1)
 		{
-			pthread_spin_lock(&job->status_lock);
-			job->running = 0;
-			job->exit_code = exit_code;
-			pthread_spin_unlock(&job->status_lock);
-			break;
+			LOG_SERROR_MSG(errno, "Failed to setup pipe");
+			close(fds[0]);
+			close(fds[1]);
+			return 1;
 		}
-		job = job->next;
 	}
+
+	return 0;
+}
+
+/* Sends message to error thread.  Can be called from a signal handler. */
+static void
+notify_error_thread(int msg)
+{
+	/* Message of size of int is written atomically.  When the pipe is full, the
+	 * message is lost, in which case finished job is dropped only on EOF of its
+	 * stream. */
+	if(write(err_notify_pipe[1], &msg, sizeof(msg)) < 0)
+	{
+		/* Nothing can be done here, logging isn't safe in signal handler. */
+	}
+}
+#endif
+
+void
+bg_process_finished_cb(pid_t pid, int exit_code)
+{
+	int in_use;
+
+	bg_job_t *const job = pid_index_find(pid);
+	if(job == NULL)
+	{
+		return;
+	}
+
+	pthread_spin_lock(&job->status_lock);
+	job->running = 0;
+	job->exit_code = exit_code;
+	in_use = job->in_use;
+	pthread_spin_unlock(&job->status_lock);
+
+#ifndef _WIN32
+	if(in_use)
+	{
+		/* Error stream might be kept open by processes started by the job. */
+		notify_error_thread(job->fd);
+	}
+#endif
+
+	mark_jobs_changed();
+}
+
+/* Makes next bg_check() examine jobs and wakes up event loop so that it calls
+ * bg_check() soon.  Can be called from a signal handler. */
+static void
+mark_jobs_changed(void)
+{
+	jobs_changed = 1;
+	event_loop_wake();
 }
 
 void
@@ -190,11 +327,24 @@ bg_check(void)
 		return;
 	}
 
+#ifndef _WIN32
+	/* State of processes is updated by signal handler and other threads, there
+	 * is nothing to do if they haven't reported anything.  On Windows state of
+	 * processes is queried below. */
+	if(!jobs_changed)
+	{
+		return;
+	}
+#endif
+
 	if(bg_jobs_freeze() != 0)
 	{
 		return;
 	}
 
+	/* Changes made after this point will be handled on the next call. */
+	jobs_changed = 0;
+
 	head = bg_jobs;
 	bg_jobs = NULL;
 
@@ -226,6 +376,7 @@ bg_check(void)
 				ui_stat_job_bar_remove(&j->bg_op);
 			}
 
+			pid_index_remove(j);
 			job_free(j);
 		}
 		else
@@ -313,6 +464,136 @@ job_free(bg_job_t *const job)
 	free(job);
 }
 
+/* Adds job of external process to index by process id.  Must be called with
+ * SIGCHLD blocked.  Returns zero on success and non-zero otherwise. */
+static int
+pid_index_add(bg_job_t *job)
+{
+	size_t slot;
+
+	/* Keep load factor below one half. */
+	if((pid_index_count + 1U)*2U > pid_index_size)
+	{
+		const size_t old_size = pid_index_size;
+		bg_job_t **const old_index = pid_index;
+		size_t i;
+
+		const size_t new_size = (old_size == 0U) ? 64U : old_size*2U;
+		bg_job_t **const new_index = calloc(new_size, sizeof(*new_index));
+		if(new_index == NULL)
+		{
+			return 1;
+		}
+
+		pid_index = new_index;
+		pid_index_size = new_size;
+		for(i = 0U; i < old_size; ++i)
+		{
+			if(old_index[i] != NULL)
+			{
+				slot = pid_index_slot(old_index[i]->pid);
+				while(pid_index[slot] != NULL)
+				{
+					slot = (slot + 1U) & (pid_index_size - 1U);
+				}
+				pid_index[slot] = old_index[i];
+			}
+		}
+		free(old_index);
+	}
+
+	slot = pid_index_slot(job->pid);
+	while(pid_index[slot] != NULL)
+	{
+		slot = (slot + 1U) & (pid_index_size - 1U);
+	}
+	pid_index[slot] = job;
+	++pid_index_count;
+	return 0;
+}
+
+/* Removes job from index by process id if it's there.  Must be called with
+ * SIGCHLD blocked. */
+static void
+pid_index_remove(const bg_job_t *job)
+{
+	size_t slot, next;
+
+	if(pid_index_size == 0U)
+	{
+		return;
+	}
+
+	slot = pid_index_slot(job->pid);
+	while(pid_index[slot] != job)
+	{
+		if(pid_index[slot] == NULL)
+		{
+			return;
+		}
+		slot = (slot + 1U) & (pid_index_size - 1U);
+	}
+
+	/* Shift following entries of the cluster back instead of leaving a mark of
+	 * deleted entry. */
+	next = slot;
+	while(1)
+	{
+		size_t home;
+
+		next = (next + 1U) & (pid_index_size - 1U);
+		if(pid_index[next] == NULL)
+		{
+			break;
+		}
+
+		/* Entry can be moved to the free slot if its home slot isn't in the range
+		 * (slot; next] taking wrap around into account. */
+		home = pid_index_slot(pid_index[next]->pid);
+		if(((next - home) & (pid_index_size - 1U)) >=
+				((next - slot) & (pid_index_size - 1U)))
+		{
+			pid_index[slot] = pid_index[next];
+			slot = next;
+		}
+	}
+
+	pid_index[slot] = NULL;
+	--pid_index_count;
+}
+
+/* Looks up job of external process by its id.  Can be called from a signal
+ * handler.  Returns the job or NULL if there is no such job. */
+static bg_job_t *
+pid_index_find(pid_t pid)
+{
+	size_t slot;
+
+	if(pid_index_size == 0U)
+	{
+		return NULL;
+	}
+
+	slot = pid_index_slot(pid);
+	while(pid_index[slot] != NULL)
+	{
+		if(pid_index[slot]->pid == pid)
+		{
+			return pid_index[slot];
+		}
+		slot = (slot + 1U) & (pid_index_size - 1U);
+	}
+	return NULL;
+}
+
+/* Computes home slot of process id in the index.  Returns the slot. */
+static size_t
+pid_index_slot(pid_t pid)
+{
+	/* Multiplicative hashing spreads sequential ids. */
+	return ((unsigned int)pid*2654435761U) & (pid_index_size - 1U);
+}
+
 /* Used for FUSE mounting and unmounting only. */
 int
 bg_and_wait_for_status(char cmd[],
@@ -456,100 +737,86 @@ bg_and_wait_for_errors(char cmd[], const struct cancellation_t *cancellation)
 
 #ifndef _WIN32
 /* Entry point of a thread which reads input from input of active background
- * programs.  Does not return. */
+ * programs.  p is selector to use.  Does not return. */
 static void *
 error_thread(void *p)
 {
-	bg_job_t *jobs = NULL;
+	selector_t *const selector = p;
 
 	(void)pthread_detach(pthread_self());
 	block_all_thread_signals();
 
 	while(1)
 	{
-		fd_set active, ready;
-		const int max_fd = update_job_list(&jobs, &active);
-		struct timeval timeout = { .tv_sec = 0, .tv_usec = 250*1000 }, ts = timeout;
+		int pos;
+		int fd;
 
-		while(select(max_fd + 1, memcpy(&ready, &active, sizeof(active)), NULL,
-					NULL, &ts) > 0)
+		if(!selector_wait(selector, -1))
 		{
-			int need_update_list = (jobs == NULL);
+			continue;
+		}
 
-			bg_job_t **job = &jobs;
-			while(*job != NULL)
+		/* Only streams that have something to report are visited. */
+		pos = 0;
+		while((fd = selector_next_ready(selector, &pos)) != -1)
+		{
+			if(fd == err_notify_pipe[0])
 			{
-				bg_job_t *const j = *job;
-				char err_msg[ERR_MSG_LEN];
-				ssize_t nread;
-
-				if(!FD_ISSET(j->fd, &ready))
-				{
-					goto next_job;
-				}
-
-				nread = read(j->fd, err_msg, sizeof(err_msg) - 1U);
-				if(nread < 0)
-				{
-					need_update_list = 1;
-					goto next_job;
-				}
+				process_notifications(selector);
+				continue;
+			}
 
-				if(nread == 0)
+			/* The job might have been dropped while processing notifications. */
+			if(fd < err_jobs_len && err_jobs[fd] != NULL)
+			{
+				if(read_job_errors(err_jobs[fd]) != 0)
 				{
-					/* Reached EOF, cut this job out of our list and allow its
-					 * deletion. */
-					pthread_spin_lock(&j->status_lock);
-					j->in_use = 0;
-					*job = j->err_next;
-					pthread_spin_unlock(&j->status_lock);
-					continue;
+					unwatch_job(selector, err_jobs[fd]);
 				}
-
-				err_msg[nread] = '\0';
-				append_error_msg(j, err_msg);
-
-			next_job:
-				job = &j->err_next;
 			}
+		}
+	}
+	return NULL;
+}
 
-			if(!need_update_list)
-			{
-				pthread_mutex_lock(&new_err_jobs_lock);
-				need_update_list = (new_err_jobs != NULL);
-				pthread_mutex_unlock(&new_err_jobs_lock);
-			}
-			if(need_update_list)
-			{
-				break;
-			}
+/* Handles all messages available in notification pipe. */
+static void
+process_notifications(selector_t *selector)
+{
+	int msg;
+	while(read(err_notify_pipe[0], &msg, sizeof(msg)) == sizeof(msg))
+	{
+		bg_job_t *job;
+
+		if(msg == NEW_JOBS_MSG)
+		{
+			watch_new_jobs(selector);
+			continue;
+		}
 
-			ts = timeout;
+		/* Descriptor might have been reused by a job started later, so checking
+		 * that the job has actually finished. */
+		job = (msg >= 0 && msg < err_jobs_len) ? err_jobs[msg] : NULL;
+		if(job != NULL && !bg_job_is_running(job))
+		{
+			/* Collect what's left in the pipe, but don't wait for EOF. */
+			(void)read_job_errors(job);
+			unwatch_job(selector, job);
 		}
 	}
-	return NULL;
 }
 
-/* Updates *jobs by removing finished tasks and adding new ones.  Initializes
- * *set in the process.  Returns max file descriptor number of the set. */
-static int
-update_job_list(bg_job_t **jobs, fd_set *set)
+/* Starts reading error streams of jobs from new_err_jobs list. */
+static void
+watch_new_jobs(selector_t *selector)
 {
-	int max_fd;
 	bg_job_t *new_jobs;
-	bg_job_t **job;
 
-	/* Add new tasks to internal list, wait if there are no jobs. */
 	pthread_mutex_lock(&new_err_jobs_lock);
-	while(*jobs == NULL && new_err_jobs == NULL)
-	{
-		pthread_cond_wait(&new_err_jobs_cond, &new_err_jobs_lock);
-	}
 	new_jobs = new_err_jobs;
 	new_err_jobs = NULL;
 	pthread_mutex_unlock(&new_err_jobs_lock);
 
-	/* Prepend new jobs to the list. */
 	while(new_jobs != NULL)
 	{
 		bg_job_t *const new_job = new_jobs;
@@ -558,39 +825,93 @@ update_job_list(bg_job_t **jobs, fd_set *set)
 		assert(new_job->type == BJT_COMMAND &&
 				"Only external commands should be here.");
 
-		new_job->err_next = *jobs;
-		*jobs = new_job;
+		watch_job(selector, new_job);
 	}
+}
 
-	FD_ZERO(set);
+/* Starts reading error stream of the job.  On failure the job is released. */
+static void
+watch_job(selector_t *selector, bg_job_t *job)
+{
+	const int fd = job->fd;
+	const int flags = fcntl(fd, F_GETFL);
 
-	max_fd = 0;
-	job = jobs;
-	while(*job != NULL)
+	if(fd >= err_jobs_len)
 	{
-		bg_job_t *const j = *job;
-
-		pthread_spin_lock(&j->status_lock);
-		/* If finished, reset in_use mark and drop it from the list. */
-		if(!j->running)
+		const int len = (fd < 32) ? 64 : fd*2;
+		bg_job_t **const p = reallocarray(err_jobs, len, sizeof(*p));
+		if(p == NULL)
 		{
-			j->in_use = 0;
-			*job = j->err_next;
-			pthread_spin_unlock(&j->status_lock);
-			continue;
+			unwatch_job(selector, job);
+			return;
 		}
-		pthread_spin_unlock(&j->status_lock);
+		memset(p + err_jobs_len, 0, sizeof(*p)*(len - err_jobs_len));
+		err_jobs = p;
+		err_jobs_len = len;
+	}
+
+	/* Stream is read only when it's ready, but readiness might be reported for
+	 * a descriptor that was closed and reused since then. */
+	if(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1 ||
+			selector_add(selector, fd, SEL_READ) != 0)
+	{
+		unwatch_job(selector, job);
+		return;
+	}
+
+	err_jobs[fd] = job;
+
+	/* Process could have finished before the job got here, in which case
+	 * notification about it was ignored. */
+	if(!bg_job_is_running(job))
+	{
+		(void)read_job_errors(job);
+		unwatch_job(selector, job);
+	}
+}
+
+/* Stops reading error stream of the job and allows its deletion. */
+static void
+unwatch_job(selector_t *selector, bg_job_t *job)
+{
+	selector_remove(selector, job->fd);
+	if(job->fd < err_jobs_len)
+	{
+		err_jobs[job->fd] = NULL;
+	}
+
+	pthread_spin_lock(&job->status_lock);
+	job->in_use = 0;
+	pthread_spin_unlock(&job->status_lock);
 
-		FD_SET(j->fd, set);
-		if(j->fd > max_fd)
+	mark_jobs_changed();
+}
+
+/* Reads data available in error stream of the job.  Returns non-zero if the
+ * stream reached EOF or failed, otherwise zero is returned. */
+static int
+read_job_errors(bg_job_t *job)
+{
+	while(1)
+	{
+		char err_msg[ERR_MSG_LEN];
+		const ssize_t nread = read(job->fd, err_msg, sizeof(err_msg) - 1U);
+		if(nread == 0)
 		{
-			max_fd = j->fd;
+			return 1;
+		}
+		if(nread < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return (errno != EAGAIN && errno != EWOULDBLOCK);
 		}
 
-		job = &j->err_next;
+		err_msg[nread] = '\0';
+		append_error_msg(job, err_msg);
 	}
-
-	return max_fd;
 }
 
 /* Either displays error message to the user for foreground operations or saves
@@ -619,6 +940,8 @@ append_error_msg(bg_job_t *job, const char err_msg[])
 	(void)strappend(&job->errors, &job->errors_len, err_msg);
 	(void)strappend(&job->new_errors, &job->new_errors_len, err_msg);
 	pthread_spin_unlock(&job->errors_lock);
+
+	mark_jobs_changed();
 }
 
 pid_t
@@ -818,8 +1141,15 @@ bg_run_external(const char cmd[], int skip_errors)
 		return -1;
 	}
 
+	/* Process must be in the list of jobs by the time SIGCHLD for it is
+	 * handled. */
+	(void)bg_jobs_freeze();
+
 	if((pid = fork()) == -1)
 	{
+		bg_jobs_unfreeze();
+		close(error_pipe[0]);
+		close(error_pipe[1]);
 		free(command);
 		return -1;
 	}
@@ -829,6 +1159,10 @@ bg_run_external(const char cmd[], int skip_errors)
 		extern char **environ;
 
 		int nullfd;
+
+		/* Signal mask is inherited by programs, don't leave SIGCHLD blocked. */
+		(void)set_sigchld(0);
+
 		/* Redirect stderr to write end of pipe. */
 		if(dup2(error_pipe[1], STDERR_FILENO) == -1)
 		{
@@ -868,6 +1202,7 @@ bg_run_external(const char cmd[], int skip_errors)
 		close(error_pipe[1]);
 
 		job = add_background_job(pid, command, error_pipe[0], BJT_COMMAND);
+		bg_jobs_unfreeze();
 		if(job == NULL)
 		{
 			free(command);
@@ -938,8 +1273,10 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 
 	task_args->func = task_func;
 	task_args->args = args;
+	(void)bg_jobs_freeze();
 	task_args->job = add_background_job(WRONG_PID, descr, NO_JOB_ID,
 			important ? BJT_OPERATION : BJT_TASK);
+	bg_jobs_unfreeze();
 
 	if(task_args->job == NULL)
 	{
@@ -963,6 +1300,7 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 		task_args->job->running = 0;
 		task_args->job->exit_code = 1;
 		pthread_spin_unlock(&task_args->job->status_lock);
+		mark_jobs_changed();
 
 		free(task_args);
 		ret = 1;
@@ -972,7 +1310,7 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 }
 
 /* Creates structure that describes background job and registers it in the list
- * of jobs. */
+ * of jobs.  SIGCHLD must be blocked by the caller. */
 #ifndef _WIN32
 static bg_job_t *
 add_background_job(pid_t pid, const char cmd[], int fd, BgJobType type)
@@ -989,6 +1327,12 @@ add_background_job(pid_t pid, const char cmd[], HANDLE hprocess, BgJobType type)
 	}
 	new->type = type;
 	new->pid = pid;
+	if(type == BJT_COMMAND && pid_index_add(new) != 0)
+	{
+		free(new);
+		show_error_msg("Memory error", "Unable to allocate enough memory");
+		return NULL;
+	}
 	new->cmd = strdup(cmd);
 	new->next = bg_jobs;
 	new->skip_errors = 0;
@@ -1001,20 +1345,23 @@ add_background_job(pid_t pid, const char cmd[], HANDLE hprocess, BgJobType type)
 	pthread_spin_init(&new->errors_lock, PTHREAD_PROCESS_PRIVATE);
 	pthread_spin_init(&new->status_lock, PTHREAD_PROCESS_PRIVATE);
 	new->running = 1;
-	new->in_use = (type == BJT_COMMAND);
 	new->exit_code = -1;
 
 #ifndef _WIN32
+	/* Without error thread nothing reads the stream and job can be removed as
+	 * soon as its process is finished. */
+	new->in_use = (type == BJT_COMMAND && error_thread_started && fd != -1);
 	new->fd = fd;
-	if(fd != -1)
+	if(new->in_use)
 	{
 		pthread_mutex_lock(&new_err_jobs_lock);
 		new->err_next = new_err_jobs;
 		new_err_jobs = new;
 		pthread_mutex_unlock(&new_err_jobs_lock);
-		pthread_cond_signal(&new_err_jobs_cond);
+		notify_error_thread(NEW_JOBS_MSG);
 	}
 #else
+	new->in_use = 0;
 	new->hprocess = hprocess;
 #endif
 
@@ -1051,6 +1398,7 @@ background_task_bootstrap(void *arg)
 	task_args->job->running = 0;
 	task_args->job->exit_code = 0;
 	pthread_spin_unlock(&task_args->job->status_lock);
+	mark_jobs_changed();
 
 	free(task_args);
 
@@ -53,6 +53,7 @@
 #include "../utils/macros.h"
 #include "../utils/str.h"
 #include "../utils/path.h"
+#include "../utils/trace.h"
 #include "../utils/utils.h"
 #include "../cmd_core.h"
 #include "../filelist.h"
@@ -737,6 +738,7 @@ source_file_internal(FILE *fp, const char filename[])
 	}
 	chomp(line);
 
+	trace_begin("source_file", filename);
 	commands_scope_start();
 
 	line_num = 1;
@@ -756,11 +758,18 @@ source_file_internal(FILE *fp, const char filename[])
 			else
 				break;
 		}
+		if(trace_is_active())
+		{
+			char *const location = format_str("%s:%d: %s", filename, line_num, line);
+			trace_begin("source_line", location);
+			free(location);
+		}
 		if(exec_commands(line, curr_view, CIT_COMMAND) < 0)
 		{
 			show_sourcing_error(filename, line_num);
 			encoutered_errors = 1;
 		}
+		trace_end();
 		if(curr_stats.sourcing_state == SOURCING_FINISHING)
 			break;
 
@@ -783,6 +792,7 @@ source_file_internal(FILE *fp, const char filename[])
 		show_sourcing_error(filename, line_num);
 		encoutered_errors = 1;
 	}
+	trace_end();
 
 	return encoutered_errors;
 }
@@ -20,20 +20,48 @@
 
 #include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* calloc() free() */
-#include <string.h> /* memmove() */
+#include <string.h> /* memmove() strcmp() strdup() */
 
 #include "../utils/macros.h"
+#include "../utils/str.h"
 #include "../utils/string_array.h"
 
 #define NO_POS (-1)
 
-static int move_to_first_position(hist_t *hist, const char item[]);
+/* Initial number of slots of an index. */
+#define MIN_INDEX_CAPACITY 16U
+
+/* Slot of an index. */
+typedef struct
+{
+	char *item;  /* Item of the history (not a copy) or NULL for empty slot. */
+	size_t hash; /* Hash of the item. */
+}
+slot_t;
+
+/* Hash table of items with open addressing and linear probing.  Stores
+ * pointers to strings rather than their positions, so that reordering or
+ * reallocation of list of items doesn't affect it. */
+struct hist_index_t
+{
+	size_t capacity; /* Number of slots (power of two). */
+	size_t count;    /* Number of occupied slots. */
+	slot_t slots[];  /* The table. */
+};
+
+static int move_to_first_position(hist_t *hist, char item[]);
 static int insert_at_first_position(hist_t *hist, size_t size, const char item[]);
+static char * index_find(const hist_t *hist, const char item[]);
+static int index_add(hist_t *hist, char item[]);
+static void index_remove(hist_t *hist, const char item[]);
+static int index_grow(hist_t *hist);
 
 int
 hist_init(hist_t *hist, size_t size)
 {
 	hist->pos = NO_POS;
+	hist->unsaved = 0;
+	hist->index = NULL;
 	hist->items = calloc(size, sizeof(char *));
 	return hist->items == NULL;
 }
@@ -44,6 +72,9 @@ hist_reset(hist_t *hist, size_t size)
 	free_string_array(hist->items, size);
 	hist->items = NULL;
 	hist->pos = NO_POS;
+	hist->unsaved = 0;
+	free(hist->index);
+	hist->index = NULL;
 }
 
 int
@@ -55,8 +86,15 @@ hist_is_empty(const hist_t *hist)
 void
 hist_trunc(hist_t *hist, size_t new_size, size_t removed_count)
 {
+	int i;
+	for(i = new_size; i <= hist->pos; ++i)
+	{
+		index_remove(hist, hist->items[i]);
+	}
+
 	free_strings(hist->items + new_size, removed_count);
 	hist->pos = MIN(hist->pos, (int)new_size - 1);
+	hist->unsaved = MIN(hist->unsaved, hist->pos + 1);
 }
 
 int
@@ -66,7 +104,7 @@ hist_contains(const hist_t *hist, const char item[])
 	{
 		return 0;
 	}
-	return is_in_string_array(hist->items, hist->pos + 1, item);
+	return index_find(hist, item) != NULL;
 }
 
 int
@@ -74,32 +112,44 @@ hist_add(hist_t *hist, const char item[], size_t size)
 {
 	if(size > 0 && item[0] != '\0')
 	{
-		if(move_to_first_position(hist, item) != 0)
+		char *const existing = hist_is_empty(hist) ? NULL : index_find(hist, item);
+		if(existing != NULL)
 		{
-			return insert_at_first_position(hist, size, item);
+			return move_to_first_position(hist, existing);
 		}
+		return insert_at_first_position(hist, size, item);
 	}
 	return 0;
 }
 
-/* Moves item to the first position.  Returns zero on success or non-zero when
- * item wasn't found in the history. */
+void
+hist_mark_saved(hist_t *hist)
+{
+	hist->unsaved = 0;
+}
+
+/* Moves item, which is a pointer to one of elements of the history, to the
+ * first position.  Returns zero. */
 static int
-move_to_first_position(hist_t *hist, const char item[])
+move_to_first_position(hist_t *hist, char item[])
 {
-	const int pos = string_array_pos(hist->items, hist->pos + 1, item);
-	if(pos == 0)
+	/* Comparing pointers is much cheaper than comparing strings. */
+	int pos = 0;
+	while(hist->items[pos] != item)
 	{
-		return 0;
+		++pos;
 	}
-	else if(pos > 0)
+
+	if(pos > 0)
 	{
-		char *const item = hist->items[pos];
 		memmove(hist->items + 1, hist->items, sizeof(char *)*pos);
 		hist->items[0] = item;
-		return 0;
+		if(pos >= hist->unsaved)
+		{
+			++hist->unsaved;
+		}
 	}
-	return 1;
+	return 0;
 }
 
 /* Inserts item at the first position.  Returns zero on success or non-zero on
@@ -113,15 +163,147 @@ insert_at_first_position(hist_t *hist, size_t size, const char item[])
 		return 1;
 	}
 
-	hist->pos = MIN(hist->pos + 1, (int)size - 1);
-	if(hist->pos > 0)
+	if(index_add(hist, item_copy) != 0)
 	{
+		free(item_copy);
+		return 1;
+	}
+
+	/* Drop the oldest item if there is no space left. */
+	if(hist->pos + 1 >= (int)size)
+	{
+		hist->pos = (int)size - 1;
+		index_remove(hist, hist->items[hist->pos]);
 		free(hist->items[hist->pos]);
-		memmove(hist->items + 1, hist->items, sizeof(char *)*hist->pos);
-		hist->items[0] = NULL;
+		--hist->pos;
 	}
 
+	++hist->pos;
+	memmove(hist->items + 1, hist->items, sizeof(char *)*hist->pos);
 	hist->items[0] = item_copy;
+	hist->unsaved = MIN(hist->unsaved + 1, hist->pos + 1);
+	return 0;
+}
+
+/* Looks up item in the index.  Returns pointer to the item of the history or
+ * NULL if there is no such item. */
+static char *
+index_find(const hist_t *hist, const char item[])
+{
+	size_t i;
+	const hist_index_t *const index = hist->index;
+	const size_t hash = hash_str(item);
+
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = hash & (index->capacity - 1U); index->slots[i].item != NULL;
+			i = (i + 1U) & (index->capacity - 1U))
+	{
+		if(index->slots[i].hash == hash && strcmp(index->slots[i].item, item) == 0)
+		{
+			return index->slots[i].item;
+		}
+	}
+	return NULL;
+}
+
+/* Adds item that's not in the index yet to it.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+index_add(hist_t *hist, char item[])
+{
+	size_t i;
+	hist_index_t *index;
+	const size_t hash = hash_str(item);
+
+	/* Keep load factor at or below one half. */
+	if((hist->index == NULL || (hist->index->count + 1U)*2U >
+				hist->index->capacity) && index_grow(hist) != 0)
+	{
+		return 1;
+	}
+
+	index = hist->index;
+	i = hash & (index->capacity - 1U);
+	while(index->slots[i].item != NULL)
+	{
+		i = (i + 1U) & (index->capacity - 1U);
+	}
+
+	index->slots[i].item = item;
+	index->slots[i].hash = hash;
+	++index->count;
+	return 0;
+}
+
+/* Removes item from the index shifting following items of the same cluster
+ * back to where they would be without it. */
+static void
+index_remove(hist_t *hist, const char item[])
+{
+	size_t i, j;
+	hist_index_t *const index = hist->index;
+	const size_t mask = index->capacity - 1U;
+
+	i = hash_str(item) & mask;
+	while(index->slots[i].item != item)
+	{
+		i = (i + 1U) & mask;
+	}
+
+	for(j = (i + 1U) & mask; index->slots[j].item != NULL; j = (j + 1U) & mask)
+	{
+		/* Item can be moved back only if its home slot isn't in (i; j]. */
+		const size_t home = index->slots[j].hash & mask;
+		if(((j - home) & mask) >= ((j - i) & mask))
+		{
+			index->slots[i] = index->slots[j];
+			i = j;
+		}
+	}
+
+	index->slots[i].item = NULL;
+	--index->count;
+}
+
+/* Doubles number of slots of the index (or allocates it) redistributing items
+ * among them.  Returns zero on success, otherwise non-zero is returned. */
+static int
+index_grow(hist_t *hist)
+{
+	size_t i;
+	hist_index_t *const old = hist->index;
+	const size_t capacity = (old == NULL) ? MIN_INDEX_CAPACITY : old->capacity*2U;
+
+	hist_index_t *const index = calloc(1U,
+			sizeof(*index) + capacity*sizeof(index->slots[0]));
+	if(index == NULL)
+	{
+		return 1;
+	}
+	index->capacity = capacity;
+
+	hist->index = index;
+	if(old != NULL)
+	{
+		for(i = 0U; i < old->capacity; ++i)
+		{
+			if(old->slots[i].item != NULL)
+			{
+				size_t j = old->slots[i].hash & (capacity - 1U);
+				while(index->slots[j].item != NULL)
+				{
+					j = (j + 1U) & (capacity - 1U);
+				}
+				index->slots[j] = old->slots[i];
+			}
+		}
+		index->count = old->count;
+		free(old);
+	}
 	return 0;
 }
 
@@ -21,6 +21,9 @@
 
 #include <stddef.h> /* size_t */
 
+/* Opaque declaration of hash index of history items. */
+typedef struct hist_index_t hist_index_t;
+
 /* History object structure.  Doesn't store its length. */
 typedef struct
 {
@@ -29,6 +32,11 @@ typedef struct
 	/* Position of the last item in the items list.  Undefined (likely to be
 	 * negative) for empty lists. */
 	int pos;
+	/* Number of items at the front of the list that were added or moved there
+	 * since the last call of hist_mark_saved(). */
+	int unsaved;
+	/* Index of items for lookups by value.  Can be NULL for empty list. */
+	hist_index_t *index;
 }
 hist_t;
 
@@ -58,6 +66,10 @@ int hist_contains(const hist_t *hist, const char item[]);
  * when item is added/moved or rejected, on failure non-zero is returned. */
 int hist_add(hist_t *hist, const char item[], size_t size);
 
+/* Marks all items of the history as saved, so that only items added after this
+ * call are counted as unsaved. */
+void hist_mark_saved(hist_t *hist);
+
 #endif /* VIFM__CFG__HISTORY_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -60,6 +60,12 @@
 #include "hist.h"
 #include "info_chars.h"
 
+/* First line of a valid history journal, which also specifies its version. */
+#define JOURNAL_HEADER "# vifminfo history journal, version 1"
+
+/* Number of histories that are stored in the journal. */
+#define JOURNALED_HISTORIES 4
+
 static void get_sort_info(FileView *view, const char line[]);
 static void append_to_history(hist_t *hist, void (*saver)(const char[]),
 		const char item[]);
@@ -67,9 +73,19 @@ static void ensure_history_not_full(hist_t *hist);
 static void get_history(FileView *view, int reread, const char dir[],
 		const char file[], int rel_pos);
 static void set_view_property(FileView *view, char type, const char value[]);
+static void read_journal(int replay);
+static void mark_histories_saved(void);
 static int copy_file(const char src[], const char dst[]);
 static int copy_file_internal(FILE *const src, FILE *const dst);
-static void update_info_file(const char filename[], int merge);
+static void update_info_file(const char filename[], int merge,
+		int journaled);
+static int write_journal(void);
+static int is_valid_journal(const char path[]);
+static int rewrite_journal(const char path[]);
+static int append_to_journal(const char path[], int changed);
+static int write_journal_items(FILE *fp, int unsaved_only);
+static int write_journal_hist(FILE *fp, const hist_t *hist, char mark,
+		int flag, int unsaved_only);
 static void process_hist_entry(FileView *view, const char dir[],
 		const char file[], int pos, char ***lh, int *nlh, int **lhp, size_t *nlhp);
 static char * convert_old_trash_path(const char trash_path[]);
@@ -106,6 +122,16 @@ static size_t add_to_int_array(int **array, size_t len, int what);
 /* Monitor to check for changes of vifminfo file. */
 static filemon_t vifminfo_mon;
 
+/* Monitor to check for changes of history journal by other instances. */
+static filemon_t journal_mon;
+
+/* Number of items in history journal as of its last read or write. */
+static int journal_len;
+
+/* Whether contents of history journal wasn't loaded and must not be appended
+ * to. */
+static int journal_stale;
+
 void
 read_info_file(int reread)
 {
@@ -114,11 +140,15 @@ read_info_file(int reread)
 	FILE *fp;
 	char info_file[PATH_MAX + 16];
 	char *line = NULL, *line2 = NULL, *line3 = NULL, *line4 = NULL;
+	int journaled = 0;
 
 	snprintf(info_file, sizeof(info_file), "%s/vifminfo", cfg.config_dir);
 
 	if((fp = os_fopen(info_file, "r")) == NULL)
+	{
+		read_journal(0);
 		return;
+	}
 
 	(void)filemon_from_file(info_file, &vifminfo_mon);
 
@@ -296,6 +326,10 @@ read_info_file(int reread)
 		{
 			append_to_history(&cfg.filter_hist, cfg_save_filter_history, line_val);
 		}
+		else if(type == LINE_TYPE_HIST_JOURNAL)
+		{
+			journaled = 1;
+		}
 		else if(type == LINE_TYPE_DIR_STACK)
 		{
 			if((line2 = read_vifminfo_line(fp, line2)) != NULL)
@@ -365,6 +399,8 @@ read_info_file(int reread)
 	free(line4);
 	fclose(fp);
 
+	read_journal(journaled);
+
 	dir_stack_freeze();
 }
 
@@ -446,6 +482,76 @@ get_history(FileView *view, int reread, const char dir[], const char file[],
 	}
 }
 
+/* Loads history items appended to the journal on top of those read from
+ * vifminfo file.  The replay flag specifies whether vifminfo says that
+ * histories were journaled, otherwise the journal is outdated (it's left
+ * behind when journaling is turned off) and is ignored. */
+static void
+read_journal(int replay)
+{
+	FILE *fp;
+	char journal_file[PATH_MAX + 32];
+	char *line = NULL;
+
+	snprintf(journal_file, sizeof(journal_file), "%s/vifminfo.journal",
+			cfg.config_dir);
+
+	journal_len = 0;
+	journal_stale = !replay;
+
+	if(replay && (fp = os_fopen(journal_file, "r")) != NULL)
+	{
+		line = read_vifminfo_line(fp, line);
+		if(line != NULL && strcmp(line, JOURNAL_HEADER) == 0)
+		{
+			(void)filemon_from_file(journal_file, &journal_mon);
+
+			while((line = read_vifminfo_line(fp, line)) != NULL)
+			{
+				const char *const line_val = line + 1;
+				switch(line[0])
+				{
+					case LINE_TYPE_CMDLINE_HIST:
+						append_to_history(&cfg.cmd_hist, cfg_save_command_history,
+								line_val);
+						break;
+					case LINE_TYPE_SEARCH_HIST:
+						append_to_history(&cfg.search_hist, cfg_save_search_history,
+								line_val);
+						break;
+					case LINE_TYPE_PROMPT_HIST:
+						append_to_history(&cfg.prompt_hist, cfg_save_prompt_history,
+								line_val);
+						break;
+					case LINE_TYPE_FILTER_HIST:
+						append_to_history(&cfg.filter_hist, cfg_save_filter_history,
+								line_val);
+						break;
+
+					default:
+						continue;
+				}
+				++journal_len;
+			}
+		}
+		free(line);
+		fclose(fp);
+	}
+
+	/* Loaded items are already stored either in vifminfo or in the journal. */
+	mark_histories_saved();
+}
+
+/* Resets unsaved state of all histories that can be journaled. */
+static void
+mark_histories_saved(void)
+{
+	hist_mark_saved(&cfg.cmd_hist);
+	hist_mark_saved(&cfg.search_hist);
+	hist_mark_saved(&cfg.prompt_hist);
+	hist_mark_saved(&cfg.filter_hist);
+}
+
 /* Sets view property specified by the type to the value. */
 static void
 set_view_property(FileView *view, char type, const char value[])
@@ -474,6 +580,10 @@ write_info_file(void)
 	char info_file[PATH_MAX + 16];
 	char tmp_file[PATH_MAX + 16];
 
+	/* Histories are stored in vifminfo if they can't be stored in the
+	 * journal. */
+	const int journaled = (write_journal() == 0);
+
 	(void)snprintf(info_file, sizeof(info_file), "%s/vifminfo", cfg.config_dir);
 	(void)snprintf(tmp_file, sizeof(tmp_file), "%s_%u", info_file, get_pid());
 
@@ -485,7 +595,7 @@ write_info_file(void)
 		vifminfo_changed = filemon_from_file(info_file, &current_vifminfo_mon) != 0
 		                || !filemon_equal(&vifminfo_mon, &current_vifminfo_mon);
 
-		update_info_file(tmp_file, vifminfo_changed);
+		update_info_file(tmp_file, vifminfo_changed, journaled);
 		(void)filemon_from_file(tmp_file, &vifminfo_mon);
 
 		if(rename_file(tmp_file, info_file) != 0)
@@ -548,9 +658,10 @@ copy_file_internal(FILE *const src, FILE *const dst)
 }
 
 /* Reads contents of the filename file as an info file and updates it with the
- * state of current instance. */
+ * state of current instance.  Histories that can be journaled are omitted if
+ * journaled flag is set. */
 static void
-update_info_file(const char filename[], int merge)
+update_info_file(const char filename[], int merge, int journaled)
 {
 	/* TODO: refactor this function update_info_file() */
 
@@ -827,25 +938,31 @@ update_info_file(const char filename[], int merge)
 			write_view_history(fp, &rwin, "Right", LINE_TYPE_RWIN_HIST, nrh, rh, rhp);
 		}
 
-		if(cfg.vifm_info & VIFMINFO_CHISTORY)
+		if(journaled)
+		{
+			fputs("\n# Histories are stored in the journal:\n", fp);
+			fprintf(fp, "%c\n", LINE_TYPE_HIST_JOURNAL);
+		}
+
+		if((cfg.vifm_info & VIFMINFO_CHISTORY) && !journaled)
 		{
 			write_history(fp, "Command line", LINE_TYPE_CMDLINE_HIST,
 					MIN(ncmdh, cfg.history_len - cfg.cmd_hist.pos), cmdh, &cfg.cmd_hist);
 		}
 
-		if(cfg.vifm_info & VIFMINFO_SHISTORY)
+		if((cfg.vifm_info & VIFMINFO_SHISTORY) && !journaled)
 		{
 			write_history(fp, "Search", LINE_TYPE_SEARCH_HIST, nsrch, srch,
 					&cfg.search_hist);
 		}
 
-		if(cfg.vifm_info & VIFMINFO_PHISTORY)
+		if((cfg.vifm_info & VIFMINFO_PHISTORY) && !journaled)
 		{
 			write_history(fp, "Prompt", LINE_TYPE_PROMPT_HIST, nprompt, prompt,
 					&cfg.prompt_hist);
 		}
 
-		if(cfg.vifm_info & VIFMINFO_FHISTORY)
+		if((cfg.vifm_info & VIFMINFO_FHISTORY) && !journaled)
 		{
 			write_history(fp, "Local filter", LINE_TYPE_FILTER_HIST, nfilter, filter,
 					&cfg.filter_hist);
@@ -900,6 +1017,183 @@ update_info_file(const char filename[], int merge)
 	free(non_conflicting_marks);
 }
 
+/* Appends items added to histories by this instance to history journal,
+ * compacting it if it got too long.  Journal is left intact if histories aren't
+ * journaled by this instance, as other instances might still use it, but
+ * vifminfo written afterwards doesn't refer to it, so it's not replayed.
+ * Returns zero if histories were stored in the journal, otherwise non-zero is
+ * returned. */
+static int
+write_journal(void)
+{
+	char journal_file[PATH_MAX + 32];
+	filemon_t current_journal_mon;
+	int journal_changed;
+	int error;
+
+	if(cfg.vifm_info == 0 || !(cfg.vifm_info & VIFMINFO_JOURNAL))
+	{
+		journal_stale = 1;
+		return 1;
+	}
+
+	(void)snprintf(journal_file, sizeof(journal_file), "%s/vifminfo.journal",
+			cfg.config_dir);
+
+	journal_changed = filemon_from_file(journal_file, &current_journal_mon) != 0
+	               || !filemon_equal(&journal_mon, &current_journal_mon);
+
+	/* Journal that was changed by another instance isn't compacted, because
+	 * items it appended weren't loaded and would be lost.  Journal that wasn't
+	 * loaded is replaced to not bring back its outdated items. */
+	if(journal_stale || !is_valid_journal(journal_file) || (!journal_changed &&
+				journal_len > 2*JOURNALED_HISTORIES*cfg.history_len))
+	{
+		error = rewrite_journal(journal_file);
+	}
+	else
+	{
+		error = append_to_journal(journal_file, journal_changed);
+	}
+
+	/* Histories go to vifminfo on failure, which makes the journal outdated. */
+	journal_stale = error;
+	if(!error)
+	{
+		mark_histories_saved();
+	}
+	return error;
+}
+
+/* Checks whether file at the path is a history journal of supported version.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_valid_journal(const char path[])
+{
+	char *line;
+	int valid;
+
+	FILE *const fp = os_fopen(path, "r");
+	if(fp == NULL)
+	{
+		return 0;
+	}
+
+	line = read_line(fp, NULL);
+	valid = (line != NULL && strcmp(line, JOURNAL_HEADER) == 0);
+	free(line);
+	fclose(fp);
+	return valid;
+}
+
+/* Replaces history journal with a new one that contains current state of
+ * histories.  Returns zero on success, otherwise non-zero is returned. */
+static int
+rewrite_journal(const char path[])
+{
+	char tmp_file[PATH_MAX + 64];
+	FILE *fp;
+	int len;
+	int error;
+
+	(void)snprintf(tmp_file, sizeof(tmp_file), "%s_%u", path, get_pid());
+
+	if((fp = os_fopen(tmp_file, "w")) == NULL)
+	{
+		return 1;
+	}
+
+	fprintf(fp, "%s\n", JOURNAL_HEADER);
+	len = write_journal_items(fp, 0);
+
+	/* Incomplete copy must not replace the journal. */
+	error = ferror(fp);
+	if(fclose(fp) != 0 || error)
+	{
+		LOG_ERROR_MSG("Failed to write temporary copy of history journal");
+		(void)remove(tmp_file);
+		return 1;
+	}
+
+	if(rename_file(tmp_file, path) != 0)
+	{
+		LOG_ERROR_MSG("Can't replace history journal with its temporary copy");
+		(void)remove(tmp_file);
+		return 1;
+	}
+
+	journal_len = len;
+	(void)filemon_from_file(path, &journal_mon);
+	return 0;
+}
+
+/* Appends items that weren't saved yet to history journal.  The changed
+ * parameter specifies whether other instances updated the journal after it was
+ * last read or written by this one.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+append_to_journal(const char path[], int changed)
+{
+	int error;
+	FILE *const fp = os_fopen(path, "a");
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	journal_len += write_journal_items(fp, 1);
+
+	error = ferror(fp);
+	if(fclose(fp) != 0 || error)
+	{
+		LOG_ERROR_MSG("Failed to append to history journal");
+		return 1;
+	}
+
+	if(!changed)
+	{
+		(void)filemon_from_file(path, &journal_mon);
+	}
+	return 0;
+}
+
+/* Writes items of histories that are enabled in 'vifminfo' to the journal from
+ * oldest to newest.  Returns number of written items. */
+static int
+write_journal_items(FILE *fp, int unsaved_only)
+{
+	return write_journal_hist(fp, &cfg.cmd_hist, LINE_TYPE_CMDLINE_HIST,
+	                          VIFMINFO_CHISTORY, unsaved_only)
+	     + write_journal_hist(fp, &cfg.search_hist, LINE_TYPE_SEARCH_HIST,
+	                          VIFMINFO_SHISTORY, unsaved_only)
+	     + write_journal_hist(fp, &cfg.prompt_hist, LINE_TYPE_PROMPT_HIST,
+	                          VIFMINFO_PHISTORY, unsaved_only)
+	     + write_journal_hist(fp, &cfg.filter_hist, LINE_TYPE_FILTER_HIST,
+	                          VIFMINFO_FHISTORY, unsaved_only);
+}
+
+/* Writes items of the history to the journal if the flag is set in 'vifminfo'.
+ * Returns number of written items. */
+static int
+write_journal_hist(FILE *fp, const hist_t *hist, char mark, int flag,
+		int unsaved_only)
+{
+	int i;
+	int count;
+
+	if(!(cfg.vifm_info & flag))
+	{
+		return 0;
+	}
+
+	count = unsaved_only ? hist->unsaved : hist->pos + 1;
+	for(i = count - 1; i >= 0; --i)
+	{
+		fprintf(fp, "%c%s\n", mark, hist->items[i]);
+	}
+	return count;
+}
+
 /* Handles single directory history entry, possibly skipping merging it in. */
 static void
 process_hist_entry(FileView *view, const char dir[], const char file[], int pos,
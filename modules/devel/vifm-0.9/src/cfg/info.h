@@ -21,11 +21,12 @@
 #define VIFM__CFG__INFO_H__
 
 /* Reads vifminfo file populating internal structures with information it
- * contains.  Reread should be set to non-zero value when vifminfo is read not
- * during startup process. */
+ * contains, followed by history journal.  Reread should be set to non-zero
+ * value when vifminfo is read not during startup process. */
 void read_info_file(int reread);
 
-/* Writes vifminfo file updating it with state of the current instance. */
+/* Writes vifminfo file updating it with state of the current instance.  Items
+ * of histories are appended to history journal instead if it's enabled. */
 void write_info_file(void);
 
 #endif /* VIFM__CFG__INFO_H__ */
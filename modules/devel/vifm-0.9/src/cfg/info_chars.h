@@ -82,6 +82,9 @@
 /* Local filter history. */
 #define LINE_TYPE_FILTER_HIST '|'
 
+/* Histories are stored in the journal rather than in this file. */
+#define LINE_TYPE_HIST_JOURNAL 'j'
+
 /* Directory stack. */
 #define LINE_TYPE_DIR_STACK 'S'
 
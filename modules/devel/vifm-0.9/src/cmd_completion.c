@@ -27,19 +27,13 @@
 #endif
 
 #include <sys/stat.h> /* stat */
-#include <dirent.h> /* DIR dirent */
-
-#ifndef _WIN32
-#include <grp.h> /* getgrent setgrent */
-#include <pwd.h> /* getpwent setpwent */
-#endif
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* free() */
 #include <stdio.h> /* snprintf() */
 #include <string.h> /* memcpy() strdup() strlen() strncasecmp() strncmp()
-                       strrchr() */
+                       strpbrk() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -59,8 +53,13 @@
 #include "ui/color_scheme.h"
 #include "ui/colors.h"
 #include "ui/statusbar.h"
+#include "utils/dircache.h"
 #include "utils/env.h"
+#include "utils/execcache.h"
 #include "utils/fs.h"
+#ifndef _WIN32
+#include "utils/idcache.h"
+#endif
 #include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
@@ -90,12 +89,22 @@ static void complete_winrun(const char str[]);
 static void complete_from_string_list(const char str[], const char *items[][2],
 		size_t item_count, int ignore_case);
 static void complete_command_name(const char beginning[]);
+static void complete_dir_executables(const char dir[], char *names[],
+		int count, void *arg);
 static void filename_completion_in_dir(const char *path, const char *str,
 		CompletionType type);
-static void filename_completion_internal(DIR *dir, const char filename[],
-		CompletionType type);
-static int is_dirent_targets_exec(const struct dirent *d);
-#ifdef _WIN32
+static int filename_completion_internal(FileView *view, const char dir[],
+		const char filename[], CompletionType type);
+static int view_lists_dir(FileView *view, const char dir[]);
+static DirCacheType get_entry_type(const dir_entry_t *entry);
+static int path_compl_is_case_sensitive(void);
+static void add_filename_match(const char name[], DirCacheType ftype,
+		const char filename[], size_t filename_len, CompletionType type);
+static int targets_dir(const char name[], DirCacheType type);
+static int targets_exec(const char name[], DirCacheType type);
+#ifndef _WIN32
+static void complete_with_names(const char str[], char *names[], int count);
+#else
 static void complete_with_shared(const char *server, const char *file);
 #endif
 static int file_matches(const char fname[], const char prefix[],
@@ -840,9 +849,20 @@ complete_command_name(const char beginning[])
 	size_t i;
 	char ** paths;
 	size_t paths_count;
-	char *const cwd = save_cwd();
+	char *cwd;
 
+	/* This also updates list of directories of the index. */
 	paths = get_paths(&paths_count);
+
+	/* Index doesn't know about subdirectories and environment variables. */
+	if(strpbrk(beginning, "/$") == NULL &&
+			execcache_list(&complete_dir_executables, (void *)beginning) == 0)
+	{
+		vle_compl_add_last_path_match(beginning);
+		return;
+	}
+
+	cwd = save_cwd();
 	for(i = 0U; i < paths_count; ++i)
 	{
 		if(vifm_chdir(paths[i]) == 0)
@@ -855,6 +875,38 @@ complete_command_name(const char beginning[])
 	restore_cwd(cwd);
 }
 
+/* Adds executables of the directory that match prefix passed in arg as
+ * completion matches the same way filename_completion() would. */
+static void
+complete_dir_executables(const char dir[], char *names[], int count, void *arg)
+{
+	const char *const prefix = arg;
+	const size_t prefix_len = strlen(prefix);
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		char path[PATH_MAX];
+
+		if(prefix[0] == '\0' && names[i][0] == '.')
+		{
+			continue;
+		}
+		if(!file_matches(names[i], prefix, prefix_len))
+		{
+			continue;
+		}
+
+		snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+		if(executable_exists(path))
+		{
+			vle_compl_add_path_match(names[i]);
+		}
+	}
+
+	vle_compl_finish_group();
+}
+
 static void
 filename_completion_in_dir(const char *path, const char *str,
 		CompletionType type)
@@ -879,7 +931,6 @@ filename_completion(const char str[], CompletionType type,
 		int skip_canonicalization)
 {
 	/* TODO refactor filename_completion(...) function */
-	DIR *dir;
 	char *dirname;
 	char *filename;
 	char *temp;
@@ -957,83 +1008,197 @@ filename_completion(const char str[], CompletionType type,
 	}
 #endif
 
-	dir = os_opendir(dirname);
-
 	cwd = save_cwd();
 
-	if(dir == NULL || vifm_chdir(dirname) != 0)
+	if(vifm_chdir(dirname) != 0 ||
+			filename_completion_internal(curr_view, dirname, filename, type) != 0)
 	{
 		vle_compl_add_path_match(filename);
 	}
-	else
-	{
-		filename_completion_internal(dir, filename, type);
-		(void)vifm_chdir(flist_get_dir(curr_view));
-	}
+	(void)vifm_chdir(flist_get_dir(curr_view));
 
 	free(filename);
 	free(dirname);
 
-	if(dir != NULL)
-	{
-		os_closedir(dir);
-	}
-
 	restore_cwd(cwd);
 }
 
-static void
-filename_completion_internal(DIR *dir, const char filename[],
-		CompletionType type)
+/* Completes names of files of the directory, which must be current working
+ * directory.  Listing of the view is used if it's complete, otherwise cached
+ * listing of the directory is used.  Returns zero on success and non-zero if
+ * directory can't be listed. */
+static int
+filename_completion_internal(FileView *view, const char dir[],
+		const char filename[], CompletionType type)
 {
-	struct dirent *d;
+	const size_t filename_len = strlen(filename);
+	int i;
 
-	size_t filename_len = strlen(filename);
-	while((d = os_readdir(dir)) != NULL)
+	if(view_lists_dir(view, dir))
 	{
-		if(filename[0] == '\0' && d->d_name[0] == '.')
-			continue;
-		if(!file_matches(d->d_name, filename, filename_len))
-			continue;
-
-		if(type == CT_DIRONLY && !is_dirent_targets_dir(d))
-			continue;
-		else if(type == CT_EXECONLY && !is_dirent_targets_exec(d))
-			continue;
-		else if(type == CT_DIREXEC && !is_dirent_targets_dir(d) &&
-				!is_dirent_targets_exec(d))
-			continue;
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			const dir_entry_t *const entry = &view->dir_entry[i];
+			if(!is_parent_dir(entry->name))
+			{
+				add_filename_match(entry->name, get_entry_type(entry), filename,
+						filename_len, type);
+			}
+		}
+	}
+	else
+	{
+		int first = 0;
+		int count;
 
-		if(is_dirent_targets_dir(d) && type != CT_ALL_WOS)
+		const dircache_listing_t *const listing = dircache_get(dir);
+		if(listing == NULL)
 		{
-			vle_compl_put_path_match(format_str("%s/", d->d_name));
+			return 1;
 		}
-		else
+
+		/* Range of matches can be found only if names are compared the same way
+		 * they are sorted. */
+		count = path_compl_is_case_sensitive()
+		      ? dircache_find_prefix(listing, filename, &first)
+		      : listing->count;
+
+		for(i = first; i < first + count; ++i)
 		{
-			vle_compl_add_path_match(d->d_name);
+			add_filename_match(listing->entries[i].name, listing->entries[i].type,
+					filename, filename_len, type);
 		}
 	}
 
+	/* Neither of listings contains these, but they are in every directory. */
+	add_filename_match(".", DCT_DIR, filename, filename_len, type);
+	add_filename_match("..", DCT_DIR, filename, filename_len, type);
+
 	vle_compl_finish_group();
 	if(type != CT_EXECONLY)
 	{
 		vle_compl_add_last_path_match(filename);
 	}
+	return 0;
+}
+
+/* Checks whether file list of the view is a complete and up to date listing of
+ * the directory.  Returns non-zero if so, otherwise zero is returned. */
+static int
+view_lists_dir(FileView *view, const char dir[])
+{
+	int failed;
+
+	if(flist_custom_active(view) || view->filtered != 0 ||
+			view->local_filter.unfiltered != NULL || view->watch == NULL ||
+			!paths_are_equal(flist_get_dir(view), dir) ||
+			!paths_are_equal(view->watched_dir, dir))
+	{
+		return 0;
+	}
+
+	/* Change that wasn't processed yet makes the list outdated, let the view
+	 * know about it as the change is consumed here. */
+	if(fswatch_changed(view->watch, &failed) || failed)
+	{
+		ui_view_schedule_reload(view);
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Maps type of file list entry onto type of cached directory entry.  Returns
+ * the type. */
+static DirCacheType
+get_entry_type(const dir_entry_t *entry)
+{
+	switch(entry->type)
+	{
+		case FT_DIR:  return DCT_DIR;
+		case FT_LINK: return DCT_LINK;
+
+		default:
+			return DCT_OTHER;
+	}
+}
+
+/* Checks whether names of files are compared case sensitively during
+ * completion.  Returns non-zero if so, otherwise zero is returned. */
+static int
+path_compl_is_case_sensitive(void)
+{
+	if(cfg.case_override & CO_PATH_COMPL)
+	{
+		return !(cfg.case_ignore & CO_PATH_COMPL);
+	}
+#ifndef _WIN32
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/* Adds file of current working directory as a completion match if it matches
+ * the prefix and kind of completion. */
+static void
+add_filename_match(const char name[], DirCacheType ftype,
+		const char filename[], size_t filename_len, CompletionType type)
+{
+	if(filename[0] == '\0' && name[0] == '.')
+		return;
+	if(!file_matches(name, filename, filename_len))
+		return;
+
+	if(type == CT_DIRONLY && !targets_dir(name, ftype))
+		return;
+	else if(type == CT_EXECONLY && !targets_exec(name, ftype))
+		return;
+	else if(type == CT_DIREXEC && !targets_dir(name, ftype) &&
+			!targets_exec(name, ftype))
+		return;
+
+	if(targets_dir(name, ftype) && type != CT_ALL_WOS)
+	{
+		vle_compl_put_path_match(format_str("%s/", name));
+	}
+	else
+	{
+		vle_compl_add_path_match(name);
+	}
 }
 
-/* Uses dentry to check file type.  Returns non-zero for directories,
- * otherwise zero is returned.  Symbolic links are dereferenced. */
+/* Checks whether file of current working directory is a directory or a
+ * symbolic link to one.  Returns non-zero if so, otherwise zero is
+ * returned. */
 static int
-is_dirent_targets_exec(const struct dirent *d)
+targets_dir(const char name[], DirCacheType type)
+{
+	switch(type)
+	{
+		case DCT_DIR:   return 1;
+		case DCT_LINK:  return get_symlink_type(name) != SLT_UNKNOWN;
+		case DCT_OTHER: return 0;
+
+		default:
+			return is_dir(name);
+	}
+}
+
+/* Checks whether file of current working directory is an executable.  Returns
+ * non-zero if so, otherwise zero is returned.  Symbolic links are
+ * dereferenced. */
+static int
+targets_exec(const char name[], DirCacheType type)
 {
 #ifndef _WIN32
-	if(d->d_type == DT_DIR)
+	if(type == DCT_DIR)
 		return 0;
-	if(d->d_type == DT_LNK && get_symlink_type(d->d_name) != SLT_UNKNOWN)
+	if(type == DCT_LINK && get_symlink_type(name) != SLT_UNKNOWN)
 		return 0;
-	return os_access(d->d_name, X_OK) == 0;
+	return os_access(name, X_OK) == 0;
 #else
-	return is_win_executable(d->d_name);
+	return is_win_executable(name);
 #endif
 }
 
@@ -1042,34 +1207,33 @@ is_dirent_targets_exec(const struct dirent *d)
 void
 complete_user_name(const char *str)
 {
-	struct passwd *pw;
-	size_t len;
-
-	len = strlen(str);
-	setpwent();
-	while((pw = getpwent()) != NULL)
-	{
-		if(strncmp(pw->pw_name, str, len) == 0)
-		{
-			vle_compl_add_match(pw->pw_name, "");
-		}
-	}
-	vle_compl_finish_group();
-	vle_compl_add_last_match(str);
+	int count;
+	char **const names = idcache_list_users(&count);
+	complete_with_names(str, names, count);
+	free_string_array(names, count);
 }
 
 void
 complete_group_name(const char *str)
 {
-	struct group *gr;
-	size_t len = strlen(str);
+	int count;
+	char **const names = idcache_list_groups(&count);
+	complete_with_names(str, names, count);
+	free_string_array(names, count);
+}
+
+/* Adds names that start with the str as completion matches. */
+static void
+complete_with_names(const char str[], char *names[], int count)
+{
+	const size_t len = strlen(str);
+	int i;
 
-	setgrent();
-	while((gr = getgrent()) != NULL)
+	for(i = 0; i < count; ++i)
 	{
-		if(strncmp(gr->gr_name, str, len) == 0)
+		if(strncmp(names[i], str, len) == 0)
 		{
-			vle_compl_add_match(gr->gr_name, "");
+			vle_compl_add_match(names[i], "");
 		}
 	}
 	vle_compl_finish_group();
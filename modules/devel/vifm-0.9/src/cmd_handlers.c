@@ -28,12 +28,13 @@
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() */
 #include <errno.h>
+#include <limits.h> /* INT_MAX */
 #include <signal.h>
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* pclose() popen() snprintf() */
 #include <stdlib.h> /* EXIT_SUCCESS atoi() free() realloc() */
 #include <string.h> /* strchr() strcmp() strcasecmp() strcpy() strdup() strlen()
-                       strrchr() */
+                       strrchr() strspn() */
 #include <wctype.h> /* iswspace() */
 #include <wchar.h> /* wcslen() wcsncmp() */
 
@@ -77,6 +78,7 @@
 #include "utils/regexp.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
+#include "utils/trace.h"
 #include "utils/trie.h"
 #include "utils/utils.h"
 #include "background.h"
@@ -227,6 +229,7 @@ static int normal_cmd(const cmd_info_t *cmd_info);
 static int nunmap_cmd(const cmd_info_t *cmd_info);
 static int only_cmd(const cmd_info_t *cmd_info);
 static int popd_cmd(const cmd_info_t *cmd_info);
+static int profile_cmd(const cmd_info_t *cmd_info);
 static int pushd_cmd(const cmd_info_t *cmd_info);
 static int put_cmd(const cmd_info_t *cmd_info);
 static int pwd_cmd(const cmd_info_t *cmd_info);
@@ -621,6 +624,10 @@ const cmd_add_t cmds_list[] = {
 	  .descr = "pop top of directory stack",
 	  .flags = HAS_COMMENT,
 	  .handler = &popd_cmd,        .min_args = 0,   .max_args = 0, },
+	{ .name = "profile",           .abbr = "prof",  .id = -1,
+	  .descr = "start/stop recording profile",
+	  .flags = HAS_QUOTED_ARGS | HAS_COMMENT | HAS_ENVVARS,
+	  .handler = &profile_cmd,     .min_args = 1,   .max_args = 2, },
 	{ .name = "pushd",             .abbr = NULL,    .id = COM_PUSHD,
 	  .descr = "push onto directory stack",
 	  .flags = HAS_EMARK | HAS_QUOTED_ARGS | HAS_COMMENT | HAS_ENVVARS,
@@ -745,7 +752,7 @@ const cmd_add_t cmds_list[] = {
 	{ .name = "tree",              .abbr = NULL,    .id = -1,
 	  .descr = "display filesystem as a tree",
 	  .flags = HAS_COMMENT,
-	  .handler = &tree_cmd,        .min_args = 0,   .max_args = 0, },
+	  .handler = &tree_cmd,        .min_args = 0,   .max_args = 1, },
 	{ .name = "undolist",          .abbr = "undol", .id = -1,
 	  .descr = "display list of operations",
 	  .flags = HAS_EMARK | HAS_COMMENT,
@@ -2465,6 +2472,10 @@ highlight_file(const cmd_info_t *cmd_info)
 	result = parse_and_apply_highlight(cmd_info, &color);
 	result += cs_add_file_hi(matchers, &color);
 
+	/* Entries that didn't match anything might match the new highlight. */
+	fview_view_cs_reset(&lwin);
+	fview_view_cs_reset(&rwin);
+
 	/* Redraw is enough to update filename specific highlights. */
 	curr_stats.need_update = UT_REDRAW;
 
@@ -2934,6 +2945,9 @@ let_cmd(const cmd_info_t *cmd_info)
 		status_bar_message(vle_tb_get_data(vle_err));
 	}
 	update_path_env(0);
+	/* Options might have been changed via &option syntax. */
+	fview_reset_cells(&lwin);
+	fview_reset_cells(&rwin);
 	return 0;
 }
 
@@ -3293,6 +3307,50 @@ popd_cmd(const cmd_info_t *cmd_info)
 	return 0;
 }
 
+/* :prof[ile] start {path} | :prof[ile] stop.  Starts recording timings of
+ * operations or stops recording and writes them out in trace event format. */
+static int
+profile_cmd(const cmd_info_t *cmd_info)
+{
+	if(strcmp(cmd_info->argv[0], "start") == 0 && cmd_info->argc == 2)
+	{
+		char path[PATH_MAX];
+		char *const expanded = expand_tilde(cmd_info->argv[1]);
+		to_canonic_path(expanded, flist_get_dir(curr_view), path, sizeof(path));
+		free(expanded);
+
+		if(trace_start(path) != 0)
+		{
+			status_bar_error("Failed to start profiling");
+			return 1;
+		}
+		return 0;
+	}
+
+	if(strcmp(cmd_info->argv[0], "stop") == 0 && cmd_info->argc == 1)
+	{
+		char path[PATH_MAX];
+
+		if(!trace_is_active())
+		{
+			status_bar_error("Profiling is not active");
+			return 1;
+		}
+
+		copy_str(path, sizeof(path), trace_get_path());
+		if(trace_finish() != 0)
+		{
+			status_bar_errorf("Failed to write profile to %s", path);
+			return 1;
+		}
+		status_bar_messagef("Profile written to %s", path);
+		return 1;
+	}
+
+	status_bar_errorf("Invalid argument: %s", cmd_info->args);
+	return 1;
+}
+
 static int
 pushd_cmd(const cmd_info_t *cmd_info)
 {
@@ -3973,7 +4031,22 @@ trashes_cmd(const cmd_info_t *cmd_info)
 static int
 tree_cmd(const cmd_info_t *cmd_info)
 {
-	(void)flist_load_tree(curr_view, flist_get_dir(curr_view));
+	int depth = INT_MAX;
+
+	if(cmd_info->argc != 0)
+	{
+		const char *const arg = cmd_info->argv[0];
+		const char *const value = after_first(arg, '=');
+		if(!starts_with_lit(arg, "depth=") || *value == '\0' ||
+				value[strspn(value, "0123456789")] != '\0' ||
+				(depth = str_to_int(value)) <= 0)
+		{
+			status_bar_errorf("Invalid argument: %s", arg);
+			return 1;
+		}
+	}
+
+	(void)flist_load_tree(curr_view, flist_get_dir(curr_view), depth);
 	return 0;
 }
 
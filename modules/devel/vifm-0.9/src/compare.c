@@ -22,7 +22,7 @@
 #include <stddef.h> /* size_t */
 #include <stdint.h> /* INTPTR_MAX INT64_MAX */
 #include <stdio.h> /* FILE fclose() feof() fopen() fread() */
-#include <stdlib.h> /* free() malloc() qsort() */
+#include <stdlib.h> /* calloc() free() malloc() qsort() */
 #include <string.h> /* memcmp() */
 
 #include "compat/fs_limits.h"
@@ -35,6 +35,8 @@
 #include "utils/dynarray.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
+#include "utils/fslister.h"
+#include "utils/intern.h"
 #include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
@@ -55,6 +57,10 @@
 /* Amount of data to hash for coarse comparison. */
 #define PREFIX_SIZE (256*1024)
 
+/* Number of threads that read directories of compared trees ahead of the
+ * traversal. */
+#define LISTING_THREADS 4
+
 /* Entry in singly-bounded list of files that have matched fingerprints. */
 typedef struct compare_record_t
 {
@@ -64,6 +70,20 @@ typedef struct compare_record_t
 }
 compare_record_t;
 
+/* State of building list of entries for comparison. */
+typedef struct
+{
+	trie_t *trie;       /* Maps fingerprints to lists of compare_record_t. */
+	FileView *view;     /* View whose entries are being listed. */
+	int *next_id;       /* Next id to assign to a new group of files. */
+	CompareType ct;     /* Type of comparison. */
+	int skip_empty;     /* Whether empty files should be ignored. */
+	int dups_only;      /* Whether new files shouldn't be added to the trie. */
+	entries_t entries;  /* Entries collected so far. */
+	int nfiles;         /* Number of files processed so far. */
+}
+diff_list_t;
+
 static void make_unique_lists(entries_t curr, entries_t other);
 static void leave_only_dups(entries_t *curr, entries_t *other);
 static int is_not_duplicate(FileView *view, const dir_entry_t *entry,
@@ -73,11 +93,15 @@ static int id_sorter(const void *first, const void *second);
 static void put_or_free(FileView *view, dir_entry_t *entry, int id, int take);
 static entries_t make_diff_list(trie_t *trie, FileView *view, int *next_id,
 		CompareType ct, int skip_empty, int dups_only);
+static void add_to_diff_list(diff_list_t *dl, const char path[]);
 static void list_view_entries(const FileView *view, strlist_t *list);
 static void append_valid_nodes(const char name[], int valid,
 		const void *parent_data, void *data, void *arg);
-static void list_files_recursively(const char path[], int skip_dot_files,
-		strlist_t *list);
+static void diff_tree(diff_list_t *dl, const char path[], int skip_dot_files);
+static void diff_files_recursively(diff_list_t *dl, fslister_t *lister,
+		fslister_req_t *req, const char path[], int skip_dot_files);
+static int is_subtree(const fslister_entry_t *entry, int skip_dot_files);
+static int fslister_entry_sorter(const void *first, const void *second);
 static char * get_file_fingerprint(const char path[], const dir_entry_t *entry,
 		CompareType ct);
 static char * get_contents_fingerprint(const char path[],
@@ -489,82 +513,108 @@ static entries_t
 make_diff_list(trie_t *trie, FileView *view, int *next_id, CompareType ct,
 		int skip_empty, int dups_only)
 {
-	int i;
-	strlist_t files = {};
-	entries_t r = {};
-	int last_progress = 0;
+	diff_list_t dl = {
+		.trie = trie,
+		.view = view,
+		.next_id = next_id,
+		.ct = ct,
+		.skip_empty = skip_empty,
+		.dups_only = dups_only,
+	};
 
-	show_progress("Listing...", 0);
 	if(flist_custom_active(view) &&
 			ONE_OF(view->custom.type, CV_REGULAR, CV_VERY))
 	{
+		int i;
+		int last_progress = 0;
+		strlist_t files = {};
+
+		show_progress("Listing...", 0);
 		list_view_entries(view, &files);
+
+		show_progress("Querying...", 0);
+		for(i = 0; i < files.nitems && !ui_cancellation_requested(); ++i)
+		{
+			int progress;
+
+			add_to_diff_list(&dl, files.items[i]);
+
+			progress = (i*100)/files.nitems;
+			if(progress != last_progress)
+			{
+				char progress_msg[128];
+
+				last_progress = progress;
+				snprintf(progress_msg, sizeof(progress_msg), "Querying... %d (% 2d%%)",
+						i, progress);
+				show_progress(progress_msg, -1);
+			}
+		}
+
+		free_string_array(files.items, files.nitems);
 	}
 	else
 	{
-		list_files_recursively(flist_get_dir(view), view->hide_dot, &files);
+		show_progress("Querying...", 0);
+		diff_tree(&dl, flist_get_dir(view), view->hide_dot);
 	}
 
-	show_progress("Querying...", 0);
-	for(i = 0; i < files.nitems && !ui_cancellation_requested(); ++i)
-	{
-		int progress;
-		int existing_id;
-		char *fingerprint;
-		const char *const path = files.items[i];
-		dir_entry_t *const entry = entry_list_add(view, &r.entries, &r.nentries,
-				path);
-
-		if(skip_empty && entry->size == 0)
-		{
-			fentry_free(view, entry);
-			--r.nentries;
-			continue;
-		}
+	return dl.entries;
+}
 
-		fingerprint = get_file_fingerprint(path, entry, ct);
-		/* In case we couldn't obtain fingerprint (e.g., comparing by contents and
-		 * files isn't readable), ignore the file and keep going. */
-		if(is_null_or_empty(fingerprint))
-		{
-			free(fingerprint);
-			fentry_free(view, entry);
-			--r.nentries;
-			continue;
-		}
+/* Makes entry for the file, computes its fingerprint and assigns it an id.
+ * Files that are empty (when they are to be skipped) or have no fingerprint
+ * are ignored. */
+static void
+add_to_diff_list(diff_list_t *dl, const char path[])
+{
+	int existing_id;
+	char *fingerprint;
+	dir_entry_t *entry;
+	const int tag = dl->nfiles++;
+
+	entry = entry_list_add(dl->view, &dl->entries.entries, &dl->entries.nentries,
+			path);
+	if(entry == NULL)
+	{
+		return;
+	}
 
-		entry->tag = i;
-		if(get_file_id(trie, path, fingerprint, &existing_id, ct))
-		{
-			entry->id = existing_id;
-		}
-		else if(dups_only)
-		{
-			entry->id = -1;
-		}
-		else
-		{
-			entry->id = *next_id;
-			++*next_id;
-			put_file_id(trie, path, fingerprint, entry->id, ct);
-		}
+	if(dl->skip_empty && entry->size == 0)
+	{
+		fentry_free(dl->view, entry);
+		--dl->entries.nentries;
+		return;
+	}
 
+	fingerprint = get_file_fingerprint(path, entry, dl->ct);
+	/* In case we couldn't obtain fingerprint (e.g., comparing by contents and
+	 * files isn't readable), ignore the file and keep going. */
+	if(is_null_or_empty(fingerprint))
+	{
 		free(fingerprint);
+		fentry_free(dl->view, entry);
+		--dl->entries.nentries;
+		return;
+	}
 
-		progress = (i*100)/files.nitems;
-		if(progress != last_progress)
-		{
-			char progress_msg[128];
-
-			last_progress = progress;
-			snprintf(progress_msg, sizeof(progress_msg), "Querying... %d (% 2d%%)", i,
-					progress);
-			show_progress(progress_msg, -1);
-		}
+	entry->tag = tag;
+	if(get_file_id(dl->trie, path, fingerprint, &existing_id, dl->ct))
+	{
+		entry->id = existing_id;
+	}
+	else if(dl->dups_only)
+	{
+		entry->id = -1;
+	}
+	else
+	{
+		entry->id = *dl->next_id;
+		++*dl->next_id;
+		put_file_id(dl->trie, path, fingerprint, entry->id, dl->ct);
 	}
 
-	free_string_array(files.items, files.nitems);
-	return r;
+	free(fingerprint);
 }
 
 /* Fills the list with entries of the view in hierarchical order (pre-order tree
@@ -610,59 +660,136 @@ append_valid_nodes(const char name[], int valid, const void *parent_data,
 	}
 }
 
-/* Collects files under specified file system tree. */
+/* Adds files under specified file system tree to the list.  Directories are
+ * read by worker threads ahead of the traversal, so that files are processed
+ * as soon as listing of their directory is available. */
+static void
+diff_tree(diff_list_t *dl, const char path[], int skip_dot_files)
+{
+	fslister_req_t *req;
+
+	fslister_t *const lister = fslister_create(LISTING_THREADS,
+			&ui_cancellation_requested);
+	if(lister == NULL)
+	{
+		return;
+	}
+
+	req = fslister_request(lister, path);
+	if(req != NULL)
+	{
+		diff_files_recursively(dl, lister, req, path, skip_dot_files);
+	}
+
+	fslister_free(lister);
+}
+
+/* Adds files of the directory to the list after files of its subdirectories,
+ * everything in sorted order.  Symbolic links to directories are ignored. */
 static void
-list_files_recursively(const char path[], int skip_dot_files, strlist_t *list)
+diff_files_recursively(diff_list_t *dl, fslister_t *lister,
+		fslister_req_t *req, const char path[], int skip_dot_files)
 {
 	int i;
+	fslister_req_t **reqs;
 
-	/* Obtain sorted list of files. */
 	int len;
-	char **lst = list_sorted_files(path, &len);
+	fslister_entry_t *const lst = fslister_take(lister, req, &len);
 	if(len < 0)
 	{
 		return;
 	}
 
-	/* Visit all subdirectories ignoring symbolic links to directories. */
+	reqs = calloc(MAX(len, 1), sizeof(*reqs));
+	if(reqs == NULL)
+	{
+		fslister_free_entries(lst, len);
+		return;
+	}
+
+	if(len > 0)
+	{
+		qsort(lst, len, sizeof(*lst), &fslister_entry_sorter);
+	}
+
+	/* Request subdirectories in reverse order, so that they are read in order in
+	 * which they are going to be visited. */
+	for(i = len - 1; i >= 0; --i)
+	{
+		if(is_subtree(&lst[i], skip_dot_files))
+		{
+			char *const full_path = format_str("%s/%s", path, lst[i].name);
+			reqs[i] = fslister_request(lister, full_path);
+			free(full_path);
+		}
+	}
+
+	/* Visit all subdirectories. */
 	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
 	{
 		char *full_path;
-		if(skip_dot_files && lst[i][0] == '.')
+
+		if(!is_subtree(&lst[i], skip_dot_files))
 		{
-			update_string(&lst[i], NULL);
 			continue;
 		}
 
-		full_path = format_str("%s/%s", path, lst[i]);
-		if(is_dir(full_path))
+		full_path = format_str("%s/%s", path, lst[i].name);
+		if(reqs[i] == NULL)
 		{
-			if(!is_symlink(full_path))
-			{
-				list_files_recursively(full_path, skip_dot_files, list);
-			}
-			free(full_path);
-			update_string(&lst[i], NULL);
+			/* Listing wasn't requested because of an error. */
+			reqs[i] = fslister_request(lister, full_path);
 		}
-		else
+		if(reqs[i] != NULL)
 		{
-			free(lst[i]);
-			lst[i] = full_path;
+			diff_files_recursively(dl, lister, reqs[i], full_path, skip_dot_files);
+			reqs[i] = NULL;
 		}
-
-		show_progress("Listing...", 1000);
+		free(full_path);
 	}
 
-	/* Append files. */
-	for(i = 0; i < len; ++i)
+	/* Process files.  Requests that weren't taken because of cancellation are
+	 * freed along with the lister. */
+	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
 	{
-		if(lst[i] != NULL)
+		char *full_path;
+
+		if(lst[i].is_dir || (skip_dot_files && lst[i].name[0] == '.'))
 		{
-			list->nitems = put_into_string_array(&list->items, list->nitems, lst[i]);
+			continue;
 		}
+
+		full_path = format_str("%s/%s", path, lst[i].name);
+		add_to_diff_list(dl, full_path);
+		free(full_path);
+
+		show_progress("Querying...", 1000);
+	}
+
+	free(reqs);
+	fslister_free_entries(lst, len);
+}
+
+/* Checks whether entry is a directory that should be traversed.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_subtree(const fslister_entry_t *entry, int skip_dot_files)
+{
+	if(skip_dot_files && entry->name[0] == '.')
+	{
+		return 0;
 	}
+	return entry->is_dir && !entry->is_link;
+}
 
-	free(lst);
+/* qsort() comparer that sorts listing entries by name.  Returns standard -1, 0,
+ * 1 for comparisons. */
+static int
+fslister_entry_sorter(const void *first, const void *second)
+{
+	const fslister_entry_t *const a = first;
+	const fslister_entry_t *const b = second;
+	return stroscmp(a->name, b->name);
 }
 
 /* Computes fingerprint of the file specified by path and entry.  Type of the
@@ -913,7 +1040,9 @@ compare_move(FileView *from, FileView *to)
 		/* Update the other entry to not be fake. */
 		remove_last_path_component(canonical);
 		replace_string(&other->name, curr->name);
-		replace_string(&other->origin, canonical);
+		intern_free(other->origin);
+		other->origin = intern_str(canonical);
+		fentry_touch(other);
 	}
 	else
 	{
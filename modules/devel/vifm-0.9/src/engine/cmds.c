@@ -23,7 +23,7 @@
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h>
 #include <stdlib.h> /* calloc() malloc() free() realloc() */
-#include <string.h> /* strdup() */
+#include <string.h> /* memcpy() strcmp() strdup() */
 
 #include "../compat/reallocarray.h"
 #include "../utils/darray.h"
@@ -31,12 +31,15 @@
 #include "../utils/str.h"
 #include "../utils/string_array.h"
 #include "../utils/test_helpers.h"
+#include "../utils/trie.h"
 #include "../utils/utils.h"
 #include "completion.h"
 
 #define MAX_CMD_RECURSION 16
 #define MAX_CMD_NAME_LEN 256
 #define INVALID_MARK -4096
+/* Number of slots in cache of parsed command-lines, must be a power of two. */
+#define LINE_CACHE_SIZE 64
 
 typedef enum
 {
@@ -80,12 +83,37 @@ typedef struct cmd_t
 }
 cmd_t;
 
+/* Result of parsing part of command-line that follows range.  It depends only
+ * on the text and the set of commands and is reused when the same command-line
+ * is executed again. */
+typedef struct
+{
+	char *text;           /* Parsed text or NULL for an unused slot. */
+	size_t hash;          /* Hash of the text. */
+	cmd_t *cmd;           /* Command that is invoked. */
+	char *raw_args;       /* Raw arguments without background mark. */
+	int emark, qmark, bg; /* Flags specified after command name and at the end. */
+	char sep;             /* Separator of arguments. */
+
+	char *args;           /* Arguments for which argv is computed or NULL. */
+	int argc;             /* Number of arguments in argv. */
+	char **argv;          /* Result of dispatch_line() for args. */
+	int (*argvp)[2];      /* Positions of arguments in args. */
+}
+parsed_line_t;
+
 typedef struct
 {
 	cmd_t head;
 	cmd_add_t user_cmd_handler;
 	cmd_handler command_handler;
 	int udf_count;
+
+	/* Maps full names of commands to their nodes, rebuilt on demand after being
+	 * dropped on changes of the list of commands. */
+	trie_t *names;
+	/* Direct-mapped cache of parsed command-lines, dropped along with names. */
+	parsed_line_t lines[LINE_CACHE_SIZE];
 }
 inner_t;
 
@@ -95,6 +123,17 @@ static const char *RANGE_SEPARATORS = ",;";
 static inner_t *inner;
 static cmds_conf_t *cmds_conf;
 
+static int parse_line(const char cmd[], cmd_info_t *cmd_info, cmd_t **cmd_out);
+static void dispatch_args(const char line[], cmd_t *cur, cmd_info_t *cmd_info);
+static parsed_line_t * find_line(const char text[]);
+static void cache_line(const char text[], cmd_t *cmd,
+		const cmd_info_t *cmd_info);
+static void cache_args(parsed_line_t *line, const cmd_info_t *cmd_info);
+static int copy_args(const parsed_line_t *line, cmd_info_t *cmd_info);
+static int dup_args(int argc, char *argv[], int (*argvp)[2], char ***new_argv,
+		int (**new_argvp)[2]);
+static void free_line(parsed_line_t *line);
+static void commands_changed(void);
 static const char * correct_limit(const char cmd[], cmd_info_t *cmd_info);
 static int udf_is_ambiguous(const char name[]);
 static const char * parse_tail(cmd_t *cur, const char cmd[],
@@ -103,6 +142,7 @@ static const char * get_cmd_name(const char cmd[], char buf[], size_t buf_len);
 static void init_cmd_info(cmd_info_t *cmd_info);
 static const char * skip_prefix_commands(const char cmd[]);
 static cmd_t * find_cmd(const char name[]);
+static trie_t * get_names(void);
 static const char * parse_range(const char cmd[], cmd_info_t *cmd_info);
 static const char * parse_range_elem(const char cmd[], cmd_info_t *cmd_info,
 		char last_sep);
@@ -184,6 +224,7 @@ reset_cmds(void)
 	inner->head.next = NULL;
 	inner->user_cmd_handler.handler = NULL;
 
+	commands_changed();
 	free(inner);
 	cmds_conf->inner = NULL;
 }
@@ -192,12 +233,8 @@ int
 execute_cmd(const char cmd[])
 {
 	cmd_info_t cmd_info;
-	char cmd_name[MAX_CMD_NAME_LEN];
 	cmd_t *cur;
-	const char *args;
 	int execution_code;
-	size_t last_arg_len;
-	char *last_arg;
 	int last_end = 0;
 	cmds_conf_t *cc = cmds_conf;
 
@@ -223,26 +260,9 @@ execute_cmd(const char cmd[])
 		cmd_info.begin = t;
 	}
 
-	cmd = get_cmd_name(cmd, cmd_name, sizeof(cmd_name));
-	if(udf_is_ambiguous(cmd_name))
-		return CMDS_ERR_UDF_IS_AMBIGUOUS;
-
-	cur = find_cmd(cmd_name);
-	if(cur == NULL)
-		return CMDS_ERR_INVALID_CMD;
-
-	args = parse_tail(cur, cmd, &cmd_info);
-
-	cmd_info.raw_args = strdup(args);
-
-	/* Set background flag and remove background mark from raw arguments, when
-	 * command supports backgrounding. */
-	last_arg = get_last_argument(cmd_info.raw_args, cur->quote, &last_arg_len);
-	if(cur->bg && *last_arg == '&' && *vle_cmds_at_arg(last_arg + 1) == '\0')
-	{
-		cmd_info.bg = 1;
-		*last_arg = '\0';
-	}
+	execution_code = parse_line(cmd, &cmd_info, &cur);
+	if(execution_code != 0)
+		return execution_code;
 
 	if(cur->select)
 	{
@@ -265,9 +285,7 @@ execute_cmd(const char cmd[])
 		cmd_info.args = strdup(cmd_info.raw_args);
 	}
 
-	cmd_info.argv = dispatch_line(cmd_info.args, &cmd_info.argc, cmd_info.sep,
-			cur->regexp, cur->quote, cur->noescaping, cur->comment, NULL,
-			&cmd_info.argvp);
+	dispatch_args(cmd, cur, &cmd_info);
 	if(cmd_info.argc > 0)
 	{
 		last_end = cmd_info.argvp[cmd_info.argc - 1][1];
@@ -333,6 +351,248 @@ execute_cmd(const char cmd[])
 	return execution_code;
 }
 
+/* Parses command name, flags and raw arguments of command-line that follows
+ * range.  Results are taken from or put into the cache of parsed lines.  Sets
+ * *cmd_out on success.  Returns zero or one of CMDS_ERR_* codes. */
+static int
+parse_line(const char cmd[], cmd_info_t *cmd_info, cmd_t **cmd_out)
+{
+	char cmd_name[MAX_CMD_NAME_LEN];
+	cmd_t *cur;
+	const char *args;
+	size_t last_arg_len;
+	char *last_arg;
+	const parsed_line_t *const line = find_line(cmd);
+
+	if(line != NULL)
+	{
+		cmd_info->emark = line->emark;
+		cmd_info->qmark = line->qmark;
+		cmd_info->bg = line->bg;
+		cmd_info->sep = line->sep;
+		cmd_info->raw_args = strdup(line->raw_args);
+		*cmd_out = line->cmd;
+		return 0;
+	}
+
+	args = get_cmd_name(cmd, cmd_name, sizeof(cmd_name));
+	if(udf_is_ambiguous(cmd_name))
+		return CMDS_ERR_UDF_IS_AMBIGUOUS;
+
+	cur = find_cmd(cmd_name);
+	if(cur == NULL)
+		return CMDS_ERR_INVALID_CMD;
+
+	args = parse_tail(cur, args, cmd_info);
+
+	cmd_info->raw_args = strdup(args);
+
+	/* Set background flag and remove background mark from raw arguments, when
+	 * command supports backgrounding. */
+	last_arg = get_last_argument(cmd_info->raw_args, cur->quote, &last_arg_len);
+	if(cur->bg && *last_arg == '&' && *vle_cmds_at_arg(last_arg + 1) == '\0')
+	{
+		cmd_info->bg = 1;
+		*last_arg = '\0';
+	}
+
+	cache_line(cmd, cur, cmd_info);
+
+	*cmd_out = cur;
+	return 0;
+}
+
+/* Splits arguments of the command into argv and argvp fields of *cmd_info
+ * reusing result of previous call for the same line when arguments match.
+ * line is the key under which command-line was cached by parse_line(). */
+static void
+dispatch_args(const char line[], cmd_t *cur, cmd_info_t *cmd_info)
+{
+	/* The line is looked up anew, because callbacks that expand arguments could
+	 * have executed other commands and changed the cache. */
+	parsed_line_t *const parsed = find_line(line);
+
+	if(parsed != NULL && parsed->args != NULL &&
+			strcmp(parsed->args, cmd_info->args) == 0 &&
+			copy_args(parsed, cmd_info) == 0)
+	{
+		return;
+	}
+
+	cmd_info->argv = dispatch_line(cmd_info->args, &cmd_info->argc,
+			cmd_info->sep, cur->regexp, cur->quote, cur->noescaping, cur->comment,
+			NULL, &cmd_info->argvp);
+
+	if(parsed != NULL)
+	{
+		cache_args(parsed, cmd_info);
+	}
+}
+
+/* Looks up parsed command-line in the cache.  Returns the entry or NULL. */
+static parsed_line_t *
+find_line(const char text[])
+{
+	const size_t hash = hash_str(text);
+	parsed_line_t *const line = &inner->lines[hash & (LINE_CACHE_SIZE - 1U)];
+
+	if(line->text != NULL && line->hash == hash && strcmp(line->text, text) == 0)
+	{
+		return line;
+	}
+	return NULL;
+}
+
+/* Stores result of parsing command-line in the cache replacing any other line
+ * that occupies the slot.  Failure to store is not an error. */
+static void
+cache_line(const char text[], cmd_t *cmd, const cmd_info_t *cmd_info)
+{
+	const size_t hash = hash_str(text);
+	parsed_line_t *const line = &inner->lines[hash & (LINE_CACHE_SIZE - 1U)];
+
+	free_line(line);
+
+	if(cmd_info->raw_args == NULL)
+	{
+		return;
+	}
+
+	line->text = strdup(text);
+	line->raw_args = strdup(cmd_info->raw_args);
+	if(line->text == NULL || line->raw_args == NULL)
+	{
+		free_line(line);
+		return;
+	}
+
+	line->hash = hash;
+	line->cmd = cmd;
+	line->emark = cmd_info->emark;
+	line->qmark = cmd_info->qmark;
+	line->bg = cmd_info->bg;
+	line->sep = cmd_info->sep;
+}
+
+/* Remembers dispatched arguments of the line replacing previous ones.  Failure
+ * to store is not an error. */
+static void
+cache_args(parsed_line_t *line, const cmd_info_t *cmd_info)
+{
+	char **argv;
+	int (*argvp)[2];
+
+	free(line->args);
+	free_string_array(line->argv, line->argc);
+	free(line->argvp);
+	line->args = NULL;
+	line->argc = 0;
+	line->argv = NULL;
+	line->argvp = NULL;
+
+	if(dup_args(cmd_info->argc, cmd_info->argv, cmd_info->argvp, &argv,
+				&argvp) != 0)
+	{
+		return;
+	}
+
+	line->args = strdup(cmd_info->args);
+	if(line->args == NULL)
+	{
+		free_string_array(argv, cmd_info->argc);
+		free(argvp);
+		return;
+	}
+
+	line->argc = cmd_info->argc;
+	line->argv = argv;
+	line->argvp = argvp;
+}
+
+/* Fills argc, argv and argvp fields of *cmd_info from cached line.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+copy_args(const parsed_line_t *line, cmd_info_t *cmd_info)
+{
+	cmd_info->argc = line->argc;
+	return dup_args(line->argc, line->argv, line->argvp, &cmd_info->argv,
+			&cmd_info->argvp);
+}
+
+/* Duplicates result of dispatch_line().  Sets *new_argv and *new_argvp.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+dup_args(int argc, char *argv[], int (*argvp)[2], char ***new_argv,
+		int (**new_argvp)[2])
+{
+	int i;
+
+	*new_argv = NULL;
+	*new_argvp = NULL;
+	if(argc <= 0)
+	{
+		return 0;
+	}
+
+	*new_argv = reallocarray(NULL, argc + 1, sizeof(**new_argv));
+	*new_argvp = reallocarray(NULL, argc, sizeof(**new_argvp));
+	if(*new_argv == NULL || *new_argvp == NULL)
+	{
+		free(*new_argv);
+		free(*new_argvp);
+		return 1;
+	}
+
+	for(i = 0; i < argc; ++i)
+	{
+		(*new_argv)[i] = strdup(argv[i]);
+		if((*new_argv)[i] == NULL)
+		{
+			free_string_array(*new_argv, i);
+			free(*new_argvp);
+			return 1;
+		}
+	}
+	(*new_argv)[argc] = NULL;
+
+	memcpy(*new_argvp, argvp, sizeof(**new_argvp)*argc);
+	return 0;
+}
+
+/* Frees resources of cached line and marks its slot as unused. */
+static void
+free_line(parsed_line_t *line)
+{
+	free(line->text);
+	free(line->raw_args);
+	free(line->args);
+	free_string_array(line->argv, line->argc);
+	free(line->argvp);
+
+	line->text = NULL;
+	line->raw_args = NULL;
+	line->args = NULL;
+	line->argc = 0;
+	line->argv = NULL;
+	line->argvp = NULL;
+}
+
+/* Drops lookup structures that depend on the list of commands.  Must be called
+ * after every change of the list. */
+static void
+commands_changed(void)
+{
+	size_t i;
+
+	trie_free(inner->names);
+	inner->names = NULL;
+
+	for(i = 0U; i < ARRAY_LEN(inner->lines); ++i)
+	{
+		free_line(&inner->lines[i]);
+	}
+}
+
 /* Applies limit shifts and ensures that its value is not out of bounds.
  * Returns pointer to part of string after parsed piece. */
 static const char *
@@ -378,6 +638,13 @@ udf_is_ambiguous(const char name[])
 	size_t len;
 	int count;
 	cmd_t *cur;
+	void *data;
+
+	/* Exact match is never ambiguous. */
+	if(trie_get(get_names(), name, &data) == 0)
+	{
+		return 0;
+	}
 
 	len = strlen(name);
 	count = 0;
@@ -581,10 +848,18 @@ skip_prefix_commands(const char cmd[])
 	return cmd;
 }
 
+/* Finds command by its full name or by prefix of a name.  Returns the command
+ * or NULL. */
 static cmd_t *
 find_cmd(const char name[])
 {
 	cmd_t *cmd;
+	void *data;
+
+	if(trie_get(get_names(), name, &data) == 0)
+	{
+		return data;
+	}
 
 	cmd = inner->head.next;
 	while(cmd != NULL && strcmp(cmd->name, name) < 0)
@@ -600,6 +875,31 @@ find_cmd(const char name[])
 	return cmd;
 }
 
+/* Retrieves index of full names of commands building it if necessary.  Returns
+ * the index, which is NULL on failure to build it. */
+static trie_t *
+get_names(void)
+{
+	cmd_t *cmd;
+
+	if(inner->names != NULL)
+	{
+		return inner->names;
+	}
+
+	inner->names = trie_create();
+	for(cmd = inner->head.next; cmd != NULL; cmd = cmd->next)
+	{
+		if(trie_set(inner->names, cmd->name, cmd) < 0)
+		{
+			trie_free(inner->names);
+			inner->names = NULL;
+			break;
+		}
+	}
+	return inner->names;
+}
+
 /* Parses whole command range (e.g. "<val>;+<val>,,-<val>").  Returns advanced
  * value of cmd when parsing is successful, otherwise NULL is returned. */
 static const char *
@@ -942,6 +1242,7 @@ add_builtin_cmd(const char name[], int abbr, const cmd_add_t *conf)
 	new->max_args = conf->max_args;
 	init_command_flags(new, conf->flags);
 
+	commands_changed();
 	return 0;
 }
 
@@ -967,6 +1268,7 @@ comclear_cmd(const cmd_info_t *cmd_info)
 		}
 	}
 	inner->udf_count = 0;
+	commands_changed();
 	return 0;
 }
 
@@ -1048,6 +1350,7 @@ command_cmd(const cmd_info_t *cmd_info)
 	init_command_flags(new, inner->user_cmd_handler.flags);
 
 	++inner->udf_count;
+	commands_changed();
 	return 0;
 }
 
@@ -1157,6 +1460,7 @@ delcommand_cmd(const cmd_info_t *cmd_info)
 	free(cmd);
 
 	inner->udf_count--;
+	commands_changed();
 	return 0;
 }
 
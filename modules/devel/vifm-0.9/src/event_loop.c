@@ -20,13 +20,17 @@
 #include "event_loop.h"
 
 #include <curses.h>
+#include <fcntl.h> /* FD_CLOEXEC F_GETFL F_SETFD F_SETFL O_NONBLOCK fcntl() */
 #include <unistd.h>
 
 #include <assert.h> /* assert() */
+#include <errno.h> /* errno */
 #include <signal.h> /* signal() */
 #include <stddef.h> /* NULL size_t wchar_t */
+#include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* free() */
 #include <string.h> /* memmove() strncpy() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() */
 #include <wchar.h> /* wint_t wcslen() wcscmp() */
 
 #include "cfg/config.h"
@@ -44,6 +48,7 @@
 #include "ui/ui.h"
 #include "utils/log.h"
 #include "utils/macros.h"
+#include "utils/selector.h"
 #include "utils/test_helpers.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
@@ -56,7 +61,14 @@
 #include "vifm.h"
 
 static int ensure_term_is_ready(void);
+static int setup_wake_pipe(void);
 static int get_char_async_loop(WINDOW *win, wint_t *c, int timeout);
+static int get_char_polling_loop(WINDOW *win, wint_t *c, int timeout);
+static int get_char_waiting_loop(WINDOW *win, wint_t *c, int timeout);
+static int get_char(WINDOW *win, wint_t *c);
+static int watch_view(FileView *view);
+static void drain_wake_pipe(void);
+static uint64_t get_ms_time(void);
 static void process_scheduled_updates(void);
 TSTATIC int process_scheduled_updates_of_view(FileView *view);
 static void update_hardware_cursor(void);
@@ -80,6 +92,70 @@ static const size_t *curr_input_buf_pos;
 /* Whether suggestion box is active. */
 static int suggestions_are_visible;
 
+/* Set of descriptors to wait on or NULL if waiting on them isn't supported. */
+static selector_t *selector;
+/* Pipe that interrupts waiting, 0 is read end and 1 is write end. */
+static int wake_pipe[2] = { -1, -1 };
+
+void
+event_loop_init(void)
+{
+#ifdef __PDCURSES__
+	/* Input doesn't come from a descriptor. */
+	return;
+#endif
+
+	if(setup_wake_pipe() != 0)
+	{
+		return;
+	}
+
+	selector = selector_alloc(0);
+	if(selector == NULL)
+	{
+		close(wake_pipe[0]);
+		close(wake_pipe[1]);
+		wake_pipe[0] = -1;
+		wake_pipe[1] = -1;
+	}
+}
+
+/* Creates pipe that doesn't block and isn't inherited by child processes.
+ * Returns zero on success and non-zero otherwise. */
+static int
+setup_wake_pipe(void)
+{
+#ifndef _WIN32
+	int i;
+
+	if(pipe(wake_pipe) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Failed to create wake up pipe");
+		wake_pipe[0] = -1;
+		wake_pipe[1] = -1;
+		return 1;
+	}
+
+	for(i = 0; i < 2; ++i)
+	{
+		const int flags = fcntl(wake_pipe[i], F_GETFL);
+		if(flags == -1 || fcntl(wake_pipe[i], F_SETFL, flags | O_NONBLOCK) == -1 ||
+				fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC) == -1)
+		{
+			LOG_SERROR_MSG(errno, "Failed to setup wake up pipe");
+			close(wake_pipe[0]);
+			close(wake_pipe[1]);
+			wake_pipe[0] = -1;
+			wake_pipe[1] = -1;
+			return 1;
+		}
+	}
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 void
 event_loop(const int *quit)
 {
@@ -118,9 +194,9 @@ event_loop(const int *quit)
 		 * waiting for the next key after timeout. */
 		do
 		{
-			const int actual_timeout = wait_for_suggestion
-			                         ? MIN(timeout, cfg.sug.delay)
-			                         : timeout;
+			int actual_timeout = wait_for_suggestion
+			                   ? MIN(timeout, cfg.sug.delay)
+			                   : timeout;
 
 			if(!ensure_term_is_ready())
 			{
@@ -132,6 +208,15 @@ event_loop(const int *quit)
 
 			bg_check();
 
+			/* Timing out changes nothing in this state, so there is no need to wake
+			 * up unless something needs regular checks. */
+			if(!wait_for_suggestion &&
+					(input_buf_pos == 0 || last_result == KEYS_WAIT) &&
+					!modes_periodic_is_needed())
+			{
+				actual_timeout = -1;
+			}
+
 			got_input = (get_char_async_loop(status_bar, &c, actual_timeout) != ERR);
 
 			/* If suggestion delay timed out, reset it and wait the rest of the
@@ -333,10 +418,26 @@ ensure_term_is_ready(void)
  *  - checks for new IPC messages;
  *  - checks whether contents of displayed directories changed;
  *  - redraws UI if requested.
- * Returns KEY_CODE_YES for functional keys (preprocesses *c in this case), OK
- * for wide character and ERR otherwise (e.g. after timeout). */
+ * Negative timeout means waiting until input or some other event.  Returns
+ * KEY_CODE_YES for functional keys (preprocesses *c in this case), OK for wide
+ * character and ERR otherwise (e.g. after timeout). */
 static int
 get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
+{
+	if(selector == NULL)
+	{
+		/* There is no way to tell when something happens, so polling is the only
+		 * option. */
+		return get_char_polling_loop(win, c, timeout < 0 ? cfg.timeout_len
+		                                                 : timeout);
+	}
+	return get_char_waiting_loop(win, c, timeout);
+}
+
+/* Implementation of get_char_async_loop() that checks for events periodically.
+ * Returns the same values as get_char_async_loop(). */
+static int
+get_char_polling_loop(WINDOW *win, wint_t *c, int timeout)
 {
 	const int IPC_F = ipc_enabled() ? 10 : 1;
 
@@ -366,25 +467,9 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 			wtimeout(win, delay_slice);
 			timeout -= delay_slice;
 
-			if(suggestions_are_visible)
-			{
-				/* Redraw suggestion box as it might have been hidden due to other
-				 * redraws. */
-				display_suggestion_box(curr_input_buf);
-			}
-
-			/* Update cursor before waiting for input.  Modes set cursor correctly
-			 * within corresponding windows, but we need to call refresh on one of
-			 * them to make it active. */
-			update_hardware_cursor();
-
-			result = compat_wget_wch(win, c);
+			result = get_char(win, c);
 			if(result != ERR)
 			{
-				if(result == KEY_CODE_YES)
-				{
-					*c = K(*c);
-				}
 				return result;
 			}
 
@@ -396,6 +481,169 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 	return ERR;
 }
 
+/* Implementation of get_char_async_loop() that sleeps until terminal, IPC,
+ * watched directories or wake up pipe have something to report.  Falls back to
+ * periodic checks only for directories that can't be watched and while IPC
+ * clients are connected.  Returns the same values as get_char_async_loop(). */
+static int
+get_char_waiting_loop(WINDOW *win, wint_t *c, int timeout)
+{
+	const uint64_t start = get_ms_time();
+
+	while(1)
+	{
+		int result;
+		int wait_time;
+		int need_polling;
+		int woken_up;
+
+		ipc_check();
+
+		if(should_check_views_for_changes())
+		{
+			check_view_for_changes(curr_view);
+			check_view_for_changes(other_view);
+		}
+
+		process_scheduled_updates();
+
+		if(timeout == 0)
+		{
+			return ERR;
+		}
+
+		wtimeout(win, 0);
+		result = get_char(win, c);
+		if(result != ERR)
+		{
+			return result;
+		}
+
+		wait_time = -1;
+		if(timeout > 0)
+		{
+			const uint64_t elapsed = get_ms_time() - start;
+			if(elapsed >= (uint64_t)timeout)
+			{
+				return ERR;
+			}
+			wait_time = timeout - (int)elapsed;
+		}
+
+		selector_reset(selector);
+		(void)selector_add(selector, STDIN_FILENO, SEL_READ);
+		(void)selector_add(selector, wake_pipe[0], SEL_READ);
+
+		need_polling = ipc_watch(selector);
+		if(should_check_views_for_changes())
+		{
+			need_polling |= watch_view(curr_view);
+			need_polling |= watch_view(other_view);
+		}
+		if(need_polling && (wait_time < 0 || wait_time > cfg.min_timeout_len))
+		{
+			wait_time = cfg.min_timeout_len;
+		}
+
+		woken_up = selector_wait(selector, wait_time);
+		if(woken_up && selector_is_ready(selector, wake_pipe[0]))
+		{
+			drain_wake_pipe();
+		}
+
+		/* Let the caller re-evaluate its state as events might have changed what
+		 * it needs to wait for. */
+		if(timeout < 0 && woken_up && !selector_is_ready(selector, STDIN_FILENO))
+		{
+			/* Process whatever woke us up before returning. */
+			ipc_check();
+			process_scheduled_updates();
+			return ERR;
+		}
+	}
+}
+
+/* Reads character from the window using its current timeout.  Returns the same
+ * values as get_char_async_loop(). */
+static int
+get_char(WINDOW *win, wint_t *c)
+{
+	int result;
+
+	if(suggestions_are_visible)
+	{
+		/* Redraw suggestion box as it might have been hidden due to other
+		 * redraws. */
+		display_suggestion_box(curr_input_buf);
+	}
+
+	/* Update cursor before waiting for input.  Modes set cursor correctly
+	 * within corresponding windows, but we need to call refresh on one of
+	 * them to make it active. */
+	update_hardware_cursor();
+
+	result = compat_wget_wch(win, c);
+	if(result == KEY_CODE_YES)
+	{
+		*c = K(*c);
+	}
+	return result;
+}
+
+/* Adds descriptor reporting changes of the view to the selector.  Returns
+ * non-zero if the view needs to be checked periodically. */
+static int
+watch_view(FileView *view)
+{
+	return window_shows_dirlist(view) && flist_watch(view, selector);
+}
+
+/* Empties wake up pipe. */
+static void
+drain_wake_pipe(void)
+{
+#ifndef _WIN32
+	char buf[64];
+	while(read(wake_pipe[0], buf, sizeof(buf)) > 0)
+	{
+		/* Do nothing. */
+	}
+#endif
+}
+
+void
+event_loop_wake(void)
+{
+#ifndef _WIN32
+	if(wake_pipe[1] != -1)
+	{
+		/* Signal handlers shouldn't change errno. */
+		const int saved_errno = errno;
+		const char c = '\0';
+		/* Pipe being full is fine, there is a pending wake up already. */
+		if(write(wake_pipe[1], &c, 1U) < 0)
+		{
+			/* Do nothing. */
+		}
+		errno = saved_errno;
+	}
+#endif
+}
+
+/* Retrieves current time of a monotonic clock.  Returns the time in
+ * milliseconds. */
+static uint64_t
+get_ms_time(void)
+{
+#ifndef _WIN32
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000ULL + ts.tv_nsec/1000000;
+#else
+	return 0U;
+#endif
+}
+
 /* Updates TUI or its elements if something is scheduled. */
 static void
 process_scheduled_updates(void)
@@ -629,6 +877,7 @@ prepare_suggestion_box(int *height)
 	{
 		win = other_view->win;
 		*height = MIN(count, getmaxy(win));
+		fview_reset_cells(other_view);
 	}
 	else
 	{
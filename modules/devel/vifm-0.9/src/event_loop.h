@@ -22,11 +22,19 @@
 
 #include "utils/test_helpers.h"
 
+/* Prepares means of waiting for events, should be called before any threads
+ * are started or signal handlers are installed. */
+void event_loop_init(void);
+
 /* Everything is driven from this function with the exception of signals which
  * are handled in signals.c.  It is reentrant so remote pieces of code can run
  * nested event loops. */
 void event_loop(const int *quit);
 
+/* Makes event loop process scheduled updates if it's waiting for events at the
+ * moment.  Can be called from other threads and signal handlers. */
+void event_loop_wake(void);
+
 void update_input_buf(void);
 
 int is_input_buf_empty(void);
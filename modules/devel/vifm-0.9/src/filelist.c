@@ -28,10 +28,11 @@
 
 #include <curses.h>
 
-#include <sys/stat.h> /* stat */
+#include <sys/stat.h> /* stat S_ISDIR() S_ISLNK() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
+#include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* intptr_t uint64_t */
 #include <stdio.h> /* snprintf() */
@@ -56,7 +57,10 @@
 #include "utils/env.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
+#include "utils/fslister.h"
+#include "utils/fsprefetch.h"
 #include "utils/fswatch.h"
+#include "utils/intern.h"
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/path.h"
@@ -64,6 +68,7 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/trace.h"
 #include "utils/trie.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
@@ -79,22 +84,42 @@
 #include "status.h"
 #include "types.h"
 
+/* Number of threads that read directories while tree is being built. */
+#define TREE_LISTING_THREADS 4
+
+/* What to do with a file while building a tree. */
+typedef enum
+{
+	TA_EXCLUDE,  /* Ignore the file. */
+	TA_FILTER,   /* Count the file as filtered out. */
+	TA_DESCEND,  /* Filter out the file, but look for files inside of it. */
+	TA_ADD,      /* Add the file. */
+	TA_ADD_TREE, /* Add the file along with files inside of it. */
+}
+TreeAction;
+
 static void init_view(FileView *view);
 static void init_flist(FileView *view);
 static void reset_view(FileView *view);
 static void init_view_history(FileView *view);
 static int navigate_to_file_in_custom_view(FileView *view, const char dir[],
 		const char file[]);
-static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
+static int fill_dir_entry_by_path(const FileView *view, dir_entry_t *entry,
+		const char path[]);
 #ifndef _WIN32
-static int fill_dir_entry(dir_entry_t *entry, const char path[],
-		const struct dirent *d);
+static int fill_dir_entry(const FileView *view, dir_entry_t *entry,
+		const char path[], const struct dirent *d);
+static int fill_dir_entry_by_stat(const FileView *view, dir_entry_t *entry,
+		const char path[], const struct stat *s, FileType fallback_type);
 static int data_is_dir_entry(const struct dirent *d);
+static int add_prefetched_entry(FileView *view,
+		const fsprefetch_entry_t *prefetched);
 #else
-static int fill_dir_entry(dir_entry_t *entry, const char path[],
-		const WIN32_FIND_DATAW *ffd);
+static int fill_dir_entry(const FileView *view, dir_entry_t *entry,
+		const char path[], const WIN32_FIND_DATAW *ffd);
 static int data_is_dir_entry(const WIN32_FIND_DATAW *ffd);
 #endif
+static int add_prefetched_entries(FileView *view, fsprefetch_t *prefetch);
 static int flist_custom_finish_internal(FileView *view, CVType type, int reload,
 		const char dir[], int allow_empty);
 static void on_location_change(FileView *view, int force);
@@ -114,14 +139,15 @@ static int entry_exists(FileView *view, const dir_entry_t *entry, void *arg);
 static void zap_compare_view(FileView *view, FileView *other, zap_filter filter,
 		void *arg);
 static int find_separator(FileView *view, int idx);
-static int update_dir_watcher(FileView *view);
+static int update_dir_watcher(FileView *view, int keep_events);
 static int custom_list_is_incomplete(const FileView *view);
 static int is_dead_or_filtered(FileView *view, const dir_entry_t *entry,
 		void *arg);
 static void update_entries_data(FileView *view);
 static int is_dir_big(const char path[]);
 static void free_view_entries(FileView *view);
-static int update_dir_list(FileView *view, int reload);
+static int update_dir_list(FileView *view, int reload,
+		fsprefetch_t *prefetch);
 static void start_dir_list_change(FileView *view, dir_entry_t **entries,
 		int *len, int reload);
 static void finish_dir_list_change(FileView *view, dir_entry_t *entries,
@@ -139,6 +165,7 @@ static int rescue_from_empty_filelist(FileView *view);
 static void init_dir_entry(FileView *view, dir_entry_t *entry,
 		const char name[]);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
+static int is_watched(const FileView *view);
 static int tree_has_changed(const dir_entry_t *entries, size_t nchildren);
 TSTATIC void pick_cd_path(FileView *view, const char base_dir[],
 		const char path[], int *updir, char buf[], size_t buf_size);
@@ -152,11 +179,17 @@ static int iter_entries(FileView *view, dir_entry_t **entry,
 static void clear_marking(FileView *view);
 static int set_position_by_path(FileView *view, const char path[]);
 static int flist_load_tree_internal(FileView *view, const char path[],
-		int reload);
-static int make_tree(FileView *view, const char path[], int reload,
+		int depth, int reload);
+static int make_tree(FileView *view, const char path[], int depth, int reload,
 		trie_t *excluded_paths);
-static int add_files_recursively(FileView *view, const char path[],
-		trie_t *excluded_paths, int parent_pos, int no_direct_parent);
+static int add_files_recursively(FileView *view, fslister_t *lister,
+		fslister_req_t *req, const char path[], trie_t *excluded_paths,
+		int parent_pos, int no_direct_parent, int depth);
+static dir_entry_t * add_listed_file(FileView *view, const char path[],
+		const fslister_entry_t *listed);
+static TreeAction get_tree_action(FileView *view, const char path[],
+		const fslister_entry_t *entry, trie_t *excluded_paths, int depth);
+static int tree_action_descends(TreeAction action);
 static int file_is_visible(FileView *view, const char filename[], int is_dir,
 		const void *data, int apply_local_filter);
 static int add_directory_leaf(FileView *view, const char path[],
@@ -278,6 +311,38 @@ load_initial_directory(FileView *view, const char dir[])
 	}
 }
 
+void
+flist_prefetch(FileView *view)
+{
+	flist_prefetch_discard(view);
+	if(!flist_custom_active(view))
+	{
+		/* Watcher is set up before directory is read, so that changes made while
+		 * it's being read aren't missed. */
+		(void)update_dir_watcher(view, 0);
+		view->prefetch = fsprefetch_start(view->curr_dir);
+	}
+}
+
+void
+flist_prefetch_finish(FileView *view)
+{
+	if(view->load_postponed)
+	{
+		/* This load waits for the listing instead of postponing itself again. */
+		load_dir_list(view, view->postponed_load_reload);
+	}
+	flist_prefetch_discard(view);
+}
+
+void
+flist_prefetch_discard(FileView *view)
+{
+	fsprefetch_free(view->prefetch);
+	view->prefetch = NULL;
+	view->load_postponed = 0;
+}
+
 dir_entry_t *
 get_current_entry(const FileView *view)
 {
@@ -762,7 +827,7 @@ flist_custom_add_separator(FileView *view, int id)
 	if(dir_entry != NULL)
 	{
 		init_dir_entry(view, dir_entry, "");
-		dir_entry->origin = strdup(flist_get_dir(view));
+		dir_entry->origin = intern_str(flist_get_dir(view));
 		dir_entry->id = id;
 		++view->custom.entry_count;
 	}
@@ -770,19 +835,21 @@ flist_custom_add_separator(FileView *view, int id)
 
 #ifndef _WIN32
 
-/* Fills directory entry with information about file specified by the path.
- * Returns non-zero on error, otherwise zero is returned. */
+/* Fills directory entry of the view with information about file specified by
+ * the path.  Returns non-zero on error, otherwise zero is returned. */
 static int
-fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
+fill_dir_entry_by_path(const FileView *view, dir_entry_t *entry,
+		const char path[])
 {
-	return fill_dir_entry(entry, path, NULL);
+	return fill_dir_entry(view, entry, path, NULL);
 }
 
-/* Fills fields of the entry from stat information of the file specified by its
- * path.  d is optional source of file type.  Returns zero on success, otherwise
- * non-zero is returned. */
+/* Fills fields of the entry of the view from stat information of the file
+ * specified by its path.  d is optional source of file type.  Returns zero on
+ * success, otherwise non-zero is returned. */
 static int
-fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
+fill_dir_entry(const FileView *view, dir_entry_t *entry, const char path[],
+		const struct dirent *d)
 {
 	struct stat s;
 
@@ -793,10 +860,21 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		return 1;
 	}
 
-	entry->type = get_type_from_mode(s.st_mode);
+	return fill_dir_entry_by_stat(view, entry, path, &s,
+			(d == NULL) ? FT_UNK : type_from_dir_entry(d));
+}
+
+/* Fills fields of the entry of the view from result of lstat() on the file
+ * specified by its path.  fallback_type is used if mode doesn't define type of
+ * the file.  Returns zero on success, otherwise non-zero is returned. */
+static int
+fill_dir_entry_by_stat(const FileView *view, dir_entry_t *entry,
+		const char path[], const struct stat *s, FileType fallback_type)
+{
+	entry->type = get_type_from_mode(s->st_mode);
 	if(entry->type == FT_UNK)
 	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d);
+		entry->type = fallback_type;
 	}
 	if(entry->type == FT_UNK)
 	{
@@ -804,14 +882,14 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		return 1;
 	}
 
-	entry->size = (uintmax_t)s.st_size;
-	entry->mode = s.st_mode;
-	entry->uid = s.st_uid;
-	entry->gid = s.st_gid;
-	entry->mtime = s.st_mtime;
-	entry->atime = s.st_atime;
-	entry->ctime = s.st_ctime;
-	entry->nlinks = s.st_nlink;
+	entry->size = (uintmax_t)s->st_size;
+	entry->mode = s->st_mode;
+	entry->uid = s->st_uid;
+	entry->gid = s->st_gid;
+	entry->mtime = s->st_mtime;
+	entry->atime = s->st_atime;
+	entry->ctime = s->st_ctime;
+	entry->nlinks = s->st_nlink;
 
 	if(entry->type == FT_LINK)
 	{
@@ -819,11 +897,20 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 
 		const SymLinkType symlink_type = get_symlink_type(path);
 		entry->dir_link = (symlink_type != SLT_UNKNOWN);
+		entry->broken_link = 0;
 
-		/* Query mode of symbolic link target. */
-		if(symlink_type != SLT_SLOW && os_stat(entry->name, &s) == 0)
+		/* Query mode of symbolic link target.  Targets on slow file systems are
+		 * assumed to exist as actual check might take long time. */
+		if(symlink_type != SLT_SLOW)
 		{
-			entry->mode = s.st_mode;
+			if(os_stat(path, &s) == 0)
+			{
+				entry->mode = s.st_mode;
+			}
+			else
+			{
+				entry->broken_link = !view->on_slow_fs;
+			}
 		}
 	}
 
@@ -838,12 +925,87 @@ data_is_dir_entry(const struct dirent *d)
 	return is_dirent_targets_dir(d);
 }
 
+/* Fills file list of the view with listing that was read ahead of time.  Takes
+ * ownership of the prefetch.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+add_prefetched_entries(FileView *view, fsprefetch_t *prefetch)
+{
+	int i, count;
+	fsprefetch_entry_t *entries;
+
+	if(stroscmp(fsprefetch_get_path(prefetch), view->curr_dir) != 0)
+	{
+		fsprefetch_free(prefetch);
+		return 1;
+	}
+
+	entries = fsprefetch_take(prefetch, &count);
+	if(count < 0)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		if(add_prefetched_entry(view, &entries[i]) != 0)
+		{
+			break;
+		}
+	}
+
+	fsprefetch_free_entries(entries, count);
+	return 0;
+}
+
+/* Appends file that was read ahead of time to file list of the view.  Returns
+ * zero on success or non-zero to indicate failure. */
+static int
+add_prefetched_entry(FileView *view, const fsprefetch_entry_t *prefetched)
+{
+	dir_entry_t *entry;
+	const mode_t mode = prefetched->info.st_mode;
+	/* Working directory is the directory of the view, so relative name is
+	 * enough. */
+	const int is_dir = S_ISDIR(mode)
+	                || (S_ISLNK(mode) &&
+	                    get_symlink_type(prefetched->name) != SLT_UNKNOWN);
+
+	if(!file_is_visible(view, prefetched->name, is_dir, NULL, 1))
+	{
+		++view->filtered;
+		return 0;
+	}
+
+	entry = alloc_dir_entry(&view->dir_entry, view->list_rows);
+	if(entry == NULL)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return 1;
+	}
+
+	init_dir_entry(view, entry, prefetched->name);
+
+	if(fill_dir_entry_by_stat(view, entry, entry->name, &prefetched->info,
+				FT_UNK) == 0)
+	{
+		++view->list_rows;
+	}
+	else
+	{
+		fentry_free(view, entry);
+	}
+
+	return 0;
+}
+
 #else
 
 /* Fills directory entry with information about file specified by the path.
  * Returns non-zero on error, otherwise zero is returned. */
 static int
-fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
+fill_dir_entry_by_path(const FileView *view, dir_entry_t *entry,
+		const char path[])
 {
 	wchar_t *utf16_path;
 	HANDLE hfind;
@@ -858,7 +1020,7 @@ fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
 		return 1;
 	}
 
-	fill_dir_entry(entry, path, &ffd);
+	fill_dir_entry(view, entry, path, &ffd);
 
 	FindClose(hfind);
 
@@ -869,7 +1031,7 @@ fill_dir_entry_by_path(dir_entry_t *entry, const char path[])
  * path.  type_hint is additional source of file type.  Returns zero on success,
  * Returns zero on success, otherwise non-zero is returned. */
 static int
-fill_dir_entry(dir_entry_t *entry, const char path[],
+fill_dir_entry(const FileView *view, dir_entry_t *entry, const char path[],
 		const WIN32_FIND_DATAW *ffd)
 {
 	entry->size = ((uintmax_t)ffd->nFileSizeHigh*(MAXDWORD + 1))
@@ -883,6 +1045,8 @@ fill_dir_entry(dir_entry_t *entry, const char path[],
 	{
 		const SymLinkType symlink_type = get_symlink_type(path);
 		entry->dir_link = (symlink_type != SLT_UNKNOWN);
+		entry->broken_link = !view->on_slow_fs && symlink_type != SLT_SLOW
+		                  && !path_exists(path, DEREF);
 
 		entry->type = FT_LINK;
 	}
@@ -912,6 +1076,15 @@ data_is_dir_entry(const WIN32_FIND_DATAW *ffd)
 	return (ffd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
 }
 
+/* Listings aren't read ahead of time on Windows, so this only frees the
+ * prefetch.  Returns non-zero. */
+static int
+add_prefetched_entries(FileView *view, fsprefetch_t *prefetch)
+{
+	fsprefetch_free(prefetch);
+	return 1;
+}
+
 #endif
 
 int
@@ -955,7 +1128,7 @@ flist_custom_finish_internal(FileView *view, CVType type, int reload,
 		{
 			init_dir_entry(view, dir_entry, "..");
 			dir_entry->type = FT_DIR;
-			dir_entry->origin = strdup(dir);
+			dir_entry->origin = intern_str(dir);
 			++view->custom.entry_count;
 		}
 	}
@@ -1257,7 +1430,7 @@ flist_custom_clone(FileView *to, const FileView *from)
 		}
 		else
 		{
-			dst[j].origin = strdup(dst[j].origin);
+			dst[j].origin = intern_str(dst[j].origin);
 		}
 
 		/* As destination pane won't be a tree, erase tree-specific data, because
@@ -1338,18 +1511,18 @@ uncompress_traverser(const char name[], int valid, const void *parent_data,
 		init_dir_entry(view, dir_entry, name);
 		if(parent_data == NULL)
 		{
-			dir_entry->origin = strdup(flist_get_dir(view));
+			dir_entry->origin = intern_str(flist_get_dir(view));
 		}
 		else
 		{
 			char parent_path[PATH_MAX];
 			const intptr_t *parent_idx = parent_data;
 			get_full_path_at(view, *parent_idx, sizeof(parent_path), parent_path);
-			dir_entry->origin = strdup(parent_path);
+			dir_entry->origin = intern_str(parent_path);
 		}
 
 		get_full_path_of(dir_entry, sizeof(full_path), full_path);
-		fill_dir_entry_by_path(dir_entry, full_path);
+		fill_dir_entry_by_path(view, dir_entry, full_path);
 
 		dir_entry->temporary = 1;
 	}
@@ -1474,7 +1647,9 @@ entry_calc_nitems(const dir_entry_t *entry)
 void
 populate_dir_list(FileView *view, int reload)
 {
+	trace_begin("load_dir_list", flist_get_dir(view));
 	(void)populate_dir_list_internal(view, reload);
+	trace_end();
 }
 
 void
@@ -1490,7 +1665,13 @@ load_dir_list(FileView *view, int reload)
 static void
 load_dir_list_internal(FileView *view, int reload, int draw_only)
 {
-	if(populate_dir_list_internal(view, reload) != 0)
+	int result;
+
+	trace_begin("load_dir_list", flist_get_dir(view));
+	result = populate_dir_list_internal(view, reload);
+	trace_end();
+
+	if(result != 0)
 	{
 		return;
 	}
@@ -1519,14 +1700,22 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 static int
 populate_dir_list_internal(FileView *view, int reload)
 {
+	/* Listing read ahead of time is either used by this load or discarded. */
+	fsprefetch_t *const prefetch = view->prefetch;
+	const int was_postponed = view->load_postponed;
+	view->prefetch = NULL;
+	view->load_postponed = 0;
+
 	view->filtered = 0;
 
 	if(flist_custom_active(view))
 	{
+		fsprefetch_free(prefetch);
 		return populate_custom_view(view, reload);
 	}
 
-	if(!reload && is_dir_big(view->curr_dir))
+	if(!reload && ((prefetch != NULL && !fsprefetch_is_done(prefetch)) ||
+				is_dir_big(view->curr_dir)))
 	{
 		if(!vle_mode_is(CMDLINE_MODE))
 		{
@@ -1534,6 +1723,22 @@ populate_dir_list_internal(FileView *view, int reload)
 		}
 	}
 
+	/* Don't make the first frame wait for the listing, file list is loaded by
+	 * flist_prefetch_finish() after the frame is drawn. */
+	if(curr_stats.load_stage == 2 && !was_postponed && prefetch != NULL &&
+			!fsprefetch_is_done(prefetch) &&
+			stroscmp(fsprefetch_get_path(prefetch), view->curr_dir) == 0)
+	{
+		view->prefetch = prefetch;
+		view->load_postponed = 1;
+		view->postponed_load_reload = reload;
+		if(view->list_rows < 1)
+		{
+			add_parent_dir(view);
+		}
+		return 0;
+	}
+
 	if(curr_stats.load_stage < 2)
 	{
 		update_all_windows();
@@ -1543,11 +1748,13 @@ populate_dir_list_internal(FileView *view, int reload)
 	if(vifm_chdir(view->curr_dir) != 0 && !is_unc_root(view->curr_dir))
 	{
 		LOG_SERROR_MSG(errno, "Can't chdir() into \"%s\"", view->curr_dir);
+		fsprefetch_free(prefetch);
 		return 1;
 	}
 
 	if(is_unc_root(view->curr_dir))
 	{
+		fsprefetch_free(prefetch);
 #ifdef _WIN32
 		free_view_entries(view);
 		if(fill_with_shared(view) == 0)
@@ -1563,7 +1770,7 @@ populate_dir_list_internal(FileView *view, int reload)
 					"Can't load list of shares of %s", view->curr_dir);
 
 			leave_invalid_dir(view);
-			if(update_dir_list(view, reload) != 0)
+			if(update_dir_list(view, reload, NULL) != 0)
 			{
 				/* We don't have read access, only execute, or there were other
 				 * problems. */
@@ -1573,7 +1780,7 @@ populate_dir_list_internal(FileView *view, int reload)
 		}
 #endif
 	}
-	else if(update_dir_list(view, reload) != 0)
+	else if(update_dir_list(view, reload, prefetch) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
@@ -1608,7 +1815,10 @@ populate_dir_list_internal(FileView *view, int reload)
 
 	fview_list_updated(view);
 
-	if(update_dir_watcher(view) != 0 && !is_unc_root(view->curr_dir))
+	/* Events collected since watcher of prefetched directory was set up might
+	 * be about changes the listing doesn't reflect. */
+	if(update_dir_watcher(view, prefetch != NULL) != 0 &&
+			!is_unc_root(view->curr_dir))
 	{
 		LOG_SERROR_MSG(errno, "Can't get directory mtime \"%s\"", view->curr_dir);
 		return 1;
@@ -1627,7 +1837,8 @@ populate_custom_view(FileView *view, int reload)
 		int prev_list_rows, result;
 
 		start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
-		result = flist_load_tree_internal(view, flist_get_dir(view), 1);
+		result = flist_load_tree_internal(view, flist_get_dir(view),
+				view->custom.tree_depth, 1);
 
 		if(view->dir_entry == NULL)
 		{
@@ -1738,6 +1949,7 @@ zap_compare_view(FileView *view, FileView *other, zap_filter filter, void *arg)
 				continue;
 			}
 			replace_string(&entry->name, "");
+			fentry_touch(entry);
 			entry->type = FT_UNK;
 			entry->id = other->dir_entry[i].id;
 		}
@@ -1778,10 +1990,11 @@ find_separator(FileView *view, int idx)
 	return -1;
 }
 
-/* Updates directory watcher of the view.  Returns zero on success, otherwise
- * non-zero is returned. */
+/* Updates directory watcher of the view.  Pending events of the watcher are
+ * dropped unless keep_events is set and the watcher is already in place.
+ * Returns zero on success, otherwise non-zero is returned. */
 static int
-update_dir_watcher(FileView *view)
+update_dir_watcher(FileView *view, int keep_events)
 {
 	int error;
 	const char *const curr_dir = flist_get_dir(view);
@@ -1800,6 +2013,10 @@ update_dir_watcher(FileView *view)
 
 		copy_str(view->watched_dir, sizeof(view->watched_dir), curr_dir);
 	}
+	else if(keep_events)
+	{
+		return 0;
+	}
 
 	(void)fswatch_changed(view->watch, &error);
 
@@ -1866,7 +2083,7 @@ update_entries_data(FileView *view)
 		get_full_path_of(entry, sizeof(full_path), full_path);
 
 		/* Do not care about possible failure, just use previous meta-data. */
-		(void)fill_dir_entry_by_path(entry, full_path);
+		(void)fill_dir_entry_by_path(view, entry, full_path);
 	}
 }
 
@@ -1962,7 +2179,8 @@ zap_entries(FileView *view, dir_entry_t *entries, int *count, zap_filter filter,
 			path = format_str("%s/..", full_path);
 			init_parent_entry(view, &entries[j], path);
 			remove_last_path_component(path);
-			entries[j].origin = path;
+			entries[j].origin = intern_str(path);
+			free(path);
 			entries[j].child_pos = 1;
 
 			/* Since we now adding back one entry, correct increase parent counts and
@@ -2024,17 +2242,19 @@ free_view_entries(FileView *view)
 	free_dir_entries(view, &view->dir_entry, &view->list_rows);
 }
 
-/* Updates file list with files from current directory.  Returns zero on
- * success, otherwise non-zero is returned. */
+/* Updates file list with files from current directory.  Uses and frees listing
+ * that was read ahead of time if prefetch isn't NULL.  Returns zero on success,
+ * otherwise non-zero is returned. */
 static int
-update_dir_list(FileView *view, int reload)
+update_dir_list(FileView *view, int reload, fsprefetch_t *prefetch)
 {
 	dir_entry_t *prev_dir_entries;
 	int prev_list_rows;
 
 	start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
 
-	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
+	if((prefetch == NULL || add_prefetched_entries(view, prefetch) != 0) &&
+			enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
 	{
 		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
 		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
@@ -2123,7 +2343,7 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 
 	init_dir_entry(view, entry, name);
 
-	if(fill_dir_entry(entry, entry->name, data) == 0)
+	if(fill_dir_entry(view, entry, entry->name, data) == 0)
 	{
 		++view->list_rows;
 	}
@@ -2348,6 +2568,7 @@ init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 {
 	entry->name = strdup(name);
 	entry->origin = &view->curr_dir[0];
+	fentry_touch(entry);
 
 	entry->size = 0ULL;
 #ifndef _WIN32
@@ -2364,6 +2585,7 @@ init_dir_entry(FileView *view, dir_entry_t *entry, const char name[])
 
 	entry->type = FT_UNK;
 	entry->dir_link = 0;
+	entry->broken_link = 0;
 	entry->hi_num = -1;
 	entry->name_dec_num = -1;
 
@@ -2401,7 +2623,7 @@ replace_dir_entries(FileView *view, dir_entry_t **entries, int *count,
 		dir_entry_t *const entry = &new[i];
 
 		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
+		entry->origin = intern_str(entry->origin);
 
 		if(entry->name == NULL || entry->origin == NULL)
 		{
@@ -2438,7 +2660,7 @@ fentry_free(const FileView *view, dir_entry_t *entry)
 
 	if(entry->origin != &view->curr_dir[0])
 	{
-		free(entry->origin);
+		intern_free(entry->origin);
 		entry->origin = NULL;
 	}
 }
@@ -2461,6 +2683,7 @@ dir_entry_t *
 entry_list_add(FileView *view, dir_entry_t **list, int *list_size,
 		const char path[])
 {
+	char origin[PATH_MAX];
 	dir_entry_t *const dir_entry = alloc_dir_entry(list, *list_size);
 	if(dir_entry == NULL)
 	{
@@ -2469,10 +2692,11 @@ entry_list_add(FileView *view, dir_entry_t **list, int *list_size,
 
 	init_dir_entry(view, dir_entry, get_last_path_component(path));
 
-	dir_entry->origin = strdup(path);
-	remove_last_path_component(dir_entry->origin);
+	copy_str(origin, sizeof(origin), path);
+	remove_last_path_component(origin);
+	dir_entry->origin = intern_str(origin);
 
-	if(fill_dir_entry_by_path(dir_entry, path) != 0)
+	if(fill_dir_entry_by_path(view, dir_entry, path) != 0)
 	{
 		fentry_free(view, dir_entry);
 		return NULL;
@@ -2503,9 +2727,7 @@ check_if_filelist_have_changed(FileView *view)
 	int failed, changed;
 	const char *const curr_dir = flist_get_dir(view);
 
-	if(view->on_slow_fs ||
-			(flist_custom_active(view) && view->custom.type != CV_TREE) ||
-			is_unc_root(curr_dir))
+	if(!is_watched(view))
 	{
 		return;
 	}
@@ -2514,7 +2736,7 @@ check_if_filelist_have_changed(FileView *view)
 	{
 		/* If watch is not initialized, try to do this, but don't fail on error. */
 
-		(void)update_dir_watcher(view);
+		(void)update_dir_watcher(view, 0);
 		failed = 0;
 		changed = (view->watch != NULL);
 	}
@@ -2553,6 +2775,42 @@ check_if_filelist_have_changed(FileView *view)
 	}
 }
 
+int
+flist_watch(FileView *view, selector_t *selector)
+{
+	int fd;
+
+	if(!is_watched(view))
+	{
+		return 0;
+	}
+
+	if(view->watch == NULL)
+	{
+		/* Creation of the watch is retried on every check. */
+		return 1;
+	}
+
+	fd = fswatch_get_fd(view->watch);
+	if(fd == -1 || selector_add(selector, fd, SEL_READ) != 0)
+	{
+		return 1;
+	}
+
+	/* Subdirectories of a tree are not watched. */
+	return (flist_custom_active(view) && view->custom.type == CV_TREE);
+}
+
+/* Checks whether the view is checked for changes of its directory.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_watched(const FileView *view)
+{
+	return !view->on_slow_fs
+	    && (!flist_custom_active(view) || view->custom.type == CV_TREE)
+	    && !is_unc_root(flist_get_dir(view));
+}
+
 /* Checks whether tree-view needs a reload (any of subdirectories were changed).
  * Returns non-zero if so, otherwise zero is returned. */
 static int
@@ -3294,6 +3552,7 @@ fentry_rename(FileView *view, dir_entry_t *entry, const char to[])
 	 * the caches. */
 	entry->hi_num = -1;
 	entry->name_dec_num = -1;
+	fentry_touch(entry);
 
 	if(flist_custom_active(view) && fentry_is_dir(entry))
 	{
@@ -3311,9 +3570,11 @@ fentry_rename(FileView *view, dir_entry_t *entry, const char to[])
 				chosp(new_origin);
 				if(e->origin != view->curr_dir)
 				{
-					free(e->origin);
+					intern_free(e->origin);
 				}
-				e->origin = new_origin;
+				e->origin = intern_str(new_origin);
+				fentry_touch(e);
+				free(new_origin);
 			}
 		}
 
@@ -3323,6 +3584,14 @@ fentry_rename(FileView *view, dir_entry_t *entry, const char to[])
 	free(old_name);
 }
 
+void
+fentry_touch(dir_entry_t *entry)
+{
+	/* Source of unique identities of entries. */
+	static uint64_t last_stamp;
+	entry->stamp = ++last_stamp;
+}
+
 int
 fentry_is_fake(const dir_entry_t *entry)
 {
@@ -3342,12 +3611,12 @@ fentry_is_dir(const dir_entry_t *entry)
 }
 
 int
-flist_load_tree(FileView *view, const char path[])
+flist_load_tree(FileView *view, const char path[], int depth)
 {
 	char full_path[PATH_MAX];
 	get_current_full_path(view, sizeof(full_path), full_path);
 
-	if(flist_load_tree_internal(view, path, 0) != 0)
+	if(flist_load_tree_internal(view, path, depth, 0) != 0)
 	{
 		return 1;
 	}
@@ -3380,7 +3649,8 @@ set_position_by_path(FileView *view, const char path[])
 int
 flist_clone_tree(FileView *to, const FileView *from)
 {
-	if(make_tree(to, flist_get_dir(from), 0, from->custom.excluded_paths) != 0)
+	if(make_tree(to, flist_get_dir(from), from->custom.tree_depth, 0,
+				from->custom.excluded_paths) != 0)
 	{
 		return 1;
 	}
@@ -3393,11 +3663,12 @@ flist_clone_tree(FileView *to, const FileView *from)
 /* Implements tree view (re)loading.  Returns zero on success, otherwise
  * non-zero is returned. */
 static int
-flist_load_tree_internal(FileView *view, const char path[], int reload)
+flist_load_tree_internal(FileView *view, const char path[], int depth,
+		int reload)
 {
 	trie_t *excluded_paths = reload ? view->custom.excluded_paths : NULL;
 
-	if(make_tree(view, path, reload, excluded_paths) != 0)
+	if(make_tree(view, path, depth, reload, excluded_paths) != 0)
 	{
 		return 1;
 	}
@@ -3411,12 +3682,15 @@ flist_load_tree_internal(FileView *view, const char path[], int reload)
 }
 
 /* (Re)loads tree at path into the view using specified list of excluded files.
- * Returns zero on success, otherwise non-zero is returned. */
+ * The depth limits number of levels of the tree.  Returns zero on success,
+ * otherwise non-zero is returned. */
 static int
-make_tree(FileView *view, const char path[], int reload, trie_t *excluded_paths)
+make_tree(FileView *view, const char path[], int depth, int reload,
+		trie_t *excluded_paths)
 {
 	char canonic_path[PATH_MAX];
-	int nfiltered;
+	int nfiltered = -1;
+	fslister_t *lister;
 
 	flist_custom_start(view, "tree");
 
@@ -3424,7 +3698,17 @@ make_tree(FileView *view, const char path[], int reload, trie_t *excluded_paths)
 
 	ui_cancellation_reset();
 	ui_cancellation_enable();
-	nfiltered = add_files_recursively(view, path, excluded_paths, -1, 0);
+	lister = fslister_create(TREE_LISTING_THREADS, &ui_cancellation_requested);
+	if(lister != NULL)
+	{
+		fslister_req_t *const req = fslister_request(lister, path);
+		if(req != NULL)
+		{
+			nfiltered = add_files_recursively(view, lister, req, path,
+					excluded_paths, -1, 0, depth);
+		}
+		fslister_free(lister);
+	}
 	ui_cancellation_disable();
 
 	ui_sb_quick_msg_clear();
@@ -3448,67 +3732,104 @@ make_tree(FileView *view, const char path[], int reload, trie_t *excluded_paths)
 		return 1;
 	}
 	view->filtered = nfiltered;
+	view->custom.tree_depth = depth;
 
 	replace_string(&view->custom.orig_dir, canonic_path);
 
 	return 0;
 }
 
-/* Adds custom view entries corresponding to file system tree.  parent_pos is
- * expected to be negative for the outermost invocation.  Returns number of
- * filtered out files on success or partial success and negative value on
- * serious error. */
+/* Adds custom view entries corresponding to file system tree.  req is a request
+ * for listing of the path.  parent_pos is expected to be negative for the
+ * outermost invocation.  depth is the number of levels to add, only directory
+ * itself is listed when it's one.  Returns number of filtered out files on
+ * success or partial success and negative value on serious error. */
 static int
-add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
-		int parent_pos, int no_direct_parent)
+add_files_recursively(FileView *view, fslister_t *lister, fslister_req_t *req,
+		const char path[], trie_t *excluded_paths, int parent_pos,
+		int no_direct_parent, int depth)
 {
 	int i;
 	const int prev_count = view->custom.entry_count;
 	int nfiltered = 0;
+	int failed = 0;
+	char **paths;
+	TreeAction *actions;
+	fslister_req_t **reqs;
 
 	int len;
-	char **lst = list_all_files(path, &len);
+	fslister_entry_t *const lst = fslister_take(lister, req, &len);
 	if(len < 0)
 	{
 		return -1;
 	}
 
+	paths = reallocarray(NULL, MAX(len, 1), sizeof(*paths));
+	actions = reallocarray(NULL, MAX(len, 1), sizeof(*actions));
+	reqs = calloc(MAX(len, 1), sizeof(*reqs));
+	if(paths == NULL || actions == NULL || reqs == NULL)
+	{
+		free(paths);
+		free(actions);
+		free(reqs);
+		fslister_free_entries(lst, len);
+		return -1;
+	}
+
+	/* Request directories in reverse order, so that they are read in order in
+	 * which they are going to be traversed. */
+	for(i = len - 1; i >= 0; --i)
+	{
+		paths[i] = format_str("%s/%s", path, lst[i].name);
+		actions[i] = get_tree_action(view, paths[i], &lst[i], excluded_paths,
+				depth);
+		if(tree_action_descends(actions[i]))
+		{
+			reqs[i] = fslister_request(lister, paths[i]);
+		}
+	}
+
 	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
 	{
-		int dir;
-		void *dummy;
 		dir_entry_t *entry;
-		char *const full_path = format_str("%s/%s", path, lst[i]);
+		const char *const full_path = paths[i];
 
-		if(trie_get(excluded_paths, full_path, &dummy) == 0)
+		if(tree_action_descends(actions[i]) && reqs[i] == NULL)
+		{
+			/* Listing wasn't requested because of an error. */
+			reqs[i] = fslister_request(lister, full_path);
+			if(reqs[i] == NULL)
+			{
+				failed = 1;
+				break;
+			}
+		}
+
+		if(actions[i] == TA_EXCLUDE)
 		{
-			free(full_path);
 			continue;
 		}
 
-		dir = is_dir(full_path);
-		if(!file_is_visible(view, lst[i], dir, NULL, 1))
+		if(actions[i] == TA_FILTER || actions[i] == TA_DESCEND)
 		{
-			/* Traverse directory (but not symlink to it) even if we're skipping it,
-			 * because we might need files that are inside of it. */
-			if(dir && !is_symlink(full_path) &&
-					file_is_visible(view, lst[i], dir, NULL, 0))
+			/* Traverse directory even if we're skipping it, because we might need
+			 * files that are inside of it. */
+			if(actions[i] == TA_DESCEND)
 			{
-				nfiltered += add_files_recursively(view, full_path, excluded_paths,
-						parent_pos, 1);
+				nfiltered += add_files_recursively(view, lister, reqs[i], full_path,
+						excluded_paths, parent_pos, 1, depth - 1);
+				reqs[i] = NULL;
 			}
 
-			free(full_path);
 			++nfiltered;
 			continue;
 		}
 
-		entry = flist_custom_add(view, full_path);
+		entry = add_listed_file(view, full_path, &lst[i]);
 		if(entry == NULL)
 		{
-			free(full_path);
-			free_string_array(lst, len);
-			return -1;
+			failed = 1;
+			break;
 		}
 
 		if(parent_pos >= 0)
@@ -3516,13 +3837,14 @@ add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
 			entry->child_pos = (view->custom.entry_count - 1) - parent_pos;
 		}
 
-		/* Not using dir variable here, because it is set for symlinks to
-		 * directories as well. */
-		if(entry->type == FT_DIR)
+		/* Listing is requested only for real directories, check type as well in
+		 * case it has changed in the meantime. */
+		if(actions[i] == TA_ADD_TREE && entry->type == FT_DIR)
 		{
 			const int idx = view->custom.entry_count - 1;
-			const int filtered = add_files_recursively(view, full_path,
-					excluded_paths, idx, 0);
+			const int filtered = add_files_recursively(view, lister, reqs[i],
+					full_path, excluded_paths, idx, 0, depth - 1);
+			reqs[i] = NULL;
 			/* Keep going in case of error and load partial list. */
 			if(filtered >= 0)
 			{
@@ -3534,12 +3856,19 @@ add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
 			}
 		}
 
-		free(full_path);
-
 		show_progress("Building tree...", 1000);
 	}
 
-	free_string_array(lst, len);
+	/* Listings that weren't taken are freed along with the lister. */
+	free(reqs);
+	free(actions);
+	free_string_array(paths, len);
+	fslister_free_entries(lst, len);
+
+	if(failed)
+	{
+		return -1;
+	}
 
 	/* The prev_count != 0 check is to make sure that we won't create leaf instead
 	 * of the whole tree (this is handled in flist_custom_finish()). */
@@ -3557,6 +3886,90 @@ add_files_recursively(FileView *view, const char path[], trie_t *excluded_paths,
 	return nfiltered;
 }
 
+/* Adds file at the path to custom view using information collected by the
+ * lister.  Returns pointer to the entry or NULL on failure. */
+static dir_entry_t *
+add_listed_file(FileView *view, const char path[],
+		const fslister_entry_t *listed)
+{
+#ifndef _WIN32
+	char canonic_path[PATH_MAX];
+	char origin[PATH_MAX];
+	dir_entry_t *entry;
+
+	to_canonic_path(path, flist_get_dir(view), canonic_path,
+			sizeof(canonic_path));
+
+	/* Don't add duplicates. */
+	if(trie_put(view->custom.paths_cache, canonic_path) != 0)
+	{
+		return NULL;
+	}
+
+	entry = alloc_dir_entry(&view->custom.entries, view->custom.entry_count);
+	if(entry == NULL)
+	{
+		return NULL;
+	}
+
+	init_dir_entry(view, entry, get_last_path_component(canonic_path));
+
+	copy_str(origin, sizeof(origin), canonic_path);
+	remove_last_path_component(origin);
+	entry->origin = intern_str(origin);
+
+	/* Lister has already done lstat() on its thread. */
+	if(fill_dir_entry_by_stat(view, entry, canonic_path, &listed->info,
+				FT_UNK) != 0)
+	{
+		fentry_free(view, entry);
+		return NULL;
+	}
+
+	++view->custom.entry_count;
+	return entry;
+#else
+	return flist_custom_add(view, path);
+#endif
+}
+
+/* Decides how file at the path should be treated while building a tree with
+ * depth levels left.  Returns the action. */
+static TreeAction
+get_tree_action(FileView *view, const char path[],
+		const fslister_entry_t *entry, trie_t *excluded_paths, int depth)
+{
+	void *dummy;
+	const int real_dir = (entry->is_dir && !entry->is_link);
+
+	if(trie_get(excluded_paths, path, &dummy) == 0)
+	{
+		return TA_EXCLUDE;
+	}
+
+	if(!file_is_visible(view, entry->name, entry->is_dir, NULL, 1))
+	{
+		/* Directories (but not symbolic links to them) that are hidden only by
+		 * local filter are traversed. */
+		if(real_dir && depth > 1 &&
+				file_is_visible(view, entry->name, 1, NULL, 0))
+		{
+			return TA_DESCEND;
+		}
+		return TA_FILTER;
+	}
+
+	return (real_dir && depth > 1) ? TA_ADD_TREE : TA_ADD;
+}
+
+/* Checks whether the action requires listing a directory.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+tree_action_descends(TreeAction action)
+{
+	return action == TA_DESCEND || action == TA_ADD_TREE;
+}
+
 /* Checks whether file is visible according to dot and filename filters.  is_dir
  * is used when data is NULL, otherwise data_is_dir_entry() called (this is an
  * optimization).  Returns non-zero if so, otherwise zero is returned. */
@@ -3610,7 +4023,8 @@ add_directory_leaf(FileView *view, const char path[], int parent_pos)
 	}
 
 	remove_last_path_component(full_path);
-	entry->origin = full_path;
+	entry->origin = intern_str(full_path);
+	free(full_path);
 
 	if(parent_pos >= 0)
 	{
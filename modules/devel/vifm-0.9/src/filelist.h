@@ -26,6 +26,7 @@
 #include <stdint.h> /* uint64_t */
 
 #include "ui/ui.h"
+#include "utils/selector.h"
 #include "utils/test_helpers.h"
 
 /* Type of filter function for zapping list of entries.  Should return non-zero
@@ -44,6 +45,15 @@ void init_filelists(void);
 void reset_views(void);
 /* Loads view file list for the first time. */
 void load_initial_directory(FileView *view, const char dir[]);
+/* Starts reading current directory of the view on a worker thread, so that the
+ * next load of its file list doesn't wait for the file system.  Does nothing
+ * for custom views. */
+void flist_prefetch(FileView *view);
+/* Loads file list of the view if its load was postponed until listing read
+ * ahead of time is ready and discards the listing otherwise. */
+void flist_prefetch_finish(FileView *view);
+/* Discards listing of the view that was read ahead of time and wasn't used. */
+void flist_prefetch_discard(FileView *view);
 
 /* Appearance related functions. */
 
@@ -162,6 +172,10 @@ dir_entry_t * get_current_entry(const FileView *view);
 /* Checks whether content in the current directory of the view changed and
  * reloads the view if so. */
 void check_if_filelist_have_changed(FileView *view);
+/* Adds descriptor that signals changes of the current directory of the view to
+ * the selector.  Returns non-zero if changes must also be checked for
+ * periodically, otherwise zero is returned. */
+int flist_watch(FileView *view, selector_t *selector);
 /* Checks whether cd'ing into path is possible. Shows cd errors to a user.
  * Returns non-zero if it's possible, zero otherwise. */
 int cd_is_possible(const char *path);
@@ -267,6 +281,9 @@ void fentry_free(const FileView *view, dir_entry_t *entry);
 void add_parent_dir(FileView *view);
 /* Changes name of a file entry, performing additional required updates. */
 void fentry_rename(FileView *view, dir_entry_t *entry, const char to[]);
+/* Gives the entry new identity for the purposes of redrawing.  Must be called
+ * after name or origin of an existing entry are changed in place. */
+void fentry_touch(dir_entry_t *entry);
 /* Checks whether this is fake entry for internal purposes, which should not be
  * processed as a file. */
 int fentry_is_fake(const dir_entry_t *entry);
@@ -278,8 +295,10 @@ int fentry_is_valid(const dir_entry_t *entry);
  * directories).  Returns non-zero if so, otherwise zero is returned. */
 int fentry_is_dir(const dir_entry_t *entry);
 /* Loads directory tree specified by its path into the view.  Considers various
- * filters.  Returns zero on success, otherwise non-zero is returned. */
-int flist_load_tree(FileView *view, const char path[]);
+ * filters.  The depth limits number of levels of the tree (INT_MAX for no
+ * limit), directories at the last level aren't read.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int flist_load_tree(FileView *view, const char path[], int depth);
 /* Makes to contain tree with the same root as from including copying list of
  * excluded files.  Returns zero on success, otherwise non-zero is returned. */
 int flist_clone_tree(FileView *to, const FileView *from);
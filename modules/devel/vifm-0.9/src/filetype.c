@@ -28,6 +28,7 @@
 #include "compat/fs_limits.h"
 #include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
+#include "utils/classifier.h"
 #include "utils/matchers.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -35,6 +36,8 @@
 
 static const char * find_existing_cmd(const assoc_list_t *record_list,
 		const char file[]);
+static int find_match(const assoc_list_t *record_list, const char file[],
+		int from);
 static assoc_record_t find_existing_cmd_record(const assoc_records_t *records);
 static void assoc_programs(matchers_t *matchers,
 		const assoc_records_t *programs, int for_x, int in_x);
@@ -98,16 +101,12 @@ find_existing_cmd(const assoc_list_t *record_list, const char file[])
 {
 	int i;
 
-	for(i = 0; i < record_list->count; ++i)
+	for(i = find_match(record_list, file, 0); i >= 0;
+			i = find_match(record_list, file, i + 1))
 	{
 		assoc_record_t prog;
 		assoc_t *const assoc = &record_list->list[i];
 
-		if(!matchers_match(assoc->matchers, file))
-		{
-			continue;
-		}
-
 		prog = find_existing_cmd_record(&assoc->records);
 		if(!is_assoc_record_empty(&prog))
 		{
@@ -118,6 +117,28 @@ find_existing_cmd(const assoc_list_t *record_list, const char file[])
 	return NULL;
 }
 
+/* Finds first association starting with the one at index from whose pattern
+ * matches the file.  Returns index of the association or -1 if there is none. */
+static int
+find_match(const assoc_list_t *record_list, const char file[], int from)
+{
+	int i;
+
+	if(record_list->index != NULL)
+	{
+		return classifier_find(record_list->index, file, from);
+	}
+
+	for(i = from; i < record_list->count; ++i)
+	{
+		if(matchers_match(record_list->list[i].matchers, file))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
 /* Finds record that corresponds to an external command that is available.
  * Returns the record on success or an empty record on failure. */
 static assoc_record_t
@@ -235,13 +256,10 @@ clone_all_matching_records(const char file[], const assoc_list_t *record_list)
 	int i;
 	assoc_records_t result = {};
 
-	for(i = 0; i < record_list->count; ++i)
+	for(i = find_match(record_list, file, 0); i >= 0;
+			i = find_match(record_list, file, i + 1))
 	{
-		assoc_t *const assoc = &record_list->list[i];
-		if(matchers_match(assoc->matchers, file))
-		{
-			ft_assoc_record_add_all(&result, &assoc->records);
-		}
+		ft_assoc_record_add_all(&result, &record_list->list[i].records);
 	}
 
 	return result;
@@ -302,6 +320,19 @@ add_assoc(assoc_list_t *assoc_list, assoc_t assoc)
 	assoc_list->list = p;
 	assoc_list->list[assoc_list->count] = assoc;
 	assoc_list->count++;
+
+	/* Index is dropped if it can't be updated, which makes lookups fall back to
+	 * trying all matchers in order. */
+	if(assoc_list->count == 1)
+	{
+		assoc_list->index = classifier_create();
+	}
+	if(assoc_list->index != NULL &&
+			classifier_add(assoc_list->index, assoc.matchers) != 0)
+	{
+		classifier_free(assoc_list->index);
+		assoc_list->index = NULL;
+	}
 }
 
 void
@@ -351,6 +382,9 @@ reset_list_head(assoc_list_t *assoc_list)
 	free(assoc_list->list);
 	assoc_list->list = NULL;
 	assoc_list->count = 0;
+
+	classifier_free(assoc_list->index);
+	assoc_list->index = NULL;
 }
 
 static void
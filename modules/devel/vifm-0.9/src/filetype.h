@@ -22,6 +22,7 @@
 
 #define VIFM_PSEUDO_CMD "vifm"
 
+struct classifier_t;
 struct matchers_t;
 
 /* Type of file association by it's source. */
@@ -61,6 +62,7 @@ typedef struct
 {
 	assoc_t *list;
 	int count;
+	struct classifier_t *index; /* Index of matchers of the list or NULL. */
 }
 assoc_list_t;
 
@@ -28,6 +28,7 @@
 #include "../compat/reallocarray.h"
 #include "../engine/variables.h"
 #include "../utils/env.h"
+#include "../utils/execcache.h"
 #include "../utils/fs.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
@@ -60,6 +61,7 @@ update_path_env(int force)
 	{
 		append_scripts_dirs();
 		split_path_list();
+		execcache_set_dirs(paths, paths_count);
 	}
 }
 
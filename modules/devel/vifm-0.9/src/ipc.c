@@ -36,7 +36,8 @@ ipc_list(int *len)
 }
 
 void
-ipc_init(const char name[], ipc_callback callback_func)
+ipc_init(const char name[], ipc_callback callback_func,
+		ipc_request_callback request_func)
 {
 }
 
@@ -51,12 +52,25 @@ ipc_check(void)
 {
 }
 
+int
+ipc_watch(selector_t *selector)
+{
+	return 0;
+}
+
 int
 ipc_send(const char whom[], char *data[])
 {
 	return 1;
 }
 
+strlist_t
+ipc_request(const char whom[], char *request[])
+{
+	strlist_t reply = {};
+	return reply;
+}
+
 #else
 
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -66,10 +80,13 @@ ipc_send(const char whom[], char *data[])
 #endif
 
 #ifndef WIN32_PIPE_READ
-# include <sys/types.h>
-# include <sys/select.h> /* FD_* select() */
+# include <sys/types.h> /* ssize_t */
+# include <sys/socket.h> /* AF_UNIX MSG_NOSIGNAL SOCK_STREAM SOL_SOCKET
+                            SO_RCVTIMEO SO_SNDTIMEO accept() bind() connect()
+                            listen() recv() send() setsockopt() socket() */
+# include <sys/time.h> /* timeval */
+# include <sys/un.h> /* sockaddr_un */
 #else
-# define O_NONBLOCK 0
 # define REQUIRED_WINVER 0x0600 /* To get PIPE_REJECT_REMOTE_CLIENTS. */
 # include "utils/windefs.h"
 # include <windows.h>
@@ -81,36 +98,80 @@ ipc_send(const char whom[], char *data[])
 # endif
 #endif
 
-#include <sys/stat.h> /* mkfifo() stat() */
-#include <dirent.h> /* DIR closedir() opendir() readdir() */
-#include <fcntl.h>
-#include <unistd.h> /* close() open() select() unlink() */
+#include <sys/stat.h> /* S_ISSOCK stat lstat() umask() */
+#include <fcntl.h> /* FD_CLOEXEC F_GETFL F_SETFD F_SETFL O_NONBLOCK fcntl() */
+#include <unistd.h> /* close() unlink() usleep() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* EACCES EEXIST EDQUOT ENOSPC ENXIO errno */
-#include <stddef.h> /* NULL size_t ssize_t */
-#include <stdio.h> /* FILE fclose() fdopen() fread() fwrite() */
-#include <stdlib.h> /* atexit() free() malloc() qsort() snprintf() */
-#include <string.h> /* strcmp() strcpy() strlen() */
-
+#include <errno.h> /* EADDRINUSE EAGAIN ECONNREFUSED EINTR ENOENT EWOULDBLOCK
+                      errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint32_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* atexit() free() malloc() qsort() realloc() */
+#include <string.h> /* memchr() memcpy() memmove() memset() strcmp() strcpy()
+                       strlen() */
+#include <time.h> /* time_t time() */
+
+#include "compat/fs_limits.h"
 #include "utils/fs.h"
 #include "utils/log.h"
-#include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
-#include "utils/utils.h"
-#include "status.h"
 
-/* Prefix for names of all pipes to distinguish them from other pipes. */
+/* Prefix for names of all sockets and pipes to distinguish them from other
+ * files. */
 #define PREFIX "vifm-ipc-"
 
+/* Maximum size of payload of a package, larger packages are considered to be
+ * malformed. */
+#define MAX_PKG_SIZE (16U*1024U*1024U)
+
 #ifndef WIN32_PIPE_READ
-typedef FILE *read_pipe_t;
-#define NULL_READ_PIPE NULL
+
+/* Maximum number of clients served at the same time, the rest wait for their
+ * turn in the backlog. */
+#define MAX_CLIENTS 16
+
+/* Amount of unsent replies after which client's requests aren't processed until
+ * it reads some of them. */
+#define OUT_LIMIT (64U*1024U)
+
+/* Number of seconds after which a client that neither sends requests nor reads
+ * replies is disconnected, so that clients can't occupy all the slots. */
+#define CLIENT_TIMEOUT 10
+
+/* Number of seconds client waits for a server to accept connection, to read
+ * data or to send some of the reply before giving up on it. */
+#define IO_TIMEOUT 10
+
+#ifndef MSG_NOSIGNAL
+/* SO_NOSIGPIPE socket option is used on systems that lack this flag. */
+#define MSG_NOSIGNAL 0
+#endif
+
+typedef int server_t;
+#define NULL_SERVER -1
+
+/* Connection of a client to this instance. */
+typedef struct
+{
+	int fd;         /* Socket of the connection. */
+	char *in;       /* Received data that wasn't processed yet. */
+	size_t in_len;  /* Length of the in buffer. */
+	char *out;      /* Replies that weren't sent yet. */
+	size_t out_len; /* Length of the out buffer. */
+	int eof;        /* Whether client won't send any more requests. */
+	time_t active;  /* Time of the last data exchange with the client. */
+}
+client_t;
+
 #else
-typedef HANDLE read_pipe_t;
-#define NULL_READ_PIPE INVALID_HANDLE_VALUE
+
+typedef HANDLE server_t;
+#define NULL_SERVER INVALID_HANDLE_VALUE
+
 #endif
 
 /* Holds list information for add_to_list(). */
@@ -123,28 +184,63 @@ typedef struct
 list_data_t;
 
 static void cleanup_at_exit(void);
-static read_pipe_t create_pipe(const char name[], char path_buf[], size_t len);
-static char * receive_pkg(void);
-static read_pipe_t try_use_pipe(const char path[], int *fatal);
-static void handle_pkg(const char pkg[]);
-static int send_pkg(const char whom[], const char what[], size_t len);
+static server_t create_server(const char name[], char path_buf[], size_t len);
+static server_t try_use_path(const char path[], int *fatal);
+static strlist_t process_pkg(const char payload[], size_t len);
+static strlist_t make_error(const char msg[]);
+static int send_request(const char whom[], char *request[], int count,
+		strlist_t *reply);
+static int send_pkg(const char whom[], const char pkg[], size_t len,
+		strlist_t *reply);
+static char * make_pkg(char *strings[], int count, size_t *len);
+static strlist_t parse_payload(const char payload[], size_t len);
 static char * get_the_only_target(void);
 static int add_to_list(const char name[], const void *data, void *param);
 static const char * get_ipc_dir(void);
 static int sorter(const void *first, const void *second);
 #ifndef WIN32_PIPE_READ
-static int pipe_is_in_use(const char path[]);
+static void accept_clients(void);
+static void drop_idle_clients(void);
+static int serve_client(client_t *client);
+static int handle_request(client_t *client, const char payload[], size_t len);
+static int flush_replies(client_t *client);
+static void drop_client(int index);
+static int append_data(char **buf, size_t *len, const char data[], size_t n);
+static int receive_reply(int fd, strlist_t *reply);
+static int send_all(int fd, const char data[], size_t len);
+static int recv_all(int fd, char data[], size_t len);
+static int connect_to(const char path[]);
+static int new_socket(int nonblocking);
+static int setup_socket(int fd, int nonblocking);
+static int set_io_timeout(int fd);
+static int fill_address(struct sockaddr_un *addr, const char path[]);
+static int bind_socket(int fd, const struct sockaddr_un *addr);
+static int socket_is_abandoned(const char path[]);
+static int socket_is_in_use(const char path[]);
+#else
+static char * receive_pkg(size_t *len);
 #endif
 
-/* Stores callback to report received messages. */
+/* Stores callback to report received arguments. */
 static ipc_callback callback;
+/* Stores callback to handle other requests. */
+static ipc_request_callback request_callback;
 /* Whether unit was initialized and what's the result (-1 is error, 1 is
  * success). */
 static int initialized;
-/* Path to the pipe used by this instance. */
-static char pipe_path[PATH_MAX];
-/* Opened file of the pipe. */
-static read_pipe_t pipe_file;
+/* Whether requests are being processed at the moment. */
+static int processing;
+/* Path to the socket or pipe used by this instance. */
+static char server_path[PATH_MAX];
+/* Listening socket or pipe. */
+static server_t server;
+
+#ifndef WIN32_PIPE_READ
+/* Currently connected clients. */
+static client_t clients[MAX_CLIENTS];
+/* Number of elements in the clients array. */
+static int nclients;
+#endif
 
 int
 ipc_enabled(void)
@@ -153,19 +249,21 @@ ipc_enabled(void)
 }
 
 void
-ipc_init(const char name[], ipc_callback callback_func)
+ipc_init(const char name[], ipc_callback callback_func,
+		ipc_request_callback request_func)
 {
 	assert(!initialized && "Repeated initialization?");
 
 	callback = callback_func;
+	request_callback = request_func;
 
 	if(name == NULL)
 	{
 		name = "vifm";
 	}
 
-	pipe_file = create_pipe(name, pipe_path, sizeof(pipe_path));
-	if(pipe_file == NULL_READ_PIPE)
+	server = create_server(name, server_path, sizeof(server_path));
+	if(server == NULL_SERVER)
 	{
 		initialized = -1;
 		return;
@@ -180,10 +278,14 @@ static void
 cleanup_at_exit(void)
 {
 #ifndef WIN32_PIPE_READ
-	fclose(pipe_file);
-	unlink(pipe_path);
+	while(nclients != 0)
+	{
+		drop_client(nclients - 1);
+	}
+	close(server);
+	unlink(server_path);
 #else
-	CloseHandle(pipe_file);
+	CloseHandle(server);
 #endif
 }
 
@@ -195,221 +297,224 @@ ipc_get_name(void)
 		return "";
 	}
 
-	return get_last_path_component(pipe_path) + (sizeof(PREFIX) - 1U);
+	return get_last_path_component(server_path) + (sizeof(PREFIX) - 1U);
 }
 
 void
 ipc_check(void)
 {
-	char *pkg;
+#ifndef WIN32_PIPE_READ
+	int i;
+#else
+	char *payload;
+	size_t len;
+#endif
 
 	assert(initialized != 0 && "Wrong IPC unit state.");
-	if(initialized < 0)
+	/* Requests can run commands that check for IPC from nested event loops, such
+	 * requests are left for later. */
+	if(initialized < 0 || processing)
 	{
 		return;
 	}
 
-	pkg = receive_pkg();
-	if(pkg == NULL)
+	processing = 1;
+
+#ifndef WIN32_PIPE_READ
+	drop_idle_clients();
+	accept_clients();
+
+	i = 0;
+	while(i < nclients)
 	{
-		return;
+		if(serve_client(&clients[i]) != 0)
+		{
+			drop_client(i);
+			continue;
+		}
+		++i;
+	}
+#else
+	payload = receive_pkg(&len);
+	if(payload != NULL)
+	{
+		/* There is no way to deliver the reply. */
+		strlist_t reply = process_pkg(payload, len);
+		free_string_array(reply.items, reply.nitems);
+		free(payload);
 	}
+#endif
 
-	handle_pkg(pkg);
-	free(pkg);
+	processing = 0;
 }
 
-/* Receives message addressed to this instance.  Returns NULL if there was no
- * message or on failure to read it, otherwise newly allocated string is
- * returned. */
-static char *
-receive_pkg(void)
+int
+ipc_watch(selector_t *selector)
 {
 #ifndef WIN32_PIPE_READ
-	uint32_t size;
-	char *pkg;
-	char *p;
+	int i;
 
-	fd_set ready;
-	int max_fd;
-	struct timeval ts = { .tv_sec = 0, .tv_usec = 10000 };
-
-	if(fread(&size, sizeof(size), 1U, pipe_file) != 1U || size >= 4294967294U)
+	/* Nothing will be done until outer ipc_check() is done processing. */
+	if(initialized <= 0 || processing)
 	{
-		return NULL;
+		return 0;
 	}
 
-	pkg = malloc(size + 2U);
-	if(pkg == NULL)
+	if(nclients < MAX_CLIENTS)
 	{
-		return NULL;
+		(void)selector_add(selector, server, SEL_READ);
 	}
 
-	max_fd = fileno(pipe_file);
-	FD_ZERO(&ready);
-	FD_SET(max_fd, &ready);
-
-	p = pkg;
-	while(size != 0U && select(max_fd + 1, &ready, NULL, NULL, &ts) > 0)
+	for(i = 0; i < nclients; ++i)
 	{
-		const size_t nread = fread(p, 1U, size, pipe_file);
-		size -= nread;
-		p += nread;
-
-		if(nread == 0U)
+		const client_t *const client = &clients[i];
+		int events = 0;
+		if(!client->eof && client->out_len < OUT_LIMIT)
 		{
-			break;
+			events |= SEL_READ;
 		}
-
-		ts.tv_sec = 0;
-		ts.tv_usec = 10000;
-	}
-
-	if(size != 0U)
-	{
-		free(pkg);
-		return NULL;
+		if(client->out_len != 0U)
+		{
+			events |= SEL_WRITE;
+		}
+		(void)selector_add(selector, client->fd, events);
 	}
 
-	/* Make sure we have two trailing zeroes. */
-	*p++ = '\0';
-	*p = '\0';
-
-	return pkg;
+	return (nclients != 0);
 #else
-	uint32_t size;
-	char *pkg;
-	char *p;
-	DWORD nread;
+	return 0;
+#endif
+}
+
+/* Parses payload of a request, processes it and forms reply.  Returns the
+ * reply. */
+static strlist_t
+process_pkg(const char payload[], size_t len)
+{
+	strlist_t reply = {};
+	strlist_t request = parse_payload(payload, len);
+	const int nitems = request.nitems;
 
-	if(ReadFile(pipe_file, &size, sizeof(size), &nread, NULL) == FALSE ||
-			size >= 4294967294U)
+	/* Make the array NULL terminated. */
+	request.nitems = put_into_string_array(&request.items, request.nitems, NULL);
+	if(request.nitems == nitems)
 	{
-		return NULL;
+		reply = make_error("Not enough memory");
 	}
-
-	pkg = malloc(size + 2U);
-	if(pkg == NULL)
+	else if(nitems == 0)
 	{
-		return NULL;
+		reply = make_error("Empty request");
 	}
-
-	p = pkg;
-	while(size != 0U)
+	else if(strcmp(request.items[0], "args") == 0)
 	{
-		/* TODO: maybe use OVERLAPPED I/O on Windows instead, it's just so
-		 *       inconvenient... */
-		usleep(10000);
-
-		if(ReadFile(pipe_file, p, size, &nread, NULL) == FALSE || nread == 0U)
+		if(nitems < 2)
 		{
-			break;
+			reply = make_error("No working directory");
+		}
+		else
+		{
+			callback(request.items + 1);
+			reply.nitems = add_to_string_array(&reply.items, reply.nitems, 1, "ok");
 		}
-
-		size -= nread;
-		p += nread;
 	}
-
-	/* Weird requirement for named pipes, need to break and set connection every
-	 * time. */
-	DisconnectNamedPipe(pipe_file);
-	ConnectNamedPipe(pipe_file, NULL);
-
-	if(size != 0U)
+	else if(request_callback != NULL)
 	{
-		free(pkg);
-		return NULL;
+		reply = request_callback(request.items);
+	}
+	else
+	{
+		reply = make_error("Unsupported request");
 	}
 
-	/* Make sure we have two trailing zeroes. */
-	*p++ = '\0';
-	*p = '\0';
+	free_string_array(request.items, request.nitems);
+	return reply;
+}
 
-	return pkg;
-#endif
+/* Makes reply that reports an error.  Returns the reply. */
+static strlist_t
+make_error(const char msg[])
+{
+	strlist_t reply = {};
+	reply.nitems = add_to_string_array(&reply.items, reply.nitems, 2, "error",
+			msg);
+	return reply;
 }
 
-/* Tries to open a pipe for communication.  Returns NULL_READ_PIPE on error or
- * opened file descriptor otherwise. */
-static read_pipe_t
-create_pipe(const char name[], char path_buf[], size_t len)
+/* Tries to create a server for communication.  Returns NULL_SERVER on error or
+ * a valid handle otherwise. */
+static server_t
+create_server(const char name[], char path_buf[], size_t len)
 {
 	unsigned int id = 0U;
-	read_pipe_t rp;
+	server_t s;
 	int fatal;
 
 	/* Try to use name as is at first. */
 	snprintf(path_buf, len, "%s/" PREFIX "%s", get_ipc_dir(), name);
-	rp = try_use_pipe(path_buf, &fatal);
-	while(rp == NULL_READ_PIPE && !fatal)
+	s = try_use_path(path_buf, &fatal);
+	while(s == NULL_SERVER && !fatal)
 	{
 		snprintf(path_buf, len, "%s/" PREFIX "%s%u", get_ipc_dir(), name, ++id);
 
 		if(id == 0)
 		{
-			return NULL_READ_PIPE;
+			return NULL_SERVER;
 		}
 
-		rp = try_use_pipe(path_buf, &fatal);
+		s = try_use_path(path_buf, &fatal);
 	}
 
-	return rp;
+	return s;
 }
 
-/* Either creates a pipe or reused previously abandoned one.  Returns
- * NULL_READ_PIPE on failure (with *fatal set to non-zero if further tries don't
- * make any sense) or valid file descriptor otherwise. */
-static read_pipe_t
-try_use_pipe(const char path[], int *fatal)
+/* Either creates a server at the path or reuses previously abandoned one.
+ * Returns NULL_SERVER on failure (with *fatal set to non-zero if further tries
+ * don't make any sense) or valid handle otherwise. */
+static server_t
+try_use_path(const char path[], int *fatal)
 {
 #ifndef WIN32_PIPE_READ
-	FILE *f;
+	struct sockaddr_un addr;
 	int fd;
 
-	*fatal = 0;
+	*fatal = 1;
 
-	/* Try to create a pipe. */
-	if(mkfifo(path, 0600) == 0)
+	/* Other names will be even longer. */
+	if(fill_address(&addr, path) != 0)
 	{
-		/* Open if created. */
-		const int fd = open(path, O_RDONLY | O_NONBLOCK);
-		if(fd == -1)
-		{
-			if(errno == EACCES)
-			{
-				/* If we created a file that we can't open, remove it and assume that
-				 * something is fundamentally wrong with the system setup. */
-				(void)unlink(path);
-				*fatal = 1;
-			}
-			return NULL_READ_PIPE;
-		}
-		return fdopen(fd, "r");
+		return NULL_SERVER;
 	}
 
-	/* Fail fast if the error is not related to existence of the file or pipe
-	 * exists and is in use. */
-	if(errno != EEXIST || pipe_is_in_use(path))
+	fd = new_socket(1);
+	if(fd == -1)
 	{
-		/* No retries if file-system is unable to create more files. */
-		*fatal = (errno == EDQUOT || errno == ENOSPC);
-		return NULL_READ_PIPE;
+		return NULL_SERVER;
 	}
 
-	/* Use this file if we're the only one willing to read from it. */
-	fd = open(path, O_RDONLY | O_NONBLOCK);
-
-	if(fd == -1)
+	if(bind_socket(fd, &addr) != 0)
 	{
-		return NULL_READ_PIPE;
+		/* Only existence of the socket is a reason to try another name. */
+		*fatal = (errno != EADDRINUSE);
+
+		/* Reuse socket of an instance that didn't exit cleanly. */
+		if(*fatal || !socket_is_abandoned(path) || unlink(path) != 0 ||
+				bind_socket(fd, &addr) != 0)
+		{
+			close(fd);
+			return NULL_SERVER;
+		}
 	}
 
-	f = fdopen(fd, "r");
-	if(f == NULL_READ_PIPE)
+	if(listen(fd, MAX_CLIENTS) != 0)
 	{
 		close(fd);
+		(void)unlink(path);
+		*fatal = 1;
+		return NULL_SERVER;
 	}
-	return f;
+
+	*fatal = 0;
+	return fd;
 #else
 	*fatal = 0;
 	return CreateNamedPipeA(path,
@@ -419,57 +524,73 @@ try_use_pipe(const char path[], int *fatal)
 #endif
 }
 
-/* Parses pkg into array of strings and invokes callback. */
-static void
-handle_pkg(const char pkg[])
+int
+ipc_send(const char whom[], char *data[])
 {
-	char **array = NULL;
-	size_t len = 0U;
+	char cwd[PATH_MAX];
+	char **request = NULL;
+	int len;
+	int ret;
 
-	while(*pkg != '\0')
+	assert(initialized != 0 && "Wrong IPC unit state.");
+	if(initialized < 0)
 	{
-		len = add_to_string_array(&array, len, 1, pkg);
-		pkg += strlen(pkg) + 1;
+		return 1;
 	}
-	len = put_into_string_array(&array, len, NULL);
 
-	if(len != 0U)
+	if(get_cwd(cwd, sizeof(cwd)) == NULL)
 	{
-		callback(array);
+		LOG_ERROR_MSG("Can't get working directory");
+		return 1;
+	}
+
+	len = add_to_string_array(&request, 0, 2, "args", cwd);
+	while(*data != NULL)
+	{
+		len = add_to_string_array(&request, len, 1, *data++);
 	}
 
-	free_string_array(array, len);
+	ret = send_request(whom, request, len, NULL);
+
+	free_string_array(request, len);
+	return ret;
 }
 
-int
-ipc_send(const char whom[], char *data[])
+strlist_t
+ipc_request(const char whom[], char *request[])
 {
-	/* FIXME: this shouldn't have fixed size.  Or maybe it should be PIPE_BUF to
-	 * guarantee atomic operation. */
-	char pkg[8192];
-	size_t len;
-	char *name = NULL;
-	int ret;
+	strlist_t reply = {};
+	int count = 0;
 
 	assert(initialized != 0 && "Wrong IPC unit state.");
 	if(initialized < 0)
 	{
-		return 1;
+		return reply;
 	}
 
-	if(get_cwd(pkg, sizeof(pkg)) == NULL)
+	while(request[count] != NULL)
 	{
-		LOG_ERROR_MSG("Can't get working directory");
-		return 1;
+		++count;
 	}
-	len = strlen(pkg) + 1;
 
-	while(*data != NULL)
+	if(send_request(whom, request, count, &reply) != 0)
 	{
-		len += copy_str(pkg + len, sizeof(pkg) - len, *data);
-		++data;
+		free_string_array(reply.items, reply.nitems);
+		reply.items = NULL;
+		reply.nitems = 0;
 	}
-	pkg[len++] = '\0';
+	return reply;
+}
+
+/* Sends request to another instance and waits for reply if reply isn't NULL.
+ * Returns zero on success and non-zero otherwise. */
+static int
+send_request(const char whom[], char *request[], int count, strlist_t *reply)
+{
+	size_t len;
+	char *pkg;
+	char *name = NULL;
+	int ret;
 
 	if(whom == NULL)
 	{
@@ -481,54 +602,52 @@ ipc_send(const char whom[], char *data[])
 		whom = name;
 	}
 
-	ret = send_pkg(whom, pkg, len);
+	pkg = make_pkg(request, count, &len);
+	ret = (pkg == NULL) ? 1 : send_pkg(whom, pkg, len, reply);
 
+	free(pkg);
 	free(name);
 	return ret;
 }
 
-/* Performs actual sending of package to another instance.  Returns zero on
- * success and non-zero otherwise. */
+/* Performs actual sending of package to another instance and receiving of
+ * reply to it if reply isn't NULL.  Returns zero on success and non-zero
+ * otherwise. */
 static int
-send_pkg(const char whom[], const char what[], size_t len)
+send_pkg(const char whom[], const char pkg[], size_t len, strlist_t *reply)
 {
 #ifndef WIN32_PIPE_READ
 	char path[PATH_MAX];
 	int fd;
-	FILE *dst;
-	uint32_t size;
+	int ret;
 
 	snprintf(path, sizeof(path), "%s/" PREFIX "%s", get_ipc_dir(), whom);
 
-	fd = open(path, O_WRONLY | O_NONBLOCK);
+	fd = connect_to(path);
 	if(fd == -1)
 	{
 		return 1;
 	}
 
-	dst = fdopen(fd, "w");
-	if(dst == NULL)
-	{
-		close(fd);
-		return 1;
-	}
-
-	size = len;
-	if(fwrite(&size, sizeof(size), 1U, dst) != 1U ||
-			fwrite(what, len, 1U, dst) != 1U)
+	ret = send_all(fd, pkg, len);
+	if(ret == 0 && reply != NULL)
 	{
-		fclose(dst);
-		return 1;
+		ret = receive_reply(fd, reply);
 	}
 
-	fclose(dst);
-	return 0;
+	close(fd);
+	return ret;
 #else
 	char path[PATH_MAX];
 	HANDLE h;
-	uint32_t size;
 	DWORD nwritten;
 
+	/* Pipes are one way. */
+	if(reply != NULL)
+	{
+		return 1;
+	}
+
 	snprintf(path, sizeof(path), "%s/" PREFIX "%s", get_ipc_dir(), whom);
 
 	h = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
@@ -538,10 +657,7 @@ send_pkg(const char whom[], const char what[], size_t len)
 		return 1;
 	}
 
-	size = len;
-	if(WriteFile(h, &size, sizeof(size), &nwritten, NULL) == FALSE ||
-			nwritten != sizeof(size) ||
-			WriteFile(h, what, len, &nwritten, NULL) == FALSE || nwritten != len)
+	if(WriteFile(h, pkg, len, &nwritten, NULL) == FALSE || nwritten != len)
 	{
 		CloseHandle(h);
 		return 1;
@@ -552,6 +668,82 @@ send_pkg(const char whom[], const char what[], size_t len)
 #endif
 }
 
+/* Serializes array of strings into a package.  Returns newly allocated package
+ * of *len bytes or NULL on error. */
+static char *
+make_pkg(char *strings[], int count, size_t *len)
+{
+	uint32_t size;
+	size_t payload_len = 0U;
+	char *pkg;
+	char *p;
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		payload_len += strlen(strings[i]) + 1U;
+	}
+
+	if(payload_len > MAX_PKG_SIZE)
+	{
+		return NULL;
+	}
+
+	pkg = malloc(sizeof(size) + payload_len);
+	if(pkg == NULL)
+	{
+		return NULL;
+	}
+
+	size = payload_len;
+	memcpy(pkg, &size, sizeof(size));
+
+	p = pkg + sizeof(size);
+	for(i = 0; i < count; ++i)
+	{
+		const size_t item_len = strlen(strings[i]) + 1U;
+		memcpy(p, strings[i], item_len);
+		p += item_len;
+	}
+
+	*len = sizeof(size) + payload_len;
+	return pkg;
+}
+
+/* Splits payload of a package into strings.  Returns the list. */
+static strlist_t
+parse_payload(const char payload[], size_t len)
+{
+	strlist_t list = {};
+	const char *const end = payload + len;
+
+	while(payload < end)
+	{
+		const char *const nul = memchr(payload, '\0', end - payload);
+		const size_t item_len = (nul == NULL) ? (size_t)(end - payload)
+		                                      : (size_t)(nul - payload);
+
+		char *const item = malloc(item_len + 1U);
+		if(item == NULL)
+		{
+			break;
+		}
+		memcpy(item, payload, item_len);
+		item[item_len] = '\0';
+
+		if(put_into_string_array(&list.items, list.nitems, item) == list.nitems)
+		{
+			free(item);
+			break;
+		}
+		++list.nitems;
+
+		payload += item_len + 1U;
+	}
+
+	return list;
+}
+
 /* Automatically picks target instance to send data to.  Returns newly allocated
  * string or NULL on error (no other instances or memory allocation failure). */
 static char *
@@ -617,8 +809,8 @@ ipc_list(int *len)
 	return data.lst;
 }
 
-/* Analyzes pipe and adds it to the list of pipes.  Returns zero on success or
- * non-zero on error. */
+/* Analyzes socket or pipe and adds it to the list of servers.  Returns zero on
+ * success or non-zero on error. */
 static int
 add_to_list(const char name[], const void *data, void *param)
 {
@@ -630,7 +822,7 @@ add_to_list(const char name[], const void *data, void *param)
 	}
 
 	/* Skip ourself. */
-	if(stroscmp(name, get_last_path_component(pipe_path)) == 0)
+	if(stroscmp(name, get_last_path_component(server_path)) == 0)
 	{
 		return 0;
 	}
@@ -641,8 +833,8 @@ add_to_list(const char name[], const void *data, void *param)
 		char path[PATH_MAX];
 		struct stat statbuf;
 		snprintf(path, sizeof(path), "%s/%s", list_data->ipc_dir, name);
-		if(stat(path, &statbuf) != 0 || !S_ISFIFO(statbuf.st_mode) ||
-				!pipe_is_in_use(path))
+		if(lstat(path, &statbuf) != 0 || !S_ISSOCK(statbuf.st_mode) ||
+				!socket_is_in_use(path))
 		{
 			return 0;
 		}
@@ -654,7 +846,7 @@ add_to_list(const char name[], const void *data, void *param)
 	return 0;
 }
 
-/* Retrieves directory where FIFO objects are created.  Returns the path. */
+/* Retrieves directory where IPC objects are created.  Returns the path. */
 static const char *
 get_ipc_dir(void)
 {
@@ -676,24 +868,493 @@ sorter(const void *first, const void *second)
 
 #ifndef WIN32_PIPE_READ
 
-/* Tries to open a pipe to check whether it has any readers or it's
- * abandoned.  Returns non-zero if somebody is reading from the pipe and zero
+/* Accepts pending connections while there is room for new clients. */
+static void
+accept_clients(void)
+{
+	while(nclients < MAX_CLIENTS)
+	{
+		client_t *client;
+
+		const int fd = accept(server, NULL, NULL);
+		if(fd == -1)
+		{
+			break;
+		}
+
+		if(setup_socket(fd, 1) != 0)
+		{
+			close(fd);
+			continue;
+		}
+
+		client = &clients[nclients++];
+		memset(client, 0, sizeof(*client));
+		client->fd = fd;
+		client->active = time(NULL);
+	}
+}
+
+/* Disconnects clients that didn't exchange any data for a while. */
+static void
+drop_idle_clients(void)
+{
+	const time_t now = time(NULL);
+	int i = 0;
+	while(i < nclients)
+	{
+		if(now - clients[i].active > CLIENT_TIMEOUT)
+		{
+			drop_client(i);
+			continue;
+		}
+		++i;
+	}
+}
+
+/* Reads requests of the client, processes them and sends replies.  Returns
+ * zero if connection should be kept and non-zero otherwise. */
+static int
+serve_client(client_t *client)
+{
+	while(client->out_len < OUT_LIMIT)
+	{
+		char buf[4096];
+		ssize_t nread;
+
+		if(client->in_len >= sizeof(uint32_t))
+		{
+			uint32_t size;
+			memcpy(&size, client->in, sizeof(size));
+
+			if(size > MAX_PKG_SIZE)
+			{
+				return 1;
+			}
+
+			if(client->in_len - sizeof(size) >= size)
+			{
+				if(handle_request(client, client->in + sizeof(size), size) != 0)
+				{
+					return 1;
+				}
+
+				client->in_len -= sizeof(size) + size;
+				memmove(client->in, client->in + sizeof(size) + size, client->in_len);
+
+				if(flush_replies(client) != 0)
+				{
+					return 1;
+				}
+				continue;
+			}
+		}
+
+		if(client->eof)
+		{
+			break;
+		}
+
+		nread = recv(client->fd, buf, sizeof(buf), 0);
+		if(nread > 0)
+		{
+			client->active = time(NULL);
+			if(append_data(&client->in, &client->in_len, buf, nread) != 0)
+			{
+				return 1;
+			}
+		}
+		else if(nread == 0)
+		{
+			client->eof = 1;
+		}
+		else if(errno != EINTR)
+		{
+			if(errno != EAGAIN && errno != EWOULDBLOCK)
+			{
+				return 1;
+			}
+			break;
+		}
+	}
+
+	if(flush_replies(client) != 0)
+	{
+		return 1;
+	}
+
+	/* Nothing else can happen after client stopped sending requests and got all
+	 * the replies. */
+	return (client->eof && client->out_len == 0U);
+}
+
+/* Processes single request of the client and queues reply to it.  Returns
+ * zero on success and non-zero otherwise. */
+static int
+handle_request(client_t *client, const char payload[], size_t len)
+{
+	size_t pkg_len;
+	char *pkg;
+	int ret;
+
+	strlist_t reply = process_pkg(payload, len);
+	pkg = make_pkg(reply.items, reply.nitems, &pkg_len);
+	free_string_array(reply.items, reply.nitems);
+
+	if(pkg == NULL)
+	{
+		char *error[] = { "error", "Reply is too large" };
+		pkg = make_pkg(error, 2, &pkg_len);
+		if(pkg == NULL)
+		{
+			return 1;
+		}
+	}
+
+	ret = append_data(&client->out, &client->out_len, pkg, pkg_len);
+	free(pkg);
+	return ret;
+}
+
+/* Sends as many queued replies as possible without blocking.  Returns zero on
+ * success and non-zero if connection is broken. */
+static int
+flush_replies(client_t *client)
+{
+	while(client->out_len != 0U)
+	{
+		const ssize_t nsent = send(client->fd, client->out, client->out_len,
+				MSG_NOSIGNAL);
+		if(nsent < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return (errno != EAGAIN && errno != EWOULDBLOCK);
+		}
+
+		client->out_len -= nsent;
+		memmove(client->out, client->out + nsent, client->out_len);
+		client->active = time(NULL);
+	}
+	return 0;
+}
+
+/* Closes connection of the client and removes it from the list. */
+static void
+drop_client(int index)
+{
+	client_t *const client = &clients[index];
+
+	close(client->fd);
+	free(client->in);
+	free(client->out);
+
+	clients[index] = clients[--nclients];
+}
+
+/* Appends data to a buffer.  Returns zero on success and non-zero
  * otherwise. */
 static int
-pipe_is_in_use(const char path[])
+append_data(char **buf, size_t *len, const char data[], size_t n)
 {
-	const int fd = open(path, O_WRONLY | O_NONBLOCK);
-	if(fd != -1 || errno != ENXIO)
+	char *const new_buf = realloc(*buf, *len + n);
+	if(new_buf == NULL)
 	{
-		if(fd != -1)
+		return 1;
+	}
+
+	memcpy(new_buf + *len, data, n);
+	*buf = new_buf;
+	*len += n;
+	return 0;
+}
+
+/* Waits for a reply and parses it.  Returns zero on success and non-zero
+ * otherwise. */
+static int
+receive_reply(int fd, strlist_t *reply)
+{
+	uint32_t size;
+	char *payload;
+
+	if(recv_all(fd, (char *)&size, sizeof(size)) != 0 || size > MAX_PKG_SIZE)
+	{
+		return 1;
+	}
+
+	payload = malloc(size + 1U);
+	if(payload == NULL)
+	{
+		return 1;
+	}
+
+	if(recv_all(fd, payload, size) != 0)
+	{
+		free(payload);
+		return 1;
+	}
+
+	*reply = parse_payload(payload, size);
+	free(payload);
+	return (reply->nitems == 0);
+}
+
+/* Sends all the data blocking if needed.  Returns zero on success and non-zero
+ * otherwise. */
+static int
+send_all(int fd, const char data[], size_t len)
+{
+	while(len != 0U)
+	{
+		const ssize_t nsent = send(fd, data, len, MSG_NOSIGNAL);
+		if(nsent < 0)
 		{
-			close(fd);
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+
+		data += nsent;
+		len -= nsent;
+	}
+	return 0;
+}
+
+/* Receives exactly len bytes blocking if needed.  Returns zero on success and
+ * non-zero otherwise. */
+static int
+recv_all(int fd, char data[], size_t len)
+{
+	while(len != 0U)
+	{
+		const ssize_t nread = recv(fd, data, len, 0);
+		if(nread <= 0)
+		{
+			if(nread < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
 		}
+
+		data += nread;
+		len -= nread;
+	}
+	return 0;
+}
+
+/* Opens connection to a server.  Returns connected socket or -1 on error with
+ * errno set. */
+static int
+connect_to(const char path[])
+{
+	struct sockaddr_un addr;
+	int error;
+	int fd;
+
+	if(fill_address(&addr, path) != 0)
+	{
+		errno = ENOENT;
+		return -1;
+	}
+
+	fd = new_socket(0);
+	if(fd == -1)
+	{
+		return -1;
+	}
+
+	/* Unresponsive server (e.g., one with full backlog) shouldn't block us
+	 * forever.  On timeout of connect() errno is set to EAGAIN, so the server is
+	 * still considered to be in use. */
+	if(set_io_timeout(fd) != 0)
+	{
+		error = errno;
+		close(fd);
+		errno = error;
+		return -1;
+	}
+
+	if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+	{
+		return fd;
+	}
+
+	error = errno;
+	close(fd);
+	errno = error;
+	return -1;
+}
+
+/* Creates a socket for local communication.  Returns the socket or -1 on
+ * error. */
+static int
+new_socket(int nonblocking)
+{
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd != -1 && setup_socket(fd, nonblocking) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* Prevents the socket from being inherited by child processes and from raising
+ * SIGPIPE and optionally makes it non-blocking.  Returns zero on success and
+ * non-zero otherwise. */
+static int
+setup_socket(int fd, int nonblocking)
+{
+	if(fcntl(fd, F_SETFD, FD_CLOEXEC) != 0)
+	{
+		return 1;
+	}
+
+	if(nonblocking)
+	{
+		const int flags = fcntl(fd, F_GETFL);
+		if(flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)
+		{
+			return 1;
+		}
+	}
+
+#ifdef SO_NOSIGPIPE
+	{
+		const int on = 1;
+		(void)setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	}
+#endif
+
+	return 0;
+}
+
+/* Limits time blocking operations on the socket can take.  Returns zero on
+ * success and non-zero otherwise with errno set. */
+static int
+set_io_timeout(int fd)
+{
+	const struct timeval tv = { .tv_sec = IO_TIMEOUT };
+	return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0
+	    || setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0;
+}
+
+/* Fills address structure for the path.  Returns zero on success and non-zero
+ * if the path is too long. */
+static int
+fill_address(struct sockaddr_un *addr, const char path[])
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+
+	if(strlen(path) >= sizeof(addr->sun_path))
+	{
 		return 1;
 	}
+
+	strcpy(addr->sun_path, path);
 	return 0;
 }
 
+/* Binds socket to the address making it accessible only by current user.
+ * Returns zero on success and non-zero otherwise with errno set. */
+static int
+bind_socket(int fd, const struct sockaddr_un *addr)
+{
+	const mode_t old_umask = umask(0077);
+	const int result = bind(fd, (const struct sockaddr *)addr, sizeof(*addr));
+	(void)umask(old_umask);
+	return result;
+}
+
+/* Checks whether the path is a socket that's left by an instance that didn't
+ * exit cleanly.  Returns non-zero if so and zero otherwise. */
+static int
+socket_is_abandoned(const char path[])
+{
+	struct stat statbuf;
+	return lstat(path, &statbuf) == 0
+	    && S_ISSOCK(statbuf.st_mode)
+	    && !socket_is_in_use(path);
+}
+
+/* Tries to connect to a socket to check whether it has a server or it's
+ * abandoned.  Returns non-zero if somebody is listening on the socket and zero
+ * otherwise. */
+static int
+socket_is_in_use(const char path[])
+{
+	const int fd = connect_to(path);
+	if(fd != -1)
+	{
+		close(fd);
+		return 1;
+	}
+	return (errno != ECONNREFUSED && errno != ENOENT);
+}
+
+#else
+
+/* Receives message addressed to this instance.  Returns NULL if there was no
+ * message or on failure to read it, otherwise newly allocated payload of *len
+ * bytes is returned. */
+static char *
+receive_pkg(size_t *len)
+{
+	uint32_t size;
+	char *pkg;
+	char *p;
+	DWORD nread;
+
+	if(ReadFile(server, &size, sizeof(size), &nread, NULL) == FALSE ||
+			size > MAX_PKG_SIZE)
+	{
+		return NULL;
+	}
+
+	pkg = malloc(size + 1U);
+	if(pkg == NULL)
+	{
+		return NULL;
+	}
+
+	*len = size;
+
+	p = pkg;
+	while(size != 0U)
+	{
+		/* TODO: maybe use OVERLAPPED I/O on Windows instead, it's just so
+		 *       inconvenient... */
+		usleep(10000);
+
+		if(ReadFile(server, p, size, &nread, NULL) == FALSE || nread == 0U)
+		{
+			break;
+		}
+
+		size -= nread;
+		p += nread;
+	}
+
+	/* Weird requirement for named pipes, need to break and set connection every
+	 * time. */
+	DisconnectNamedPipe(server);
+	ConnectNamedPipe(server, NULL);
+
+	if(size != 0U)
+	{
+		free(pkg);
+		return NULL;
+	}
+
+	return pkg;
+}
+
 #endif
 
 #endif
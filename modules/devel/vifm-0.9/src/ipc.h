@@ -19,11 +19,33 @@
 #ifndef VIFM__IPC_H__
 #define VIFM__IPC_H__
 
+#include "utils/selector.h"
+#include "utils/string_array.h"
+
+/* Every message (in both directions) is a package that consists of 32-bit
+ * length of its payload followed by the payload, which is a sequence of
+ * null-terminated strings.  First string of a request specifies its kind, the
+ * rest are its arguments.  First string of a reply is either "ok" (followed
+ * by results) or "error" (followed by error message).  Clients can send any
+ * number of requests over a single connection without waiting for replies,
+ * each request gets exactly one reply and replies come in order of requests.
+ *
+ * Request kinds handled by this unit:
+ *  - "args" -- cwd and command-line arguments, passed to ipc_callback.
+ * All other requests are passed to ipc_request_callback.
+ *
+ * On Windows communication is one way (replies are never sent). */
+
 /* Type of function that is invoked on IPC receive.  args is NULL terminated
  * array of arguments, args[0] is absolute path at which they should be
  * processed. */
 typedef void (*ipc_callback)(char *args[]);
 
+/* Type of function that is invoked to handle requests other than "args".
+ * request is NULL terminated array, request[0] is kind of the request.
+ * Returns reply, which is freed by the caller. */
+typedef strlist_t (*ipc_request_callback)(char *request[]);
+
 /* Checks whether IPC is in use.  Returns non-zero if so, otherwise zero is
  * returned. */
 int ipc_enabled(void);
@@ -33,20 +55,34 @@ int ipc_enabled(void);
 char ** ipc_list(int *len);
 
 /* Initializes IPC unit state.  name can be NULL, which will use the default
- * one (VIFM).  The callback_func will be called by ipc_check(). */
-void ipc_init(const char name[], ipc_callback callback_func);
+ * one (VIFM).  The callback_func and request_func will be called by
+ * ipc_check(), request_func can be NULL. */
+void ipc_init(const char name[], ipc_callback callback_func,
+		ipc_request_callback request_func);
 
 /* Retrieves name of the IPC server.  Returns the name or an empty string if IPC
  * is not available (ipc_enabled() returns zero). */
 const char * ipc_get_name(void);
 
-/* Checks for incoming messages.  Calls callback passed to ipc_init(). */
+/* Accepts new connections, processes incoming requests and sends replies to
+ * them.  Calls callbacks passed to ipc_init().  Doesn't block. */
 void ipc_check(void);
 
-/* Sends data to server.  The data array should end with NULL.  Returns zero on
- * successful send and non-zero otherwise. */
+/* Adds descriptors that need ipc_check() call once they are ready to the
+ * selector.  Returns non-zero if ipc_check() should also be called
+ * periodically (to disconnect idle clients), otherwise zero is returned. */
+int ipc_watch(selector_t *selector);
+
+/* Sends data to server as "args" request without waiting for reply.  whom can
+ * be NULL to pick the first available server.  The data array should end with
+ * NULL.  Returns zero on successful send and non-zero otherwise. */
 int ipc_send(const char whom[], char *data[]);
 
+/* Sends request to server and waits for reply to it.  whom can be NULL to pick
+ * the first available server.  The request array should end with NULL.
+ * Returns the reply, which is empty on failure. */
+strlist_t ipc_request(const char whom[], char *request[]);
+
 #endif /* VIFM__IPC_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -0,0 +1,207 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "ipc_handlers.h"
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strcmp() */
+
+#include "compat/fs_limits.h"
+#include "engine/text_buffer.h"
+#include "ui/statusbar.h"
+#include "ui/ui.h"
+#include "utils/path.h"
+#include "utils/str.h"
+#include "cmd_core.h"
+#include "filelist.h"
+#include "status.h"
+
+static strlist_t run_commands(char *cmds[]);
+static strlist_t eval_exprs(char *exprs[]);
+static strlist_t query_state(char *args[]);
+static strlist_t make_reply(const char status[]);
+static strlist_t make_error(const char msg[]);
+static void add_path(strlist_t *reply, const dir_entry_t *entry);
+
+strlist_t
+ipc_handle_request(char *request[])
+{
+	if(strcmp(request[0], "cmd") == 0)
+	{
+		return run_commands(request + 1);
+	}
+	if(strcmp(request[0], "expr") == 0)
+	{
+		return eval_exprs(request + 1);
+	}
+	if(strcmp(request[0], "query") == 0)
+	{
+		return query_state(request + 1);
+	}
+	return make_error("Unknown request");
+}
+
+/* Executes command-lines one by one until the first error.  Returns reply. */
+static strlist_t
+run_commands(char *cmds[])
+{
+	for(; *cmds != NULL; ++cmds)
+	{
+		curr_stats.save_msg = exec_commands(*cmds, curr_view, CIT_COMMAND);
+		if(curr_stats.save_msg < 0)
+		{
+			const char *const msg = get_last_message();
+			char *const error = format_str("%s: %s", *cmds,
+					(msg == NULL) ? "Command failed" : msg);
+			strlist_t reply = make_error(error);
+			free(error);
+			return reply;
+		}
+	}
+
+	return make_reply("ok");
+}
+
+/* Evaluates expressions.  Returns reply with their values. */
+static strlist_t
+eval_exprs(char *exprs[])
+{
+	strlist_t reply = make_reply("ok");
+
+	for(; *exprs != NULL; ++exprs)
+	{
+		const char *error_pos = NULL;
+		char *value = NULL;
+
+		vle_tb_clear(vle_err);
+		if((*exprs)[0] != '\0')
+		{
+			value = eval_arglist(*exprs, &error_pos);
+		}
+
+		if(value == NULL)
+		{
+			char *const error = format_str("Invalid expression: %s",
+					(error_pos == NULL) ? *exprs : error_pos);
+			free_string_array(reply.items, reply.nitems);
+			reply = make_error(error);
+			free(error);
+			break;
+		}
+
+		if(put_into_string_array(&reply.items, reply.nitems, value) ==
+				reply.nitems)
+		{
+			free(value);
+			free_string_array(reply.items, reply.nitems);
+			reply = make_error("Not enough memory");
+			break;
+		}
+		++reply.nitems;
+	}
+
+	return reply;
+}
+
+/* Queries state of the current view.  Returns reply with the result. */
+static strlist_t
+query_state(char *args[])
+{
+	strlist_t reply;
+	const char *const what = args[0];
+
+	if(what == NULL || args[1] != NULL)
+	{
+		return make_error("Query expects exactly one argument");
+	}
+
+	if(strcmp(what, "cwd") == 0)
+	{
+		reply = make_reply("ok");
+		reply.nitems = add_to_string_array(&reply.items, reply.nitems, 1,
+				flist_get_dir(curr_view));
+	}
+	else if(strcmp(what, "current") == 0)
+	{
+		reply = make_reply("ok");
+		if(curr_view->list_rows > 0 &&
+				!fentry_is_fake(&curr_view->dir_entry[curr_view->list_pos]))
+		{
+			add_path(&reply, &curr_view->dir_entry[curr_view->list_pos]);
+		}
+	}
+	else if(strcmp(what, "selection") == 0)
+	{
+		dir_entry_t *entry = NULL;
+		reply = make_reply("ok");
+		while(iter_selected_entries(curr_view, &entry))
+		{
+			add_path(&reply, entry);
+		}
+	}
+	else if(strcmp(what, "list") == 0)
+	{
+		int i;
+		reply = make_reply("ok");
+		for(i = 0; i < curr_view->list_rows; ++i)
+		{
+			const dir_entry_t *const entry = &curr_view->dir_entry[i];
+			if(!fentry_is_fake(entry) && !is_parent_dir(entry->name))
+			{
+				add_path(&reply, entry);
+			}
+		}
+	}
+	else
+	{
+		reply = make_error("Unknown query");
+	}
+
+	return reply;
+}
+
+/* Makes reply that consists of a status only.  Returns the reply. */
+static strlist_t
+make_reply(const char status[])
+{
+	strlist_t reply = {};
+	reply.nitems = add_to_string_array(&reply.items, reply.nitems, 1, status);
+	return reply;
+}
+
+/* Makes reply that reports an error.  Returns the reply. */
+static strlist_t
+make_error(const char msg[])
+{
+	strlist_t reply = make_reply("error");
+	reply.nitems = add_to_string_array(&reply.items, reply.nitems, 1, msg);
+	return reply;
+}
+
+/* Appends full path of the entry to the reply. */
+static void
+add_path(strlist_t *reply, const dir_entry_t *entry)
+{
+	char path[PATH_MAX];
+	get_full_path_of(entry, sizeof(path), path);
+	reply->nitems = add_to_string_array(&reply->items, reply->nitems, 1, path);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,41 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IPC_HANDLERS_H__
+#define VIFM__IPC_HANDLERS_H__
+
+#include "utils/string_array.h"
+
+/* Handling of requests received via IPC other than passing command-line
+ * arguments.  Supported kinds of requests:
+ *  - "cmd" -- executes each of its arguments as a command-line, stops at the
+ *             first failure;
+ *  - "expr" -- evaluates each of its arguments as an expression and replies
+ *              with their values;
+ *  - "query" -- replies with information about state of the current view, its
+ *               argument is one of "cwd", "current", "selection" or "list"
+ *               (omits ".." entry). */
+
+/* Processes request.  request is NULL terminated array, request[0] is kind of
+ * the request.  Returns reply, which should be freed by the caller. */
+strlist_t ipc_handle_request(char *request[]);
+
+#endif /* VIFM__IPC_HANDLERS_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -45,6 +45,10 @@ void modes_pre(void);
 /* Executes poll-based requests for any of the active modes. */
 void modes_periodic(void);
 
+/* Checks whether any of the active modes relies on modes_periodic() being
+ * called regularly.  Returns non-zero if so, otherwise zero is returned. */
+int modes_periodic_is_needed(void);
+
 void modes_post(void);
 
 void modes_redraw(void);
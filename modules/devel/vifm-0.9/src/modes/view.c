@@ -21,6 +21,7 @@
 #include <curses.h>
 
 #include <regex.h>
+#include <sys/time.h> /* gettimeofday() */
 #include <unistd.h> /* usleep() */
 
 #include <assert.h> /* assert() */
@@ -33,6 +34,7 @@
 #include "../compat/curses.h"
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/pthread.h"
 #include "../compat/reallocarray.h"
 #include "../engine/keys.h"
 #include "../engine/mode.h"
@@ -46,6 +48,7 @@
 #include "../ui/quickview.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/filemap.h"
 #include "../utils/filemon.h"
 #include "../utils/fs.h"
 #include "../utils/macros.h"
@@ -65,6 +68,16 @@
 #include "normal.h"
 #include "wk.h"
 
+/* Maximum number of bytes of a line of mapped file that are displayed. */
+#define MAX_MAPPED_LINE_LEN (256*1024)
+
+/* Period of checking for cancellation of search in mapped file in
+ * microseconds. */
+#define SEARCH_POLL_PERIOD 50000
+
+/* Time in microseconds before displaying progress of search. */
+#define PROGRESS_DELAY 100000
+
 /* Named boolean values of "silent" parameter for better readability. */
 enum
 {
@@ -72,6 +85,14 @@ enum
 	SILENT,   /* Do not display error message dialog. */
 };
 
+/* Line of the view prepared for drawing. */
+typedef struct
+{
+	size_t key; /* Line number or offset of the line in mapped file. */
+	char *line; /* Line with search matches highlighted. */
+}
+prepared_line_t;
+
 /* Describes view state and its properties. */
 typedef struct
 {
@@ -83,6 +104,14 @@ typedef struct
 	int line;         /* Current real line number. */
 	int linev;        /* Current virtual line number. */
 
+	/* Data of the view that is backed by a mapped file.  Lines aren't loaded
+	 * into memory in this case, position is tracked by file offset instead of
+	 * line numbers, which are known only after indexing. */
+	filemap_t *map; /* Mapped file or NULL if data is in memory. */
+	size_t top;     /* Offset of the first visible line. */
+	int top_row;    /* Number of screen lines of the first line above view. */
+	int indexed;    /* Whether ruler displays complete index information. */
+
 	/* Dimensions, units of actions. */
 	int win_size; /* Scroll window size. */
 	int half_win; /* Height of a "page" (can be changed). */
@@ -96,6 +125,13 @@ typedef struct
 	regex_t re;               /* Search regular expression. */
 	int last_search_backward; /* Value -1 means no search was performed. */
 	int search_repeat;        /* Saved count prefix of search commands. */
+	char *literal;            /* Literal part of the pattern or NULL. */
+	int icase;                /* Whether case of the literal doesn't matter. */
+
+	/* Lines displayed during the last redraw, cached to avoid highlighting the
+	 * same lines over and over again. */
+	prepared_line_t *prepared; /* Lines sorted by their keys. */
+	int nprepared;             /* Number of elements in prepared array. */
 
 	/* The rest of the state. */
 	FileView *view; /* File view association with the view. */
@@ -127,6 +163,11 @@ static void calc_vlines(void);
 static void calc_vlines_wrapped(view_info_t *vi);
 static void calc_vlines_non_wrapped(view_info_t *vi);
 static void draw(void);
+static int draw_line(const char line[], int vl, int skip, esc_state *state);
+static void draw_mapped(void);
+static const char * prepare_line(view_info_t *vi, size_t key,
+		const char line[], prepared_line_t prepared[], int *nprepared);
+static void drop_prepared_lines(view_info_t *vi);
 static int get_part(const char line[], int offset, size_t max_len, char part[]);
 static void display_error(const char error_msg[]);
 static void cmd_ctrl_l(key_info_t key_info, keys_info_t *keys_info);
@@ -187,8 +228,23 @@ static int is_trying_the_same_file(void);
 static int get_file_to_explore(const FileView *view, char buf[],
 		size_t buf_len);
 static int forward_if_changed(view_info_t *vi);
+static int map_reopen(view_info_t *vi);
 static int scroll_to_bottom(view_info_t *vi);
 static void reload_view(view_info_t *vi, int silent);
+static int map_line_rows(const view_info_t *vi, size_t off);
+static int map_scroll_down(const view_info_t *vi, size_t *top, int *top_row,
+		int count);
+static int map_scroll_up(const view_info_t *vi, size_t *top, int *top_row,
+		int count);
+static void map_get_bottom(const view_info_t *vi, size_t *top, int *top_row);
+static int map_pos_cmp(size_t top_a, int row_a, size_t top_b, int row_b);
+static int map_get_line_num(const view_info_t *vi);
+static size_t map_find(view_info_t *vi, size_t off, int backward);
+static void * map_search_thread(void *arg);
+static int map_search_cancelled(void *arg);
+static void map_search_progress(size_t processed, void *arg);
+static void wait_for_search(pthread_cond_t *cond, pthread_mutex_t *lock);
+static int map_line_matches(const char line[], void *arg);
 
 static view_info_t view_info[VI_COUNT];
 static view_info_t* vi = &view_info[VI_QV];
@@ -424,6 +480,13 @@ try_activate_view_mode(void)
 void
 view_pre(void)
 {
+	/* Size of mapped file is checked once per key rather than on every access
+	 * by key handlers. */
+	if(vi->map != NULL)
+	{
+		filemap_refresh(vi->map);
+	}
+
 	if(curr_stats.save_msg == 0)
 	{
 		const char *const suffix = vi->auto_forward ? "(auto forwarding)" : "";
@@ -443,6 +506,31 @@ void
 view_ruler_update(void)
 {
 	char buf[POS_WIN_MIN_WIDTH + 1];
+
+	if(vi->map != NULL)
+	{
+		char line[16];
+		/* Line, "-", number of lines (at most 11 chars), "+", " " and null. */
+		char ruler[sizeof(line) + 1 + 11 + 3];
+		const int line_num = filemap_line_num(vi->map, vi->top);
+
+		vi->indexed = filemap_indexed(vi->map);
+
+		if(line_num < 0)
+		{
+			copy_str(line, sizeof(line), "?");
+		}
+		else
+		{
+			snprintf(line, sizeof(line), "%d", line_num + 1);
+		}
+
+		snprintf(ruler, sizeof(ruler), "%s-%d%s ", line,
+				filemap_line_count(vi->map), vi->indexed ? "" : "+");
+		ui_ruler_set(ruler);
+		return;
+	}
+
 	snprintf(buf, sizeof(buf), "%d-%d ", vi->line + 1, vi->nlines);
 
 	ui_ruler_set(buf);
@@ -549,10 +637,13 @@ free_view_info(view_info_t *vi)
 {
 	free_string_array(vi->lines, vi->nlines);
 	free(vi->widths);
+	filemap_close(vi->map);
 	if(vi->last_search_backward != -1)
 	{
 		regfree(&vi->re);
 	}
+	free(vi->literal);
+	drop_prepared_lines(vi);
 	free(vi->filename);
 	free(vi->viewer);
 }
@@ -579,6 +670,14 @@ calc_vlines(void)
 	vi->width = ui_qv_width(vi->view);
 	vi->wrap = cfg.wrap_quick_view;
 
+	if(vi->map != NULL)
+	{
+		/* Layout of lines is computed on demand, just make sure that position is
+		 * still valid. */
+		vi->top_row = 0;
+		return;
+	}
+
 	if(vi->wrap)
 	{
 		calc_vlines_wrapped(vi);
@@ -623,9 +722,9 @@ draw(void)
 	int l, vl;
 	const col_scheme_t *cs = ui_view_get_cs(vi->view);
 	const int height = ui_qv_height(vi->view);
-	const int width = ui_qv_width(vi->view);
 	const int max_l = MIN(vi->line + height, vi->nlines);
-	const int searched = (vi->last_search_backward != -1);
+	prepared_line_t *prepared;
+	int nprepared = 0;
 	esc_state state;
 
 	if(vi->graphics)
@@ -639,41 +738,183 @@ draw(void)
 		return;
 	}
 
+	if(vi->map != NULL)
+	{
+		draw_mapped();
+		return;
+	}
+
+	prepared = reallocarray(NULL, height, sizeof(*prepared));
+
 	esc_state_init(&state, &cs->color[WIN_COLOR]);
 
 	ui_view_erase(vi->view);
 
 	for(vl = 0, l = vi->line; l < max_l && vl < height; ++l)
 	{
-		int offset = 0;
-		int processed = 0;
-		char *const line = vi->lines[l];
-		char *p = searched ? esc_highlight_pattern(line, &vi->re) : line;
-		do
-		{
-			int printed;
-			const int vis = l != vi->line
-			             || vl + processed >= vi->linev - vi->widths[vi->line][0];
-			offset += esc_print_line(p + offset, vi->view->win, ui_qv_left(vi->view),
-					ui_qv_top(vi->view) + vl, width, !vis, &state, &printed);
-			vl += vis;
-			++processed;
-		}
-		while(vi->wrap && p[offset] != '\0' && vl < height);
-		if(searched)
+		const int skip = (l == vi->line) ? vi->linev - vi->widths[l][0] : 0;
+		const char *const line = prepare_line(vi, l, vi->lines[l], prepared,
+				&nprepared);
+		vl += draw_line(line, vl, skip, &state);
+	}
+	refresh_view_win(vi->view);
+
+	drop_prepared_lines(vi);
+	vi->prepared = prepared;
+	vi->nprepared = nprepared;
+
+	checked_wmove(vi->view->win, ui_qv_top(vi->view), ui_qv_left(vi->view));
+}
+
+/* Prints single line of the view starting at vl-th screen line.  First skip
+ * screen lines of wrapped line are not displayed.  Returns number of screen
+ * lines occupied on the screen. */
+static int
+draw_line(const char line[], int vl, int skip, esc_state *state)
+{
+	const int height = ui_qv_height(vi->view);
+	const int width = ui_qv_width(vi->view);
+	const int first_vl = vl;
+	int offset = 0;
+	int processed = 0;
+	do
+	{
+		int printed;
+		const int vis = processed >= skip;
+		offset += esc_print_line(line + offset, vi->view->win, ui_qv_left(vi->view),
+				ui_qv_top(vi->view) + vl, width, !vis, state, &printed);
+		vl += vis;
+		++processed;
+	}
+	while(vi->wrap && line[offset] != '\0' && vl < height);
+	return vl - first_vl;
+}
+
+/* Draws view that is backed by a mapped file. */
+static void
+draw_mapped(void)
+{
+	const col_scheme_t *cs = ui_view_get_cs(vi->view);
+	const int height = ui_qv_height(vi->view);
+	prepared_line_t *prepared;
+	int nprepared = 0;
+	size_t off = vi->top;
+	int vl = 0;
+	esc_state state;
+
+	filemap_refresh(vi->map);
+
+	prepared = reallocarray(NULL, height, sizeof(*prepared));
+
+	esc_state_init(&state, &cs->color[WIN_COLOR]);
+
+	ui_view_erase(vi->view);
+
+	while(vl < height && !filemap_at_end(vi->map, off))
+	{
+		const int skip = (off == vi->top) ? vi->top_row : 0;
+		const char *const line = prepare_line(vi, off, NULL, prepared, &nprepared);
+		if(line == NULL)
 		{
-			free(p);
+			break;
 		}
+
+		vl += draw_line(line, vl, skip, &state);
+
+		off = filemap_next_line(vi->map, off);
 	}
 	refresh_view_win(vi->view);
 
+	drop_prepared_lines(vi);
+	vi->prepared = prepared;
+	vi->nprepared = nprepared;
+
 	checked_wmove(vi->view->win, ui_qv_top(vi->view), ui_qv_left(vi->view));
 }
 
+/* Retrieves line identified by the key in a form suitable for drawing reusing
+ * result of previous redraw when possible.  The line is NULL for mapped files.
+ * The result is appended to prepared array.  Returns the line or NULL on
+ * error. */
+static const char *
+prepare_line(view_info_t *vi, size_t key, const char line[],
+		prepared_line_t prepared[], int *nprepared)
+{
+	const int searched = (vi->last_search_backward != -1);
+	char *copy = NULL;
+	char *result;
+	int i;
+
+	if(prepared == NULL)
+	{
+		return line;
+	}
+
+	for(i = 0; i < vi->nprepared; ++i)
+	{
+		if(vi->prepared[i].key == key && vi->prepared[i].line != NULL)
+		{
+			result = vi->prepared[i].line;
+			vi->prepared[i].line = NULL;
+			goto done;
+		}
+	}
+
+	if(line == NULL)
+	{
+		copy = filemap_get_line(vi->map, key, MAX_MAPPED_LINE_LEN);
+		if(copy == NULL)
+		{
+			return NULL;
+		}
+		line = copy;
+	}
+
+	if(!searched)
+	{
+		/* Nothing to cache for lines that are already in memory. */
+		if(copy == NULL)
+		{
+			return line;
+		}
+		result = copy;
+	}
+	else
+	{
+		result = esc_highlight_pattern(line, &vi->re);
+		free(copy);
+		if(result == NULL)
+		{
+			return NULL;
+		}
+	}
+
+done:
+	prepared[*nprepared].key = key;
+	prepared[*nprepared].line = result;
+	++*nprepared;
+	return result;
+}
+
+/* Frees lines that were prepared for drawing. */
+static void
+drop_prepared_lines(view_info_t *vi)
+{
+	int i;
+	for(i = 0; i < vi->nprepared; ++i)
+	{
+		free(vi->prepared[i].line);
+	}
+	free(vi->prepared);
+	vi->prepared = NULL;
+	vi->nprepared = 0;
+}
+
 int
 find_vwpattern(const char *pattern, int backward)
 {
 	int err;
+	int cflags;
 
 	if(pattern == NULL)
 		return 0;
@@ -681,7 +922,14 @@ find_vwpattern(const char *pattern, int backward)
 	if(vi->last_search_backward != -1)
 		regfree(&vi->re);
 	vi->last_search_backward = -1;
-	if((err = regcomp(&vi->re, pattern, get_regexp_cflags(pattern))) != 0)
+	drop_prepared_lines(vi);
+
+	free(vi->literal);
+	cflags = get_regexp_cflags(pattern);
+	vi->literal = regexp_get_literal(pattern, cflags);
+	vi->icase = (cflags & REG_ICASE);
+
+	if((err = regcomp(&vi->re, pattern, cflags)) != 0)
 	{
 		status_bar_errorf("Invalid pattern: %s", get_regexp_error(err, &vi->re));
 		regfree(&vi->re);
@@ -928,6 +1176,28 @@ cmd_percent(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count > 100)
 		key_info.count = 100;
 
+	if(vi->map != NULL)
+	{
+		const unsigned long long size = filemap_size(vi->map);
+		size_t top, bottom;
+		int bottom_row;
+
+		top = filemap_line_start(vi->map, (size*key_info.count)/100);
+		map_get_bottom(vi, &bottom, &bottom_row);
+		if(map_pos_cmp(top, 0, bottom, bottom_row) > 0)
+		{
+			vi->top = bottom;
+			vi->top_row = bottom_row;
+		}
+		else
+		{
+			vi->top = top;
+			vi->top_row = 0;
+		}
+		draw();
+		return;
+	}
+
 	vi->line = (key_info.count*vi->nlinesv)/100;
 	if(vi->line >= vi->nlines)
 		vi->line = vi->nlines - 1;
@@ -1055,6 +1325,11 @@ load_view_data(view_info_t *vi, const char action[], const char file_to_view[],
 			return 1;
 	}
 
+	if(vi->map != NULL)
+	{
+		return 0;
+	}
+
 	vi->widths = reallocarray(NULL, vi->nlines, sizeof(*vi->widths));
 	if(vi->widths == NULL)
 	{
@@ -1087,6 +1362,22 @@ get_view_data(view_info_t *vi, const char file_to_view[])
 		}
 		else
 		{
+			/* Regular files are mapped and indexed lazily, which makes opening of
+			 * huge files instant. */
+			vi->map = filemap_open(file_to_view);
+			if(vi->map != NULL)
+			{
+				if(filemap_size(vi->map) == 0U)
+				{
+					filemap_close(vi->map);
+					vi->map = NULL;
+					return 4;
+				}
+
+				(void)filemap_index_async(vi->map);
+				return 0;
+			}
+
 			fp = os_fopen(file_to_view, "rb");
 		}
 
@@ -1171,10 +1462,24 @@ replace_vi(view_info_t *const orig, view_info_t *const new)
 		orig->last_search_backward = -1;
 	}
 
+	new->literal = orig->literal;
+	orig->literal = NULL;
+	new->icase = orig->icase;
+
 	new->win_size = orig->win_size;
 	new->half_win = orig->half_win;
 	new->line = orig->line;
 	new->linev = orig->linev;
+	if(new->map != NULL)
+	{
+		new->top = filemap_line_start(new->map, orig->top);
+		new->top_row = (new->top == orig->top) ? orig->top_row : 0;
+		if(filemap_at_end(new->map, new->top))
+		{
+			/* File got shorter, show its end. */
+			map_get_bottom(new, &new->top, &new->top_row);
+		}
+	}
 	new->view = orig->view;
 	new->auto_forward = orig->auto_forward;
 	filemon_assign(&new->file_mon, &orig->file_mon);
@@ -1220,6 +1525,26 @@ cmd_g(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
 
+	if(vi->map != NULL)
+	{
+		size_t top, bottom;
+		int bottom_row;
+
+		top = filemap_line_offset(vi->map, key_info.count - 1);
+		map_get_bottom(vi, &bottom, &bottom_row);
+		if(map_pos_cmp(top, 0, bottom, bottom_row) > 0)
+		{
+			top = bottom;
+		}
+
+		if(top == vi->top && vi->top_row == 0)
+			return;
+		vi->top = top;
+		vi->top_row = 0;
+		draw();
+		return;
+	}
+
 	key_info.count = MIN(vi->nlinesv - ui_qv_height(vi->view), key_info.count);
 	key_info.count = MAX(1, key_info.count);
 
@@ -1233,6 +1558,36 @@ cmd_g(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_j(key_info_t key_info, keys_info_t *keys_info)
 {
+	if(vi->map != NULL)
+	{
+		size_t bottom;
+		int bottom_row;
+		int moved = 0;
+
+		if(key_info.count == NO_COUNT_GIVEN)
+			key_info.count = 1;
+
+		if(key_info.reg != NO_REG_GIVEN)
+		{
+			moved = map_scroll_down(vi, &vi->top, &vi->top_row, key_info.count);
+		}
+		else
+		{
+			map_get_bottom(vi, &bottom, &bottom_row);
+			while(key_info.count-- > 0 &&
+					map_pos_cmp(vi->top, vi->top_row, bottom, bottom_row) < 0)
+			{
+				moved += map_scroll_down(vi, &vi->top, &vi->top_row, 1);
+			}
+		}
+
+		if(moved)
+		{
+			draw();
+		}
+		return;
+	}
+
 	if(key_info.reg == NO_REG_GIVEN)
 	{
 		if((vi->linev + 1) + ui_qv_height(vi->view) > vi->nlinesv)
@@ -1267,6 +1622,17 @@ cmd_j(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_k(key_info_t key_info, keys_info_t *keys_info)
 {
+	if(vi->map != NULL)
+	{
+		if(key_info.count == NO_COUNT_GIVEN)
+			key_info.count = 1;
+		if(map_scroll_up(vi, &vi->top, &vi->top_row, key_info.count) != 0)
+		{
+			draw();
+		}
+		return;
+	}
+
 	if(vi->linev == 0)
 		return;
 
@@ -1335,6 +1701,24 @@ find_previous(int vline_offset)
 	char buf[ui_qv_width(vi->view)*4];
 	int vl, l;
 
+	if(vi->map != NULL)
+	{
+		const size_t off = map_find(vi, vi->top, 1);
+		if(!filemap_at_end(vi->map, off))
+		{
+			vi->top = off;
+			vi->top_row = 0;
+			draw();
+			return;
+		}
+		draw();
+		if(!curr_stats.save_msg)
+		{
+			display_error("Pattern not found");
+		}
+		return;
+	}
+
 	vl = vi->linev - vline_offset;
 	l = vi->line;
 
@@ -1379,6 +1763,24 @@ find_next(void)
 	char buf[ui_qv_width(vi->view)*4];
 	int vl, l;
 
+	if(vi->map != NULL)
+	{
+		const size_t off = map_find(vi, vi->top, 0);
+		if(!filemap_at_end(vi->map, off))
+		{
+			vi->top = off;
+			vi->top_row = 0;
+			draw();
+			return;
+		}
+		draw();
+		if(!curr_stats.save_msg)
+		{
+			display_error("Pattern not found");
+		}
+		return;
+	}
+
 	vl = vi->linev + 1;
 	l = vi->line;
 
@@ -1475,8 +1877,9 @@ static void
 cmd_v(key_info_t key_info, keys_info_t *keys_info)
 {
 	char path[PATH_MAX];
+	const int line = (vi->map != NULL) ? map_get_line_num(vi) : vi->line;
 	get_current_full_path(curr_view, sizeof(path), path);
-	(void)vim_view_file(path, vi->line + ui_qv_height(vi->view)/2, -1, 1);
+	(void)vim_view_file(path, line + ui_qv_height(vi->view)/2, -1, 1);
 	/* In some cases two redraw operations are needed, otherwise TUI is not fully
 	 * redrawn. */
 	update_screen(UT_REDRAW);
@@ -1600,18 +2003,35 @@ view_check_for_updates(void)
 	need_redraw += forward_if_changed(&view_info[VI_LWIN]);
 	need_redraw += forward_if_changed(&view_info[VI_RWIN]);
 
+	/* Reflect progress of background indexing. */
+	if(vle_mode_is(VIEW_MODE) && vi->map != NULL && !vi->indexed)
+	{
+		view_ruler_update();
+	}
+
 	if(need_redraw)
 	{
 		schedule_redraw();
 	}
 }
 
-/* Forwards the view if underlying file changed.  Returns non-zero if reload
- * occurred, otherwise zero is returned. */
+int
+view_needs_updates_check(void)
+{
+	return view_info[VI_QV].auto_forward
+	    || view_info[VI_LWIN].auto_forward
+	    || view_info[VI_RWIN].auto_forward
+	    || (vle_mode_is(VIEW_MODE) && vi->map != NULL && !vi->indexed);
+}
+
+/* Forwards the view if underlying file changed.  Mapped files are extended in
+ * place unless they were truncated or replaced.  Returns non-zero if view needs
+ * to be redrawn, otherwise zero is returned. */
 static int
 forward_if_changed(view_info_t *vi)
 {
 	filemon_t mon;
+	int truncated;
 
 	if(!vi->auto_forward)
 	{
@@ -1623,21 +2043,86 @@ forward_if_changed(view_info_t *vi)
 		return 0;
 	}
 
-	if(filemon_equal(&mon, &vi->file_mon))
+	/* Size is checked explicitly, because truncation isn't necessarily visible
+	 * in timestamps yet while old mapping shouldn't be used past new end. */
+	truncated = (vi->map != NULL && filemap_truncated(vi->map));
+	if(!truncated && filemon_equal(&mon, &vi->file_mon))
 	{
 		return 0;
 	}
 
 	filemon_assign(&vi->file_mon, &mon);
+
+	if(vi->map != NULL)
+	{
+		/* Process only data that was appended to the file if possible. */
+		const int result = truncated ? -1
+		                             : filemap_follow(vi->map, vi->filename);
+		if(result == 0)
+		{
+			return 0;
+		}
+		if(result > 0 || map_reopen(vi) == 0)
+		{
+			(void)filemap_index_async(vi->map);
+			vi->indexed = 0;
+			/* Last line might have been extended. */
+			drop_prepared_lines(vi);
+			(void)scroll_to_bottom(vi);
+			return 1;
+		}
+	}
+
 	reload_view(vi, SILENT);
 	return scroll_to_bottom(vi);
 }
 
+/* Replaces map of a file that was truncated or replaced with a new one.
+ * Unlike reload_view(), accepts empty files, because accessing old map of a
+ * truncated file isn't safe.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+map_reopen(view_info_t *vi)
+{
+	filemap_t *const map = filemap_open(vi->filename);
+	if(map == NULL)
+	{
+		return 1;
+	}
+
+	filemap_close(vi->map);
+	vi->map = map;
+
+	vi->top = filemap_line_start(map, vi->top);
+	vi->top_row = 0;
+	if(filemap_at_end(map, vi->top))
+	{
+		map_get_bottom(vi, &vi->top, &vi->top_row);
+	}
+	return 0;
+}
+
 /* Scrolls view to the bottom if there is any room for that.  Returns non-zero
  * if position was changed, otherwise zero is returned. */
 static int
 scroll_to_bottom(view_info_t *vi)
 {
+	if(vi->map != NULL)
+	{
+		size_t bottom;
+		int bottom_row;
+
+		map_get_bottom(vi, &bottom, &bottom_row);
+		if(map_pos_cmp(vi->top, vi->top_row, bottom, bottom_row) >= 0)
+		{
+			return 0;
+		}
+
+		vi->top = bottom;
+		vi->top_row = bottom_row;
+		return 1;
+	}
+
 	if(vi->linev + 1 + ui_qv_height(vi->view) > vi->nlinesv)
 	{
 		return 0;
@@ -1675,5 +2160,330 @@ reload_view(view_info_t *vi, int silent)
 	}
 }
 
+/* Computes number of screen lines occupied by a line of mapped file that starts
+ * at the off.  Returns the number. */
+static int
+map_line_rows(const view_info_t *vi, size_t off)
+{
+	char *line;
+	int width;
+
+	if(!vi->wrap)
+	{
+		return 1;
+	}
+
+	line = filemap_get_line(vi->map, off, MAX_MAPPED_LINE_LEN);
+	if(line == NULL)
+	{
+		return 1;
+	}
+
+	width = utf8_strsw_with_tabs(line, cfg.tab_stop) - esc_str_overhead(line);
+	free(line);
+	return MAX(DIV_ROUND_UP(width, vi->width), 1);
+}
+
+/* Moves position in mapped file count screen lines down, but not past the last
+ * screen line.  Returns number of screen lines moved by. */
+static int
+map_scroll_down(const view_info_t *vi, size_t *top, int *top_row, int count)
+{
+	int moved = 0;
+	while(moved < count)
+	{
+		if(*top_row + 1 < map_line_rows(vi, *top))
+		{
+			++*top_row;
+		}
+		else
+		{
+			const size_t next = filemap_next_line(vi->map, *top);
+			if(filemap_at_end(vi->map, next))
+			{
+				break;
+			}
+			*top = next;
+			*top_row = 0;
+		}
+		++moved;
+	}
+	return moved;
+}
+
+/* Moves position in mapped file count screen lines up, but not past the first
+ * screen line.  Returns number of screen lines moved by. */
+static int
+map_scroll_up(const view_info_t *vi, size_t *top, int *top_row, int count)
+{
+	int moved = 0;
+	while(moved < count)
+	{
+		if(*top_row > 0)
+		{
+			--*top_row;
+		}
+		else if(*top == 0U)
+		{
+			break;
+		}
+		else
+		{
+			*top = filemap_prev_line(vi->map, *top);
+			*top_row = map_line_rows(vi, *top) - 1;
+		}
+		++moved;
+	}
+	return moved;
+}
+
+/* Finds position in mapped file at which the last line is displayed at the
+ * bottom of the view.  Only the end of the file is examined. */
+static void
+map_get_bottom(const view_info_t *vi, size_t *top, int *top_row)
+{
+	*top = filemap_size(vi->map);
+	*top_row = 0;
+	(void)map_scroll_up(vi, top, top_row, ui_qv_height(vi->view));
+}
+
+/* Compares two positions within mapped file.  Returns negative value, zero or
+ * positive value if the first one is before, the same or after the second one
+ * respectively. */
+static int
+map_pos_cmp(size_t top_a, int row_a, size_t top_b, int row_b)
+{
+	if(top_a != top_b)
+	{
+		return (top_a < top_b) ? -1 : 1;
+	}
+	return row_a - row_b;
+}
+
+/* Retrieves number of the top line of mapped file, which might require
+ * indexing the file up to that point.  Returns the number. */
+static int
+map_get_line_num(const view_info_t *vi)
+{
+	int line = filemap_line_num(vi->map, vi->top);
+	if(line < 0)
+	{
+		filemap_index(vi->map);
+		line = filemap_line_num(vi->map, vi->top);
+	}
+	return line;
+}
+
+/* State of search in mapped file that's performed in background. */
+typedef struct
+{
+	filemap_search_t params; /* Parameters of the search and its progress. */
+	const filemap_t *map;    /* File being searched. */
+	size_t off;              /* Line from which the search starts. */
+	int backward;            /* Direction of the search. */
+	size_t result;           /* Offset of the found line. */
+
+	/* Fields below are protected by the lock. */
+	pthread_mutex_t lock;    /* Protects state of the search. */
+	pthread_cond_t changed;  /* Signaled on progress and completion. */
+	size_t processed;        /* Number of bytes processed so far. */
+	int done;                /* Whether the search has finished. */
+	int cancelled;           /* Whether the search should be stopped. */
+}
+map_search_t;
+
+/* Searches mapped file for a line that matches current pattern in a background
+ * thread, while displaying progress and handling cancellation requests.
+ * Returns offset of the line or filemap_size() if nothing was found or search
+ * was cancelled, in which case error message is displayed. */
+static size_t
+map_find(view_info_t *vi, size_t off, int backward)
+{
+	pthread_t thread;
+	struct timeval start, now;
+	int last_progress = -1;
+	int cancelled;
+	const size_t total = backward ? off : filemap_size(vi->map) - off;
+	map_search_t search = {
+		.params = {
+			.match = &map_line_matches,
+			.arg = vi,
+			.max_len = MAX_MAPPED_LINE_LEN,
+			.literal = vi->literal,
+			.icase = vi->icase,
+			/* Escape sequences are removed before matching. */
+			.special = "\033",
+			.cancel = { .hook = &map_search_cancelled },
+			.progress = &map_search_progress,
+		},
+		.map = vi->map,
+		.off = off,
+		.backward = backward,
+	};
+	search.params.cancel.arg = &search;
+	search.params.progress_arg = &search;
+
+	if(pthread_mutex_init(&search.lock, NULL) != 0)
+	{
+		search.params.cancel = no_cancellation;
+		search.params.progress = NULL;
+		return filemap_find(vi->map, off, backward, &search.params);
+	}
+	if(pthread_cond_init(&search.changed, NULL) != 0)
+	{
+		pthread_mutex_destroy(&search.lock);
+		search.params.cancel = no_cancellation;
+		search.params.progress = NULL;
+		return filemap_find(vi->map, off, backward, &search.params);
+	}
+
+	if(pthread_create(&thread, NULL, &map_search_thread, &search) != 0)
+	{
+		search.result = filemap_find(vi->map, off, backward, &search.params);
+		pthread_cond_destroy(&search.changed);
+		pthread_mutex_destroy(&search.lock);
+		return search.result;
+	}
+
+	ui_cancellation_reset();
+	ui_cancellation_enable();
+
+	show_progress("", 0);
+	(void)gettimeofday(&start, NULL);
+
+	pthread_mutex_lock(&search.lock);
+	while(!search.done)
+	{
+		const int progress = (total == 0U)
+		                   ? 100
+		                   : (int)((search.processed*100.0)/total);
+
+		if(ui_cancellation_requested())
+		{
+			search.cancelled = 1;
+		}
+
+		/* Don't bother displaying progress of searches that finish quickly. */
+		(void)gettimeofday(&now, NULL);
+		if((now.tv_sec - start.tv_sec)*1000000L + (now.tv_usec - start.tv_usec) >
+				PROGRESS_DELAY && progress != last_progress)
+		{
+			char progress_msg[64];
+			snprintf(progress_msg, sizeof(progress_msg), "Searching... %d%%",
+					progress);
+
+			/* Don't hold the search while drawing. */
+			pthread_mutex_unlock(&search.lock);
+			show_progress(progress_msg, -1);
+			pthread_mutex_lock(&search.lock);
+
+			last_progress = progress;
+			continue;
+		}
+
+		wait_for_search(&search.changed, &search.lock);
+	}
+	cancelled = search.cancelled;
+	pthread_mutex_unlock(&search.lock);
+
+	ui_cancellation_disable();
+	pthread_join(thread, NULL);
+	pthread_cond_destroy(&search.changed);
+	pthread_mutex_destroy(&search.lock);
+
+	if(cancelled)
+	{
+		display_error("Search was cancelled");
+		return filemap_size(vi->map);
+	}
+
+	if(last_progress != -1)
+	{
+		ui_sb_quick_msg_clear();
+	}
+	return search.result;
+}
+
+/* Waits until state of the search changes or it's time to check for
+ * cancellation request.  Must be called with the lock held. */
+static void
+wait_for_search(pthread_cond_t *cond, pthread_mutex_t *lock)
+{
+	struct timeval tv;
+	struct timespec ts;
+
+	(void)gettimeofday(&tv, NULL);
+	tv.tv_usec += SEARCH_POLL_PERIOD;
+	ts.tv_sec = tv.tv_sec + tv.tv_usec/1000000;
+	ts.tv_nsec = (tv.tv_usec%1000000)*1000;
+	(void)pthread_cond_timedwait(cond, lock, &ts);
+}
+
+/* Entry point of a background thread that searches in mapped file.  Returns
+ * NULL. */
+static void *
+map_search_thread(void *arg)
+{
+	map_search_t *const search = arg;
+	size_t result;
+
+	block_all_thread_signals();
+
+	result = filemap_find(search->map, search->off, search->backward,
+			&search->params);
+
+	pthread_mutex_lock(&search->lock);
+	search->result = result;
+	search->done = 1;
+	pthread_cond_signal(&search->changed);
+	pthread_mutex_unlock(&search->lock);
+	return NULL;
+}
+
+/* Cancellation hook for search in mapped file.  Returns non-zero if the search
+ * should be stopped. */
+static int
+map_search_cancelled(void *arg)
+{
+	map_search_t *const search = arg;
+	int cancelled;
+
+	pthread_mutex_lock(&search->lock);
+	cancelled = search->cancelled;
+	pthread_mutex_unlock(&search->lock);
+
+	return cancelled;
+}
+
+/* Progress callback for search in mapped file. */
+static void
+map_search_progress(size_t processed, void *arg)
+{
+	map_search_t *const search = arg;
+
+	pthread_mutex_lock(&search->lock);
+	search->processed = processed;
+	pthread_cond_signal(&search->changed);
+	pthread_mutex_unlock(&search->lock);
+}
+
+/* Checks whether line of mapped file matches current search pattern.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+map_line_matches(const char line[], void *arg)
+{
+	const view_info_t *const vi = arg;
+	int matches;
+	char *const no_esc = esc_remove(line);
+	if(no_esc == NULL)
+	{
+		return 0;
+	}
+
+	matches = (regexec(&vi->re, no_esc, 0, NULL, 0) == 0);
+	free(no_esc);
+	return matches;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -442,6 +442,7 @@ static const char *vifminfo_set[][2] = {
 	{ "registers", "contents of registers" },
 	{ "phistory",  "prompt history" },
 	{ "fhistory",  "local filter history" },
+	{ "journal",   "append history changes to a journal" },
 };
 
 /* Possible values of 'wildstyle'. */
@@ -1342,6 +1343,9 @@ process_set_args(const char args[], int global, int local)
 		scope = local ? OPT_LOCAL : OPT_GLOBAL;
 	}
 	set_options_error = (set_options(args, scope) != 0);
+	/* Options can affect appearance of file list cells in many ways. */
+	fview_reset_cells(&lwin);
+	fview_reset_cells(&rwin);
 	error |= set_options_error;
 	text_buffer = vle_tb_get_data(vle_err);
 
@@ -48,6 +48,7 @@ static void _gnuc_noreturn shutdown_nicely(int sig, const char descr[]);
 
 #include "utils/macros.h"
 #include "background.h"
+#include "event_loop.h"
 #include "status.h"
 
 /* Handle term resizing in X */
@@ -93,6 +94,9 @@ received_sigchld(void)
 			bg_process_finished_cb(pid, -1);
 		}
 	}
+
+	/* Let event loop notice finished jobs. */
+	event_loop_wake();
 }
 
 static void
@@ -23,11 +23,12 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() qsort() */
+#include <stdlib.h> /* abs() free() qsort() */
 #include <string.h> /* strcmp() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "ui/ui.h"
 #include "utils/dynarray.h"
 #include "utils/fs.h"
@@ -46,9 +47,11 @@
 static void sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 		size_t nchildren, int root);
 static void sort_sequence(dir_entry_t *entries, size_t nentries);
-static void sort_by_groups(dir_entry_t *entries, size_t nentries);
-static void sort_by_key(dir_entry_t *entries, size_t nentries, char key,
-		void *data);
+static void permute_entries(dir_entry_t *entries, dir_entry_t *order[],
+		size_t nentries);
+static void sort_by_groups(void *entries, size_t nentries);
+static void sort_by_key(void *entries, size_t nentries, char key, void *data);
+static dir_entry_t * get_entry(void *entries, size_t i);
 static int sort_dir_list(const void *one, const void *two);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
@@ -82,6 +85,8 @@ static int sort_descending;
 static SortingKey sort_type;
 /* Sorting key specific data. */
 static void *sort_data;
+/* Whether entries are sorted directly rather than via array of pointers. */
+static int sort_values;
 
 void
 sort_view(FileView *v)
@@ -184,11 +189,34 @@ sort_entries(FileView *v, entries_t entries)
 	sort_sequence(entries.entries, entries.nentries);
 }
 
-/* Sorts sequence of file entries (plain list, not tree). */
+/* Sorts sequence of file entries (plain list, not tree).  Sorting is performed
+ * on an array of pointers, so that entries themselves are moved only once.
+ * Falls back to sorting entries directly if the array can't be allocated. */
 static void
 sort_sequence(dir_entry_t *entries, size_t nentries)
 {
+	size_t j;
+	dir_entry_t **ptrs;
+	void *seq;
 	int i = SK_COUNT;
+
+	if(nentries == 0U)
+	{
+		return;
+	}
+
+	ptrs = reallocarray(NULL, nentries, sizeof(*ptrs));
+	if(ptrs != NULL)
+	{
+		for(j = 0U; j < nentries; ++j)
+		{
+			ptrs[j] = &entries[j];
+		}
+	}
+
+	sort_values = (ptrs == NULL);
+	seq = sort_values ? (void *)entries : (void *)ptrs;
+
 	while(--i >= 0)
 	{
 		const char sorting_key = view_sort[i];
@@ -200,22 +228,59 @@ sort_sequence(dir_entry_t *entries, size_t nentries)
 
 		if(sorting_key == SK_BY_GROUPS)
 		{
-			sort_by_groups(entries, nentries);
+			sort_by_groups(seq, nentries);
 			continue;
 		}
 
-		sort_by_key(entries, nentries, sorting_key, NULL);
+		sort_by_key(seq, nentries, sorting_key, NULL);
 	}
 
 	if(!ui_view_sort_list_contains(view_sort, SK_BY_DIR))
 	{
-		sort_by_key(entries, nentries, SK_BY_DIR, NULL);
+		sort_by_key(seq, nentries, SK_BY_DIR, NULL);
+	}
+
+	if(ptrs != NULL)
+	{
+		permute_entries(entries, ptrs, nentries);
+		free(ptrs);
+	}
+}
+
+/* Reorders entries in place to match the order.  The order is an array of
+ * pointers into the entries, which gets invalidated by this function. */
+static void
+permute_entries(dir_entry_t *entries, dir_entry_t *order[], size_t nentries)
+{
+	size_t i;
+
+	/* Each cycle of the permutation is rotated with a single temporary. */
+	for(i = 0U; i < nentries; ++i)
+	{
+		size_t j = i;
+		dir_entry_t tmp;
+
+		if(order[i] == &entries[i])
+		{
+			continue;
+		}
+
+		tmp = entries[i];
+		while(order[j] != &entries[i])
+		{
+			const size_t next = order[j] - entries;
+			entries[j] = entries[next];
+			order[j] = &entries[j];
+			j = next;
+		}
+		entries[j] = tmp;
+		order[j] = &entries[j];
 	}
 }
 
 /* Sorts specified range of entries according to sorting groups option. */
 static void
-sort_by_groups(dir_entry_t *entries, size_t nentries)
+sort_by_groups(void *entries, size_t nentries)
 {
 	char **groups = NULL;
 	int ngroups = 0;
@@ -245,9 +310,10 @@ sort_by_groups(dir_entry_t *entries, size_t nentries)
 	free_string_array(groups, ngroups);
 }
 
-/* Sorts specified range of entries by the key in a stable way. */
+/* Sorts specified range of entries (or pointers to them) by the key in a stable
+ * way. */
 static void
-sort_by_key(dir_entry_t *entries, size_t nentries, char key, void *data)
+sort_by_key(void *entries, size_t nentries, char key, void *data)
 {
 	unsigned int i;
 
@@ -262,10 +328,20 @@ sort_by_key(dir_entry_t *entries, size_t nentries, char key, void *data)
 
 	for(i = 0U; i < nentries; ++i)
 	{
-		entries[i].tag = i;
+		get_entry(entries, i)->tag = i;
 	}
 
-	qsort(entries, nentries, sizeof(*entries), &sort_dir_list);
+	qsort(entries, nentries,
+			sort_values ? sizeof(dir_entry_t) : sizeof(dir_entry_t *),
+			&sort_dir_list);
+}
+
+/* Retrieves i-th entry of a sequence being sorted.  Returns the entry. */
+static dir_entry_t *
+get_entry(void *entries, size_t i)
+{
+	return sort_values ? &((dir_entry_t *)entries)[i]
+	                   : ((dir_entry_t **)entries)[i];
 }
 
 /* Compares file names containing numbers correctly. */
@@ -335,8 +411,12 @@ sort_dir_list(const void *one, const void *two)
 	/* TODO: refactor this function sort_dir_list(). */
 
 	int retval;
-	const dir_entry_t *const first = one;
-	const dir_entry_t *const second = two;
+	const dir_entry_t *const first = sort_values
+	                               ? one
+	                               : *(dir_entry_t *const *)one;
+	const dir_entry_t *const second = sort_values
+	                                ? two
+	                                : *(dir_entry_t *const *)two;
 
 	const int first_is_dir = fentry_is_dir(first);
 	const int second_is_dir = fentry_is_dir(second);
@@ -446,12 +526,28 @@ sort_dir_list(const void *one, const void *two)
 			retval = first->mode - second->mode;
 			break;
 
-		case SK_BY_OWNER_NAME: /* FIXME */
+		case SK_BY_OWNER_NAME:
+			{
+				char first_name[NAME_MAX + 1], second_name[NAME_MAX + 1];
+				get_uid_string(first, 0, sizeof(first_name), first_name);
+				get_uid_string(second, 0, sizeof(second_name), second_name);
+				retval = strcmp(first_name, second_name);
+			}
+			break;
+
 		case SK_BY_OWNER_ID:
 			retval = first->uid - second->uid;
 			break;
 
-		case SK_BY_GROUP_NAME: /* FIXME */
+		case SK_BY_GROUP_NAME:
+			{
+				char first_name[NAME_MAX + 1], second_name[NAME_MAX + 1];
+				get_gid_string(first, 0, sizeof(first_name), first_name);
+				get_gid_string(second, 0, sizeof(second_name), second_name);
+				retval = strcmp(first_name, second_name);
+			}
+			break;
+
 		case SK_BY_GROUP_ID:
 			retval = first->gid - second->gid;
 			break;
@@ -45,6 +45,7 @@
 #include "utils/str.h"
 #include "utils/utils.h"
 #include "cmd_completion.h"
+#include "event_loop.h"
 #include "filelist.h"
 
 /* Environment variables by which application hosted by terminal multiplexer can
@@ -82,6 +83,8 @@ static pthread_mutex_t dcache_nitems_mutex = PTHREAD_MUTEX_INITIALIZER;
 static fsdata_t *dcache_size;
 /* Cache for directory item count. */
 static fsdata_t *dcache_nitems;
+/* Number of updates of directory caches, guarded by dcache_size_mutex. */
+static unsigned int dcache_updates;
 
 int
 init_status(config_t *config)
@@ -225,6 +228,10 @@ reset_dircache(void)
 	fsdata_free(dcache_nitems);
 	dcache_nitems = fsdata_create(0, 1);
 
+	pthread_mutex_lock(&dcache_size_mutex);
+	++dcache_updates;
+	pthread_mutex_unlock(&dcache_size_mutex);
+
 	return (dcache_size == NULL || dcache_nitems == NULL);
 }
 
@@ -232,6 +239,7 @@ void
 schedule_redraw(void)
 {
 	pending_redraw = 1;
+	event_loop_wake();
 }
 
 int
@@ -442,8 +450,22 @@ dcache_set_at(const char path[], uint64_t size, uint64_t nitems)
 		pthread_mutex_unlock(&dcache_nitems_mutex);
 	}
 
+	pthread_mutex_lock(&dcache_size_mutex);
+	++dcache_updates;
+	pthread_mutex_unlock(&dcache_size_mutex);
+
 	return ret;
 }
 
+unsigned int
+dcache_generation(void)
+{
+	unsigned int generation;
+	pthread_mutex_lock(&dcache_size_mutex);
+	generation = dcache_updates;
+	pthread_mutex_unlock(&dcache_size_mutex);
+	return generation;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
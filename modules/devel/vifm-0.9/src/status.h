@@ -245,6 +245,11 @@ void dcache_get_of(const struct dir_entry_t *entry, uint64_t *size,
  * non-zero is returned. */
 int dcache_set_at(const char path[], uint64_t size, uint64_t nitems);
 
+/* Retrieves number that changes on every update of the cache, which allows
+ * detecting whether anything retrieved from it might be outdated.  Returns the
+ * number. */
+unsigned int dcache_generation(void);
+
 #endif /* VIFM__STATUS_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -20,17 +20,40 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() malloc() */
 
+#include "../compat/reallocarray.h"
 #include "../utils/macros.h"
 #include "colors.h"
 
 /* Number of color pairs preallocated by curses library. */
 #define PREALLOCATED_COUNT 1
 
+/* Minimal number of hash buckets (power of two). */
+#define MIN_BUCKETS 64
+
+/* Information about dynamically allocated color pair. */
+typedef struct
+{
+	short int fg;  /* Foreground color. */
+	short int bg;  /* Background color. */
+	int next;      /* Next pair in the same hash bucket or -1. */
+	int more_used; /* Pair that was used after this one or -1. */
+	int less_used; /* Pair that was used before this one or -1. */
+}
+pair_info_t;
+
 static int find_pair(int fg, int bg);
-static int color_pair_matches(int pair, int fg, int bg);
 static int allocate_pair(int fg, int bg);
-static int compress_pair_space(void);
+static int evict_pair(void);
+static int ensure_capacity(int pair);
+static int rehash(int nbuckets);
+static void link_pair(int pair);
+static void unlink_pair(int pair);
+static void mark_used(int pair);
+static void append_use(int pair);
+static void remove_use(int pair);
+static int get_bucket(int fg, int bg);
 
 /* Number of color pairs available. */
 static int avail_pairs;
@@ -38,6 +61,22 @@ static int avail_pairs;
 /* Number of used color pairs. */
 static int used_pairs;
 
+/* Colors of pairs and their position in hash chains and list of uses, indexed
+ * by pair number. */
+static pair_info_t *pairs;
+/* Number of elements pairs array can hold. */
+static int pairs_capacity;
+
+/* Hash buckets that point to first pair of each chain or contain -1. */
+static int *buckets;
+/* Number of hash buckets (zero or power of two). */
+static int nbuckets;
+
+/* Most recently used pair or -1. */
+static int mru = -1;
+/* Least recently used pair or -1. */
+static int lru = -1;
+
 /* Configuration data passed in during initialization. */
 static colmgr_conf_t conf;
 
@@ -46,9 +85,7 @@ colmgr_init(const colmgr_conf_t *conf_init)
 {
 	assert(conf_init != NULL && "conf_init structure is required.");
 	assert(conf_init->init_pair != NULL && "init_pair must be set.");
-	assert(conf_init->pair_content != NULL && "pair_content must be set.");
 	assert(conf_init->pair_in_use != NULL && "pair_in_use must be set.");
-	assert(conf_init->move_pair != NULL && "move_pair must be set.");
 
 	conf = *conf_init;
 
@@ -58,8 +95,17 @@ colmgr_init(const colmgr_conf_t *conf_init)
 void
 colmgr_reset(void)
 {
+	int i;
+
 	used_pairs = PREALLOCATED_COUNT;
 	avail_pairs = conf.max_color_pairs - used_pairs;
+
+	for(i = 0; i < nbuckets; ++i)
+	{
+		buckets[i] = -1;
+	}
+	mru = -1;
+	lru = -1;
 }
 
 int
@@ -80,6 +126,7 @@ colmgr_get_pair(int fg, int bg)
 	p = find_pair(fg, bg);
 	if(p != -1)
 	{
+		mark_used(p);
 		return p;
 	}
 
@@ -92,102 +139,221 @@ colmgr_get_pair(int fg, int bg)
 static int
 find_pair(int fg, int bg)
 {
-	int i;
+	int p;
+
+	if(nbuckets == 0)
+	{
+		return -1;
+	}
 
-	for(i = PREALLOCATED_COUNT; i < used_pairs; ++i)
+	for(p = buckets[get_bucket(fg, bg)]; p != -1; p = pairs[p].next)
 	{
-		if(color_pair_matches(i, fg, bg))
+		if(pairs[p].fg == fg && pairs[p].bg == bg)
 		{
-			return i;
+			return p;
 		}
 	}
 
 	return -1;
 }
 
-/* Checks whether color pair number pair has specified foreground (fg) and
- * background (bg) colors. */
-static int
-color_pair_matches(int pair, int fg, int bg)
-{
-	short pair_fg, pair_bg;
-	conf.pair_content(pair, &pair_fg, &pair_bg);
-	return (pair_fg == fg && pair_bg == bg);
-}
-
 /* Allocates new color pair.  Returns new pair index, or -1 on failure. */
 static int
 allocate_pair(int fg, int bg)
 {
+	int p;
+
 	if(avail_pairs == 0)
 	{
-		/* Out of pairs, free unused ones. */
-		if(compress_pair_space() != 0)
+		/* Out of pairs, reuse one that isn't needed. */
+		p = evict_pair();
+		if(p == -1)
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		if(ensure_capacity(used_pairs) != 0)
 		{
 			return -1;
 		}
+
+		--avail_pairs;
+		p = used_pairs++;
 	}
 
-	conf.init_pair(used_pairs, fg, bg);
+	conf.init_pair(p, fg, bg);
 
-	--avail_pairs;
-	return used_pairs++;
+	pairs[p].fg = fg;
+	pairs[p].bg = bg;
+	link_pair(p);
+	return p;
 }
 
-/* Returns zero if at least one pair is now available, otherwise non-zero is
- * returned. */
+/* Picks least recently used pair that is not in use and forgets about it.
+ * Returns the pair or -1 if all pairs are in use. */
 static int
-compress_pair_space(void)
+evict_pair(void)
 {
-	/* TODO: in case of performance issues cache pair_in_use() in the first loop
-	 * or change the function to fill in bit field of pairs. */
-
-	int i;
-	int j;
-	int in_use;
-	int first_unused;
+	int p;
 
-	in_use = 0;
-	first_unused = -1;
-	for(i = PREALLOCATED_COUNT; i < used_pairs; ++i)
+	for(p = lru; p != -1; p = pairs[p].more_used)
 	{
-		if(conf.pair_in_use(i))
+		if(!conf.pair_in_use(p))
 		{
-			++in_use;
+			unlink_pair(p);
+			return p;
 		}
-		else if(first_unused == -1)
+	}
+
+	return -1;
+}
+
+/* Makes sure that information about the pair can be stored and that hash
+ * chains stay short.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+ensure_capacity(int pair)
+{
+	if(pair >= pairs_capacity)
+	{
+		const int capacity = MAX(pairs_capacity*2, MIN_BUCKETS);
+		pair_info_t *const new_pairs = reallocarray(pairs, capacity,
+				sizeof(*pairs));
+		if(new_pairs == NULL)
 		{
-			first_unused = i;
+			return 1;
 		}
+		pairs = new_pairs;
+		pairs_capacity = capacity;
 	}
 
-	if(first_unused == -1)
+	if(pair >= nbuckets && rehash(MAX(nbuckets*2, MIN_BUCKETS)) != 0)
 	{
-		/* No unused pairs. */
-		return -1;
+		return 1;
 	}
 
-	j = first_unused;
-	for(i = PREALLOCATED_COUNT + in_use; i < used_pairs; ++i)
+	return 0;
+}
+
+/* Changes number of hash buckets redistributing pairs among them.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+rehash(int new_nbuckets)
+{
+	int i;
+	int p;
+
+	int *const new_buckets = reallocarray(NULL, new_nbuckets, sizeof(*buckets));
+	if(new_buckets == NULL)
 	{
-		if(conf.pair_in_use(i))
-		{
-			conf.move_pair(i, j);
-
-			/* Advance to next unused pair. */
-			do
-			{
-				++j;
-			}
-			while(conf.pair_in_use(j));
-		}
+		return 1;
 	}
 
-	used_pairs = j;
-	avail_pairs = conf.max_color_pairs - used_pairs;
+	free(buckets);
+	buckets = new_buckets;
+	nbuckets = new_nbuckets;
+
+	for(i = 0; i < nbuckets; ++i)
+	{
+		buckets[i] = -1;
+	}
+
+	for(p = lru; p != -1; p = pairs[p].more_used)
+	{
+		const int bucket = get_bucket(pairs[p].fg, pairs[p].bg);
+		pairs[p].next = buckets[bucket];
+		buckets[bucket] = p;
+	}
 
 	return 0;
 }
 
+/* Adds pair to its hash chain and makes it the most recently used one. */
+static void
+link_pair(int pair)
+{
+	const int bucket = get_bucket(pairs[pair].fg, pairs[pair].bg);
+	pairs[pair].next = buckets[bucket];
+	buckets[bucket] = pair;
+
+	append_use(pair);
+}
+
+/* Removes pair from its hash chain and from the list of uses. */
+static void
+unlink_pair(int pair)
+{
+	int *link = &buckets[get_bucket(pairs[pair].fg, pairs[pair].bg)];
+	while(*link != pair)
+	{
+		link = &pairs[*link].next;
+	}
+	*link = pairs[pair].next;
+
+	remove_use(pair);
+}
+
+/* Moves the pair to the end of the list of uses. */
+static void
+mark_used(int pair)
+{
+	if(pair != mru)
+	{
+		remove_use(pair);
+		append_use(pair);
+	}
+}
+
+/* Makes the pair the most recently used one. */
+static void
+append_use(int pair)
+{
+	pairs[pair].less_used = mru;
+	pairs[pair].more_used = -1;
+	if(mru != -1)
+	{
+		pairs[mru].more_used = pair;
+	}
+	mru = pair;
+	if(lru == -1)
+	{
+		lru = pair;
+	}
+}
+
+/* Removes the pair from the list of uses. */
+static void
+remove_use(int pair)
+{
+	if(pairs[pair].less_used == -1)
+	{
+		lru = pairs[pair].more_used;
+	}
+	else
+	{
+		pairs[pairs[pair].less_used].more_used = pairs[pair].more_used;
+	}
+
+	if(pairs[pair].more_used == -1)
+	{
+		mru = pairs[pair].less_used;
+	}
+	else
+	{
+		pairs[pairs[pair].more_used].less_used = pairs[pair].less_used;
+	}
+}
+
+/* Computes hash bucket for a pair of colors.  Returns the index. */
+static int
+get_bucket(int fg, int bg)
+{
+	const unsigned int hash = ((unsigned int)(fg + 1)*65599U + (bg + 1))
+	                        *2654435761U;
+	return (hash >> 16) & (nbuckets - 1);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
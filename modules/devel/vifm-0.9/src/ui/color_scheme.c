@@ -35,6 +35,7 @@
 #include "../engine/completion.h"
 #include "../modes/dialogs/msg_dialog.h"
 #include "../utils/fs.h"
+#include "../utils/classifier.h"
 #include "../utils/fsddata.h"
 #include "../utils/macros.h"
 #include "../utils/matchers.h"
@@ -398,6 +399,7 @@ static void restore_primary_cs(const col_scheme_t *cs);
 static void reset_to_default_cs(col_scheme_t *cs);
 static void free_cs_highlights(col_scheme_t *cs);
 static file_hi_t * clone_cs_highlights(const col_scheme_t *from);
+static void index_file_hi(col_scheme_t *cs, int idx);
 static void reset_cs_colors(col_scheme_t *cs);
 static int source_cs(const char name[]);
 static void get_cs_path(const char name[], char buf[], size_t buf_size);
@@ -730,9 +732,17 @@ cs_reset(col_scheme_t *cs)
 void
 cs_assign(col_scheme_t *to, const col_scheme_t *from)
 {
+	int i;
+
 	free_cs_highlights(to);
 	*to = *from;
 	to->file_hi = clone_cs_highlights(from);
+
+	to->file_hi_index = NULL;
+	for(i = 0; i < to->file_hi_count; ++i)
+	{
+		index_file_hi(to, i);
+	}
 }
 
 /* Resets color scheme to default builtin values. */
@@ -759,9 +769,11 @@ free_cs_highlights(col_scheme_t *cs)
 	}
 
 	free(cs->file_hi);
+	classifier_free(cs->file_hi_index);
 
 	cs->file_hi = NULL;
 	cs->file_hi_count = 0;
+	cs->file_hi_index = NULL;
 }
 
 /* Clones filename specific highlight array of the *from color scheme and
@@ -783,6 +795,27 @@ clone_cs_highlights(const col_scheme_t *from)
 	return file_hi;
 }
 
+/* Adds matchers of file highlight at index idx to the index of highlights,
+ * which should already contain all preceding ones.  Index is dropped if it
+ * can't be updated, which makes lookups fall back to trying all matchers in
+ * order. */
+static void
+index_file_hi(col_scheme_t *cs, int idx)
+{
+	if(idx == 0)
+	{
+		classifier_free(cs->file_hi_index);
+		cs->file_hi_index = classifier_create();
+	}
+
+	if(cs->file_hi_index != NULL &&
+			classifier_add(cs->file_hi_index, cs->file_hi[idx].matchers) != 0)
+	{
+		classifier_free(cs->file_hi_index);
+		cs->file_hi_index = NULL;
+	}
+}
+
 int
 cs_load_local(int left, const char dir[])
 {
@@ -1020,6 +1053,7 @@ cs_add_file_hi(struct matchers_t *matchers, const col_attr_t *hi)
 	file_hi->hi = *hi;
 
 	++cs->file_hi_count;
+	index_file_hi(cs, cs->file_hi_count - 1);
 
 	return 0;
 }
@@ -1029,6 +1063,11 @@ cs_get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 {
 	int i;
 
+	if(*hi_hint == -2)
+	{
+		return NULL;
+	}
+
 	if(*hi_hint != -1)
 	{
 		assert(*hi_hint >= 0 && "Wrong index.");
@@ -1036,16 +1075,29 @@ cs_get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 		return &cs->file_hi[*hi_hint].hi;
 	}
 
-	for(i = 0; i < cs->file_hi_count; ++i)
+	if(cs->file_hi_index != NULL)
+	{
+		i = classifier_find(cs->file_hi_index, fname, 0);
+	}
+	else
 	{
-		const file_hi_t *const file_hi = &cs->file_hi[i];
-		if(matchers_match(file_hi->matchers, fname))
+		for(i = 0; i < cs->file_hi_count; ++i)
 		{
-			*hi_hint = i;
-			return &file_hi->hi;
+			if(matchers_match(cs->file_hi[i].matchers, fname))
+			{
+				break;
+			}
 		}
 	}
-	return NULL;
+
+	if(i < 0 || i >= cs->file_hi_count)
+	{
+		*hi_hint = -2;
+		return NULL;
+	}
+
+	*hi_hint = i;
+	return &cs->file_hi[i].hi;
 }
 
 int
@@ -40,6 +40,7 @@ typedef enum
 }
 ColorSchemeState;
 
+struct classifier_t;
 struct matchers_t;
 
 /* Single file highlight description. */
@@ -61,6 +62,7 @@ typedef struct
 
 	file_hi_t *file_hi; /* List of file highlight preferences. */
 	int file_hi_count;  /* Number of file highlight definitions. */
+	struct classifier_t *file_hi_index; /* Index of file_hi matchers or NULL. */
 }
 col_scheme_t;
 
@@ -140,8 +142,9 @@ void cs_mix_colors(col_attr_t *base, const col_attr_t *mixup);
 int cs_add_file_hi(struct matchers_t *matchers, const col_attr_t *hi);
 
 /* Gets filename-specific highlight.  hi_hint can't be NULL and should be equal
- * to -1 initially.  Returns NULL if nothing is found, otherwise returns pointer
- * to one of color scheme's highlights. */
+ * to -1 initially, it's set to index of the highlight or to -2 if nothing
+ * matches.  Returns NULL if nothing is found, otherwise returns pointer to one
+ * of color scheme's highlights. */
 const col_attr_t * cs_get_file_hi(const col_scheme_t *cs, const char fname[],
 		int *hi_hint);
 
@@ -30,8 +30,9 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdlib.h> /* abs() */
-#include <string.h> /* strcpy() strlen() */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* abs() free() realloc() */
+#include <string.h> /* memcmp() memset() strcmp() strcpy() strlen() */
 
 #include "../cfg/config.h"
 #include "../utils/fs.h"
@@ -40,12 +41,14 @@
 #include "../utils/regexp.h"
 #include "../utils/str.h"
 #include "../utils/test_helpers.h"
+#include "../utils/trace.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "../filelist.h"
 #include "../flist_pos.h"
 #include "../opt_handlers.h"
 #include "../sort.h"
+#include "../status.h"
 #include "color_manager.h"
 #include "color_scheme.h"
 #include "column_view.h"
@@ -55,6 +58,18 @@
 /* Mark for a cursor position of inactive pane. */
 #define INACTIVE_CURSOR_MARK "*"
 
+/* Maximum depth of tree node for which tree_prefix_t can be computed. */
+#define TREE_PREFIX_MAX_DEPTH 64
+
+/* Shape of tree prefix of an entry. */
+typedef struct
+{
+	int depth;      /* Nesting level of the entry (0 for roots) or -1 if unknown. */
+	uint64_t lasts; /* Bit i is set if node at level i + 1 on the path to the
+	                   entry (including the entry) is the last child. */
+}
+tree_prefix_t;
+
 /* Packet set of parameters to pass as user data for processing columns. */
 typedef struct
 {
@@ -69,9 +84,74 @@ typedef struct
 	size_t *prefix_len; /* Data prefix length (should be drawn in neutral color).
 	                     * A pointer to allow changing value in const struct.
 	                     * Should be zero first time, then auto reset. */
+
+	const tree_prefix_t *tree_prefix; /* Precomputed tree prefix or NULL. */
 }
 column_data_t;
 
+/* State of a single cell of file list as of the moment it was drawn.  Objects
+ * of this type are compared byte-wise, so they are zeroed before being
+ * filled. */
+typedef struct cell_state_t
+{
+	/* Geometry of the cell. */
+	int line;        /* Line of the cell. */
+	int column;      /* Offset in characters of the column. */
+	int width;       /* Width of the cell. */
+	int print_width; /* Width of printed part of the cell. */
+
+	/* State of the view and the entry that affects appearance of the cell. */
+	int pos;          /* Position of the entry in the list, -1 for stale cell. */
+	int rel_base;     /* Base of relative line numbers or -1. */
+	int hi_group;     /* Line highlight group. */
+	int is_current;   /* Whether cursor is drawn on the cell. */
+	int has_cursor;   /* Whether cursor of the view is at the cell. */
+	uint64_t stamp;   /* Identifies name and origin of the entry. */
+	uint64_t size;
+#ifndef _WIN32
+	uid_t uid;
+	gid_t gid;
+	mode_t mode;
+#else
+	uint32_t attrs;
+#endif
+	time_t mtime;
+	time_t atime;
+	time_t ctime;
+	FileType type;
+	int nlinks;
+	int search_match;
+	int match_left;
+	int match_right;
+	int selected;
+	int marked;
+	tree_prefix_t tree_prefix; /* Zeroed if not available. */
+	unsigned int dcache_gen;   /* Sizes of directories come from the cache. */
+}
+cell_state_t;
+
+/* Number of slots in cache of formatted values (power of two). */
+#define FMT_CACHE_SIZE 512U
+
+/* Result of formatting a value of an entry for a column. */
+typedef struct
+{
+	int column_id;  /* Column of the value, zero for an unused slot. */
+	uint64_t value; /* Formatted value (time, size or mode). */
+	char text[48];  /* Text produced by column's format callback. */
+}
+fmt_cache_slot_t;
+
+/* Values of options that affect texts in fmt_cache_slot_t. */
+typedef struct
+{
+	char *time_format;   /* Copy of cfg.time_format or NULL. */
+	int sizefmt_base;    /* Copy of cfg.sizefmt.base. */
+	int sizefmt_prec;    /* Copy of cfg.sizefmt.precision. */
+	int sizefmt_ieci;    /* Copy of cfg.sizefmt.ieci_prefixes. */
+}
+fmt_cache_opts_t;
+
 static void calculate_table_conf(FileView *view, size_t *count, size_t *width);
 static void calculate_number_width(FileView *view);
 static int count_digits(int num);
@@ -79,6 +159,17 @@ static int calculate_top_position(FileView *view, int top);
 static int get_line_color(const FileView *view, int pos);
 static size_t calculate_print_width(const FileView *view, int i,
 		size_t max_width);
+TSTATIC tree_prefix_t * get_tree_prefixes(const FileView *view, int top,
+		int count);
+static int get_tree_path(const FileView *view, int pos, int path[],
+		uint64_t *lasts);
+static int is_last_child(const dir_entry_t *entry);
+static void get_cell_state(const FileView *view, const column_data_t *cdt,
+		size_t col_width, size_t print_width, unsigned int dcache_gen,
+		cell_state_t *state);
+static int cells_moved(const cell_state_t old[], const cell_state_t new[],
+		int count);
+static void forget_cell(FileView *view, int cell);
 static void draw_cell(const FileView *view, const column_data_t *cdt,
 		size_t col_width, size_t print_width);
 static columns_t * get_view_columns(const FileView *view);
@@ -101,6 +192,9 @@ static void mix_in_file_hi(const FileView *view, dir_entry_t *entry,
 static void mix_in_file_name_hi(const FileView *view, dir_entry_t *entry,
 		col_attr_t *col);
 TSTATIC void format_name(int id, const void *data, size_t buf_len, char buf[]);
+static size_t print_tree_prefix(const tree_prefix_t *prefix, size_t buf_len,
+		char buf[]);
+static size_t walk_tree_prefix(dir_entry_t *entry, size_t buf_len, char buf[]);
 static void format_size(int id, const void *data, size_t buf_len, char buf[]);
 static void format_nitems(int id, const void *data, size_t buf_len, char buf[]);
 static void format_primary_group(int id, const void *data, size_t buf_len,
@@ -120,6 +214,10 @@ static void format_perms(int id, const void *data, size_t buf_len, char buf[]);
 static void format_nlinks(int id, const void *data, size_t buf_len, char buf[]);
 #endif
 static void format_id(int id, const void *data, size_t buf_len, char buf[]);
+static int fmt_cache_get(int column_id, uint64_t value, size_t buf_len,
+		char buf[]);
+static void fmt_cache_put(int column_id, uint64_t value, const char text[]);
+static void fmt_cache_validate(void);
 static size_t calculate_column_width(FileView *view);
 static size_t get_max_filename_width(const FileView *view);
 static size_t get_filename_width(const FileView *view, int i);
@@ -127,6 +225,13 @@ static size_t get_filetype_decoration_width(const dir_entry_t *entry);
 static int move_curr_line(FileView *view);
 static void reset_view_columns(FileView *view);
 
+/* Cache of formatted times, sizes and modes that allows skipping formatting of
+ * values that were already displayed (e.g., on scrolling).  Texts don't depend
+ * on width of columns as they are truncated later. */
+static fmt_cache_slot_t fmt_cache[FMT_CACHE_SIZE];
+/* Option values for which texts in fmt_cache were produced. */
+static fmt_cache_opts_t fmt_cache_opts;
+
 void
 fview_init(void)
 {
@@ -182,6 +287,9 @@ fview_view_init(FileView *view)
 
 	view->local_cs = 0;
 
+	view->cells = NULL;
+	view->ncells = 0;
+
 	view->columns = columns_create();
 	view->view_columns = strdup("");
 	view->view_columns_g = strdup("");
@@ -218,12 +326,16 @@ fview_view_cs_reset(FileView *view)
 	{
 		view->dir_entry[i].hi_num = -1;
 	}
+	fview_reset_cells(view);
 }
 
 void
 draw_dir_list(FileView *view)
 {
+	trace_begin("draw_dir_list", flist_get_dir(view));
 	draw_dir_list_only(view);
+	trace_set_count("cells_redrawn", view->cells_redrawn);
+	trace_end();
 
 	if(view != curr_view)
 	{
@@ -234,8 +346,11 @@ draw_dir_list(FileView *view)
 void
 draw_dir_list_only(FileView *view)
 {
-	int x;
-	size_t cell;
+	int cell, ncells;
+	int redraw_all;
+	cell_state_t *cells;
+	tree_prefix_t *tree_prefixes;
+	unsigned int dcache_gen;
 	size_t col_width;
 	size_t col_count;
 	int coll_pad;
@@ -268,12 +383,16 @@ draw_dir_list_only(FileView *view)
 
 	top = calculate_top_position(view, top);
 
-	ui_view_erase(view);
-
-	cell = 0U;
 	coll_pad = (!ui_view_displays_columns(view) && cfg.extra_padding) ? 1 : 0;
-	for(x = top; x < view->list_rows; ++x)
+	ncells = MAX(0, MIN(view->list_rows - top, (int)view->window_cells));
+	cells = malloc(sizeof(*cells)*MAX(ncells, 1));
+	tree_prefixes = get_tree_prefixes(view, top, ncells);
+	dcache_gen = dcache_generation();
+
+	/* Collect new state of cells to find out which of them need to be drawn. */
+	for(cell = 0; cells != NULL && cell < ncells; ++cell)
 	{
+		const int x = top + cell;
 		size_t prefix_len = 0U;
 		const column_data_t cdt = {
 			.view = view,
@@ -283,19 +402,58 @@ draw_dir_list_only(FileView *view)
 			.current_line = cell/col_count,
 			.column_offset = (cell%col_count)*col_width,
 			.prefix_len = &prefix_len,
+			.tree_prefix = (tree_prefixes == NULL) ? NULL : &tree_prefixes[cell],
 		};
 
 		const size_t print_width = calculate_print_width(view, x, col_width);
 
-		draw_cell(view, &cdt, col_width - coll_pad, print_width);
+		get_cell_state(view, &cdt, col_width - coll_pad, print_width, dcache_gen,
+				&cells[cell]);
+	}
 
-		++cell;
-		if(cell >= view->window_cells)
+	/* Redrawing only some cells is possible if they are still positioned the same
+	 * way, otherwise leftovers of old cells need to be erased first. */
+	redraw_all = (cells == NULL || view->cells == NULL || view->ncells != ncells
+	           || cells_moved(view->cells, cells, ncells));
+	if(redraw_all)
+	{
+		ui_view_erase(view);
+	}
+
+	view->cells_redrawn = 0;
+	for(cell = 0; cell < ncells; ++cell)
+	{
+		const int x = top + cell;
+		size_t prefix_len = 0U;
+		const column_data_t cdt = {
+			.view = view,
+			.line_pos = x,
+			.line_hi_group = (cells == NULL) ? get_line_color(view, x)
+			                                 : cells[cell].hi_group,
+			.is_current = (view == curr_view) ? x == view->list_pos : 0,
+			.current_line = cell/col_count,
+			.column_offset = (cell%col_count)*col_width,
+			.prefix_len = &prefix_len,
+			.tree_prefix = (tree_prefixes == NULL) ? NULL : &tree_prefixes[cell],
+		};
+
+		if(!redraw_all &&
+				memcmp(&view->cells[cell], &cells[cell], sizeof(*cells)) == 0)
 		{
-			break;
+			continue;
 		}
+
+		draw_cell(view, &cdt, col_width - coll_pad, (cells == NULL)
+				? calculate_print_width(view, x, col_width)
+				: (size_t)cells[cell].print_width);
+		++view->cells_redrawn;
 	}
 
+	free(tree_prefixes);
+	free(view->cells);
+	view->cells = cells;
+	view->ncells = (cells == NULL) ? 0 : ncells;
+
 	view->top_line = top;
 	view->curr_line = view->list_pos - view->top_line;
 
@@ -401,25 +559,7 @@ get_line_color(const FileView *view, int pos)
 			{
 				return LINK_COLOR;
 			}
-			else
-			{
-				char full[PATH_MAX];
-				get_full_path_at(view, pos, sizeof(full), full);
-				if(get_link_target_abs(full, view->dir_entry[pos].origin, full,
-							sizeof(full)) != 0)
-				{
-					return BROKEN_LINK_COLOR;
-				}
-
-				/* Assume that targets on slow file system are not broken as actual
-				 * check might take long time. */
-				if(is_on_slow_fs(full, cfg.slow_fs_list))
-				{
-					return LINK_COLOR;
-				}
-
-				return path_exists(full, DEREF) ? LINK_COLOR : BROKEN_LINK_COLOR;
-			}
+			return view->dir_entry[pos].broken_link ? BROKEN_LINK_COLOR : LINK_COLOR;
 #ifndef _WIN32
 		case FT_SOCK:
 			return SOCKET_COLOR;
@@ -466,6 +606,213 @@ draw_cell(const FileView *view, const column_data_t *cdt, size_t col_width,
 	}
 }
 
+/* Computes tree prefixes of count entries of the view starting at top in a
+ * single pass reusing path to the previous entry.  Returns newly allocated
+ * array or NULL if view doesn't display a tree or on error. */
+TSTATIC tree_prefix_t *
+get_tree_prefixes(const FileView *view, int top, int count)
+{
+	/* Positions of entries on the path from a root to the last processed
+	 * entry. */
+	int path[TREE_PREFIX_MAX_DEPTH + 1];
+	int depth = -1;
+	uint64_t lasts = 0U;
+	tree_prefix_t *prefixes;
+	int i;
+
+	if(!flist_custom_active(view) || view->custom.type != CV_TREE ||
+			!ui_view_displays_columns(view) || count <= 0)
+	{
+		return NULL;
+	}
+
+	prefixes = malloc(sizeof(*prefixes)*count);
+	if(prefixes == NULL)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		const int pos = top + i;
+		const dir_entry_t *const entry = &view->dir_entry[pos];
+
+		if(entry->child_pos == 0)
+		{
+			depth = 0;
+		}
+		else
+		{
+			/* Parent precedes its children, so it's either previous entry or one of
+			 * its ancestors. */
+			const int parent = pos - entry->child_pos;
+			while(depth >= 0 && path[depth] != parent)
+			{
+				--depth;
+			}
+			if(depth < 0)
+			{
+				depth = get_tree_path(view, parent, path, &lasts);
+			}
+			if(depth >= 0)
+			{
+				++depth;
+			}
+		}
+
+		if(depth < 0 || depth > TREE_PREFIX_MAX_DEPTH)
+		{
+			/* Too deep, this entry and probably some of the following ones are left
+			 * for format_name() to handle. */
+			prefixes[i].depth = -1;
+			prefixes[i].lasts = 0U;
+			depth = -1;
+			continue;
+		}
+
+		path[depth] = pos;
+		if(depth != 0)
+		{
+			const uint64_t bit = (uint64_t)1U << (depth - 1);
+			lasts = is_last_child(entry) ? (lasts | bit) : (lasts & ~bit);
+		}
+
+		prefixes[i].depth = depth;
+		prefixes[i].lasts = (depth == TREE_PREFIX_MAX_DEPTH)
+		                  ? lasts
+		                  : lasts & (((uint64_t)1U << depth) - 1U);
+	}
+
+	return prefixes;
+}
+
+/* Fills path with positions of nodes from a root to the entry at pos and sets
+ * corresponding bits of *lasts.  Returns depth of the entry or -1 if it's deeper
+ * than TREE_PREFIX_MAX_DEPTH. */
+static int
+get_tree_path(const FileView *view, int pos, int path[], uint64_t *lasts)
+{
+	int depth = 0;
+	int level;
+	int p;
+
+	for(p = pos; view->dir_entry[p].child_pos != 0;
+			p -= view->dir_entry[p].child_pos)
+	{
+		if(++depth > TREE_PREFIX_MAX_DEPTH)
+		{
+			return -1;
+		}
+	}
+
+	*lasts = 0U;
+	p = pos;
+	for(level = depth; level > 0; --level)
+	{
+		path[level] = p;
+		if(is_last_child(&view->dir_entry[p]))
+		{
+			*lasts |= (uint64_t)1U << (level - 1);
+		}
+		p -= view->dir_entry[p].child_pos;
+	}
+	path[0] = p;
+
+	return depth;
+}
+
+/* Checks whether entry is the last child of its parent.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_last_child(const dir_entry_t *entry)
+{
+	const dir_entry_t *const parent = entry - entry->child_pos;
+	return parent->child_count == entry->child_pos + entry->child_count;
+}
+
+/* Fills *state with current state of the cell described by cdt. */
+static void
+get_cell_state(const FileView *view, const column_data_t *cdt,
+		size_t col_width, size_t print_width, unsigned int dcache_gen,
+		cell_state_t *state)
+{
+	const dir_entry_t *const entry = &view->dir_entry[cdt->line_pos];
+
+	memset(state, 0, sizeof(*state));
+
+	state->line = cdt->current_line;
+	state->column = cdt->column_offset;
+	state->width = col_width;
+	state->print_width = print_width;
+
+	state->pos = cdt->line_pos;
+	state->rel_base = (view->num_type & NT_REL) ? view->list_pos : -1;
+	state->hi_group = cdt->line_hi_group;
+	state->is_current = cdt->is_current;
+	state->has_cursor = (cdt->line_pos == (size_t)view->list_pos);
+	state->stamp = entry->stamp;
+	state->size = entry->size;
+#ifndef _WIN32
+	state->uid = entry->uid;
+	state->gid = entry->gid;
+	state->mode = entry->mode;
+#else
+	state->attrs = entry->attrs;
+#endif
+	state->mtime = entry->mtime;
+	state->atime = entry->atime;
+	state->ctime = entry->ctime;
+	state->type = entry->type;
+	state->nlinks = entry->nlinks;
+	state->search_match = entry->search_match;
+	state->match_left = entry->match_left;
+	state->match_right = entry->match_right;
+	state->selected = entry->selected;
+	state->marked = entry->marked;
+	if(cdt->tree_prefix != NULL)
+	{
+		state->tree_prefix = *cdt->tree_prefix;
+	}
+	state->dcache_gen = dcache_gen;
+}
+
+/* Checks whether geometry of any of the cells has changed.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+cells_moved(const cell_state_t old[], const cell_state_t new[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(old[i].line != new[i].line || old[i].column != new[i].column ||
+				old[i].width != new[i].width ||
+				old[i].print_width != new[i].print_width)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Marks the cell as one that doesn't correspond to what's on the screen, which
+ * forces its redraw next time. */
+static void
+forget_cell(FileView *view, int cell)
+{
+	if(cell >= 0 && cell < view->ncells)
+	{
+		view->cells[cell].pos = -1;
+	}
+}
+
+void
+fview_reset_cells(FileView *view)
+{
+	free(view->cells);
+	view->cells = NULL;
+	view->ncells = 0;
+}
+
 /* Retrieves active view columns handle of the view considering 'lsview' option
  * status.  Returns the handle. */
 static columns_t *
@@ -640,6 +987,7 @@ put_inactive_mark(FileView *view)
 	checked_wmove(view->win, line, column);
 
 	wprinta(view->win, INACTIVE_CURSOR_MARK, line_attrs);
+	forget_cell(view, view->curr_line);
 	ui_view_win_changed(view);
 }
 
@@ -776,6 +1124,7 @@ clear_current_line_bar(FileView *view, int is_current)
 	}
 
 	draw_cell(view, &cdt, col_width, print_width);
+	forget_cell(view, old_cursor);
 }
 
 int
@@ -1179,8 +1528,7 @@ mix_in_file_name_hi(const FileView *view, dir_entry_t *entry, col_attr_t *col)
 TSTATIC void
 format_name(int id, const void *data, size_t buf_len, char buf[])
 {
-	size_t len, i;
-	dir_entry_t *child, *parent;
+	size_t len;
 
 	const column_data_t *cdt = data;
 	FileView *view = cdt->view;
@@ -1201,15 +1549,59 @@ format_name(int id, const void *data, size_t buf_len, char buf[])
 	}
 
 	/* File name possibly with path and tree prefixes. */
-	len = 0U;
-	child = entry;
-	parent = child - child->child_pos;
+	if(cdt->tree_prefix != NULL && cdt->tree_prefix->depth >= 0)
+	{
+		len = print_tree_prefix(cdt->tree_prefix, buf_len, buf);
+	}
+	else
+	{
+		len = walk_tree_prefix(entry, buf_len, buf);
+	}
+
+	get_short_path_of(view, entry, 1, 1, buf_len + 1U - len, buf + len);
+	*cdt->prefix_len = len;
+}
+
+/* Prints tree prefix described by precomputed shape into the buffer.  Returns
+ * length of the prefix. */
+static size_t
+print_tree_prefix(const tree_prefix_t *prefix, size_t buf_len, char buf[])
+{
+	int level;
+	size_t len = 0U;
+
+	for(level = 1; level <= prefix->depth; ++level)
+	{
+		const int last = ((prefix->lasts >> (level - 1)) & 1U);
+		const char *piece;
+		if(level == prefix->depth)
+		{
+			piece = (last ? "`-- " : "|-- ");
+		}
+		else
+		{
+			piece = (last ? "    " : "|   ");
+		}
+		(void)sstrappend(buf, &len, buf_len + 1U, piece);
+	}
+	return len;
+}
+
+/* Prints tree prefix of the entry into the buffer by walking up to the root.
+ * Returns length of the prefix. */
+static size_t
+walk_tree_prefix(dir_entry_t *entry, size_t buf_len, char buf[])
+{
+	size_t len = 0U, i;
+	dir_entry_t *child = entry;
+	dir_entry_t *parent = child - child->child_pos;
+
 	while(parent != child)
 	{
 		const char *prefix;
 		/* To avoid prepending, strings are reversed here and whole tree prefix is
 		 * reversed below to compensate for it. */
-		if(parent->child_count == child->child_pos + child->child_count)
+		if(is_last_child(child))
 		{
 			prefix = (child == entry ? " --`" : "    ");
 		}
@@ -1229,9 +1621,7 @@ format_name(int id, const void *data, size_t buf_len, char buf[])
 		buf[i] = buf[len - 1U - i];
 		buf[len - 1U - i] = t;
 	}
-
-	get_short_path_of(view, entry, 1, 1, buf_len + 1U - len, buf + len);
-	*cdt->prefix_len = len;
+	return len;
 }
 
 /* Primary name group format (first value of 'sortgroups' option) callback for
@@ -1281,9 +1671,15 @@ format_size(int id, const void *data, size_t buf_len, char buf[])
 		size = entry->size;
 	}
 
+	if(fmt_cache_get(id, size, buf_len + 1, buf))
+	{
+		return;
+	}
+
 	str[0] = '\0';
 	friendly_size_notation(size, sizeof(str), str);
 	snprintf(buf, buf_len + 1, " %s", str);
+	fmt_cache_put(id, size, buf);
 }
 
 /* Item number format callback for column_view unit. */
@@ -1379,6 +1775,7 @@ static void
 format_time(int id, const void *data, size_t buf_len, char buf[])
 {
 	struct tm *tm_ptr;
+	time_t t;
 	const column_data_t *cdt = data;
 	FileView *view = cdt->view;
 	dir_entry_t *entry = &view->dir_entry[cdt->line_pos];
@@ -1386,21 +1783,27 @@ format_time(int id, const void *data, size_t buf_len, char buf[])
 	switch(id)
 	{
 		case SK_BY_TIME_MODIFIED:
-			tm_ptr = localtime(&entry->mtime);
+			t = entry->mtime;
 			break;
 		case SK_BY_TIME_ACCESSED:
-			tm_ptr = localtime(&entry->atime);
+			t = entry->atime;
 			break;
 		case SK_BY_TIME_CHANGED:
-			tm_ptr = localtime(&entry->ctime);
+			t = entry->ctime;
 			break;
 
 		default:
 			assert(0 && "Unknown sort by time type");
-			tm_ptr = NULL;
-			break;
+			buf[0] = '\0';
+			return;
+	}
+
+	if(fmt_cache_get(id, (uint64_t)t, buf_len + 1, buf))
+	{
+		return;
 	}
 
+	tm_ptr = localtime(&t);
 	if(tm_ptr != NULL)
 	{
 		strftime(buf, buf_len + 1, cfg.time_format, tm_ptr);
@@ -1409,6 +1812,7 @@ format_time(int id, const void *data, size_t buf_len, char buf[])
 	{
 		buf[0] = '\0';
 	}
+	fmt_cache_put(id, (uint64_t)t, buf);
 }
 
 /* Directory vs. file type format callback for column_view unit. */
@@ -1451,7 +1855,11 @@ format_mode(int id, const void *data, size_t buf_len, char buf[])
 {
 	const column_data_t *cdt = data;
 	dir_entry_t *entry = &cdt->view->dir_entry[cdt->line_pos];
-	snprintf(buf, buf_len, " %o", entry->mode);
+	if(!fmt_cache_get(id, entry->mode, buf_len, buf))
+	{
+		snprintf(buf, buf_len, " %o", entry->mode);
+		fmt_cache_put(id, entry->mode, buf);
+	}
 }
 
 /* File permissions mask format callback for column_view unit. */
@@ -1461,7 +1869,11 @@ format_perms(int id, const void *data, size_t buf_len, char buf[])
 	const column_data_t *cdt = data;
 	FileView *view = cdt->view;
 	dir_entry_t *entry = &view->dir_entry[cdt->line_pos];
-	get_perm_string(buf, buf_len, entry->mode);
+	if(!fmt_cache_get(id, entry->mode, buf_len, buf))
+	{
+		get_perm_string(buf, buf_len, entry->mode);
+		fmt_cache_put(id, entry->mode, buf);
+	}
 }
 
 /* Hard link count format callback for column_view unit. */
@@ -1484,6 +1896,65 @@ format_id(int id, const void *data, size_t buf_len, char buf[])
 	snprintf(buf, buf_len, "#%d", entry->id);
 }
 
+/* Looks up text of the column that was produced for the value.  Returns
+ * non-zero and fills the buffer if it's found, otherwise zero is returned. */
+static int
+fmt_cache_get(int column_id, uint64_t value, size_t buf_len, char buf[])
+{
+	const fmt_cache_slot_t *slot;
+
+	fmt_cache_validate();
+
+	slot = &fmt_cache[(column_id*31U + value*2654435761U) % FMT_CACHE_SIZE];
+	if(slot->column_id != column_id || slot->value != value)
+	{
+		return 0;
+	}
+
+	copy_str(buf, buf_len, slot->text);
+	return 1;
+}
+
+/* Remembers text of the column produced for the value unless it's too long. */
+static void
+fmt_cache_put(int column_id, uint64_t value, const char text[])
+{
+	fmt_cache_slot_t *const slot =
+		&fmt_cache[(column_id*31U + value*2654435761U) % FMT_CACHE_SIZE];
+
+	if(strlen(text) < sizeof(slot->text))
+	{
+		strcpy(slot->text, text);
+		slot->column_id = column_id;
+		slot->value = value;
+	}
+}
+
+/* Drops cached texts if options that affect formatting have changed. */
+static void
+fmt_cache_validate(void)
+{
+	fmt_cache_opts_t *const opts = &fmt_cache_opts;
+	const char *const time_format = (cfg.time_format == NULL)
+	                              ? ""
+	                              : cfg.time_format;
+
+	if(opts->time_format != NULL && strcmp(opts->time_format, time_format) == 0
+			&& opts->sizefmt_base == cfg.sizefmt.base
+			&& opts->sizefmt_prec == cfg.sizefmt.precision
+			&& opts->sizefmt_ieci == cfg.sizefmt.ieci_prefixes)
+	{
+		return;
+	}
+
+	memset(fmt_cache, 0, sizeof(fmt_cache));
+
+	(void)replace_string(&opts->time_format, time_format);
+	opts->sizefmt_base = cfg.sizefmt.base;
+	opts->sizefmt_prec = cfg.sizefmt.precision;
+	opts->sizefmt_ieci = cfg.sizefmt.ieci_prefixes;
+}
+
 void
 fview_set_lsview(FileView *view, int enabled)
 {
@@ -1642,6 +2113,7 @@ fview_position_updated(FileView *view)
 	cdt.column_offset = (view->curr_line%col_count)*col_width;
 
 	draw_cell(view, &cdt, print_width, print_width);
+	forget_cell(view, view->curr_line);
 
 	refresh_view_win(view);
 	update_stat_window(view, 0);
@@ -21,6 +21,7 @@
 #define VIFM__UI__FILEVIEW_H__
 
 #include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
 
 #include "../utils/test_helpers.h"
 #include "ui.h"
@@ -65,6 +66,12 @@ void erase_current_line_bar(FileView *view);
 /* Redraws cursor of the view on the screen. */
 void fview_cursor_redraw(FileView *view);
 
+/* Makes next redraw of the view draw all of its cells instead of only those
+ * that have changed.  Should be called when contents of the window is changed
+ * by something else or when appearance of cells changes in a way that isn't
+ * tracked (e.g., options or colors). */
+void fview_reset_cells(FileView *view);
+
 /* Viewport related functions. */
 
 /* Checks whether if all files are visible, so no scrolling is needed.  Returns
@@ -152,6 +159,15 @@ void fview_sorting_updated(FileView *view);
 
 #ifdef TEST
 
+/* Shape of tree prefix of an entry. */
+typedef struct
+{
+	int depth;      /* Nesting level of the entry (0 for roots) or -1 if unknown. */
+	uint64_t lasts; /* Bit i is set if node at level i + 1 on the path to the
+	                   entry (including the entry) is the last child. */
+}
+tree_prefix_t;
+
 /* Packet set of parameters to pass as user data for processing columns. */
 typedef struct
 {
@@ -166,6 +182,8 @@ typedef struct
 	size_t *prefix_len; /* Data prefix length (should be drawn in neutral color).
 	                     * A pointer to allow changing value in const struct.
 	                     * Should be zero first time, then auto reset. */
+
+	const tree_prefix_t *tree_prefix; /* Precomputed tree prefix or NULL. */
 }
 column_data_t;
 
@@ -173,6 +191,7 @@ column_data_t;
 
 TSTATIC_DEFS(
 	void format_name(int id, const void *data, size_t buf_len, char buf[]);
+	tree_prefix_t * get_tree_prefixes(const FileView *view, int top, int count);
 )
 
 #endif /* VIFM__UI__FILEVIEW_H__ */
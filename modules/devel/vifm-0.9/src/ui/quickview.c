@@ -20,14 +20,18 @@
 #include "quickview.h"
 
 #include <curses.h> /* mvwaddstr() wattrset() */
+#include <sys/stat.h> /* stat */
+#include <sys/time.h> /* gettimeofday() */
 #include <unistd.h> /* usleep() */
 
 #include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* FILE SEEK_SET fclose() fdopen() feof() fseek()
                       tmpfile() */
 #include <stdlib.h> /* free() */
-#include <string.h> /* memmove() strcat() strlen() strncat() */
+#include <string.h> /* memmove() strcat() strcmp() strlen() strncat() */
+#include <time.h> /* time() */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
@@ -37,7 +41,9 @@
 #include "../modes/modes.h"
 #include "../modes/view.h"
 #include "../utils/file_streams.h"
+#include "../utils/filemon.h"
 #include "../utils/fs.h"
+#include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
@@ -61,6 +67,16 @@
 /* Size of buffer holding preview line (in characters). */
 #define PREVIEW_LINE_BUF_LEN 4096
 
+/* Parameters of directory tree preview. */
+enum
+{
+	TREE_MAX_BREADTH = 256,      /* Max number of entries of nested directory. */
+	TREE_QV_BUDGET_MS = 500,     /* Time limit for quick view preview. */
+	TREE_VIEW_BUDGET_MS = 3000,  /* Time limit for view mode preview. */
+	LISTING_CACHE_SIZE = 64,     /* Number of cached directory listings. */
+	LISTING_CACHE_NAMES = 16384, /* Max number of names in cached listings. */
+};
+
 /* State of directory tree print functions. */
 typedef struct
 {
@@ -69,24 +85,49 @@ typedef struct
 	int ndirs;         /* Number of seen directories. */
 	int nfiles;        /* Number of seen files. */
 	int max;           /* Maximum line number. */
+	uint64_t deadline; /* Time (in microseconds) at which traversal stops. */
+	int truncated;     /* Whether some of the entries were omitted. */
 	char prefix[4096]; /* Prefix character for each tree level. */
 }
 tree_print_state_t;
 
+/* Sorted listing of a directory that is reused while directory is unchanged. */
+typedef struct
+{
+	char *path;     /* Path to the directory, NULL for unused entry. */
+	filemon_t mon;  /* State of the directory at the moment of listing. */
+	char **names;   /* Names of directory entries. */
+	int len;        /* Number of entries. */
+	int last_use;   /* Value of use counter at the last access. */
+	int in_use;     /* Number of users of names, such listing isn't replaced. */
+}
+dir_listing_t;
+
 static void view_entry(const dir_entry_t *entry);
 static void view_file(const char path[]);
-static FILE * view_dir(const char path[], int max_lines);
-static int print_dir_tree(tree_print_state_t *s, const char path[], int last);
+static FILE * view_dir(const char path[], int max_lines, int budget_ms);
+static int print_dir_tree(tree_print_state_t *s, const char path[],
+		char *lst[], int len, int last);
+static int should_stop(tree_print_state_t *s);
+static uint64_t get_time_us(void);
+static char ** get_dir_listing(const char path[], int *len, int *cached);
+static void put_dir_listing(const char path[], char *lst[], int len,
+		int cached);
+static dir_listing_t * find_listing(const char path[]);
+static dir_listing_t * alloc_listing(int len);
+static void drop_listing(dir_listing_t *listing);
 static int enter_dir(tree_print_state_t *s, const char path[], int last);
-static int visit_file(tree_print_state_t *s, const char path[], int last);
-static int visit_link(tree_print_state_t *s, const char path[], int last,
-		const char target[]);
+static int visit_file(tree_print_state_t *s, const char path[], int dir,
+		int last);
+static int visit_link(tree_print_state_t *s, const char path[], int dir,
+		int last, const char target[]);
+static int visit_omitted(tree_print_state_t *s, int count);
 static void leave_dir(tree_print_state_t *s);
 static void indent_prefix(tree_print_state_t *s);
 static void unindent_prefix(tree_print_state_t *s);
 static void set_prefix_char(tree_print_state_t *s, char c);
 static void print_tree_entry(tree_print_state_t *s, const char path[],
-		int end_line);
+		int dir, int end_line);
 static void print_entry_prefix(tree_print_state_t *s);
 TSTATIC void view_stream(FILE *fp, int wrapped);
 static int shift_line(char line[], size_t len, size_t offset);
@@ -95,6 +136,13 @@ static void write_message(const char msg[]);
 static void cleanup_for_text(void);
 static char * expand_viewer_command(const char viewer[]);
 
+/* Listings of recently previewed directories. */
+static dir_listing_t listings[LISTING_CACHE_SIZE];
+/* Counter of listing cache accesses for finding least recently used entry. */
+static int listings_use_counter;
+/* Total number of names in all cached listings. */
+static int listings_names;
+
 int
 qv_ensure_is_shown(void)
 {
@@ -158,7 +206,7 @@ qv_draw(FileView *view)
 {
 	const dir_entry_t *curr;
 
-	if(curr_stats.load_stage < 2 || curr_stats.number_of_windows == 1 ||
+	if(curr_stats.load_stage < 3 || curr_stats.number_of_windows == 1 ||
 	   vle_mode_is(VIEW_MODE) || draw_abandoned_view_mode())
 	{
 		return;
@@ -233,7 +281,7 @@ view_file(const char path[])
 	{
 		ui_cancellation_reset();
 		ui_cancellation_enable();
-		fp = view_dir(path, ui_qv_height(other_view));
+		fp = view_dir(path, ui_qv_height(other_view), TREE_QV_BUDGET_MS);
 		ui_cancellation_disable();
 
 		if(fp == NULL)
@@ -293,28 +341,41 @@ view_file(const char path[])
 FILE *
 qv_view_dir(const char path[])
 {
-	return view_dir(path, INT_MAX);
+	return view_dir(path, INT_MAX, TREE_VIEW_BUDGET_MS);
 }
 
 /* Previews directory, actual preview is to be read from returned stream.
- * Returns the stream or NULL on error. */
+ * Traversal stops after max_lines lines were produced or after budget_ms
+ * milliseconds have passed.  Returns the stream or NULL on error. */
 static FILE *
-view_dir(const char path[], int max_lines)
+view_dir(const char path[], int max_lines, int budget_ms)
 {
-	FILE *fp = os_tmpfile();
+	int len, cached;
+	char **lst;
+	FILE *fp;
 
+	lst = get_dir_listing(path, &len, &cached);
+	if(len < 0)
+	{
+		put_dir_listing(path, lst, len, cached);
+		return NULL;
+	}
+
+	fp = os_tmpfile();
 	if(fp != NULL)
 	{
 		tree_print_state_t s = {
 			.fp = fp,
 			.max = max_lines,
+			.deadline = get_time_us() + budget_ms*1000ULL,
 		};
 
-		if(print_dir_tree(&s, path, 0) == 0 && s.n != 0)
+		if(print_dir_tree(&s, path, lst, len, 0) == 0 && s.n != 0)
 		{
 			/* Print summary only if we visited the whole subtree. */
 			fprintf(fp, "%s\n%d director%s, %d file%s",
-					ui_cancellation_requested() ? "(cancelled)\n" : "",
+					ui_cancellation_requested() ? "(cancelled)\n" :
+					s.truncated ? "(truncated)\n" : "",
 					s.ndirs, (s.ndirs == 1) ? "y" : "ies",
 					s.nfiles, (s.nfiles == 1) ? "" : "s");
 		}
@@ -333,40 +394,38 @@ view_dir(const char path[], int max_lines)
 			fseek(fp, 0, SEEK_SET);
 		}
 	}
+
+	put_dir_listing(path, lst, len, cached);
 	return fp;
 }
 
-/* Produces tree preview of the path.  Returns non-zero to request stopping of
- * the traversal, otherwise zero is returned. */
+/* Produces tree preview of the path, which contains len entries listed in the
+ * lst.  Returns non-zero to request stopping of the traversal,
+ * otherwise zero is returned. */
 static int
-print_dir_tree(tree_print_state_t *s, const char path[], int last)
+print_dir_tree(tree_print_state_t *s, const char path[], char *lst[], int len,
+		int last)
 {
 	int i;
 	int reached_limit;
-
-	int len;
-	char **lst = list_sorted_files(path, &len);
-
-	if(len < 0)
-	{
-		free_string_array(lst, len);
-		return 1;
-	}
+	/* Limit breadth of nested directories, so that single huge directory doesn't
+	 * take all the space. */
+	const int max_entries = (s->n == 0) ? len : MIN(len, TREE_MAX_BREADTH);
 
 	if(enter_dir(s, path, last) != 0)
 	{
-		free_string_array(lst, len);
 		return 1;
 	}
 
 	reached_limit = 0;
-	for(i = 0; i < len && !reached_limit && !ui_cancellation_requested(); ++i)
+	for(i = 0; i < max_entries && !reached_limit && !should_stop(s); ++i)
 	{
 		char link_target[PATH_MAX];
 		const int last_entry = (i == len - 1);
 		char *const full_path = format_str("%s/%s", path, lst[i]);
+		const int dir = is_dir(full_path);
 
-		if(is_dir(full_path))
+		if(dir)
 		{
 			++s->ndirs;
 		}
@@ -377,44 +436,221 @@ print_dir_tree(tree_print_state_t *s, const char path[], int last)
 
 		if(get_link_target(full_path, link_target, sizeof(link_target)) == 0)
 		{
-			if(visit_link(s, full_path, last_entry, link_target) != 0)
-			{
-				reached_limit = 1;
-			}
+			reached_limit = visit_link(s, full_path, dir, last_entry, link_target);
 		}
-		/* If is_dir_empty() returns non-zero than we know that it's directory and
-		 * no additional checks are needed. */
-		else if(!is_dir_empty(full_path))
+		else
 		{
-			if(last_entry)
+			int sub_len = -1, cached = 0;
+			char **const sub_lst = dir
+			                     ? get_dir_listing(full_path, &sub_len, &cached)
+			                     : NULL;
+			if(sub_len > 0)
 			{
-				set_prefix_char(s, '`');
+				if(last_entry)
+				{
+					set_prefix_char(s, '`');
+				}
+				reached_limit = print_dir_tree(s, full_path, sub_lst, sub_len,
+						last_entry);
 			}
-			if(print_dir_tree(s, full_path, last_entry) != 0)
+			else
 			{
-				reached_limit = 1;
+				reached_limit = visit_file(s, full_path, dir, last_entry);
 			}
-		}
-		else if(visit_file(s, full_path, last_entry) != 0)
-		{
-			reached_limit = 1;
+			put_dir_listing(full_path, sub_lst, sub_len, cached);
 		}
 
 		free(full_path);
 	}
-	free_string_array(lst, len);
+
+	if(i == max_entries && max_entries != len && !reached_limit)
+	{
+		reached_limit = visit_omitted(s, len - max_entries);
+	}
 
 	leave_dir(s);
 
 	return reached_limit;
 }
 
+/* Checks whether traversal should stop because of cancellation request or
+ * because its time is up.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+should_stop(tree_print_state_t *s)
+{
+	if(ui_cancellation_requested())
+	{
+		return 1;
+	}
+
+	if(get_time_us() >= s->deadline)
+	{
+		s->truncated = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Retrieves current time.  Returns the time in microseconds. */
+static uint64_t
+get_time_us(void)
+{
+	struct timeval tv = {0};
+	(void)gettimeofday(&tv, NULL);
+	return tv.tv_sec*1000000ULL + tv.tv_usec;
+}
+
+/* Lists sorted entries of a directory reusing result of previous listing if the
+ * directory didn't change since then.  *cached is set to non-zero if the list
+ * is owned by the cache, in which case it stays valid until it's passed to
+ * put_dir_listing().  Returns the list, *len is negative on error. */
+static char **
+get_dir_listing(const char path[], int *len, int *cached)
+{
+	filemon_t mon;
+	struct stat st;
+	dir_listing_t *listing;
+	char **lst;
+
+	*cached = 0;
+
+	if(filemon_from_file(path, &mon) != 0)
+	{
+		return list_sorted_files(path, len);
+	}
+
+	listing = find_listing(path);
+	if(listing != NULL && filemon_equal(&listing->mon, &mon))
+	{
+		listing->last_use = ++listings_use_counter;
+		++listing->in_use;
+		*cached = 1;
+		*len = listing->len;
+		return listing->names;
+	}
+
+	lst = list_sorted_files(path, len);
+
+	/* Changes that happen within timestamp resolution after listing can't be
+	 * detected, so don't cache listings of directories modified just now. */
+	if(*len < 0 || *len > LISTING_CACHE_NAMES || os_stat(path, &st) != 0 ||
+			st.st_mtime + 1 >= time(NULL))
+	{
+		return lst;
+	}
+
+	if(listing != NULL)
+	{
+		/* Outdated listing can't be replaced while someone is using it. */
+		if(listing->in_use != 0)
+		{
+			return lst;
+		}
+		drop_listing(listing);
+	}
+
+	listing = alloc_listing(*len);
+	if(listing == NULL || replace_string(&listing->path, path) != 0)
+	{
+		return lst;
+	}
+
+	listing->names = lst;
+	listing->len = *len;
+	listing->mon = mon;
+	listing->last_use = ++listings_use_counter;
+	listing->in_use = 1;
+	listings_names += *len;
+
+	*cached = 1;
+	return lst;
+}
+
+/* Releases list obtained via get_dir_listing(). */
+static void
+put_dir_listing(const char path[], char *lst[], int len, int cached)
+{
+	if(cached)
+	{
+		--find_listing(path)->in_use;
+	}
+	else
+	{
+		free_string_array(lst, len);
+	}
+}
+
+/* Looks up directory listing in the cache.  Returns pointer to the listing or
+ * NULL if it's not in the cache. */
+static dir_listing_t *
+find_listing(const char path[])
+{
+	int i;
+	for(i = 0; i < LISTING_CACHE_SIZE; ++i)
+	{
+		if(listings[i].path != NULL && strcmp(listings[i].path, path) == 0)
+		{
+			return &listings[i];
+		}
+	}
+	return NULL;
+}
+
+/* Frees cache entries until there is an unused one and len more names fit
+ * into the cache.  Entries that are in use are never freed.  Returns the
+ * entry or NULL if there is no room. */
+static dir_listing_t *
+alloc_listing(int len)
+{
+	while(1)
+	{
+		dir_listing_t *unused = NULL, *lru = NULL;
+		int i;
+
+		for(i = 0; i < LISTING_CACHE_SIZE; ++i)
+		{
+			if(listings[i].path == NULL)
+			{
+				unused = &listings[i];
+			}
+			else if(listings[i].in_use == 0 &&
+					(lru == NULL || listings[i].last_use < lru->last_use))
+			{
+				lru = &listings[i];
+			}
+		}
+
+		if(unused != NULL && listings_names + len <= LISTING_CACHE_NAMES)
+		{
+			return unused;
+		}
+		if(lru == NULL)
+		{
+			return NULL;
+		}
+		drop_listing(lru);
+	}
+}
+
+/* Frees cache entry making it unused. */
+static void
+drop_listing(dir_listing_t *listing)
+{
+	free_string_array(listing->names, listing->len);
+	listings_names -= listing->len;
+	update_string(&listing->path, NULL);
+	listing->names = NULL;
+	listing->len = 0;
+}
+
 /* Handles entering directory on directory tree traversal.  Returns non-zero to
  * request stopping of the traversal, otherwise zero is returned. */
 static int
 enter_dir(tree_print_state_t *s, const char path[], int last)
 {
-	print_tree_entry(s, path, 1);
+	print_tree_entry(s, path, 1, 1);
 
 	if(last)
 	{
@@ -430,10 +666,10 @@ enter_dir(tree_print_state_t *s, const char path[], int last)
 /* Handles visiting file on directory tree traversal.  Returns non-zero to
  * request stopping of the traversal, otherwise zero is returned. */
 static int
-visit_file(tree_print_state_t *s, const char path[], int last)
+visit_file(tree_print_state_t *s, const char path[], int dir, int last)
 {
 	set_prefix_char(s, last ? '`' : '|');
-	print_tree_entry(s, path, 1);
+	print_tree_entry(s, path, dir, 1);
 
 	return ++s->n >= s->max;
 }
@@ -441,11 +677,11 @@ visit_file(tree_print_state_t *s, const char path[], int last)
 /* Handles visiting symbolic link on directory tree traversal.  Returns non-zero
  * to request stopping of the traversal, otherwise zero is returned. */
 static int
-visit_link(tree_print_state_t *s, const char path[], int last,
+visit_link(tree_print_state_t *s, const char path[], int dir, int last,
 		const char target[])
 {
 	set_prefix_char(s, last ? '`' : '|');
-	print_tree_entry(s, path, 0);
+	print_tree_entry(s, path, dir, 0);
 	fputs(" -> ", s->fp);
 	fputs(target, s->fp);
 	fputc('\n', s->fp);
@@ -453,6 +689,21 @@ visit_link(tree_print_state_t *s, const char path[], int last,
 	return ++s->n >= s->max;
 }
 
+/* Handles entries of a directory that aren't displayed on directory tree
+ * traversal.  Returns non-zero to request stopping of the traversal, otherwise
+ * zero is returned. */
+static int
+visit_omitted(tree_print_state_t *s, int count)
+{
+	s->truncated = 1;
+
+	set_prefix_char(s, '`');
+	print_entry_prefix(s);
+	fprintf(s->fp, "... (%d more)\n", count);
+
+	return ++s->n >= s->max;
+}
+
 /* Handles leaving directory on directory tree traversal. */
 static void
 leave_dir(tree_print_state_t *s)
@@ -488,13 +739,15 @@ set_prefix_char(tree_print_state_t *s, char c)
 	}
 }
 
-/* Prints single entry of directory tree. */
+/* Prints single entry of directory tree.  The dir parameter specifies whether
+ * the path refers to a directory. */
 static void
-print_tree_entry(tree_print_state_t *s, const char path[], int end_line)
+print_tree_entry(tree_print_state_t *s, const char path[], int dir,
+		int end_line)
 {
 	print_entry_prefix(s);
 	fputs(get_last_path_component(path), s->fp);
-	if(is_dir(path) && !ends_with_slash(path))
+	if(dir && !ends_with_slash(path))
 	{
 		fputc('/', s->fp);
 	}
@@ -20,7 +20,6 @@
 #define VIFM__UI__STATUSBAR_H__
 
 #include "../utils/macros.h"
-#include "../utils/test_helpers.h"
 
 /* Managing status bar. */
 
@@ -45,9 +44,9 @@ void status_bar_errorf(const char message[], ...) _gnuc_printf(1, 2);
 
 int is_status_bar_multiline(void);
 
-TSTATIC_DEFS(
-	const char * get_last_message(void);
-)
+/* Retrieves last message printed on the status bar.  Returns the message or
+ * NULL if there were none. */
+const char * get_last_message(void);
 
 #endif /* VIFM__UI__STATUSBAR_H__ */
 
@@ -44,6 +44,7 @@
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "../background.h"
+#include "../event_loop.h"
 #include "../filelist.h"
 #include "ui.h"
 
@@ -594,6 +595,8 @@ ui_stat_job_bar_changed(bg_op_t *bg_op)
 	pthread_spin_lock(lock);
 	job_bar_changed = 1;
 	pthread_spin_unlock(lock);
+
+	event_loop_wake();
 }
 
 void
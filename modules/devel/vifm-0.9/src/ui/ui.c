@@ -56,6 +56,7 @@
 #include "../utils/matchers.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/trace.h"
 #include "../utils/utf8.h"
 #include "../utils/utils.h"
 #include "../event_loop.h"
@@ -569,6 +570,10 @@ update_screen(UpdateType update_kind)
 
 	update_attributes();
 
+	/* Any of options or colors might have changed, so redraw everything. */
+	fview_reset_cells(&lwin);
+	fview_reset_cells(&rwin);
+
 	if(cfg.side_borders_visible)
 	{
 		clear_border(lborder);
@@ -586,7 +591,9 @@ update_screen(UpdateType update_kind)
 
 	curr_stats.need_update = UT_NONE;
 
+	trace_begin("update_screen", NULL);
 	update_views(update_kind == UT_FULL);
+	trace_end();
 	/* Redraw message dialog over updated panes.  It's not very nice to do it
 	 * here, but for sure better then blocking pane updates by checking for
 	 * message mode. */
@@ -1768,6 +1775,7 @@ ui_view_erase(FileView *view)
 	const int bg = COLOR_PAIR(cs->pair[WIN_COLOR]) | cs->color[WIN_COLOR].attr;
 	wbkgdset(view->win, bg);
 	werase(view->win);
+	fview_reset_cells(view);
 }
 
 void
@@ -1793,6 +1801,7 @@ ui_view_wipe(FileView *view)
 	}
 	redrawwin(view->win);
 	wrefresh(view->win);
+	fview_reset_cells(view);
 }
 
 int
@@ -1807,6 +1816,7 @@ ui_view_schedule_redraw(FileView *view)
 	pthread_mutex_lock(view->timestamps_mutex);
 	view->postponed_redraw = get_updated_time(view->postponed_redraw);
 	pthread_mutex_unlock(view->timestamps_mutex);
+	event_loop_wake();
 }
 
 void
@@ -1815,6 +1825,7 @@ ui_view_schedule_reload(FileView *view)
 	pthread_mutex_lock(view->timestamps_mutex);
 	view->postponed_reload = get_updated_time(view->postponed_reload);
 	pthread_mutex_unlock(view->timestamps_mutex);
+	event_loop_wake();
 }
 
 void
@@ -1823,6 +1834,7 @@ ui_view_schedule_full_reload(FileView *view)
 	pthread_mutex_lock(view->timestamps_mutex);
 	view->postponed_full_reload = get_updated_time(view->postponed_full_reload);
 	pthread_mutex_unlock(view->timestamps_mutex);
+	event_loop_wake();
 }
 
 /* Gets updated timestamp ensuring that it differs from the previous value.
@@ -34,6 +34,7 @@
 #include "../compat/fs_limits.h"
 #include "../compat/pthread.h"
 #include "../utils/filter.h"
+#include "../utils/fsprefetch.h"
 #include "../utils/fswatch.h"
 #include "../status.h"
 #include "../types.h"
@@ -165,9 +166,43 @@ history_t;
 /* Description of a single directory entry. */
 typedef struct dir_entry_t
 {
+	/* Fields that are used by sorting, filtering and searching go first, so that
+	 * passes over the list touch as few cache lines as possible.  Fields are also
+	 * ordered to avoid padding. */
+
 	char *name;
-	char *origin;     /* Location where this file comes from. */
+	FileType type;
+
+	int search_match;      /* Non-zero if the item matches last search.  Equals to
+	                          search match number (top to bottom order). */
+	short int match_left;  /* Starting position of search match. */
+	short int match_right; /* Ending position of search match. */
+
+	unsigned int selected : 1;     /* Whether file is selected. */
+	unsigned int was_selected : 1; /* Previous selection state for Visual mode. */
+	unsigned int marked : 1;       /* Whether file should be processed. */
+	unsigned int temporary : 1;    /* Whether this is temporary node. */
+	unsigned int dir_link : 1;     /* Whether this is symlink to a directory. */
+	unsigned int broken_link : 1;  /* Whether this is symlink whose target is
+	                                  missing (computed on loading). */
+
 	uint64_t size;
+	time_t mtime;
+	char *origin;     /* Location where this file comes from. */
+
+	int tag;          /* Used to hold temporary data associated with the item,
+	                     e.g. by sorting comparer to perform stable sort or item
+	                     mapping during tree filtering. */
+	int id;           /* File uniqueness identifier. */
+
+	int child_count; /* Number of child entries (all, not just direct). */
+	int child_pos;   /* Position of this entry in among children of its parent.
+	                    Zero for top-level entries. */
+
+	/* Fields below are mostly used on displaying entries. */
+
+	time_t atime;
+	time_t ctime;
 #ifndef _WIN32
 	uid_t uid;
 	gid_t gid;
@@ -175,36 +210,14 @@ typedef struct dir_entry_t
 #else
 	uint32_t attrs;
 #endif
-	time_t mtime;
-	time_t atime;
-	time_t ctime;
-	FileType type;
 	int nlinks;       /* Number of hard links to the entry. */
 
-	int id;           /* File uniqueness identifier. */
-
-	int tag;          /* Used to hold temporary data associated with the item,
-	                     e.g. by sorting comparer to perform stable sort or item
-	                     mapping during tree filtering. */
-
 	int hi_num;       /* File highlighting parameters cache (initially -1). */
 	int name_dec_num; /* File decoration parameters cache (initially -1).  The
 	                     value is shifted by one, 0 means type decoration. */
-
-	int child_count; /* Number of child entries (all, not just direct). */
-	int child_pos;   /* Position of this entry in among children of its parent.
-	                    Zero for top-level entries. */
-
-	int search_match;      /* Non-zero if the item matches last search.  Equals to
-	                          search match number (top to bottom order). */
-	short int match_left;  /* Starting position of search match. */
-	short int match_right; /* Ending position of search match. */
-
-	unsigned int selected : 1;     /* Whether file is selected. */
-	unsigned int was_selected : 1; /* Previous selection state for Visual mode. */
-	unsigned int marked : 1;       /* Whether file should be processed. */
-	unsigned int temporary : 1;    /* Whether this is temporary node. */
-	unsigned int dir_link : 1;     /* Whether this is symlink to a directory. */
+	uint64_t stamp;   /* Unique identity of name and origin of the entry, which
+	                     is used to find out what needs to be redrawn.  Stays
+	                     the same in copies of the entry.  See fentry_touch(). */
 }
 dir_entry_t;
 
@@ -255,6 +268,9 @@ typedef struct
 		 * by tree-view. */
 		struct trie_t *excluded_paths;
 
+		/* Maximum number of levels of tree-view. */
+		int tree_depth;
+
 		/* Names of files in custom view while it's being composed.  Used for
 		 * duplicate elimination during construction of custom list. */
 		struct trie_t *paths_cache;
@@ -265,6 +281,14 @@ typedef struct
 	fswatch_t *watch;
 	char watched_dir[PATH_MAX];
 
+	/* Listing of current directory that's being read ahead of time or NULL.  It's
+	 * consumed or discarded by the next load of the file list. */
+	fsprefetch_t *prefetch;
+	/* Whether loading of file list waits for the prefetch to finish and the
+	 * reload flag of that load. */
+	int load_postponed;
+	int postponed_load_reload;
+
 	char last_dir[PATH_MAX];
 
 	/* Number of files that match current search pattern. */
@@ -382,6 +406,13 @@ typedef struct
 	                                      This is a pointer, because mutexes
 	                                      shouldn't be copied*/
 
+	/* State of file list cells as of the last redraw, which is used to draw only
+	 * cells that have changed.  Managed by fileview unit. */
+	struct cell_state_t *cells;
+	int ncells;        /* Number of elements in the cells array. */
+	int cells_redrawn; /* Number of cells drawn by the last redraw (reported in
+	                      draw_dir_list spans of :profile output). */
+
 	uint64_t last_redraw; /* Time of last redraw. */
 	uint64_t last_reload; /* Time of last [full] reload. */
 
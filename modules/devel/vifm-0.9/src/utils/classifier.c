@@ -0,0 +1,357 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "classifier.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* memmove() strchr() strdup() strlen() */
+
+#include "../compat/reallocarray.h"
+#include "matchers.h"
+#include "path.h"
+#include "str.h"
+#include "trie.h"
+
+/* Sorted list of rule indexes. */
+typedef struct
+{
+	int *items; /* Indexes in ascending order. */
+	int count;  /* Number of items. */
+}
+index_list_t;
+
+/* Classifier state. */
+struct classifier_t
+{
+	const struct matchers_t **rules; /* All rules in order. */
+	int count;                       /* Number of rules. */
+
+	int *general;  /* Indexes of rules that need to be tried one by one. */
+	int ngeneral;  /* Number of elements in general array. */
+
+	trie_t *names;    /* Maps lower-cased names to index_list_t. */
+	trie_t *suffixes; /* Maps lower-cased suffixes to index_list_t. */
+
+	int *suffix_lens; /* Lengths of suffixes in suffixes trie in ascending
+	                     order. */
+	int nsuffix_lens; /* Number of elements in suffix_lens. */
+};
+
+static int add_globs(classifier_t *c, const char globs[], int idx);
+static int is_indexable(const char globs[]);
+static int add_to_table(trie_t *table, const char key[], int idx);
+static int add_suffix_len(classifier_t *c, int len);
+static int append_int(int **array, int *count, int value);
+static int first_in_table(trie_t *table, const char key[], int from, int best);
+static void lower_ascii(char str[]);
+static void free_index_list(void *ptr);
+
+classifier_t *
+classifier_create(void)
+{
+	classifier_t *const c = calloc(1U, sizeof(*c));
+	if(c == NULL)
+	{
+		return NULL;
+	}
+
+	c->names = trie_create();
+	c->suffixes = trie_create();
+	if(c->names == NULL || c->suffixes == NULL)
+	{
+		classifier_free(c);
+		return NULL;
+	}
+
+	return c;
+}
+
+void
+classifier_free(classifier_t *c)
+{
+	if(c == NULL)
+	{
+		return;
+	}
+
+	trie_free_with_data(c->names, &free_index_list);
+	trie_free_with_data(c->suffixes, &free_index_list);
+	free(c->suffix_lens);
+	free(c->general);
+	free(c->rules);
+	free(c);
+}
+
+int
+classifier_add(classifier_t *c, const struct matchers_t *matchers)
+{
+	const int idx = c->count;
+	const char *globs;
+	void *p;
+
+	if(matchers == NULL)
+	{
+		return 1;
+	}
+
+	p = reallocarray(c->rules, c->count + 1, sizeof(*c->rules));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	c->rules = p;
+	c->rules[c->count++] = matchers;
+
+	globs = matchers_get_name_globs(matchers);
+	if(globs != NULL && is_indexable(globs) && add_globs(c, globs, idx) == 0)
+	{
+		return 0;
+	}
+
+	return append_int(&c->general, &c->ngeneral, idx);
+}
+
+/* Puts every glob of the list into lookup tables.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+add_globs(classifier_t *c, const char globs[], int idx)
+{
+	int error = 0;
+	char *const copy = strdup(globs);
+	char *glob = copy, *state = NULL;
+
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	lower_ascii(copy);
+
+	while(!error && (glob = split_and_get(glob, ',', &state)) != NULL)
+	{
+		if(glob[0] == '*')
+		{
+			error = add_to_table(c->suffixes, glob + 1, idx)
+			     || add_suffix_len(c, strlen(glob + 1));
+		}
+		else
+		{
+			error = add_to_table(c->names, glob, idx);
+		}
+	}
+
+	free(copy);
+	return error;
+}
+
+/* Checks whether every glob of the list is either a literal name or an asterisk
+ * followed by literal suffix.  Only ASCII is accepted to make case-insensitive
+ * comparison trivial.  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_indexable(const char globs[])
+{
+	const char *glob = globs;
+	while(*glob != '\0')
+	{
+		const char *const end = until_first(glob, ',');
+		const char *p;
+
+		for(p = (*glob == '*') ? glob + 1 : glob; p != end; ++p)
+		{
+			if((unsigned char)*p >= 0x80 || strchr("*?[\\", *p) != NULL)
+			{
+				return 0;
+			}
+		}
+
+		glob = (*end == ',') ? end + 1 : end;
+	}
+	return 1;
+}
+
+/* Adds index to the list associated with the key.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+add_to_table(trie_t *table, const char key[], int idx)
+{
+	void *data;
+	index_list_t *list;
+
+	if(trie_get(table, key, &data) == 0 && data != NULL)
+	{
+		list = data;
+	}
+	else
+	{
+		list = calloc(1U, sizeof(*list));
+		if(list == NULL || trie_set(table, key, list) < 0)
+		{
+			free(list);
+			return 1;
+		}
+	}
+
+	/* Same rule can contain the same glob several times. */
+	if(list->count != 0 && list->items[list->count - 1] == idx)
+	{
+		return 0;
+	}
+
+	return append_int(&list->items, &list->count, idx);
+}
+
+/* Registers length of a suffix keeping the list sorted and unique.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+add_suffix_len(classifier_t *c, int len)
+{
+	int i;
+	void *p;
+
+	for(i = 0; i < c->nsuffix_lens && c->suffix_lens[i] < len; ++i)
+	{
+	}
+
+	if(i < c->nsuffix_lens && c->suffix_lens[i] == len)
+	{
+		return 0;
+	}
+
+	p = reallocarray(c->suffix_lens, c->nsuffix_lens + 1,
+			sizeof(*c->suffix_lens));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	c->suffix_lens = p;
+
+	memmove(&c->suffix_lens[i + 1], &c->suffix_lens[i],
+			sizeof(*c->suffix_lens)*(c->nsuffix_lens - i));
+	c->suffix_lens[i] = len;
+	++c->nsuffix_lens;
+	return 0;
+}
+
+/* Appends value to the end of dynamically allocated array.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+append_int(int **array, int *count, int value)
+{
+	void *const p = reallocarray(*array, *count + 1, sizeof(**array));
+	if(p == NULL)
+	{
+		return 1;
+	}
+
+	*array = p;
+	(*array)[(*count)++] = value;
+	return 0;
+}
+
+int
+classifier_find(const classifier_t *c, const char path[], int from)
+{
+	const char *const name = get_last_path_component(path);
+	const size_t len = strlen(name);
+	char lower[len + 1];
+	int best = c->count;
+	int i;
+
+	copy_str(lower, sizeof(lower), name);
+	lower_ascii(lower);
+
+	best = first_in_table(c->names, lower, from, best);
+
+	/* Leading asterisk of a glob matches at least one character, which can't be
+	 * a dot. */
+	if(lower[0] != '.')
+	{
+		for(i = 0; i < c->nsuffix_lens && (size_t)c->suffix_lens[i] < len; ++i)
+		{
+			best = first_in_table(c->suffixes, lower + len - c->suffix_lens[i], from,
+					best);
+		}
+	}
+
+	/* Only rules that precede what's found so far can change the result. */
+	for(i = 0; i < c->ngeneral && c->general[i] < best; ++i)
+	{
+		const int idx = c->general[i];
+		if(idx >= from && matchers_match(c->rules[idx], path))
+		{
+			return idx;
+		}
+	}
+
+	return (best < c->count) ? best : -1;
+}
+
+/* Looks up rules associated with the key.  Returns the smallest index that is
+ * not less than from if it's less than best, otherwise best is returned. */
+static int
+first_in_table(trie_t *table, const char key[], int from, int best)
+{
+	int i;
+	void *data;
+	const index_list_t *list;
+
+	if(trie_get(table, key, &data) != 0 || data == NULL)
+	{
+		return best;
+	}
+
+	list = data;
+	for(i = 0; i < list->count && list->items[i] < best; ++i)
+	{
+		if(list->items[i] >= from)
+		{
+			return list->items[i];
+		}
+	}
+	return best;
+}
+
+/* Converts ASCII letters of the string to lower case in place. */
+static void
+lower_ascii(char str[])
+{
+	while(*str != '\0')
+	{
+		if(*str >= 'A' && *str <= 'Z')
+		{
+			*str += 'a' - 'A';
+		}
+		++str;
+	}
+}
+
+/* Frees index list stored in a trie. */
+static void
+free_index_list(void *ptr)
+{
+	index_list_t *const list = ptr;
+	if(list != NULL)
+	{
+		free(list->items);
+		free(list);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
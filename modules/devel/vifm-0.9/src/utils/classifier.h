@@ -0,0 +1,52 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__CLASSIFIER_H__
+#define VIFM__UTILS__CLASSIFIER_H__
+
+struct matchers_t;
+
+/* Index over ordered list of matchers that finds first of them that matches a
+ * path without trying them one by one.  Matchers that are lists of plain file
+ * names and of globs of the form "*suffix" are put into lookup tables, others
+ * are tried in order, but only until the first match found via the tables.
+ * Matchers are referenced, not copied, so they must outlive the index. */
+
+/* Opaque declaration of the classifier type. */
+typedef struct classifier_t classifier_t;
+
+/* Creates an empty classifier.  Returns the classifier or NULL on error. */
+classifier_t * classifier_create(void);
+
+/* Frees resources of the classifier.  The classifier can be NULL. */
+void classifier_free(classifier_t *c);
+
+/* Appends matchers to the end of the list of rules, their index equals to
+ * number of previously added rules.  Returns zero on success, otherwise
+ * non-zero is returned and the classifier shouldn't be used anymore. */
+int classifier_add(classifier_t *c, const struct matchers_t *matchers);
+
+/* Finds first rule starting from the one with index from that matches the path
+ * (as matchers_match() would).  Returns index of the rule or -1 if none
+ * matches. */
+int classifier_find(const classifier_t *c, const char path[], int from);
+
+#endif /* VIFM__UTILS__CLASSIFIER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,310 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dircache.h"
+
+#include <sys/stat.h> /* stat */
+#include <dirent.h> /* DIR dirent */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() qsort() */
+#include <string.h> /* strcmp() strdup() strlen() strncmp() */
+#include <time.h> /* time() */
+
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "filemon.h"
+#include "macros.h"
+#include "path.h"
+
+/* Maximum number of listings kept in the cache. */
+#define CACHE_SIZE 8
+
+/* Cached listing along with information to check whether it's up to date. */
+typedef struct
+{
+	char *path;                 /* Path to the directory or NULL for free slot. */
+	dircache_listing_t listing; /* Names of files. */
+	filemon_t mon;              /* State of the directory before reading. */
+	int racy;                   /* Directory was changed right before reading. */
+	unsigned long used;         /* Value of use counter on last access. */
+}
+cached_dir_t;
+
+static cached_dir_t * find_dir(const char path[]);
+static int is_up_to_date(const cached_dir_t *dir);
+static cached_dir_t * pick_slot(void);
+static int read_dir(cached_dir_t *dir, const char path[]);
+static DirCacheType get_type(const struct dirent *d);
+static int compare_entries(const void *a, const void *b);
+static void free_dir(cached_dir_t *dir);
+
+/* Cached listings. */
+static cached_dir_t cache[CACHE_SIZE];
+/* Counter of accesses to the cache. */
+static unsigned long use_counter;
+
+const dircache_listing_t *
+dircache_get(const char path[])
+{
+	cached_dir_t *dir = find_dir(path);
+
+	if(dir != NULL && !is_up_to_date(dir))
+	{
+		free_dir(dir);
+		dir = NULL;
+	}
+
+	if(dir == NULL)
+	{
+		dir = pick_slot();
+		free_dir(dir);
+		if(read_dir(dir, path) != 0)
+		{
+			free_dir(dir);
+			return NULL;
+		}
+	}
+
+	dir->used = ++use_counter;
+	return &dir->listing;
+}
+
+int
+dircache_find_prefix(const dircache_listing_t *listing, const char prefix[],
+		int *first)
+{
+	const size_t len = strlen(prefix);
+	int l, r;
+
+	/* Lower bound of the prefix. */
+	l = 0;
+	r = listing->count;
+	while(l < r)
+	{
+		const int m = l + (r - l)/2;
+		if(strcmp(listing->entries[m].name, prefix) < 0)
+		{
+			l = m + 1;
+		}
+		else
+		{
+			r = m;
+		}
+	}
+	*first = l;
+
+	/* Names that start with the prefix form contiguous range. */
+	r = listing->count;
+	while(l < r)
+	{
+		const int m = l + (r - l)/2;
+		if(strncmp(listing->entries[m].name, prefix, len) == 0)
+		{
+			l = m + 1;
+		}
+		else
+		{
+			r = m;
+		}
+	}
+
+	return l - *first;
+}
+
+void
+dircache_reset(void)
+{
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(cache); ++i)
+	{
+		free_dir(&cache[i]);
+	}
+}
+
+/* Looks up cached listing of the directory.  Returns the listing or NULL. */
+static cached_dir_t *
+find_dir(const char path[])
+{
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(cache); ++i)
+	{
+		if(cache[i].path != NULL && strcmp(cache[i].path, path) == 0)
+		{
+			return &cache[i];
+		}
+	}
+	return NULL;
+}
+
+/* Checks whether cached listing reflects current state of the directory.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_up_to_date(const cached_dir_t *dir)
+{
+	filemon_t mon;
+	return !dir->racy
+	    && filemon_from_file(dir->path, &mon) == 0
+	    && filemon_equal(&mon, &dir->mon);
+}
+
+/* Picks slot for a new listing, which is either unused or least recently used
+ * one.  Returns the slot. */
+static cached_dir_t *
+pick_slot(void)
+{
+	size_t i;
+	cached_dir_t *lru = &cache[0];
+
+	for(i = 0U; i < ARRAY_LEN(cache); ++i)
+	{
+		if(cache[i].path == NULL)
+		{
+			return &cache[i];
+		}
+		if(cache[i].used < lru->used)
+		{
+			lru = &cache[i];
+		}
+	}
+	return lru;
+}
+
+/* Reads listing of the directory into the slot.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+read_dir(cached_dir_t *dir, const char path[])
+{
+	struct stat s;
+	DIR *d;
+	struct dirent *entry;
+	int capacity = 0;
+
+	/* Timestamp is obtained first to not miss changes made while reading. */
+	if(filemon_from_file(path, &dir->mon) != 0 || os_stat(path, &s) != 0)
+	{
+		return 1;
+	}
+
+	/* Changes made within the same second might not affect the timestamp. */
+	dir->racy = (s.st_mtime + 1 >= time(NULL));
+
+	dir->path = strdup(path);
+	d = os_opendir(path);
+	if(dir->path == NULL || d == NULL)
+	{
+		if(d != NULL)
+		{
+			os_closedir(d);
+		}
+		return 1;
+	}
+
+	while((entry = os_readdir(d)) != NULL)
+	{
+		dircache_entry_t *e;
+
+		if(is_builtin_dir(entry->d_name))
+		{
+			continue;
+		}
+
+		if(dir->listing.count == capacity)
+		{
+			const int new_capacity = (capacity == 0) ? 64 : capacity*2;
+			dircache_entry_t *const p = reallocarray(dir->listing.entries,
+					new_capacity, sizeof(*p));
+			if(p == NULL)
+			{
+				break;
+			}
+			dir->listing.entries = p;
+			capacity = new_capacity;
+		}
+
+		e = &dir->listing.entries[dir->listing.count];
+		e->name = strdup(entry->d_name);
+		if(e->name == NULL)
+		{
+			break;
+		}
+		e->type = get_type(entry);
+		++dir->listing.count;
+	}
+	os_closedir(d);
+
+	if(entry != NULL)
+	{
+		return 1;
+	}
+
+	qsort(dir->listing.entries, dir->listing.count,
+			sizeof(dir->listing.entries[0]), &compare_entries);
+	return 0;
+}
+
+/* Determines type of the file without querying file system.  Returns the
+ * type. */
+static DirCacheType
+get_type(const struct dirent *d)
+{
+#ifndef _WIN32
+	switch(d->d_type)
+	{
+		case DT_UNKNOWN: return DCT_UNKNOWN;
+		case DT_DIR:     return DCT_DIR;
+		case DT_LNK:     return DCT_LINK;
+
+		default:
+			return DCT_OTHER;
+	}
+#else
+	return DCT_UNKNOWN;
+#endif
+}
+
+/* qsort() comparer that sorts entries by name.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_entries(const void *a, const void *b)
+{
+	const dircache_entry_t *const first = a;
+	const dircache_entry_t *const second = b;
+	return strcmp(first->name, second->name);
+}
+
+/* Frees listing of the slot and marks it as unused. */
+static void
+free_dir(cached_dir_t *dir)
+{
+	int i;
+	for(i = 0; i < dir->listing.count; ++i)
+	{
+		free(dir->listing.entries[i].name);
+	}
+	free(dir->listing.entries);
+	free(dir->path);
+
+	dir->path = NULL;
+	dir->listing.entries = NULL;
+	dir->listing.count = 0;
+	dir->used = 0UL;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,68 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DIRCACHE_H__
+#define VIFM__UTILS__DIRCACHE_H__
+
+/* Cache of sorted listings of several recently used directories.  Listing is
+ * reread when timestamp of its directory changes, least recently used listing
+ * is dropped to make room for a new one.  "." and ".." aren't listed. */
+
+/* Type of a file as reported by directory entry. */
+typedef enum
+{
+	DCT_UNKNOWN, /* Type isn't known without querying file system. */
+	DCT_DIR,     /* Directory. */
+	DCT_LINK,    /* Symbolic link. */
+	DCT_OTHER,   /* Any other kind of file. */
+}
+DirCacheType;
+
+/* Single file of a listing. */
+typedef struct
+{
+	char *name;        /* Name of the file. */
+	DirCacheType type; /* Type of the file. */
+}
+dircache_entry_t;
+
+/* Listing of a directory. */
+typedef struct
+{
+	dircache_entry_t *entries; /* Entries sorted by name with strcmp(). */
+	int count;                 /* Number of entries. */
+}
+dircache_listing_t;
+
+/* Retrieves listing of the directory reading it if there is no up to date one
+ * in the cache.  Returns pointer that is valid until the next call or NULL on
+ * error. */
+const dircache_listing_t * dircache_get(const char path[]);
+
+/* Finds range of entries whose names start with the prefix.  Sets *first to
+ * index of the first such entry.  Returns number of entries in the range. */
+int dircache_find_prefix(const dircache_listing_t *listing,
+		const char prefix[], int *first);
+
+/* Drops all cached listings. */
+void dircache_reset(void);
+
+#endif /* VIFM__UTILS__DIRCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,440 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "execcache.h"
+
+#include <sys/stat.h> /* stat */
+#include <dirent.h> /* DIR dirent */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* bsearch() calloc() free() qsort() */
+#include <string.h> /* strchr() strcmp() strdup() */
+#include <time.h> /* time_t time() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "filemon.h"
+#include "path.h"
+#include "str.h"
+#include "string_array.h"
+#include "utils.h"
+
+/* Number of seconds during which directories aren't checked for changes. */
+#define CHECK_PERIOD 2
+
+/* Indexed directory. */
+typedef struct
+{
+	char *path;    /* Path to the directory. */
+	char **names;  /* Sorted names of files of the directory. */
+	int count;     /* Number of elements in names array. */
+	filemon_t mon; /* State of the directory before it was read. */
+	int read;      /* Whether names were read. */
+	int missing;   /* Whether directory didn't exist. */
+	int racy;      /* Whether directory was changed right before reading. */
+}
+dir_t;
+
+#ifndef _WIN32
+static int acquire(int wait);
+static void start_loading(void);
+static void * load_thread(void *arg);
+static void refresh(void);
+static int dir_changed(const dir_t *dir);
+static void read_dir(dir_t *dir);
+static int compare_names(const void *a, const void *b);
+static void free_dirs(dir_t dirs[], int count);
+
+/* Protects variables below and is used with the condition variable. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when background reading is finished. */
+static pthread_cond_t loaded = PTHREAD_COND_INITIALIZER;
+
+/* List of indexed directories. */
+static dir_t *dirs;
+/* Number of elements in dirs array. */
+static int ndirs;
+/* Whether list of directories was set. */
+static int initialized;
+/* Whether directories are being read in background. */
+static int loading;
+/* Time before which directories are considered to be unchanged. */
+static time_t next_check;
+#endif
+
+void
+execcache_set_dirs(char *paths[], int count)
+{
+#ifndef _WIN32
+	int i, j;
+	dir_t *new_dirs = calloc(count, sizeof(*new_dirs));
+
+	pthread_mutex_lock(&lock);
+	while(loading)
+	{
+		pthread_cond_wait(&loaded, &lock);
+	}
+
+	for(i = 0; i < count && new_dirs != NULL; ++i)
+	{
+		for(j = 0; j < ndirs; ++j)
+		{
+			if(dirs[j].path != NULL && strcmp(dirs[j].path, paths[i]) == 0)
+			{
+				new_dirs[i] = dirs[j];
+				dirs[j].path = NULL;
+				dirs[j].names = NULL;
+				dirs[j].count = 0;
+				break;
+			}
+		}
+
+		if(j == ndirs)
+		{
+			new_dirs[i].path = strdup(paths[i]);
+			if(new_dirs[i].path == NULL)
+			{
+				free_dirs(new_dirs, i);
+				new_dirs = NULL;
+			}
+		}
+	}
+
+	free_dirs(dirs, ndirs);
+	dirs = new_dirs;
+	ndirs = (new_dirs == NULL) ? 0 : count;
+	/* Without directories index would report that there are no executables. */
+	initialized = (new_dirs != NULL || count == 0);
+	next_check = 0;
+
+	start_loading();
+
+	pthread_mutex_unlock(&lock);
+#endif
+}
+
+int
+execcache_find(const char name[], size_t path_len, char path[])
+{
+#ifndef _WIN32
+	int i;
+
+	if(strchr(name, '/') != NULL || acquire(0) != 0)
+	{
+		return -1;
+	}
+
+	refresh();
+
+	for(i = 0; i < ndirs; ++i)
+	{
+		char full_path[PATH_MAX];
+
+		if(bsearch(&name, dirs[i].names, dirs[i].count, sizeof(dirs[i].names[0]),
+					&compare_names) == NULL)
+		{
+			continue;
+		}
+
+		snprintf(full_path, sizeof(full_path), "%s/%s", dirs[i].path, name);
+		if(executable_exists(full_path))
+		{
+			if(path != NULL)
+			{
+				copy_str(path, path_len, full_path);
+			}
+			pthread_mutex_unlock(&lock);
+			return 0;
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+	return 1;
+#else
+	return -1;
+#endif
+}
+
+int
+execcache_list(execcache_visitor visitor, void *arg)
+{
+#ifndef _WIN32
+	int i;
+
+	if(acquire(1) != 0)
+	{
+		return 1;
+	}
+
+	refresh();
+
+	for(i = 0; i < ndirs; ++i)
+	{
+		visitor(dirs[i].path, dirs[i].names, dirs[i].count, arg);
+	}
+
+	pthread_mutex_unlock(&lock);
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+void
+execcache_reset(void)
+{
+#ifndef _WIN32
+	pthread_mutex_lock(&lock);
+	while(loading)
+	{
+		pthread_cond_wait(&loaded, &lock);
+	}
+
+	free_dirs(dirs, ndirs);
+	dirs = NULL;
+	ndirs = 0;
+	initialized = 0;
+
+	pthread_mutex_unlock(&lock);
+#endif
+}
+
+#ifndef _WIN32
+
+/* Locks the index if it's available optionally waiting for it to be built.
+ * Returns zero on success (the lock is held) and non-zero otherwise. */
+static int
+acquire(int wait)
+{
+	pthread_mutex_lock(&lock);
+
+	while(initialized && loading && wait)
+	{
+		pthread_cond_wait(&loaded, &lock);
+	}
+
+	if(!initialized || loading)
+	{
+		pthread_mutex_unlock(&lock);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Starts reading directories that weren't read yet in background.  Must be
+ * called with the lock held.  On failure directories are read on first use. */
+static void
+start_loading(void)
+{
+	pthread_attr_t attr;
+	pthread_t id;
+	int i;
+
+	for(i = 0; i < ndirs; ++i)
+	{
+		if(!dirs[i].read)
+		{
+			break;
+		}
+	}
+	if(i == ndirs || pthread_attr_init(&attr) != 0)
+	{
+		return;
+	}
+
+	loading = 1;
+	if(pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0 ||
+			pthread_create(&id, &attr, &load_thread, NULL) != 0)
+	{
+		loading = 0;
+	}
+
+	(void)pthread_attr_destroy(&attr);
+}
+
+/* Entry point of a thread that reads directories.  Returns NULL. */
+static void *
+load_thread(void *arg)
+{
+	int i;
+
+	block_all_thread_signals();
+
+	/* No one else touches the list while loading flag is set, so the lock isn't
+	 * needed until it's reset. */
+	for(i = 0; i < ndirs; ++i)
+	{
+		if(!dirs[i].read)
+		{
+			read_dir(&dirs[i]);
+		}
+	}
+
+	pthread_mutex_lock(&lock);
+	loading = 0;
+	pthread_cond_broadcast(&loaded);
+	pthread_mutex_unlock(&lock);
+
+	return NULL;
+}
+
+/* Rereads directories that have changed.  Must be called with the lock
+ * held. */
+static void
+refresh(void)
+{
+	const time_t now = time(NULL);
+	const int check_all = (now >= next_check);
+	int i;
+
+	for(i = 0; i < ndirs; ++i)
+	{
+		dir_t *const dir = &dirs[i];
+
+		/* Relative paths can point to a different directory on every query. */
+		const int check = check_all || dir->racy || !is_path_absolute(dir->path);
+
+		if(!dir->read || (check && dir_changed(dir)))
+		{
+			read_dir(dir);
+		}
+	}
+
+	if(check_all)
+	{
+		next_check = now + CHECK_PERIOD;
+	}
+}
+
+/* Checks whether directory might have changed since it was read.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+dir_changed(const dir_t *dir)
+{
+	filemon_t mon;
+
+	if(dir->racy)
+	{
+		return 1;
+	}
+
+	if(filemon_from_file(dir->path, &mon) != 0)
+	{
+		return !dir->missing;
+	}
+	return dir->missing || !filemon_equal(&mon, &dir->mon);
+}
+
+/* Reads names of files of the directory replacing previous list. */
+static void
+read_dir(dir_t *dir)
+{
+	struct stat s;
+	DIR *d;
+	struct dirent *entry;
+	int capacity = 0;
+
+	free_string_array(dir->names, dir->count);
+	dir->names = NULL;
+	dir->count = 0;
+	dir->read = 1;
+	dir->racy = 0;
+
+	/* Timestamp is obtained first to not miss changes made while reading. */
+	dir->missing = (filemon_from_file(dir->path, &dir->mon) != 0 ||
+			os_stat(dir->path, &s) != 0);
+	if(dir->missing)
+	{
+		return;
+	}
+
+	/* Changes made within the same second might not affect the timestamp. */
+	dir->racy = (s.st_mtime + 1 >= time(NULL));
+
+	d = os_opendir(dir->path);
+	if(d == NULL)
+	{
+		return;
+	}
+
+	while((entry = os_readdir(d)) != NULL)
+	{
+		if(is_builtin_dir(entry->d_name))
+		{
+			continue;
+		}
+
+		if(dir->count == capacity)
+		{
+			const int new_capacity = (capacity == 0) ? 64 : capacity*2;
+			char **const p = reallocarray(dir->names, new_capacity, sizeof(*p));
+			if(p == NULL)
+			{
+				break;
+			}
+			dir->names = p;
+			capacity = new_capacity;
+		}
+
+		dir->names[dir->count] = strdup(entry->d_name);
+		if(dir->names[dir->count] == NULL)
+		{
+			break;
+		}
+		++dir->count;
+	}
+	os_closedir(d);
+
+	if(entry != NULL)
+	{
+		/* Try again on next query instead of keeping partial list. */
+		dir->read = 0;
+	}
+
+	qsort(dir->names, dir->count, sizeof(dir->names[0]), &compare_names);
+}
+
+/* qsort() and bsearch() comparer for names.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_names(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Frees list of directories. */
+static void
+free_dirs(dir_t dirs[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(dirs[i].path);
+		free_string_array(dirs[i].names, dirs[i].count);
+	}
+	free(dirs);
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
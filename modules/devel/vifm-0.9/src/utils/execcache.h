@@ -0,0 +1,58 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__EXECCACHE_H__
+#define VIFM__UTILS__EXECCACHE_H__
+
+#include <stddef.h> /* size_t */
+
+/* Index of files in a list of directories (like those of $PATH) for looking up
+ * and completing names of executables (*nix only).  Directories are read in a
+ * background thread and are reread after their modification time changes.
+ * Timestamps are checked at most once per couple of seconds except for
+ * directories that were modified just before they were read.  Whether file is
+ * executable is checked on every query, so changes of permissions aren't
+ * missed. */
+
+/* Type of callback for execcache_list().  Names are sorted. */
+typedef void (*execcache_visitor)(const char dir[], char *names[], int count,
+		void *arg);
+
+/* Replaces list of directories to index.  Contents of directories that remain
+ * in the list is reused, the rest is read in background. */
+void execcache_set_dirs(char *dirs[], int count);
+
+/* Looks up executable in the directories in their order.  Full path to the
+ * executable is put into the buffer if it's not NULL.  Doesn't wait for index
+ * to be built.  Returns zero if executable was found, positive number if there
+ * is no such executable and negative number if index can't answer the query
+ * at the moment. */
+int execcache_find(const char name[], size_t path_len, char path[]);
+
+/* Calls the visitor for every directory in their order waiting for index to be
+ * built if needed.  Returns zero on success and non-zero if index isn't
+ * available. */
+int execcache_list(execcache_visitor visitor, void *arg);
+
+/* Forgets all directories making the index unavailable. */
+void execcache_reset(void);
+
+#endif /* VIFM__UTILS__EXECCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
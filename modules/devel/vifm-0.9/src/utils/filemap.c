@@ -0,0 +1,1190 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "filemap.h"
+
+#ifndef _WIN32
+#include <sys/mman.h> /* MAP_FAILED mmap() munmap() */
+#include <sys/stat.h> /* fstat() stat */
+#include <sys/types.h> /* dev_t ino_t */
+#include <fcntl.h> /* O_RDONLY open() */
+#include <unistd.h> /* close() */
+#endif
+
+#include <ctype.h> /* tolower() toupper() */
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE SEEK_END SEEK_SET fclose() fread() fseek() ftell() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memchr() memcmp() memcpy() strlen() */
+
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "cancellation.h"
+#include "utils.h"
+
+/* Parameters of line index. */
+enum
+{
+	LINES_PER_MARK = 1024,        /* Every N-th line start is remembered. */
+	MARKS_PER_CHUNK = 4096,       /* Number of marks in a single index chunk. */
+	SCAN_PIECE = 1024*1024,       /* Number of bytes indexed at once. */
+	MAX_PIECE_MARKS = SCAN_PIECE/LINES_PER_MARK + 1, /* Marks per piece. */
+};
+
+/* Character that replaces null characters in copies of lines. */
+#define NUL_REPLACEMENT '?'
+
+/* Mapped file and its line index. */
+struct filemap_t
+{
+	void *mem;        /* Beginning of mapped memory. */
+	size_t mem_size;  /* Size of mapped memory. */
+	const char *data; /* Beginning of file data (after BOM). */
+	size_t size;      /* Size of file data. */
+	size_t limit;     /* Size of data that is safe to access (see
+	                     filemap_refresh()). */
+#ifndef _WIN32
+	int fd;           /* Descriptor of the file to check its current size. */
+	dev_t dev;        /* Device of the file. */
+	ino_t inode;      /* Inode of the file. */
+#endif
+
+	/* Index data, all of it is protected by the lock. */
+	pthread_mutex_t lock; /* Protects the index against concurrent access. */
+	size_t **chunks;      /* Chunks of marks (offsets of every N-th line). */
+	int nmarks;           /* Total number of marks in all chunks. */
+	int nlines;           /* Number of line separators found so far. */
+	size_t last_start;    /* Beginning of the last line found so far. */
+	size_t scan_pos;      /* Position at which indexing stopped. */
+	int indexed;          /* Whether index covers the whole file. */
+	int stop;             /* Whether indexing thread should stop. */
+
+	pthread_t thread;     /* Indexing thread. */
+	int has_thread;       /* Whether indexing thread was started. */
+};
+
+static int map_file(filemap_t *fm, const char path[]);
+static void unmap_file(filemap_t *fm);
+static int remap_file(filemap_t *fm, const char path[]);
+static size_t query_limit(const filemap_t *fm);
+static size_t next_line(const filemap_t *fm, size_t size, size_t off);
+static size_t line_start(const filemap_t *fm, size_t from, size_t size,
+		size_t off);
+static char * get_line(const filemap_t *fm, size_t size, size_t off,
+		size_t max_len);
+static void stop_index_thread(filemap_t *fm);
+static void * index_thread(void *arg);
+static int index_piece(filemap_t *fm);
+static int add_marks(filemap_t *fm, const size_t marks[], int count);
+static size_t * get_mark(const filemap_t *fm, int n);
+static int find_mark(const filemap_t *fm, size_t off);
+static void join_index_thread(filemap_t *fm);
+static size_t skip_lines(const filemap_t *fm, size_t size, size_t off,
+		int count);
+static void report_progress(const filemap_search_t *search, size_t processed);
+static size_t find_candidate(const filemap_t *fm, size_t size, size_t from,
+		size_t to, const filemap_search_t *search);
+static size_t find_literal(const filemap_t *fm, size_t size, size_t from,
+		size_t to, const filemap_search_t *search);
+static size_t find_special(const filemap_t *fm, size_t from, size_t to,
+		const filemap_search_t *search);
+static size_t rfind_candidate(const filemap_t *fm, size_t size, size_t from,
+		size_t to, const filemap_search_t *search);
+static size_t rfind_literal(const filemap_t *fm, size_t size, size_t from,
+		size_t to, const filemap_search_t *search);
+static size_t rfind_special(const filemap_t *fm, size_t from, size_t to,
+		const filemap_search_t *search);
+static size_t find_byte(const filemap_t *fm, size_t from, size_t to, char c);
+static size_t rfind_byte(const filemap_t *fm, size_t from, size_t to, char c);
+static int literal_at(const filemap_t *fm, size_t size, size_t pos,
+		const filemap_search_t *search);
+static int line_matches(const filemap_t *fm, size_t size, size_t off,
+		const filemap_search_t *search);
+
+filemap_t *
+filemap_open(const char path[])
+{
+	filemap_t *const fm = malloc(sizeof(*fm));
+	if(fm == NULL)
+	{
+		return NULL;
+	}
+
+	if(map_file(fm, path) != 0)
+	{
+		free(fm);
+		return NULL;
+	}
+
+	fm->data = (fm->mem == NULL) ? "" : fm->mem;
+	fm->size = fm->mem_size;
+	if(fm->size >= 3U && memcmp(fm->data, "\xef\xbb\xbf", 3U) == 0)
+	{
+		fm->data += 3;
+		fm->size -= 3U;
+	}
+	fm->limit = fm->size;
+
+	fm->chunks = NULL;
+	fm->nmarks = 0;
+	fm->nlines = 0;
+	fm->last_start = 0U;
+	fm->scan_pos = 0U;
+	fm->indexed = 0;
+	fm->stop = 0;
+	fm->has_thread = 0;
+
+	if(pthread_mutex_init(&fm->lock, NULL) != 0)
+	{
+		unmap_file(fm);
+		free(fm);
+		return NULL;
+	}
+
+	/* First line always starts at the beginning of the file. */
+	if(add_marks(fm, &fm->last_start, 1) != 0)
+	{
+		filemap_close(fm);
+		return NULL;
+	}
+
+	return fm;
+}
+
+/* Fills memory-related fields of the fm by mapping or reading the file.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+map_file(filemap_t *fm, const char path[])
+{
+#ifndef _WIN32
+	struct stat st;
+	const int fd = open(path, O_RDONLY);
+	if(fd == -1)
+	{
+		return 1;
+	}
+
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		close(fd);
+		return 1;
+	}
+
+	fm->fd = fd;
+	fm->dev = st.st_dev;
+	fm->inode = st.st_ino;
+	fm->mem_size = st.st_size;
+	fm->mem = NULL;
+	if(fm->mem_size != 0U)
+	{
+		fm->mem = mmap(NULL, fm->mem_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(fm->mem == MAP_FAILED)
+		{
+			close(fd);
+			return 1;
+		}
+	}
+
+	/* Descriptor is kept open to be able to detect truncation of the file. */
+	return 0;
+#else
+	/* No memory mapping, fallback to reading the whole file. */
+	FILE *const fp = os_fopen(path, "rb");
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	fm->mem = NULL;
+	fm->mem_size = 0U;
+	while(1)
+	{
+		enum { PIECE_LEN = 64*1024 };
+		size_t read;
+		char *const mem = realloc(fm->mem, fm->mem_size + PIECE_LEN);
+		if(mem == NULL)
+		{
+			free(fm->mem);
+			fclose(fp);
+			return 1;
+		}
+
+		fm->mem = mem;
+		read = fread(mem + fm->mem_size, 1U, PIECE_LEN, fp);
+		fm->mem_size += read;
+		if(read != PIECE_LEN)
+		{
+			break;
+		}
+	}
+
+	fclose(fp);
+	return 0;
+#endif
+}
+
+/* Releases memory occupied by file data and closes the file. */
+static void
+unmap_file(filemap_t *fm)
+{
+#ifndef _WIN32
+	if(fm->mem != NULL)
+	{
+		(void)munmap(fm->mem, fm->mem_size);
+	}
+	close(fm->fd);
+#else
+	free(fm->mem);
+#endif
+	fm->mem = NULL;
+}
+
+int
+filemap_follow(filemap_t *fm, const char path[])
+{
+	const size_t bom_len = fm->mem_size - fm->size;
+	int result;
+
+	/* BOM might have been incomplete, easier to start over. */
+	if(fm->mem_size < 3U)
+	{
+		return -1;
+	}
+
+	/* Data pointer can change, so indexing shouldn't be in progress. */
+	stop_index_thread(fm);
+
+	result = remap_file(fm, path);
+	if(result > 0)
+	{
+		fm->data = (const char *)fm->mem + bom_len;
+		fm->size = fm->mem_size - bom_len;
+		fm->limit = fm->size;
+
+		pthread_mutex_lock(&fm->lock);
+		fm->indexed = 0;
+		pthread_mutex_unlock(&fm->lock);
+	}
+	return result;
+}
+
+int
+filemap_truncated(const filemap_t *fm)
+{
+	return query_limit(fm) < fm->size;
+}
+
+void
+filemap_refresh(filemap_t *fm)
+{
+	fm->limit = query_limit(fm);
+}
+
+/* Updates memory-related fields of the fm to account for data appended to the
+ * file.  Returns zero if size of the file is the same, positive number if
+ * data was appended and negative number otherwise. */
+static int
+remap_file(filemap_t *fm, const char path[])
+{
+#ifndef _WIN32
+	struct stat st;
+	void *mem;
+
+	if(os_stat(path, &st) != 0 || !S_ISREG(st.st_mode) || st.st_dev != fm->dev ||
+			st.st_ino != fm->inode || fstat(fm->fd, &st) != 0 ||
+			(size_t)st.st_size < fm->mem_size)
+	{
+		return -1;
+	}
+
+	if((size_t)st.st_size == fm->mem_size)
+	{
+		return 0;
+	}
+
+	/* Mapping the whole file again doesn't read its contents, only appended
+	 * part will be touched by indexing. */
+	mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fm->fd, 0);
+	if(mem == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	(void)munmap(fm->mem, fm->mem_size);
+	fm->mem = mem;
+	fm->mem_size = st.st_size;
+	return 1;
+#else
+	size_t size;
+	char *mem;
+	FILE *const fp = os_fopen(path, "rb");
+	if(fp == NULL)
+	{
+		return -1;
+	}
+
+	if(fseek(fp, 0, SEEK_END) != 0)
+	{
+		fclose(fp);
+		return -1;
+	}
+
+	size = ftell(fp);
+	if(size <= fm->mem_size)
+	{
+		fclose(fp);
+		return (size == fm->mem_size) ? 0 : -1;
+	}
+
+	/* Read only the part that was appended. */
+	mem = realloc(fm->mem, size);
+	if(mem == NULL)
+	{
+		fclose(fp);
+		return -1;
+	}
+
+	fm->mem = mem;
+	if(fseek(fp, fm->mem_size, SEEK_SET) != 0)
+	{
+		fclose(fp);
+		return -1;
+	}
+
+	fm->mem_size += fread(mem + fm->mem_size, 1U, size - fm->mem_size, fp);
+	fclose(fp);
+	return 1;
+#endif
+}
+
+void
+filemap_close(filemap_t *fm)
+{
+	int i;
+
+	if(fm == NULL)
+	{
+		return;
+	}
+
+	stop_index_thread(fm);
+
+	for(i = 0; i < fm->nmarks; i += MARKS_PER_CHUNK)
+	{
+		free(fm->chunks[i/MARKS_PER_CHUNK]);
+	}
+	free(fm->chunks);
+
+	pthread_mutex_destroy(&fm->lock);
+	unmap_file(fm);
+	free(fm);
+}
+
+int
+filemap_index_async(filemap_t *fm)
+{
+	if(fm->has_thread || filemap_indexed(fm))
+	{
+		return 0;
+	}
+
+	if(pthread_create(&fm->thread, NULL, &index_thread, fm) != 0)
+	{
+		return 1;
+	}
+
+	fm->has_thread = 1;
+	return 0;
+}
+
+/* Entry point of indexing thread.  Returns NULL. */
+static void *
+index_thread(void *arg)
+{
+	filemap_t *const fm = arg;
+
+	block_all_thread_signals();
+
+	while(1)
+	{
+		int stop;
+
+		pthread_mutex_lock(&fm->lock);
+		stop = fm->stop || fm->indexed;
+		pthread_mutex_unlock(&fm->lock);
+
+		if(stop || index_piece(fm) != 0)
+		{
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+void
+filemap_index(filemap_t *fm)
+{
+	join_index_thread(fm);
+
+	while(!filemap_indexed(fm))
+	{
+		if(index_piece(fm) != 0)
+		{
+			break;
+		}
+	}
+}
+
+/* Stops indexing thread if it's running.  Index remains valid and can be
+ * extended later. */
+static void
+stop_index_thread(filemap_t *fm)
+{
+	pthread_mutex_lock(&fm->lock);
+	fm->stop = 1;
+	pthread_mutex_unlock(&fm->lock);
+
+	join_index_thread(fm);
+	fm->stop = 0;
+}
+
+/* Waits for indexing thread to finish if it was started. */
+static void
+join_index_thread(filemap_t *fm)
+{
+	if(fm->has_thread)
+	{
+		(void)pthread_join(fm->thread, NULL);
+		fm->has_thread = 0;
+	}
+}
+
+/* Extends the index by processing next piece of the file.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+index_piece(filemap_t *fm)
+{
+	size_t marks[MAX_PIECE_MARKS];
+	int nmarks = 0;
+	size_t pos, last_start, end;
+	int nlines;
+	const char *nl;
+	int error;
+	const size_t size = query_limit(fm);
+
+	pthread_mutex_lock(&fm->lock);
+	pos = fm->scan_pos;
+	nlines = fm->nlines;
+	last_start = fm->last_start;
+	pthread_mutex_unlock(&fm->lock);
+
+	if(pos > size)
+	{
+		pos = size;
+	}
+
+	end = (size - pos > SCAN_PIECE) ? pos + SCAN_PIECE : size;
+	while((nl = memchr(fm->data + pos, '\n', end - pos)) != NULL)
+	{
+		pos = (nl - fm->data) + 1;
+		last_start = pos;
+		if(++nlines%LINES_PER_MARK == 0)
+		{
+			marks[nmarks++] = pos;
+		}
+	}
+
+	pthread_mutex_lock(&fm->lock);
+	error = add_marks(fm, marks, nmarks);
+	if(!error)
+	{
+		fm->nlines = nlines;
+		fm->last_start = last_start;
+		fm->scan_pos = end;
+		/* Index of truncated file is complete once it reaches new end. */
+		fm->indexed = (end == size);
+	}
+	pthread_mutex_unlock(&fm->lock);
+
+	return error;
+}
+
+/* Appends marks to the index.  Must be called with the lock held.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+add_marks(filemap_t *fm, const size_t marks[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(fm->nmarks%MARKS_PER_CHUNK == 0)
+		{
+			const int nchunks = fm->nmarks/MARKS_PER_CHUNK;
+			size_t **const chunks = reallocarray(fm->chunks, nchunks + 1,
+					sizeof(*chunks));
+			if(chunks == NULL)
+			{
+				return 1;
+			}
+			fm->chunks = chunks;
+
+			chunks[nchunks] = reallocarray(NULL, MARKS_PER_CHUNK,
+					sizeof(**chunks));
+			if(chunks[nchunks] == NULL)
+			{
+				return 1;
+			}
+		}
+
+		*get_mark(fm, fm->nmarks++) = marks[i];
+	}
+	return 0;
+}
+
+/* Retrieves pointer to the mark by its number.  Must be called with the lock
+ * held.  Returns the pointer. */
+static size_t *
+get_mark(const filemap_t *fm, int n)
+{
+	return &fm->chunks[n/MARKS_PER_CHUNK][n%MARKS_PER_CHUNK];
+}
+
+/* Finds the last mark that doesn't exceed the offset.  Must be called with the
+ * lock held.  Returns number of the mark. */
+static int
+find_mark(const filemap_t *fm, size_t off)
+{
+	int lo = 0;
+	int hi = fm->nmarks - 1;
+	while(lo < hi)
+	{
+		const int mid = lo + (hi - lo + 1)/2;
+		if(*get_mark(fm, mid) <= off)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+	return lo;
+}
+
+int
+filemap_indexed(filemap_t *fm)
+{
+	int indexed;
+	pthread_mutex_lock(&fm->lock);
+	indexed = fm->indexed;
+	pthread_mutex_unlock(&fm->lock);
+	return indexed;
+}
+
+int
+filemap_line_count(filemap_t *fm)
+{
+	int count;
+	pthread_mutex_lock(&fm->lock);
+	count = fm->nlines;
+	/* Last line might lack trailing line separator. */
+	if(fm->indexed && fm->last_start != fm->scan_pos)
+	{
+		++count;
+	}
+	pthread_mutex_unlock(&fm->lock);
+	return count;
+}
+
+size_t
+filemap_size(const filemap_t *fm)
+{
+	return fm->limit;
+}
+
+/* Computes size of data that can be accessed safely.  Touching pages of
+ * mapping past the end of the file raises SIGBUS, so size of the file is
+ * checked to account for truncation that happened after it was mapped.  The
+ * file can still be truncated right after the check, but that's a much smaller
+ * window.  Failure to check the size isn't treated as truncation.  Returns the
+ * size, which is at most fm->size. */
+static size_t
+query_limit(const filemap_t *fm)
+{
+#ifndef _WIN32
+	struct stat st;
+	const size_t bom_len = fm->mem_size - fm->size;
+
+	if(fstat(fm->fd, &st) != 0)
+	{
+		return fm->size;
+	}
+	if((size_t)st.st_size >= fm->mem_size)
+	{
+		return fm->size;
+	}
+	return ((size_t)st.st_size > bom_len) ? st.st_size - bom_len : 0U;
+#else
+	return fm->size;
+#endif
+}
+
+size_t
+filemap_next_line(const filemap_t *fm, size_t off)
+{
+	return next_line(fm, fm->limit, off);
+}
+
+/* Implementation of filemap_next_line() that accesses only first size bytes of
+ * data. */
+static size_t
+next_line(const filemap_t *fm, size_t size, size_t off)
+{
+	const char *nl;
+
+	if(off >= size)
+	{
+		return size;
+	}
+
+	nl = memchr(fm->data + off, '\n', size - off);
+	return (nl == NULL) ? size : (size_t)(nl - fm->data) + 1U;
+}
+
+size_t
+filemap_prev_line(filemap_t *fm, size_t off)
+{
+	return (off == 0U) ? 0U : filemap_line_start(fm, off - 1U);
+}
+
+size_t
+filemap_line_start(filemap_t *fm, size_t off)
+{
+	size_t from;
+
+	if(off > fm->limit)
+	{
+		off = fm->limit;
+	}
+
+	/* Line can't start before the closest indexed line start. */
+	pthread_mutex_lock(&fm->lock);
+	from = *get_mark(fm, find_mark(fm, off));
+	pthread_mutex_unlock(&fm->lock);
+
+	return line_start(fm, from, fm->limit, off);
+}
+
+/* Implementation of filemap_line_start() that accesses only first size bytes
+ * of data and doesn't look before the from offset, which must be a beginning
+ * of a line. */
+static size_t
+line_start(const filemap_t *fm, size_t from, size_t size, size_t off)
+{
+	size_t nl;
+
+	if(off > size)
+	{
+		off = size;
+	}
+	if(from > off)
+	{
+		from = 0U;
+	}
+
+	nl = rfind_byte(fm, from, off, '\n');
+	return (nl == off) ? from : nl + 1U;
+}
+
+int
+filemap_at_end(const filemap_t *fm, size_t off)
+{
+	return off >= fm->limit;
+}
+
+char *
+filemap_get_line(const filemap_t *fm, size_t off, size_t max_len)
+{
+	return get_line(fm, fm->limit, off, max_len);
+}
+
+/* Implementation of filemap_get_line() that accesses only first size bytes of
+ * data. */
+static char *
+get_line(const filemap_t *fm, size_t size, size_t off, size_t max_len)
+{
+	const char *begin, *nl;
+	size_t len;
+	char *line;
+	size_t i;
+
+	if(off > size)
+	{
+		off = size;
+	}
+
+	begin = fm->data + off;
+	len = size - off;
+	nl = memchr(begin, '\n', len);
+	if(nl != NULL)
+	{
+		len = nl - begin;
+		if(len != 0U && begin[len - 1U] == '\r')
+		{
+			--len;
+		}
+	}
+	if(len > max_len)
+	{
+		len = max_len;
+	}
+
+	line = malloc(len + 1U);
+	if(line == NULL)
+	{
+		return NULL;
+	}
+
+	memcpy(line, begin, len);
+	line[len] = '\0';
+
+	for(i = 0U; i < len; ++i)
+	{
+		if(line[i] == '\0')
+		{
+			line[i] = NUL_REPLACEMENT;
+		}
+	}
+
+	return line;
+}
+
+int
+filemap_line_num(filemap_t *fm, size_t off)
+{
+	int mark;
+	size_t pos, size;
+	int line;
+
+	pthread_mutex_lock(&fm->lock);
+	if(off > fm->scan_pos)
+	{
+		pthread_mutex_unlock(&fm->lock);
+		return -1;
+	}
+
+	mark = find_mark(fm, off);
+	pos = *get_mark(fm, mark);
+	pthread_mutex_unlock(&fm->lock);
+
+	size = fm->limit;
+	if(off > size)
+	{
+		off = size;
+	}
+
+	line = mark*LINES_PER_MARK;
+	while(pos < off)
+	{
+		const char *const nl = memchr(fm->data + pos, '\n', off - pos);
+		if(nl == NULL)
+		{
+			break;
+		}
+		pos = (nl - fm->data) + 1;
+		++line;
+	}
+	return line;
+}
+
+size_t
+filemap_line_offset(filemap_t *fm, int line)
+{
+	int mark;
+	size_t pos;
+
+	if(line <= 0)
+	{
+		return 0U;
+	}
+
+	pthread_mutex_lock(&fm->lock);
+	mark = line/LINES_PER_MARK;
+	if(mark >= fm->nmarks)
+	{
+		mark = fm->nmarks - 1;
+	}
+	pos = *get_mark(fm, mark);
+	pthread_mutex_unlock(&fm->lock);
+
+	return skip_lines(fm, fm->limit, pos, line - mark*LINES_PER_MARK);
+}
+
+/* Skips specified number of lines starting at the off accessing only first
+ * size bytes of data.  Returns offset of the resulting line. */
+static size_t
+skip_lines(const filemap_t *fm, size_t size, size_t off, int count)
+{
+	while(count-- > 0 && off < size)
+	{
+		off = next_line(fm, size, off);
+	}
+	return off;
+}
+
+size_t
+filemap_find(const filemap_t *fm, size_t off, int backward,
+		filemap_search_t *search)
+{
+	size_t pos;
+	/* Size is checked once per piece, because file might get truncated. */
+	size_t size = query_limit(fm);
+
+	if(backward)
+	{
+		pos = line_start(fm, 0U, size, off);
+		while(pos != 0U && !cancellation_requested(&search->cancel))
+		{
+			const size_t from = (pos > SCAN_PIECE) ? pos - SCAN_PIECE : 0U;
+			size_t cand;
+
+			size = query_limit(fm);
+			if(pos > size)
+			{
+				break;
+			}
+
+			cand = rfind_candidate(fm, size, from, pos, search);
+			if(cand == pos)
+			{
+				pos = from;
+			}
+			else
+			{
+				pos = line_start(fm, 0U, size, cand);
+				if(line_matches(fm, size, pos, search))
+				{
+					return pos;
+				}
+			}
+			report_progress(search, off - pos);
+		}
+		return size;
+	}
+
+	pos = next_line(fm, size, off);
+	while(pos < size && !cancellation_requested(&search->cancel))
+	{
+		const size_t to = (size - pos > SCAN_PIECE) ? pos + SCAN_PIECE : size;
+		const size_t cand = find_candidate(fm, size, pos, to, search);
+		if(cand == to)
+		{
+			pos = to;
+		}
+		else
+		{
+			const size_t line = line_start(fm, 0U, size, cand);
+			if(line_matches(fm, size, line, search))
+			{
+				return line;
+			}
+			pos = next_line(fm, size, line);
+		}
+		report_progress(search, pos - off);
+		size = query_limit(fm);
+	}
+	return size;
+}
+
+/* Passes number of processed bytes to progress callback if it's set. */
+static void
+report_progress(const filemap_search_t *search, size_t processed)
+{
+	if(search->progress != NULL)
+	{
+		search->progress(processed, search->progress_arg);
+	}
+}
+
+/* Looks for the first byte in [from; to) range that makes a line pass the
+ * prefilter, which is either a special byte or beginning of the literal.
+ * Returns position of the byte or to if there is none. */
+static size_t
+find_candidate(const filemap_t *fm, size_t size, size_t from, size_t to,
+		const filemap_search_t *search)
+{
+	size_t lit;
+
+	if(search->literal == NULL || search->literal[0] == '\0')
+	{
+		return from;
+	}
+
+	lit = find_literal(fm, size, from, to, search);
+	/* Special bytes are looked up only before the literal to keep search
+	 * linear. */
+	return find_special(fm, from, lit, search);
+}
+
+/* Finds the first occurrence of the literal that starts in [from; to) range.
+ * Returns its position or to if there is none. */
+static size_t
+find_literal(const filemap_t *fm, size_t size, size_t from, size_t to,
+		const filemap_search_t *search)
+{
+	const unsigned char first = search->literal[0];
+	const char lower = tolower(first), upper = toupper(first);
+	size_t next_lower, next_upper;
+
+	if(!search->icase)
+	{
+		next_lower = next_upper = find_byte(fm, from, to, first);
+	}
+	else
+	{
+		next_lower = find_byte(fm, from, to, lower);
+		next_upper = (lower == upper) ? next_lower
+		                              : find_byte(fm, from, to, upper);
+	}
+
+	/* Positions of next occurrences of both variants of the first byte are
+	 * tracked separately so that each byte is scanned once. */
+	while(1)
+	{
+		const size_t pos = (next_lower < next_upper) ? next_lower : next_upper;
+		if(pos == to || literal_at(fm, size, pos, search))
+		{
+			return pos;
+		}
+
+		if(next_lower == pos)
+		{
+			next_lower = find_byte(fm, pos + 1U, to, search->icase ? lower : first);
+		}
+		if(next_upper == pos)
+		{
+			next_upper = (!search->icase || lower == upper)
+			           ? next_lower
+			           : find_byte(fm, pos + 1U, to, upper);
+		}
+	}
+}
+
+/* Finds the first special byte in [from; to) range.  Null character is always
+ * special.  Returns its position or to if there is none. */
+static size_t
+find_special(const filemap_t *fm, size_t from, size_t to,
+		const filemap_search_t *search)
+{
+	const char *special = (search->special == NULL) ? "" : search->special;
+
+	to = find_byte(fm, from, to, '\0');
+	while(*special != '\0')
+	{
+		to = find_byte(fm, from, to, *special++);
+	}
+	return to;
+}
+
+/* Looks for the last byte in [from; to) range that makes a line pass the
+ * prefilter.  Returns position of the byte or to if there is none. */
+static size_t
+rfind_candidate(const filemap_t *fm, size_t size, size_t from, size_t to,
+		const filemap_search_t *search)
+{
+	size_t lit, special;
+
+	if(search->literal == NULL || search->literal[0] == '\0')
+	{
+		return to - 1U;
+	}
+
+	lit = rfind_literal(fm, size, from, to, search);
+	special = rfind_special(fm, (lit == to) ? from : lit + 1U, to, search);
+	return (special == to) ? lit : special;
+}
+
+/* Finds the last occurrence of the literal that starts in [from; to) range.
+ * Returns its position or to if there is none. */
+static size_t
+rfind_literal(const filemap_t *fm, size_t size, size_t from, size_t to,
+		const filemap_search_t *search)
+{
+	const unsigned char first = search->literal[0];
+	const char lower = search->icase ? tolower(first) : first;
+	const char upper = search->icase ? toupper(first) : first;
+	size_t prev_lower = rfind_byte(fm, from, to, lower);
+	size_t prev_upper = (lower == upper) ? prev_lower
+	                                     : rfind_byte(fm, from, to, upper);
+
+	while(1)
+	{
+		size_t pos;
+
+		if(prev_lower == to || prev_upper == to)
+		{
+			pos = (prev_lower == to) ? prev_upper : prev_lower;
+		}
+		else
+		{
+			pos = (prev_lower > prev_upper) ? prev_lower : prev_upper;
+		}
+
+		if(pos == to || literal_at(fm, size, pos, search))
+		{
+			return pos;
+		}
+
+		/* rfind_byte() reports absence by returning its upper bound, which is pos
+		 * here, so map it to to. */
+		if(prev_lower == pos)
+		{
+			prev_lower = rfind_byte(fm, from, pos, lower);
+			prev_lower = (prev_lower == pos) ? to : prev_lower;
+		}
+		if(prev_upper == pos)
+		{
+			if(lower == upper)
+			{
+				prev_upper = prev_lower;
+			}
+			else
+			{
+				prev_upper = rfind_byte(fm, from, pos, upper);
+				prev_upper = (prev_upper == pos) ? to : prev_upper;
+			}
+		}
+	}
+}
+
+/* Finds the last special byte in [from; to) range.  Null character is always
+ * special.  Returns its position or to if there is none. */
+static size_t
+rfind_special(const filemap_t *fm, size_t from, size_t to,
+		const filemap_search_t *search)
+{
+	const char *special = (search->special == NULL) ? "" : search->special;
+	size_t last = rfind_byte(fm, from, to, '\0');
+
+	while(*special != '\0')
+	{
+		const size_t pos = rfind_byte(fm, (last == to) ? from : last + 1U, to,
+				*special++);
+		if(pos != to)
+		{
+			last = pos;
+		}
+	}
+	return last;
+}
+
+/* Finds the first occurrence of the byte in [from; to) range.  Returns its
+ * position or to if there is none. */
+static size_t
+find_byte(const filemap_t *fm, size_t from, size_t to, char c)
+{
+	const char *const p = memchr(fm->data + from, c, to - from);
+	return (p == NULL) ? to : (size_t)(p - fm->data);
+}
+
+/* Finds the last occurrence of the byte in [from; to) range.  Data is
+ * examined a word at a time until a word containing the byte is found.
+ * Returns its position or to if there is none. */
+static size_t
+rfind_byte(const filemap_t *fm, size_t from, size_t to, char c)
+{
+	const size_t ones = (size_t)-1/0xff;
+	const size_t highs = ones*0x80;
+	const size_t pattern = ones*(unsigned char)c;
+	size_t pos = to;
+
+	while(pos - from >= sizeof(size_t))
+	{
+		size_t word;
+		memcpy(&word, fm->data + pos - sizeof(word), sizeof(word));
+		word ^= pattern;
+		if(((word - ones) & ~word & highs) != 0U)
+		{
+			break;
+		}
+		pos -= sizeof(word);
+	}
+
+	for(; pos != from; --pos)
+	{
+		if(fm->data[pos - 1U] == c)
+		{
+			return pos - 1U;
+		}
+	}
+	return to;
+}
+
+/* Checks whether the literal starts at the pos.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+literal_at(const filemap_t *fm, size_t size, size_t pos,
+		const filemap_search_t *search)
+{
+	const size_t len = strlen(search->literal);
+	const char *const p = fm->data + pos;
+	size_t i;
+
+	if(size - pos < len)
+	{
+		return 0;
+	}
+
+	if(!search->icase)
+	{
+		return memcmp(p, search->literal, len) == 0;
+	}
+
+	for(i = 0U; i < len; ++i)
+	{
+		if(tolower((unsigned char)p[i]) !=
+				tolower((unsigned char)search->literal[i]))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Checks whether line that starts at the off is matched by the callback.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+line_matches(const filemap_t *fm, size_t size, size_t off,
+		const filemap_search_t *search)
+{
+	int matches;
+	char *const line = get_line(fm, size, off, search->max_len);
+	if(line == NULL)
+	{
+		return 0;
+	}
+
+	matches = search->match(line, search->arg);
+	free(line);
+	return matches;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
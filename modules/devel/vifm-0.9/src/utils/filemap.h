@@ -0,0 +1,155 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FILEMAP_H__
+#define VIFM__UTILS__FILEMAP_H__
+
+#include <stddef.h> /* size_t */
+
+#include "cancellation.h"
+
+/* Read-only view of a file that is mapped into memory (where supported) along
+ * with lazily built index of line beginnings.  The index is sparse (it stores
+ * offset of every N-th line in fixed-size chunks), so its size is bounded by
+ * number of lines divided by N.  Lines are separated by '\n', trailing '\r' is
+ * not considered to be part of a line.  Leading UTF-8 BOM is skipped.  If the
+ * file is truncated after being mapped, data past its new end is treated as
+ * absent once filemap_refresh() notices it, filemap_follow() reports
+ * truncation. */
+
+/* Opaque declaration of the file map type. */
+typedef struct filemap_t filemap_t;
+
+/* Type of callback that checks whether a line (as returned by
+ * filemap_get_line()) matches.  Should return non-zero if so, otherwise zero
+ * should be returned. */
+typedef int (*filemap_match_func)(const char line[], void *arg);
+
+/* Type of callback that receives number of bytes processed by a search so
+ * far. */
+typedef void (*filemap_progress_func)(size_t processed, void *arg);
+
+/* Description and state of a search among lines of a map. */
+typedef struct
+{
+	filemap_match_func match; /* Checks whether a line matches. */
+	void *arg;                /* Parameter for the match callback. */
+	size_t max_len;           /* Maximum length of lines given to the callback. */
+
+	/* Prefilter, lines that don't pass it aren't passed to the callback.  Lines
+	 * that contain null characters or any of special bytes always pass it. */
+	const char *literal; /* Substring of every matching line or NULL. */
+	int icase;           /* Whether literal is compared ignoring ASCII case. */
+	const char *special; /* Bytes that callback treats specially or NULL. */
+
+	cancellation_t cancel;          /* Allows cancelling the search. */
+	filemap_progress_func progress; /* Reports progress or NULL. */
+	void *progress_arg;             /* Parameter for the progress callback. */
+}
+filemap_search_t;
+
+/* Maps file at the path into memory.  The index is empty at this point.
+ * Returns the map or NULL on error. */
+filemap_t * filemap_open(const char path[]);
+
+/* Stops indexing (if it's in progress) and frees all resources of the map.
+ * The map can be NULL. */
+void filemap_close(filemap_t *fm);
+
+/* Picks up changes of the file at the path, which should be the one map was
+ * opened from.  Data appended to the file is mapped and the index is extended
+ * to cover it (indexing needs to be restarted via filemap_index_async() or
+ * filemap_index()).  Returns zero if size of the file didn't change, positive
+ * number if it grew and negative number if it got smaller, was replaced by
+ * another file, can't be updated in place or on error, in which case the map
+ * should be reopened. */
+int filemap_follow(filemap_t *fm, const char path[]);
+
+/* Checks whether the file was truncated after it was mapped.  Unlike
+ * filemap_follow(), doesn't depend on path of the file.  Returns non-zero if
+ * so, otherwise zero is returned. */
+int filemap_truncated(const filemap_t *fm);
+
+/* Checks current size of the file to limit accesses to data that is still
+ * there.  Size is remembered, so this should be called before a group of
+ * accesses (like a redraw) rather than before every one of them. */
+void filemap_refresh(filemap_t *fm);
+
+/* Starts building line index in a background thread.  Returns zero on success,
+ * otherwise non-zero is returned and the index can still be built
+ * synchronously by filemap_index(). */
+int filemap_index_async(filemap_t *fm);
+
+/* Builds the rest of line index in the current thread, waits for indexing
+ * thread if it's running. */
+void filemap_index(filemap_t *fm);
+
+/* Checks whether index is fully built.  Returns non-zero if so, otherwise zero
+ * is returned. */
+int filemap_indexed(filemap_t *fm);
+
+/* Retrieves number of lines that are indexed at the moment.  It's the total
+ * number of lines in the file if filemap_indexed() returns non-zero. */
+int filemap_line_count(filemap_t *fm);
+
+/* Retrieves size of the file data (excluding BOM) as of the last
+ * filemap_refresh().  Returns the size. */
+size_t filemap_size(const filemap_t *fm);
+
+/* Finds beginning of the line that follows the one that starts at the off.
+ * Returns the offset, which equals to filemap_size() for the last line. */
+size_t filemap_next_line(const filemap_t *fm, size_t off);
+
+/* Finds beginning of the line that precedes the one that starts at the off.
+ * Returns the offset, which is zero for the first line. */
+size_t filemap_prev_line(filemap_t *fm, size_t off);
+
+/* Finds beginning of the line which contains specified offset.  Returns the
+ * offset. */
+size_t filemap_line_start(filemap_t *fm, size_t off);
+
+/* Checks whether the off points past the last line.  Returns non-zero if so,
+ * otherwise zero is returned. */
+int filemap_at_end(const filemap_t *fm, size_t off);
+
+/* Makes a copy of at most max_len bytes of the line that starts at the off.
+ * Line separators are not copied, null characters are replaced.  Returns newly
+ * allocated string or NULL on error. */
+char * filemap_get_line(const filemap_t *fm, size_t off, size_t max_len);
+
+/* Finds line number of a line starting at the off.  Returns the number or -1
+ * if the off isn't covered by the index yet. */
+int filemap_line_num(filemap_t *fm, size_t off);
+
+/* Finds offset of beginning of a line by its number.  Scans the file from the
+ * nearest indexed line if the line isn't covered by the index yet.  Returns the
+ * offset, which is filemap_size() for lines past the end of file. */
+size_t filemap_line_offset(filemap_t *fm, int line);
+
+/* Searches for a matching line starting with the one that follows (or precedes
+ * if backward is non-zero) the line that starts at the off.  Doesn't use the
+ * index and can be called from a thread other than the one using the map.
+ * Returns offset of the line or filemap_size() if there is no match or search
+ * was cancelled. */
+size_t filemap_find(const filemap_t *fm, size_t off, int backward,
+		filemap_search_t *search);
+
+#endif /* VIFM__UTILS__FILEMAP_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,481 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "fslister.h"
+
+#include <sys/stat.h> /* S_ISDIR() S_ISLNK() fstatat() */
+#include <sys/time.h> /* gettimeofday() */
+#include <dirent.h> /* DIR dirent dirfd() */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW */
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+#include <time.h> /* timespec */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "fs.h"
+#include "macros.h"
+#include "path.h"
+#include "utils.h"
+
+/* How often waiting for a listing checks for cancellation, in
+ * microseconds. */
+#define CANCEL_POLL_PERIOD 100000
+
+/* How many files are read between checks whether lister is being stopped. */
+#define STOP_CHECK_PERIOD 256
+
+/* State of a request. */
+typedef enum
+{
+	RS_PENDING, /* Wasn't picked up by a worker yet. */
+	RS_RUNNING, /* Directory is being read. */
+	RS_DONE,    /* Listing is available. */
+}
+ReqState;
+
+/* Request to list a directory. */
+struct fslister_req_t
+{
+	char *path;     /* Path to the directory. */
+	ReqState state; /* Current state of the request. */
+	int abandoned;  /* Client won't take the result, worker should free it. */
+
+	fslister_entry_t *entries; /* Result of reading the directory. */
+	int count;                 /* Number of entries or -1 on error. */
+
+	fslister_req_t *prev; /* Previous request in the list it belongs to. */
+	fslister_req_t *next; /* Next request in the list it belongs to. */
+};
+
+/* Lister state. */
+struct fslister_t
+{
+	pthread_mutex_t lock;     /* Protects everything below. */
+	pthread_cond_t work_cond; /* Signaled on new requests and on stopping. */
+	pthread_cond_t done_cond; /* Signaled on completing a request. */
+
+	fslister_req_t *pending; /* Stack of requests to be picked up. */
+	fslister_req_t *started; /* List of running and completed requests. */
+	int stop;                /* Whether workers should quit. */
+
+	pthread_t *threads; /* Worker threads. */
+	int nthreads;       /* Number of worker threads. */
+
+	fslister_cancelled_func cancelled; /* Cancellation check or NULL. */
+};
+
+static void * worker(void *arg);
+static void process_request(fslister_t *lister, fslister_req_t *req);
+static fslister_entry_t * read_dir(fslister_t *lister, const char path[],
+		int *count);
+static void get_type(const char dir[], const struct dirent *d,
+		fslister_entry_t *entry);
+static int is_stopped(fslister_t *lister);
+static int wait_for(fslister_t *lister, fslister_req_t *req);
+static void push(fslister_req_t **list, fslister_req_t *req);
+static void unlink_req(fslister_req_t **list, fslister_req_t *req);
+static void free_req(fslister_req_t *req);
+
+fslister_t *
+fslister_create(int nthreads, fslister_cancelled_func cancelled)
+{
+	fslister_t *const lister = calloc(1U, sizeof(*lister));
+	if(lister == NULL)
+	{
+		return NULL;
+	}
+
+	lister->threads = reallocarray(NULL, MAX(nthreads, 1),
+			sizeof(*lister->threads));
+	if(lister->threads == NULL)
+	{
+		free(lister);
+		return NULL;
+	}
+
+	pthread_mutex_init(&lister->lock, NULL);
+	pthread_cond_init(&lister->work_cond, NULL);
+	pthread_cond_init(&lister->done_cond, NULL);
+	lister->cancelled = cancelled;
+
+	/* Not being able to start some (or all) of the threads is fine, requests are
+	 * processed by fslister_take() when nobody picks them up. */
+	while(lister->nthreads < nthreads &&
+			pthread_create(&lister->threads[lister->nthreads], NULL, &worker,
+				lister) == 0)
+	{
+		++lister->nthreads;
+	}
+
+	return lister;
+}
+
+void
+fslister_free(fslister_t *lister)
+{
+	int i;
+
+	if(lister == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&lister->lock);
+	lister->stop = 1;
+	pthread_cond_broadcast(&lister->work_cond);
+	pthread_mutex_unlock(&lister->lock);
+
+	for(i = 0; i < lister->nthreads; ++i)
+	{
+		pthread_join(lister->threads[i], NULL);
+	}
+
+	while(lister->pending != NULL)
+	{
+		fslister_req_t *const req = lister->pending;
+		unlink_req(&lister->pending, req);
+		free_req(req);
+	}
+	while(lister->started != NULL)
+	{
+		fslister_req_t *const req = lister->started;
+		unlink_req(&lister->started, req);
+		free_req(req);
+	}
+
+	pthread_cond_destroy(&lister->done_cond);
+	pthread_cond_destroy(&lister->work_cond);
+	pthread_mutex_destroy(&lister->lock);
+	free(lister->threads);
+	free(lister);
+}
+
+fslister_req_t *
+fslister_request(fslister_t *lister, const char path[])
+{
+	fslister_req_t *const req = calloc(1U, sizeof(*req));
+	if(req == NULL)
+	{
+		return NULL;
+	}
+
+	req->path = strdup(path);
+	if(req->path == NULL)
+	{
+		free(req);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&lister->lock);
+	push(&lister->pending, req);
+	pthread_cond_signal(&lister->work_cond);
+	pthread_mutex_unlock(&lister->lock);
+
+	return req;
+}
+
+fslister_entry_t *
+fslister_take(fslister_t *lister, fslister_req_t *req, int *count)
+{
+	fslister_entry_t *entries;
+
+	pthread_mutex_lock(&lister->lock);
+
+	if(req->state == RS_PENDING)
+	{
+		/* There is no point in waiting for a worker, do the job right here. */
+		unlink_req(&lister->pending, req);
+		pthread_mutex_unlock(&lister->lock);
+
+		entries = read_dir(lister, req->path, count);
+		free_req(req);
+		return entries;
+	}
+
+	if(wait_for(lister, req) != 0)
+	{
+		/* Leave the request to the worker, which is still busy with it. */
+		req->abandoned = 1;
+		pthread_mutex_unlock(&lister->lock);
+
+		*count = -1;
+		return NULL;
+	}
+
+	unlink_req(&lister->started, req);
+	pthread_mutex_unlock(&lister->lock);
+
+	entries = req->entries;
+	*count = req->count;
+	req->entries = NULL;
+	req->count = 0;
+	free_req(req);
+	return entries;
+}
+
+void
+fslister_free_entries(fslister_entry_t entries[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(entries[i].name);
+	}
+	free(entries);
+}
+
+/* Entry point of worker threads.  Returns NULL. */
+static void *
+worker(void *arg)
+{
+	fslister_t *const lister = arg;
+
+	block_all_thread_signals();
+
+	pthread_mutex_lock(&lister->lock);
+	while(1)
+	{
+		fslister_req_t *req;
+
+		while(!lister->stop && lister->pending == NULL)
+		{
+			pthread_cond_wait(&lister->work_cond, &lister->lock);
+		}
+		if(lister->stop)
+		{
+			break;
+		}
+
+		req = lister->pending;
+		unlink_req(&lister->pending, req);
+		push(&lister->started, req);
+		req->state = RS_RUNNING;
+
+		pthread_mutex_unlock(&lister->lock);
+		process_request(lister, req);
+		pthread_mutex_lock(&lister->lock);
+	}
+	pthread_mutex_unlock(&lister->lock);
+
+	return NULL;
+}
+
+/* Reads directory of the request and publishes the result. */
+static void
+process_request(fslister_t *lister, fslister_req_t *req)
+{
+	int count;
+	fslister_entry_t *const entries = read_dir(lister, req->path, &count);
+
+	pthread_mutex_lock(&lister->lock);
+	req->entries = entries;
+	req->count = count;
+	req->state = RS_DONE;
+	if(req->abandoned)
+	{
+		unlink_req(&lister->started, req);
+		free_req(req);
+	}
+	pthread_cond_broadcast(&lister->done_cond);
+	pthread_mutex_unlock(&lister->lock);
+}
+
+/* Lists files of the directory omitting "." and "..".  Returns array of
+ * entries and sets *count to its length or to -1 on error. */
+static fslister_entry_t *
+read_dir(fslister_t *lister, const char path[], int *count)
+{
+	struct dirent *d;
+	fslister_entry_t *entries = NULL;
+	int capacity = 0;
+	int n = 0;
+
+	DIR *const dir = os_opendir(path);
+	if(dir == NULL)
+	{
+		*count = -1;
+		return NULL;
+	}
+
+	while((d = os_readdir(dir)) != NULL)
+	{
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		if(n%STOP_CHECK_PERIOD == STOP_CHECK_PERIOD - 1 && is_stopped(lister))
+		{
+			break;
+		}
+
+		if(n == capacity)
+		{
+			const int new_capacity = (capacity == 0) ? 16 : capacity*2;
+			void *const p = reallocarray(entries, new_capacity, sizeof(*entries));
+			if(p == NULL)
+			{
+				break;
+			}
+			entries = p;
+			capacity = new_capacity;
+		}
+
+#ifndef _WIN32
+		/* Querying relative to the directory saves resolving its path for every
+		 * file. */
+		if(fstatat(dirfd(dir), d->d_name, &entries[n].info,
+					AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			/* The file is gone. */
+			continue;
+		}
+#endif
+
+		entries[n].name = strdup(d->d_name);
+		if(entries[n].name == NULL)
+		{
+			break;
+		}
+		get_type(path, d, &entries[n]);
+		++n;
+	}
+	os_closedir(dir);
+
+	if(d != NULL)
+	{
+		/* Loop was interrupted. */
+		fslister_free_entries(entries, n);
+		*count = -1;
+		return NULL;
+	}
+
+	*count = n;
+	return entries;
+}
+
+/* Determines type of the file using information from lstat() where it's
+ * available. */
+static void
+get_type(const char dir[], const struct dirent *d, fslister_entry_t *entry)
+{
+	char full_path[PATH_MAX];
+
+#ifndef _WIN32
+	entry->is_dir = S_ISDIR(entry->info.st_mode);
+	entry->is_link = S_ISLNK(entry->info.st_mode);
+	if(!entry->is_link)
+	{
+		return;
+	}
+#endif
+
+	snprintf(full_path, sizeof(full_path), "%s/%s", dir, d->d_name);
+	entry->is_dir = is_dir(full_path);
+#ifdef _WIN32
+	entry->is_link = is_symlink(full_path);
+#endif
+}
+
+/* Checks whether lister is being destroyed.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+is_stopped(fslister_t *lister)
+{
+	int stop;
+	pthread_mutex_lock(&lister->lock);
+	stop = lister->stop;
+	pthread_mutex_unlock(&lister->lock);
+	return stop;
+}
+
+/* Waits for the request to be completed by a worker checking for cancellation
+ * periodically.  Must be called with the lock held.  Returns zero when the
+ * request is done and non-zero if waiting was cancelled. */
+static int
+wait_for(fslister_t *lister, fslister_req_t *req)
+{
+	while(req->state != RS_DONE)
+	{
+		struct timeval tv;
+		struct timespec ts;
+
+		if(lister->cancelled != NULL && lister->cancelled())
+		{
+			return 1;
+		}
+
+		(void)gettimeofday(&tv, NULL);
+		tv.tv_usec += CANCEL_POLL_PERIOD;
+		ts.tv_sec = tv.tv_sec + tv.tv_usec/1000000;
+		ts.tv_nsec = (tv.tv_usec%1000000)*1000;
+		(void)pthread_cond_timedwait(&lister->done_cond, &lister->lock, &ts);
+	}
+	return 0;
+}
+
+/* Inserts request at the head of the list. */
+static void
+push(fslister_req_t **list, fslister_req_t *req)
+{
+	req->prev = NULL;
+	req->next = *list;
+	if(*list != NULL)
+	{
+		(*list)->prev = req;
+	}
+	*list = req;
+}
+
+/* Removes request from the list. */
+static void
+unlink_req(fslister_req_t **list, fslister_req_t *req)
+{
+	if(req->prev == NULL)
+	{
+		*list = req->next;
+	}
+	else
+	{
+		req->prev->next = req->next;
+	}
+	if(req->next != NULL)
+	{
+		req->next->prev = req->prev;
+	}
+	req->prev = NULL;
+	req->next = NULL;
+}
+
+/* Frees the request along with its result. */
+static void
+free_req(fslister_req_t *req)
+{
+	fslister_free_entries(req->entries, req->count);
+	free(req->path);
+	free(req);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
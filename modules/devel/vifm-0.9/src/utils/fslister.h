@@ -0,0 +1,75 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FSLISTER_H__
+#define VIFM__UTILS__FSLISTER_H__
+
+#include <sys/stat.h> /* stat */
+
+/* Lister of directories that reads them on worker threads.  Client requests
+ * directories it's going to need and later takes their listings in any order,
+ * while the lister reads them ahead of time.  Directories requested last are
+ * read first, which suits depth-first traversal if children are requested in
+ * reverse order. */
+
+/* Opaque declaration of the lister type. */
+typedef struct fslister_t fslister_t;
+
+/* Opaque handle of a requested directory. */
+typedef struct fslister_req_t fslister_req_t;
+
+/* Single file of a listing. */
+typedef struct
+{
+	char *name;       /* Name of the file. */
+	int is_dir;       /* Whether it's a directory or a symbolic link to one. */
+	int is_link;      /* Whether it's a symbolic link. */
+	struct stat info; /* Result of lstat() on the file (not set on Windows). */
+}
+fslister_entry_t;
+
+/* Callback that checks whether operation should be abandoned.  Returns non-zero
+ * if so, otherwise zero is returned. */
+typedef int (*fslister_cancelled_func)(void);
+
+/* Creates lister with specified number of worker threads.  cancelled can be
+ * NULL.  Returns the lister or NULL on error. */
+fslister_t * fslister_create(int nthreads, fslister_cancelled_func cancelled);
+
+/* Stops reading of directories, waits for workers to finish and frees all
+ * listings that weren't taken.  The lister can be NULL. */
+void fslister_free(fslister_t *lister);
+
+/* Schedules reading of the directory.  Returns handle to be passed to
+ * fslister_take() or NULL on error. */
+fslister_req_t * fslister_request(fslister_t *lister, const char path[]);
+
+/* Waits for listing of the request to become available and frees the request
+ * handle.  Returns array of entries (can be NULL if there are none) and sets
+ * *count to its length or to -1 on failure to read the directory or on
+ * cancellation. */
+fslister_entry_t * fslister_take(fslister_t *lister, fslister_req_t *req,
+		int *count);
+
+/* Frees array of entries returned by fslister_take(). */
+void fslister_free_entries(fslister_entry_t entries[], int count);
+
+#endif /* VIFM__UTILS__FSLISTER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,258 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "fsprefetch.h"
+
+#include <sys/stat.h> /* stat fstatat() */
+#include <dirent.h> /* DIR dirent dirfd() */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW */
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "path.h"
+#include "utils.h"
+
+/* How many files are read between checks whether prefetch is being
+ * stopped. */
+#define STOP_CHECK_PERIOD 64
+
+/* Prefetch state. */
+struct fsprefetch_t
+{
+	char *path;       /* Path to the directory. */
+	pthread_t thread; /* Worker thread. */
+
+	pthread_mutex_t lock; /* Protects stop and done fields. */
+	int stop;             /* Whether worker should quit. */
+	int done;             /* Whether listing is available. */
+
+	fsprefetch_entry_t *entries; /* Result of reading the directory. */
+	int count;                   /* Number of entries or -1 on error. */
+};
+
+static void * worker(void *arg);
+static fsprefetch_entry_t * read_dir(fsprefetch_t *prefetch, int *count);
+static int is_stopped(fsprefetch_t *prefetch);
+
+fsprefetch_t *
+fsprefetch_start(const char path[])
+{
+#ifndef _WIN32
+	fsprefetch_t *const prefetch = calloc(1U, sizeof(*prefetch));
+	if(prefetch == NULL)
+	{
+		return NULL;
+	}
+
+	prefetch->path = strdup(path);
+	if(prefetch->path == NULL)
+	{
+		free(prefetch);
+		return NULL;
+	}
+
+	pthread_mutex_init(&prefetch->lock, NULL);
+
+	if(pthread_create(&prefetch->thread, NULL, &worker, prefetch) != 0)
+	{
+		pthread_mutex_destroy(&prefetch->lock);
+		free(prefetch->path);
+		free(prefetch);
+		return NULL;
+	}
+
+	return prefetch;
+#else
+	return NULL;
+#endif
+}
+
+void
+fsprefetch_free(fsprefetch_t *prefetch)
+{
+	int count;
+	fsprefetch_entry_t *entries;
+
+	if(prefetch == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&prefetch->lock);
+	prefetch->stop = 1;
+	pthread_mutex_unlock(&prefetch->lock);
+
+	entries = fsprefetch_take(prefetch, &count);
+	fsprefetch_free_entries(entries, count);
+}
+
+const char *
+fsprefetch_get_path(const fsprefetch_t *prefetch)
+{
+	return prefetch->path;
+}
+
+int
+fsprefetch_is_done(fsprefetch_t *prefetch)
+{
+	int done;
+	pthread_mutex_lock(&prefetch->lock);
+	done = prefetch->done;
+	pthread_mutex_unlock(&prefetch->lock);
+	return done;
+}
+
+fsprefetch_entry_t *
+fsprefetch_take(fsprefetch_t *prefetch, int *count)
+{
+	fsprefetch_entry_t *entries;
+
+	pthread_join(prefetch->thread, NULL);
+
+	entries = prefetch->entries;
+	*count = prefetch->count;
+
+	pthread_mutex_destroy(&prefetch->lock);
+	free(prefetch->path);
+	free(prefetch);
+	return entries;
+}
+
+void
+fsprefetch_free_entries(fsprefetch_entry_t entries[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(entries[i].name);
+	}
+	free(entries);
+}
+
+/* Entry point of worker thread.  Returns NULL. */
+static void *
+worker(void *arg)
+{
+	fsprefetch_t *const prefetch = arg;
+	int count;
+	fsprefetch_entry_t *entries;
+
+	block_all_thread_signals();
+
+	entries = read_dir(prefetch, &count);
+
+	pthread_mutex_lock(&prefetch->lock);
+	prefetch->entries = entries;
+	prefetch->count = count;
+	prefetch->done = 1;
+	pthread_mutex_unlock(&prefetch->lock);
+
+	return NULL;
+}
+
+/* Lists files of the directory omitting "." and "..".  Returns array of
+ * entries and sets *count to its length or to -1 on error. */
+static fsprefetch_entry_t *
+read_dir(fsprefetch_t *prefetch, int *count)
+{
+	struct dirent *d;
+	fsprefetch_entry_t *entries = NULL;
+	int capacity = 0;
+	int n = 0;
+	int nread = 0;
+
+	DIR *const dir = os_opendir(prefetch->path);
+	if(dir == NULL)
+	{
+		*count = -1;
+		return NULL;
+	}
+
+	while((d = os_readdir(dir)) != NULL)
+	{
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		if(++nread%STOP_CHECK_PERIOD == 0 && is_stopped(prefetch))
+		{
+			break;
+		}
+
+		if(n == capacity)
+		{
+			const int new_capacity = (capacity == 0) ? 64 : capacity*2;
+			void *const p = reallocarray(entries, new_capacity, sizeof(*entries));
+			if(p == NULL)
+			{
+				break;
+			}
+			entries = p;
+			capacity = new_capacity;
+		}
+
+		/* Querying relative to the directory saves resolving its path for every
+		 * file. */
+		if(fstatat(dirfd(dir), d->d_name, &entries[n].info,
+					AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			/* The file is gone. */
+			continue;
+		}
+
+		entries[n].name = strdup(d->d_name);
+		if(entries[n].name == NULL)
+		{
+			break;
+		}
+		++n;
+	}
+	os_closedir(dir);
+
+	if(d != NULL)
+	{
+		/* Loop was interrupted. */
+		fsprefetch_free_entries(entries, n);
+		*count = -1;
+		return NULL;
+	}
+
+	*count = n;
+	return entries;
+}
+
+/* Checks whether prefetch is being stopped.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+is_stopped(fsprefetch_t *prefetch)
+{
+	int stop;
+	pthread_mutex_lock(&prefetch->lock);
+	stop = prefetch->stop;
+	pthread_mutex_unlock(&prefetch->lock);
+	return stop;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,67 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FSPREFETCH_H__
+#define VIFM__UTILS__FSPREFETCH_H__
+
+#include <sys/stat.h> /* stat */
+
+/* Reading of a directory along with lstat() information about its files on a
+ * separate thread, so that the listing is ready by the time it's needed.  Not
+ * supported on Windows, where listing of a directory already provides
+ * information about files. */
+
+/* Opaque declaration of the prefetch type. */
+typedef struct fsprefetch_t fsprefetch_t;
+
+/* Single file of a listing. */
+typedef struct
+{
+	char *name;       /* Name of the file. */
+	struct stat info; /* Result of lstat() on the file. */
+}
+fsprefetch_entry_t;
+
+/* Starts reading the directory on a worker thread.  Returns the prefetch or
+ * NULL on error or if it's not supported. */
+fsprefetch_t * fsprefetch_start(const char path[]);
+
+/* Stops reading of the directory, waits for the worker and frees all
+ * resources.  The prefetch can be NULL. */
+void fsprefetch_free(fsprefetch_t *prefetch);
+
+/* Retrieves path of the directory that's being read.  Returns the path. */
+const char * fsprefetch_get_path(const fsprefetch_t *prefetch);
+
+/* Checks whether listing is available already.  Returns non-zero if so,
+ * otherwise zero is returned. */
+int fsprefetch_is_done(fsprefetch_t *prefetch);
+
+/* Waits for listing to become available and frees the prefetch.  Files that
+ * disappeared before they were queried are omitted.  Returns array of entries
+ * (can be NULL if there are none) and sets *count to its length or to -1 on
+ * failure to read the directory. */
+fsprefetch_entry_t * fsprefetch_take(fsprefetch_t *prefetch, int *count);
+
+/* Frees array of entries returned by fsprefetch_take(). */
+void fsprefetch_free_entries(fsprefetch_entry_t entries[], int count);
+
+#endif /* VIFM__UTILS__FSPREFETCH_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -92,7 +92,7 @@ fswatch_create(const char path[])
 	/* Add directory to watch. */
 	wd = inotify_add_watch(w->fd, path, IN_ATTRIB | IN_MODIFY | IN_CREATE |
 			IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_EXCL_UNLINK |
-			IN_CLOSE_WRITE);
+			IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF);
 	if(wd == -1)
 	{
 		close(w->fd);
@@ -168,6 +168,12 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+int
+fswatch_get_fd(const fswatch_t *w)
+{
+	return w->fd;
+}
+
 /* Updates information about a file event is about.  Returns non-zero if this is
  * an interesting event that's worth attention (e.g. re-reading information from
  * file system), otherwise zero is returned. */
@@ -302,6 +308,12 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+int
+fswatch_get_fd(const fswatch_t *w)
+{
+	return -1;
+}
+
 #endif
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
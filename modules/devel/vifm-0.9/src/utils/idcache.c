@@ -0,0 +1,528 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "idcache.h"
+
+#include <sys/types.h> /* gid_t uid_t */
+#include <grp.h> /* endgrent() getgrent() getgrgid_r() setgrent() */
+#include <pwd.h> /* endpwent() getpwent() getpwuid_r() setpwent() */
+#include <unistd.h> /* sysconf() */
+
+#include <errno.h> /* ERANGE */
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+#include <time.h> /* time_t time() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "macros.h"
+#include "str.h"
+#include "string_array.h"
+#include "utils.h"
+
+/* Lifetime of names in seconds. */
+#define NAME_TTL (10*60)
+
+/* Lifetime of failed lookups in seconds. */
+#define NO_NAME_TTL 60
+
+/* Initial size of hash tables. */
+#define MIN_CAPACITY 64U
+
+/* Single cached id. */
+typedef struct
+{
+	unsigned int id; /* User or group id. */
+	char *name;      /* Name or NULL if lookup has failed. */
+	time_t expires;  /* Time at which this entry becomes outdated. */
+	int used;        /* Whether this slot of hash table is occupied. */
+}
+id_entry_t;
+
+/* Contents of a database. */
+typedef struct
+{
+	unsigned int *ids; /* Ids. */
+	char **names;      /* Names that correspond to ids. */
+	int count;         /* Number of elements in both arrays. */
+}
+id_dump_t;
+
+/* Looks up name for the id.  Returns newly allocated string or NULL. */
+typedef char * (*lookup_func)(unsigned int id);
+
+/* Reads whole database into the dump. */
+typedef void (*enum_func)(id_dump_t *dump);
+
+/* Cache of names of one kind. */
+typedef struct
+{
+	lookup_func lookup;  /* Looks up single id. */
+	enum_func enumerate; /* Reads whole database. */
+
+	id_entry_t *entries; /* Hash table with open addressing. */
+	size_t capacity;     /* Size of the table (zero or power of two). */
+	size_t count;        /* Number of used slots. */
+
+	char **names;        /* Names read from the database. */
+	int nnames;          /* Number of elements in names. */
+	time_t names_expire; /* When names become outdated, zero if never read. */
+	int loading;         /* Whether database is being read. */
+}
+id_table_t;
+
+static void get_name(id_table_t *table, unsigned int id, size_t buf_len,
+		char buf[]);
+static char ** list_names(id_table_t *table, int *count);
+static int start_loading(id_table_t *table, time_t now);
+static void * load_thread(void *arg);
+static void load_table(id_table_t *table);
+static id_entry_t * find_entry(id_table_t *table, unsigned int id);
+static void put_entry(id_table_t *table, unsigned int id, char name[],
+		time_t expires);
+static int grow_table(id_table_t *table);
+static void free_table(id_table_t *table);
+static void dump_add(id_dump_t *dump, unsigned int id, const char name[]);
+static char * lookup_user(unsigned int id);
+static char * lookup_group(unsigned int id);
+static void enum_users(id_dump_t *dump);
+static void enum_groups(id_dump_t *dump);
+
+/* Protects tables below and is used with the condition variable. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when reading of a database is finished. */
+static pthread_cond_t loaded = PTHREAD_COND_INITIALIZER;
+
+/* Cache of user names. */
+static id_table_t users = { .lookup = &lookup_user, .enumerate = &enum_users };
+/* Cache of group names. */
+static id_table_t groups = { .lookup = &lookup_group,
+                             .enumerate = &enum_groups };
+
+void
+idcache_user_name(uid_t uid, size_t buf_len, char buf[])
+{
+	get_name(&users, uid, buf_len, buf);
+}
+
+void
+idcache_group_name(gid_t gid, size_t buf_len, char buf[])
+{
+	get_name(&groups, gid, buf_len, buf);
+}
+
+char **
+idcache_list_users(int *count)
+{
+	return list_names(&users, count);
+}
+
+char **
+idcache_list_groups(int *count)
+{
+	return list_names(&groups, count);
+}
+
+void
+idcache_reset(void)
+{
+	pthread_mutex_lock(&lock);
+	while(users.loading || groups.loading)
+	{
+		pthread_cond_wait(&loaded, &lock);
+	}
+	free_table(&users);
+	free_table(&groups);
+	pthread_mutex_unlock(&lock);
+}
+
+/* Puts name that corresponds to the id into the buffer querying the system if
+ * there is no up to date entry for it. */
+static void
+get_name(id_table_t *table, unsigned int id, size_t buf_len, char buf[])
+{
+	const time_t now = time(NULL);
+	id_entry_t *entry;
+	char *name;
+
+	pthread_mutex_lock(&lock);
+
+	/* It's fine to fail here, ids can be looked up one by one. */
+	(void)start_loading(table, now);
+
+	entry = find_entry(table, id);
+	if(entry != NULL && now < entry->expires)
+	{
+		if(entry->name == NULL)
+		{
+			snprintf(buf, buf_len, "%d", (int)id);
+		}
+		else
+		{
+			copy_str(buf, buf_len, entry->name);
+		}
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	/* Don't block reading of database while waiting for a reply. */
+	name = table->lookup(id);
+	if(name == NULL)
+	{
+		snprintf(buf, buf_len, "%d", (int)id);
+	}
+	else
+	{
+		copy_str(buf, buf_len, name);
+	}
+
+	pthread_mutex_lock(&lock);
+	put_entry(table, id, name, now + (name == NULL ? NO_NAME_TTL : NAME_TTL));
+	pthread_mutex_unlock(&lock);
+}
+
+/* Lists names of the database reading it if necessary.  Returns array of names
+ * and sets *count to its size. */
+static char **
+list_names(id_table_t *table, int *count)
+{
+	char **names;
+
+	pthread_mutex_lock(&lock);
+
+	if(start_loading(table, time(NULL)) != 0)
+	{
+		table->loading = 1;
+		pthread_mutex_unlock(&lock);
+		load_table(table);
+		pthread_mutex_lock(&lock);
+	}
+
+	while(table->loading)
+	{
+		pthread_cond_wait(&loaded, &lock);
+	}
+
+	names = copy_string_array(table->names, table->nnames);
+	*count = (names == NULL) ? 0 : table->nnames;
+
+	pthread_mutex_unlock(&lock);
+	return names;
+}
+
+/* Starts reading database in background if it wasn't read yet or it's
+ * outdated.  Must be called with the lock held.  Returns zero if nothing needs
+ * to be done or reading has started, otherwise non-zero is returned. */
+static int
+start_loading(id_table_t *table, time_t now)
+{
+	pthread_attr_t attr;
+	pthread_t id;
+	int error;
+
+	if(table->loading || now < table->names_expire)
+	{
+		return 0;
+	}
+
+	if(pthread_attr_init(&attr) != 0)
+	{
+		return 1;
+	}
+
+	table->loading = 1;
+	error = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0
+	     || pthread_create(&id, &attr, &load_thread, table) != 0;
+	if(error)
+	{
+		table->loading = 0;
+	}
+
+	(void)pthread_attr_destroy(&attr);
+	return error;
+}
+
+/* Entry point of a thread that reads database.  Returns NULL. */
+static void *
+load_thread(void *arg)
+{
+	block_all_thread_signals();
+	load_table(arg);
+	return NULL;
+}
+
+/* Reads database and stores its contents in the table.  Expects loading flag
+ * of the table to be set and resets it. */
+static void
+load_table(id_table_t *table)
+{
+	id_dump_t dump = {};
+	time_t now;
+	int i;
+
+	table->enumerate(&dump);
+	now = time(NULL);
+
+	pthread_mutex_lock(&lock);
+
+	/* Go backwards to make first of entries with the same id take effect. */
+	for(i = dump.count - 1; i >= 0; --i)
+	{
+		char *const name = strdup(dump.names[i]);
+		if(name != NULL)
+		{
+			put_entry(table, dump.ids[i], name, now + NAME_TTL);
+		}
+	}
+
+	free_string_array(table->names, table->nnames);
+	table->names = dump.names;
+	table->nnames = dump.count;
+	table->names_expire = now + NAME_TTL;
+
+	table->loading = 0;
+	pthread_cond_broadcast(&loaded);
+
+	pthread_mutex_unlock(&lock);
+
+	free(dump.ids);
+}
+
+/* Looks up entry of the id in the table.  Returns the entry or NULL. */
+static id_entry_t *
+find_entry(id_table_t *table, unsigned int id)
+{
+	size_t i;
+
+	if(table->capacity == 0U)
+	{
+		return NULL;
+	}
+
+	for(i = id*2654435761U; ; ++i)
+	{
+		id_entry_t *const entry = &table->entries[i & (table->capacity - 1U)];
+		if(!entry->used)
+		{
+			return NULL;
+		}
+		if(entry->id == id)
+		{
+			return entry;
+		}
+	}
+}
+
+/* Adds or updates entry of the id taking ownership of the name. */
+static void
+put_entry(id_table_t *table, unsigned int id, char name[], time_t expires)
+{
+	size_t i;
+	id_entry_t *entry = find_entry(table, id);
+
+	if(entry != NULL)
+	{
+		free(entry->name);
+		entry->name = name;
+		entry->expires = expires;
+		return;
+	}
+
+	/* Keep load factor below one half for short probe sequences. */
+	if((table->count + 1U)*2U > table->capacity && grow_table(table) != 0)
+	{
+		free(name);
+		return;
+	}
+
+	for(i = id*2654435761U; ; ++i)
+	{
+		entry = &table->entries[i & (table->capacity - 1U)];
+		if(!entry->used)
+		{
+			break;
+		}
+	}
+
+	entry->id = id;
+	entry->name = name;
+	entry->expires = expires;
+	entry->used = 1;
+	++table->count;
+}
+
+/* Doubles capacity of the table.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+grow_table(id_table_t *table)
+{
+	const size_t capacity = MAX(table->capacity*2U, MIN_CAPACITY);
+	id_entry_t *const old_entries = table->entries;
+	const size_t old_capacity = table->capacity;
+	size_t i;
+
+	id_entry_t *const entries = calloc(capacity, sizeof(*entries));
+	if(entries == NULL)
+	{
+		return 1;
+	}
+
+	table->entries = entries;
+	table->capacity = capacity;
+	table->count = 0U;
+
+	for(i = 0U; i < old_capacity; ++i)
+	{
+		if(old_entries[i].used)
+		{
+			put_entry(table, old_entries[i].id, old_entries[i].name,
+					old_entries[i].expires);
+		}
+	}
+
+	free(old_entries);
+	return 0;
+}
+
+/* Frees all data of the table leaving it in initial state. */
+static void
+free_table(id_table_t *table)
+{
+	size_t i;
+	for(i = 0U; i < table->capacity; ++i)
+	{
+		free(table->entries[i].name);
+	}
+	free(table->entries);
+	table->entries = NULL;
+	table->capacity = 0U;
+	table->count = 0U;
+
+	free_string_array(table->names, table->nnames);
+	table->names = NULL;
+	table->nnames = 0;
+	table->names_expire = 0;
+}
+
+/* Appends id and a copy of the name to the dump. */
+static void
+dump_add(id_dump_t *dump, unsigned int id, const char name[])
+{
+	unsigned int *const ids = reallocarray(dump->ids, dump->count + 1,
+			sizeof(*ids));
+	if(ids == NULL)
+	{
+		return;
+	}
+	dump->ids = ids;
+
+	if(add_to_string_array(&dump->names, dump->count, 1, name) == dump->count)
+	{
+		return;
+	}
+
+	dump->ids[dump->count++] = id;
+}
+
+/* Looks up name of the user.  Returns newly allocated string or NULL. */
+static char *
+lookup_user(unsigned int id)
+{
+	enum { MAX_TRIES = 4 };
+	size_t size = MAX(sysconf(_SC_GETPW_R_SIZE_MAX) + 1, PATH_MAX);
+	int i;
+	for(i = 0; i < MAX_TRIES; ++i, size *= 2)
+	{
+		char buf[size];
+		struct passwd pwd_b;
+		struct passwd *pwd_buf;
+
+		const int error = getpwuid_r(id, &pwd_b, buf, sizeof(buf), &pwd_buf);
+		if(error == 0)
+		{
+			return (pwd_buf == NULL) ? NULL : strdup(pwd_buf->pw_name);
+		}
+		if(error != ERANGE)
+		{
+			break;
+		}
+	}
+	return NULL;
+}
+
+/* Looks up name of the group.  Returns newly allocated string or NULL. */
+static char *
+lookup_group(unsigned int id)
+{
+	enum { MAX_TRIES = 4 };
+	size_t size = MAX(sysconf(_SC_GETGR_R_SIZE_MAX) + 1, PATH_MAX);
+	int i;
+	for(i = 0; i < MAX_TRIES; ++i, size *= 2)
+	{
+		char buf[size];
+		struct group group_b;
+		struct group *group_buf;
+
+		const int error = getgrgid_r(id, &group_b, buf, sizeof(buf), &group_buf);
+		if(error == 0)
+		{
+			return (group_buf == NULL) ? NULL : strdup(group_buf->gr_name);
+		}
+		if(error != ERANGE)
+		{
+			break;
+		}
+	}
+	return NULL;
+}
+
+/* Reads database of users. */
+static void
+enum_users(id_dump_t *dump)
+{
+	struct passwd *pw;
+
+	setpwent();
+	while((pw = getpwent()) != NULL)
+	{
+		dump_add(dump, pw->pw_uid, pw->pw_name);
+	}
+	endpwent();
+}
+
+/* Reads database of groups. */
+static void
+enum_groups(id_dump_t *dump)
+{
+	struct group *gr;
+
+	setgrent();
+	while((gr = getgrent()) != NULL)
+	{
+		dump_add(dump, gr->gr_gid, gr->gr_name);
+	}
+	endgrent();
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
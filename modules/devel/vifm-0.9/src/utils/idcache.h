@@ -0,0 +1,53 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__IDCACHE_H__
+#define VIFM__UTILS__IDCACHE_H__
+
+#include <sys/types.h> /* gid_t uid_t */
+
+#include <stddef.h> /* size_t */
+
+/* Cache of user and group names (*nix only).  Both successful and failed
+ * lookups are remembered for some time.  On first use of each kind of names
+ * whole user or group database is read in a background thread. */
+
+/* Puts name of the user into the buffer or formats the id as a number if there
+ * is no such user. */
+void idcache_user_name(uid_t uid, size_t buf_len, char buf[]);
+
+/* Puts name of the group into the buffer or formats the id as a number if there
+ * is no such group. */
+void idcache_group_name(gid_t gid, size_t buf_len, char buf[]);
+
+/* Lists names of all users waiting for database to be read if needed.  Returns
+ * array of names (to be freed by caller) and sets *count to its length. */
+char ** idcache_list_users(int *count);
+
+/* Lists names of all groups waiting for database to be read if needed.
+ * Returns array of names (to be freed by caller) and sets *count to its
+ * length. */
+char ** idcache_list_groups(int *count);
+
+/* Forgets everything that was cached. */
+void idcache_reset(void);
+
+#endif /* VIFM__UTILS__IDCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,159 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "intern.h"
+
+#include <stddef.h> /* NULL offsetof() size_t */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() strcmp() strlen() */
+
+#include "str.h"
+
+/* Initial number of buckets of the table. */
+#define MIN_CAPACITY 64U
+
+/* Single interned string, its text is stored right after the header. */
+typedef struct node_t
+{
+	struct node_t *next; /* Next node in the same bucket. */
+	size_t hash;         /* Hash of the string. */
+	size_t refs;         /* Number of users of the string. */
+	char str[];          /* The string itself. */
+}
+node_t;
+
+static node_t * get_node(char str[]);
+static int grow_table(void);
+
+/* Hash table with separate chaining.  It and strings in it are accessed only
+ * from the main thread, see header. */
+static node_t **buckets;
+/* Number of buckets (zero or power of two). */
+static size_t capacity;
+/* Number of strings in the table. */
+static size_t count;
+
+char *
+intern_str(const char str[])
+{
+	size_t len;
+	node_t *node;
+	const size_t hash = hash_str(str);
+
+	if(capacity != 0U)
+	{
+		for(node = buckets[hash & (capacity - 1U)]; node != NULL; node = node->next)
+		{
+			if(node->hash == hash && strcmp(node->str, str) == 0)
+			{
+				++node->refs;
+				return node->str;
+			}
+		}
+	}
+
+	if(count >= capacity && grow_table() != 0 && capacity == 0U)
+	{
+		return NULL;
+	}
+
+	len = strlen(str);
+	node = malloc(sizeof(*node) + len + 1U);
+	if(node == NULL)
+	{
+		return NULL;
+	}
+
+	memcpy(node->str, str, len + 1U);
+	node->hash = hash;
+	node->refs = 1U;
+	node->next = buckets[hash & (capacity - 1U)];
+	buckets[hash & (capacity - 1U)] = node;
+	++count;
+
+	return node->str;
+}
+
+void
+intern_free(char str[])
+{
+	node_t **link;
+	node_t *node;
+
+	if(str == NULL)
+	{
+		return;
+	}
+
+	node = get_node(str);
+	if(--node->refs != 0U)
+	{
+		return;
+	}
+
+	link = &buckets[node->hash & (capacity - 1U)];
+	while(*link != node)
+	{
+		link = &(*link)->next;
+	}
+	*link = node->next;
+	--count;
+
+	free(node);
+}
+
+/* Retrieves node that holds the string.  Returns the node. */
+static node_t *
+get_node(char str[])
+{
+	return (node_t *)(str - offsetof(node_t, str));
+}
+
+/* Doubles number of buckets redistributing nodes among them.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+grow_table(void)
+{
+	size_t i;
+	const size_t new_capacity = (capacity == 0U) ? MIN_CAPACITY : capacity*2U;
+	node_t **const new_buckets = calloc(new_capacity, sizeof(*new_buckets));
+	if(new_buckets == NULL)
+	{
+		return 1;
+	}
+
+	for(i = 0U; i < capacity; ++i)
+	{
+		node_t *node = buckets[i];
+		while(node != NULL)
+		{
+			node_t *const next = node->next;
+			node->next = new_buckets[node->hash & (new_capacity - 1U)];
+			new_buckets[node->hash & (new_capacity - 1U)] = node;
+			node = next;
+		}
+	}
+
+	free(buckets);
+	buckets = new_buckets;
+	capacity = new_capacity;
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,39 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__INTERN_H__
+#define VIFM__UTILS__INTERN_H__
+
+/* Storage of reference counted immutable strings, equal strings are stored
+ * only once.  Not thread-safe: there is no locking of any kind (neither for the
+ * table nor for reference counts), so the unit must be used only from the main
+ * thread, which is where file lists (the only users of it) are built.  Worker
+ * threads must pass plain strings to the main thread instead. */
+
+/* Obtains shared copy of the string incrementing its reference count.  Returns
+ * the copy, which must not be modified, or NULL on error. */
+char * intern_str(const char str[]);
+
+/* Decrements reference count of a string returned by intern_str() freeing it
+ * when it's not used anymore.  The str can be NULL. */
+void intern_free(char str[]);
+
+#endif /* VIFM__UTILS__INTERN_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -410,5 +410,11 @@ matcher_is_full_path(const matcher_t *matcher)
 	return matcher->full_path;
 }
 
+int
+matcher_is_name_globs(const matcher_t *matcher)
+{
+	return matcher->type == MT_GLOBS && !matcher->negated && !matcher->full_path;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -56,6 +56,10 @@ int matcher_includes(const matcher_t *matcher, const matcher_t *like);
  * otherwise zero is returned. */
 int matcher_is_full_path(const matcher_t *matcher);
 
+/* Checks whether given matcher is a non-negated list of globs that is matched
+ * against file name.  Returns non-zero if so, otherwise zero is returned. */
+int matcher_is_name_globs(const matcher_t *matcher);
+
 #endif /* VIFM__UTILS__MATCHER_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -210,6 +210,16 @@ matchers_get_expr(const matchers_t *matchers)
 	return matchers->expr;
 }
 
+const char *
+matchers_get_name_globs(const matchers_t *matchers)
+{
+	if(matchers->count != 1 || !matcher_is_name_globs(matchers->list[0]))
+	{
+		return NULL;
+	}
+	return matcher_get_undec(matchers->list[0]);
+}
+
 int
 matchers_includes(const matchers_t *matchers, const matchers_t *like)
 {
@@ -46,6 +46,10 @@ int matchers_match_dir(const matchers_t *matchers, const char path[]);
 /* Retrieves original matcher expression.  Returns the expression. */
 const char * matchers_get_expr(const matchers_t *matchers);
 
+/* Retrieves comma-separated list of globs if matchers consist of a single
+ * non-negated glob matcher of file names.  Returns the list or NULL. */
+const char * matchers_get_name_globs(const matchers_t *matchers);
+
 /* Checks whether everything matched by the matcher is also matched by the like.
  * Returns non-zero if so, otherwise zero is returned. */
 int matchers_includes(const matchers_t *matchers, const matchers_t *like);
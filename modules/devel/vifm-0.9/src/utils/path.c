@@ -40,6 +40,7 @@
 #include "../compat/fs_limits.h"
 #include "../int/path_env.h"
 #include "env.h"
+#include "execcache.h"
 #include "fs.h"
 #include "str.h"
 #include "utils.h"
@@ -738,8 +739,18 @@ find_cmd_in_path(const char cmd[], size_t path_len, char path[])
 	size_t i;
 	size_t paths_count;
 	char **paths;
+	int result;
 
+	/* This also updates list of directories of the index. */
 	paths = get_paths(&paths_count);
+
+	/* Directories are checked one by one only if index isn't ready. */
+	result = execcache_find(cmd, path_len, path);
+	if(result >= 0)
+	{
+		return result;
+	}
+
 	for(i = 0; i < paths_count; i++)
 	{
 		char tmp_path[PATH_MAX];
@@ -18,11 +18,23 @@
 
 #include "regexp.h"
 
-#include <regex.h> /* regex_t regmatch_t regerror() regexec() */
+#include <regex.h> /* REG_EXTENDED REG_ICASE regex_t regmatch_t regerror()
+                      regexec() */
+
+#include <ctype.h> /* ispunct() */
+#include <stddef.h> /* size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() strchr() strlen() strstr() */
 
 #include "../cfg/config.h"
 #include "str.h"
 
+static const char * skip_group(const char p[]);
+static const char * skip_bracket(const char p[]);
+static void drop_last_char(const char run[], size_t *run_len);
+static void commit_run(const char run[], size_t *run_len, char best[],
+		size_t *best_len);
+
 int
 get_regexp_cflags(const char pattern[])
 {
@@ -93,5 +105,210 @@ get_group_match(const regex_t *re, const char str[])
 	return matches[1];
 }
 
+char *
+regexp_get_literal(const char pattern[], int cflags)
+{
+	const int icase = (cflags & REG_ICASE);
+	const char *p = pattern;
+	size_t run_len = 0U, best_len = 0U;
+	char *run, *best;
+
+	if(!(cflags & REG_EXTENDED))
+	{
+		return NULL;
+	}
+
+	run = malloc(strlen(pattern) + 1U);
+	best = malloc(strlen(pattern) + 1U);
+	if(run == NULL || best == NULL)
+	{
+		free(run);
+		free(best);
+		return NULL;
+	}
+
+	while(p != NULL && *p != '\0')
+	{
+		switch(*p)
+		{
+			case '|':
+				/* Alternation at the top level makes every branch optional. */
+				p = NULL;
+				continue;
+			case '(':
+				commit_run(run, &run_len, best, &best_len);
+				p = skip_group(p);
+				continue;
+			case '[':
+				commit_run(run, &run_len, best, &best_len);
+				p = skip_bracket(p);
+				continue;
+
+			case '*':
+			case '?':
+			case '{':
+				/* Preceding character can be absent. */
+				drop_last_char(run, &run_len);
+				commit_run(run, &run_len, best, &best_len);
+				if(*p == '{')
+				{
+					p = strchr(p, '}');
+					if(p == NULL)
+					{
+						continue;
+					}
+				}
+				break;
+			case '+':
+				/* Preceding character is there, but it can be repeated. */
+				commit_run(run, &run_len, best, &best_len);
+				break;
+
+			case '\\':
+				if(p[1] == '\0')
+				{
+					p = NULL;
+					continue;
+				}
+				if(ispunct((unsigned char)p[1]))
+				{
+					run[run_len++] = p[1];
+				}
+				else
+				{
+					/* Back-references and extensions like \w or \<. */
+					commit_run(run, &run_len, best, &best_len);
+				}
+				++p;
+				break;
+
+			default:
+				if(*p == '.' || *p == '^' || *p == '$' || *p == ')' ||
+						(icase && (unsigned char)*p >= 0x80))
+				{
+					commit_run(run, &run_len, best, &best_len);
+				}
+				else
+				{
+					run[run_len++] = *p;
+				}
+				break;
+		}
+		++p;
+	}
+
+	commit_run(run, &run_len, best, &best_len);
+	free(run);
+
+	if(p == NULL || best_len == 0U)
+	{
+		free(best);
+		return NULL;
+	}
+
+	best[best_len] = '\0';
+	return best;
+}
+
+/* Skips parenthesized group that starts at the p.  Returns pointer to the
+ * character after the group or NULL if the group isn't terminated. */
+static const char *
+skip_group(const char p[])
+{
+	int depth = 0;
+	while(p != NULL && *p != '\0')
+	{
+		switch(*p)
+		{
+			case '\\':
+				if(p[1] == '\0')
+				{
+					return NULL;
+				}
+				++p;
+				break;
+			case '[':
+				p = skip_bracket(p);
+				continue;
+			case '(':
+				++depth;
+				break;
+			case ')':
+				if(--depth == 0)
+				{
+					return p + 1;
+				}
+				break;
+		}
+		++p;
+	}
+	return NULL;
+}
+
+/* Skips bracket expression that starts at the p.  Returns pointer to the
+ * character after the expression or NULL if it isn't terminated. */
+static const char *
+skip_bracket(const char p[])
+{
+	++p;
+	if(*p == '^')
+	{
+		++p;
+	}
+	if(*p == ']')
+	{
+		++p;
+	}
+
+	while(*p != ']')
+	{
+		if(*p == '\0')
+		{
+			return NULL;
+		}
+
+		/* Character classes, collating symbols and equivalence classes. */
+		if(p[0] == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '='))
+		{
+			const char end[] = { p[1], ']', '\0' };
+			p = strstr(p + 2, end);
+			if(p == NULL)
+			{
+				return NULL;
+			}
+			++p;
+		}
+		++p;
+	}
+	return p + 1;
+}
+
+/* Removes last (possibly multibyte) character from the run. */
+static void
+drop_last_char(const char run[], size_t *run_len)
+{
+	while(*run_len != 0U && ((unsigned char)run[*run_len - 1U] & 0xc0) == 0x80)
+	{
+		--*run_len;
+	}
+	if(*run_len != 0U)
+	{
+		--*run_len;
+	}
+}
+
+/* Remembers the run if it's longer than the best one found so far and starts
+ * new run. */
+static void
+commit_run(const char run[], size_t *run_len, char best[], size_t *best_len)
+{
+	if(*run_len > *best_len)
+	{
+		memcpy(best, run, *run_len);
+		*best_len = *run_len;
+	}
+	*run_len = 0U;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -44,6 +44,13 @@ int parse_case_flag(const char flags[], int *case_sensitive);
  * group both start and end fields are set to zero. */
 regmatch_t get_group_match(const regex_t *re, const char str[]);
 
+/* Extracts the longest string that must appear literally in every match of the
+ * pattern compiled with the cflags (only REG_EXTENDED syntax is supported).
+ * When REG_ICASE is set, the string consists of ASCII characters only and
+ * should be compared ignoring their case.  Returns newly allocated string or
+ * NULL if there is no such string or it can't be determined. */
+char * regexp_get_literal(const char pattern[], int cflags);
+
 #endif /* VIFM__UTILS__REGEXP_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -0,0 +1,393 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "selector.h"
+
+#if defined(__linux__)
+# define USE_EPOLL
+# include <sys/epoll.h> /* EPOLL_* epoll_event epoll_create1() epoll_ctl()
+                           epoll_wait() */
+# include <unistd.h> /* close() */
+#endif
+#ifndef _WIN32
+# include <poll.h> /* POLLIN POLLOUT pollfd poll() */
+#endif
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* memset() */
+
+#include "../compat/reallocarray.h"
+
+#ifndef _WIN32
+
+#ifdef USE_EPOLL
+
+/* Mark of descriptors registered in the selector, which is stored alongside
+ * SEL_* values. */
+#define REGISTERED (1 << 30)
+
+#endif
+
+/* Set of descriptors along with results of the last wait. */
+struct selector_t
+{
+	struct pollfd *fds; /* Descriptors to wait on. */
+	int count;          /* Number of elements in fds array. */
+	int capacity;       /* Number of allocated elements of fds array. */
+
+#ifdef USE_EPOLL
+	int epfd; /* Instance of epoll or -1 if poll() is used. */
+
+	int *events;     /* Registered events indexed by descriptors. */
+	int events_len;  /* Number of elements in events array. */
+	int nregistered; /* Number of registered descriptors. */
+
+	struct epoll_event *ready; /* Descriptors found ready by the last wait. */
+	int ready_capacity;        /* Number of allocated elements of ready array. */
+	int nready;                /* Number of used elements of ready array. */
+#endif
+};
+
+static struct pollfd * find_fd(selector_t *selector, int fd);
+
+#ifdef USE_EPOLL
+static void epoll_reset(selector_t *selector);
+static int epoll_add(selector_t *selector, int fd, int events);
+static void epoll_remove(selector_t *selector, int fd);
+static int ensure_capacity(selector_t *selector, int fd);
+#endif
+
+#endif
+
+selector_t *
+selector_alloc(int long_lived)
+{
+#ifndef _WIN32
+	selector_t *const selector = calloc(1U, sizeof(*selector));
+	if(selector == NULL)
+	{
+		return NULL;
+	}
+
+#ifdef USE_EPOLL
+	/* Registering descriptors in epoll costs a system call each, which pays off
+	 * only if the set is reused by many waits.  poll() is used if epoll isn't
+	 * available. */
+	selector->epfd = long_lived ? epoll_create1(EPOLL_CLOEXEC) : -1;
+#else
+	(void)long_lived;
+#endif
+
+	return selector;
+#else
+	return NULL;
+#endif
+}
+
+void
+selector_free(selector_t *selector)
+{
+#ifndef _WIN32
+	if(selector != NULL)
+	{
+#ifdef USE_EPOLL
+		if(selector->epfd != -1)
+		{
+			close(selector->epfd);
+		}
+		free(selector->events);
+		free(selector->ready);
+#endif
+		free(selector->fds);
+		free(selector);
+	}
+#endif
+}
+
+void
+selector_reset(selector_t *selector)
+{
+#ifdef USE_EPOLL
+	if(selector->epfd != -1)
+	{
+		epoll_reset(selector);
+		return;
+	}
+#endif
+#ifndef _WIN32
+	selector->count = 0;
+#endif
+}
+
+int
+selector_add(selector_t *selector, int fd, int events)
+{
+#ifndef _WIN32
+	struct pollfd *pfd;
+
+#ifdef USE_EPOLL
+	if(selector->epfd != -1)
+	{
+		return epoll_add(selector, fd, events);
+	}
+#endif
+
+	pfd = find_fd(selector, fd);
+	if(pfd == NULL)
+	{
+		if(selector->count == selector->capacity)
+		{
+			const int capacity = (selector->capacity == 0)
+			                   ? 8
+			                   : selector->capacity*2;
+			void *const p = reallocarray(selector->fds, capacity, sizeof(*pfd));
+			if(p == NULL)
+			{
+				return 1;
+			}
+			selector->fds = p;
+			selector->capacity = capacity;
+		}
+
+		pfd = &selector->fds[selector->count++];
+		pfd->fd = fd;
+		pfd->events = 0;
+	}
+
+	pfd->events |= ((events & SEL_READ) ? POLLIN : 0)
+	             | ((events & SEL_WRITE) ? POLLOUT : 0);
+	pfd->revents = 0;
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+void
+selector_remove(selector_t *selector, int fd)
+{
+#ifndef _WIN32
+	struct pollfd *pfd;
+
+#ifdef USE_EPOLL
+	if(selector->epfd != -1)
+	{
+		epoll_remove(selector, fd);
+		return;
+	}
+#endif
+
+	pfd = find_fd(selector, fd);
+	if(pfd != NULL)
+	{
+		*pfd = selector->fds[--selector->count];
+	}
+#endif
+}
+
+int
+selector_wait(selector_t *selector, int timeout)
+{
+#ifndef _WIN32
+	int i;
+
+#ifdef USE_EPOLL
+	if(selector->epfd != -1)
+	{
+		selector->nready = epoll_wait(selector->epfd, selector->ready,
+				selector->ready_capacity, (timeout < 0) ? -1 : timeout);
+		if(selector->nready < 0)
+		{
+			selector->nready = 0;
+		}
+		return (selector->nready > 0);
+	}
+#endif
+
+	for(i = 0; i < selector->count; ++i)
+	{
+		selector->fds[i].revents = 0;
+	}
+
+	return poll(selector->fds, selector->count, (timeout < 0) ? -1 : timeout) > 0;
+#else
+	return 0;
+#endif
+}
+
+int
+selector_is_ready(const selector_t *selector, int fd)
+{
+	int pos = 0;
+	int ready_fd;
+	while((ready_fd = selector_next_ready(selector, &pos)) != -1)
+	{
+		if(ready_fd == fd)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int
+selector_next_ready(const selector_t *selector, int *pos)
+{
+#ifdef USE_EPOLL
+	if(selector->epfd != -1)
+	{
+		return (*pos < selector->nready) ? selector->ready[(*pos)++].data.fd : -1;
+	}
+#endif
+#ifndef _WIN32
+	while(*pos < selector->count)
+	{
+		/* Errors and hang ups are reported as readiness, so that they are handled
+		 * by reading or writing. */
+		const struct pollfd *const pfd = &selector->fds[(*pos)++];
+		if(pfd->revents != 0)
+		{
+			return pfd->fd;
+		}
+	}
+#endif
+	return -1;
+}
+
+#ifndef _WIN32
+
+/* Looks up descriptor in the selector.  Returns pointer to its entry or NULL
+ * if it's not there. */
+static struct pollfd *
+find_fd(selector_t *selector, int fd)
+{
+	int i;
+	for(i = 0; i < selector->count; ++i)
+	{
+		if(selector->fds[i].fd == fd)
+		{
+			return &selector->fds[i];
+		}
+	}
+	return NULL;
+}
+
+#endif
+
+#ifdef USE_EPOLL
+
+/* Implementation of selector_reset() for epoll. */
+static void
+epoll_reset(selector_t *selector)
+{
+	int fd;
+	for(fd = 0; fd < selector->events_len && selector->nregistered != 0; ++fd)
+	{
+		epoll_remove(selector, fd);
+	}
+	selector->nready = 0;
+}
+
+/* Implementation of selector_add() for epoll.  Returns zero on success and
+ * non-zero otherwise. */
+static int
+epoll_add(selector_t *selector, int fd, int events)
+{
+	struct epoll_event ev;
+	int op;
+
+	if(fd < 0 || ensure_capacity(selector, fd) != 0)
+	{
+		return 1;
+	}
+
+	events |= selector->events[fd] & (SEL_READ | SEL_WRITE);
+
+	ev.events = ((events & SEL_READ) ? EPOLLIN : 0)
+	          | ((events & SEL_WRITE) ? EPOLLOUT : 0);
+	ev.data.fd = fd;
+
+	op = (selector->events[fd] & REGISTERED) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	if(epoll_ctl(selector->epfd, op, fd, &ev) != 0)
+	{
+		return 1;
+	}
+
+	if(op == EPOLL_CTL_ADD)
+	{
+		++selector->nregistered;
+	}
+	selector->events[fd] = events | REGISTERED;
+	return 0;
+}
+
+/* Implementation of selector_remove() for epoll. */
+static void
+epoll_remove(selector_t *selector, int fd)
+{
+	if(fd >= 0 && fd < selector->events_len &&
+			(selector->events[fd] & REGISTERED))
+	{
+		/* Closed descriptors are removed automatically, so failure is fine. */
+		(void)epoll_ctl(selector->epfd, EPOLL_CTL_DEL, fd, NULL);
+		selector->events[fd] = 0;
+		--selector->nregistered;
+	}
+}
+
+/* Makes sure that there is room for the descriptor in arrays of the selector.
+ * Returns zero on success and non-zero otherwise. */
+static int
+ensure_capacity(selector_t *selector, int fd)
+{
+	/* Every registered descriptor can be reported as ready at the same time. */
+	if(selector->nregistered + 1 > selector->ready_capacity)
+	{
+		const int capacity = selector->nregistered + 8;
+		void *const p = reallocarray(selector->ready, capacity,
+				sizeof(*selector->ready));
+		if(p == NULL)
+		{
+			return 1;
+		}
+		selector->ready = p;
+		selector->ready_capacity = capacity;
+	}
+
+	if(fd >= selector->events_len)
+	{
+		const int len = (fd < 32) ? 64 : fd*2;
+		int *const p = reallocarray(selector->events, len, sizeof(*p));
+		if(p == NULL)
+		{
+			return 1;
+		}
+		memset(p + selector->events_len, 0,
+				sizeof(*p)*(len - selector->events_len));
+		selector->events = p;
+		selector->events_len = len;
+	}
+
+	return 0;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
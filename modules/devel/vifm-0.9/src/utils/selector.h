@@ -0,0 +1,73 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__SELECTOR_H__
+#define VIFM__UTILS__SELECTOR_H__
+
+/* Waiting for any of a set of file descriptors to become ready.  Uses poll() on
+ * *nix systems and epoll for long-lived sets on Linux.  Not supported on
+ * Windows. */
+
+/* Opaque declaration of the selector type. */
+typedef struct selector_t selector_t;
+
+/* Kinds of readiness to wait for. */
+enum
+{
+	SEL_READ  = 1 << 0, /* Descriptor has data to read or reached end of file. */
+	SEL_WRITE = 1 << 1, /* Descriptor can be written to without blocking. */
+};
+
+/* Creates an empty selector.  Non-zero long_lived hints that the set changes
+ * rarely compared to the number of waits on it (as opposed to being rebuilt
+ * before each wait).  Returns the selector or NULL on error or if it's not
+ * supported. */
+selector_t * selector_alloc(int long_lived);
+
+/* Frees the selector.  selector can be NULL. */
+void selector_free(selector_t *selector);
+
+/* Removes all descriptors from the selector. */
+void selector_reset(selector_t *selector);
+
+/* Adds descriptor to the selector.  events is a combination of SEL_* values,
+ * adding the same descriptor again extends its set of events.  Returns zero on
+ * success and non-zero otherwise. */
+int selector_add(selector_t *selector, int fd, int events);
+
+/* Removes descriptor from the selector.  Does nothing if it isn't there. */
+void selector_remove(selector_t *selector, int fd);
+
+/* Waits for at least one of descriptors to become ready.  timeout is in
+ * milliseconds, negative value means no timeout.  Returns non-zero if anything
+ * is ready and zero on timeout, interruption by a signal or error. */
+int selector_wait(selector_t *selector, int timeout);
+
+/* Checks whether descriptor was found ready by the last selector_wait().
+ * Returns non-zero if so, otherwise zero is returned. */
+int selector_is_ready(const selector_t *selector, int fd);
+
+/* Enumerates descriptors found ready by the last selector_wait().  *pos should
+ * be zero on the first call.  Returns the next ready descriptor or -1 if there
+ * are no more of them. */
+int selector_next_ready(const selector_t *selector, int *pos);
+
+#endif /* VIFM__UTILS__SELECTOR_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
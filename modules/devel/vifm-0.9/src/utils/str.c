@@ -1054,6 +1054,17 @@ chars_in_str(const char s[], char c)
 	return char_count;
 }
 
+size_t
+hash_str(const char str[])
+{
+	size_t hash = 2166136261U;
+	while(*str != '\0')
+	{
+		hash = (hash ^ (unsigned char)*str++)*16777619U;
+	}
+	return hash;
+}
+
 #ifdef _WIN32
 
 char *
@@ -289,6 +289,10 @@ int count_lines(const char text[], int max_width);
 /* Counts number of c char occurrences in the s string.  Returns the number. */
 size_t chars_in_str(const char s[], char c);
 
+/* Computes FNV-1a hash of the string for use in hash tables.  Returns the
+ * hash. */
+size_t hash_str(const char str[]);
+
 #ifdef _WIN32
 
 /* Same as strstr(), but in case insensitive way. */
@@ -0,0 +1,325 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fprintf() fputc() fputs() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() timespec */
+
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+
+/* Maximum number of spans that are collected, the rest is dropped. */
+#define MAX_SPANS 1000000
+
+/* Maximum nesting level of spans. */
+#define MAX_DEPTH 64
+
+/* Single span of execution. */
+typedef struct
+{
+	const char *name; /* Name of the span. */
+	char *arg;        /* Additional information or NULL. */
+	const char *count_name; /* Name of numeric argument or NULL. */
+	long long int count;    /* Value of numeric argument. */
+	uint64_t start;   /* Start time in microseconds since start of tracing. */
+	uint64_t end;     /* End time or zero if the span is still open. */
+}
+span_t;
+
+static uint64_t get_time(void);
+static void write_str(FILE *fp, const char str[]);
+static void free_spans(void);
+
+/* Whether spans are being collected. */
+static int active;
+/* Path to the file to write spans to. */
+static char *out_path;
+/* Time at which collection was started. */
+static uint64_t trace_start_time;
+/* Collected spans. */
+static span_t *spans;
+/* Number of elements in the spans array. */
+static size_t nspans;
+/* Capacity of the spans array. */
+static size_t spans_capacity;
+/* Indexes of currently open spans. */
+static size_t open_spans[MAX_DEPTH];
+/* Nesting level, can exceed MAX_DEPTH or number of spans that were actually
+ * recorded (those are ignored on closing). */
+static int depth;
+/* Nesting level at which spans stopped being recorded or -1. */
+static int dropped_depth = -1;
+
+int
+trace_start(const char path[])
+{
+	char *const path_copy = strdup(path);
+	if(path_copy == NULL)
+	{
+		return 1;
+	}
+
+	trace_stop();
+
+	out_path = path_copy;
+	active = 1;
+	trace_start_time = get_time();
+	return 0;
+}
+
+void
+trace_stop(void)
+{
+	free_spans();
+	free(out_path);
+	out_path = NULL;
+	active = 0;
+}
+
+int
+trace_is_active(void)
+{
+	return active;
+}
+
+void
+trace_begin(const char name[], const char arg[])
+{
+	span_t *span;
+
+	if(!active)
+	{
+		return;
+	}
+
+	if(dropped_depth >= 0 || depth >= MAX_DEPTH || nspans >= MAX_SPANS)
+	{
+		/* Nested spans of a dropped one are dropped as well to keep structure
+		 * consistent. */
+		if(dropped_depth < 0)
+		{
+			dropped_depth = depth;
+		}
+		++depth;
+		return;
+	}
+
+	if(nspans == spans_capacity)
+	{
+		const size_t new_capacity = (spans_capacity == 0U) ? 256U
+		                                                   : spans_capacity*2U;
+		span_t *const new_spans = reallocarray(spans, new_capacity,
+				sizeof(*new_spans));
+		if(new_spans == NULL)
+		{
+			dropped_depth = depth++;
+			return;
+		}
+		spans = new_spans;
+		spans_capacity = new_capacity;
+	}
+
+	span = &spans[nspans];
+	span->name = name;
+	span->arg = (arg == NULL) ? NULL : strdup(arg);
+	span->count_name = NULL;
+	span->start = get_time() - trace_start_time;
+	span->end = 0U;
+
+	open_spans[depth++] = nspans++;
+}
+
+void
+trace_set_count(const char name[], long long int value)
+{
+	span_t *span;
+
+	if(!active || depth == 0 || dropped_depth >= 0)
+	{
+		return;
+	}
+
+	span = &spans[open_spans[depth - 1]];
+	span->count_name = name;
+	span->count = value;
+}
+
+void
+trace_end(void)
+{
+	if(!active || depth == 0)
+	{
+		return;
+	}
+
+	--depth;
+	if(dropped_depth >= 0)
+	{
+		if(depth == dropped_depth)
+		{
+			dropped_depth = -1;
+		}
+		return;
+	}
+
+	spans[open_spans[depth]].end = get_time() - trace_start_time;
+	/* Zero means that the span is open, so make sure it's not used. */
+	if(spans[open_spans[depth]].end == 0U)
+	{
+		spans[open_spans[depth]].end = 1U;
+	}
+}
+
+const char *
+trace_get_path(void)
+{
+	return out_path;
+}
+
+int
+trace_finish(void)
+{
+	size_t i;
+	FILE *fp;
+	const uint64_t now = get_time() - trace_start_time;
+
+	if(!active)
+	{
+		return 1;
+	}
+
+	fp = os_fopen(out_path, "w");
+	if(fp == NULL)
+	{
+		trace_stop();
+		return 1;
+	}
+
+	fputs("{\"traceEvents\":[", fp);
+	for(i = 0U; i < nspans; ++i)
+	{
+		const span_t *const span = &spans[i];
+		const uint64_t end = (span->end == 0U) ? now : span->end;
+
+		fputs(i == 0U ? "\n" : ",\n", fp);
+		fputs("{\"name\":", fp);
+		write_str(fp, span->name);
+		fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%llu,\"dur\":%llu",
+				(unsigned long long)span->start,
+				(unsigned long long)(end - span->start));
+		if(span->arg != NULL || span->count_name != NULL)
+		{
+			fputs(",\"args\":{", fp);
+			if(span->arg != NULL)
+			{
+				fputs("\"arg\":", fp);
+				write_str(fp, span->arg);
+			}
+			if(span->count_name != NULL)
+			{
+				fputs(span->arg != NULL ? "," : "", fp);
+				write_str(fp, span->count_name);
+				fprintf(fp, ":%lld", span->count);
+			}
+			fputc('}', fp);
+		}
+		fputc('}', fp);
+	}
+	fputs("\n],\"displayTimeUnit\":\"ms\"}\n", fp);
+
+	trace_stop();
+	return (fclose(fp) != 0);
+}
+
+/* Retrieves current value of a monotonic clock.  Returns the time in
+ * microseconds. */
+static uint64_t
+get_time(void)
+{
+#ifndef _WIN32
+	struct timespec ts;
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+	{
+		return 0U;
+	}
+	return (uint64_t)ts.tv_sec*1000000U + ts.tv_nsec/1000U;
+#else
+	LARGE_INTEGER freq, counter;
+	if(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&counter))
+	{
+		return 0U;
+	}
+	return (uint64_t)(counter.QuadPart/freq.QuadPart)*1000000U +
+		(uint64_t)(counter.QuadPart%freq.QuadPart)*1000000U/freq.QuadPart;
+#endif
+}
+
+/* Writes string as a JSON string literal. */
+static void
+write_str(FILE *fp, const char str[])
+{
+	fputc('"', fp);
+	for(; *str != '\0'; ++str)
+	{
+		const unsigned char c = *str;
+		if(c == '"' || c == '\\')
+		{
+			fputc('\\', fp);
+			fputc(c, fp);
+		}
+		else if(c < 0x20)
+		{
+			fprintf(fp, "\\u%04x", c);
+		}
+		else
+		{
+			fputc(c, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+/* Frees all collected spans and resets nesting state. */
+static void
+free_spans(void)
+{
+	size_t i;
+	for(i = 0U; i < nspans; ++i)
+	{
+		free(spans[i].arg);
+	}
+	free(spans);
+
+	spans = NULL;
+	nspans = 0U;
+	spans_capacity = 0U;
+	depth = 0;
+	dropped_depth = -1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,63 @@
+/* vifm
+ * Copyright (C) 2017 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__TRACE_H__
+#define VIFM__UTILS__TRACE_H__
+
+/* Collection of timed and possibly nested spans of execution, which can be
+ * written out in Chrome's trace-event format (loadable by chrome://tracing and
+ * similar viewers).  Spans are ignored unless collection is active.  Not
+ * thread-safe, meant to be used from the main thread. */
+
+/* Discards previously collected spans and starts collecting new ones, which
+ * will be written to the specified file.  Returns zero on success, otherwise
+ * non-zero is returned. */
+int trace_start(const char path[]);
+
+/* Stops collection discarding all spans. */
+void trace_stop(void);
+
+/* Checks whether spans are being collected.  Returns non-zero if so, otherwise
+ * zero is returned. */
+int trace_is_active(void);
+
+/* Opens new span nested into currently open one.  The name should be a string
+ * literal, while arg is copied and can be NULL. */
+void trace_begin(const char name[], const char arg[]);
+
+/* Attaches a number to the innermost open span, it's written as one of its
+ * arguments.  The name should be a string literal.  Setting it again
+ * overwrites previous value. */
+void trace_set_count(const char name[], long long int value);
+
+/* Closes the innermost open span. */
+void trace_end(void);
+
+/* Retrieves path to the file the spans are going to be written to.  Returns the
+ * path or NULL if collection isn't active. */
+const char * trace_get_path(void);
+
+/* Writes collected spans to the file and stops collection.  Spans that are
+ * still open are written as if they were closed right now.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int trace_finish(void);
+
+#endif /* VIFM__UTILS__TRACE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -66,6 +66,7 @@
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
+#include "utils/trace.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
 #include "args.h"
@@ -83,6 +84,7 @@
 #include "flist_pos.h"
 #include "fops_common.h"
 #include "ipc.h"
+#include "ipc_handlers.h"
 #include "marks.h"
 #include "ops.h"
 #include "opt_handlers.h"
@@ -95,7 +97,6 @@
 
 static int vifm_main(int argc, char *argv[]);
 static int pair_in_use(short int pair);
-static void move_pair(short int from, short int to);
 static int undo_perform_func(OPS op, void *data, const char src[],
 		const char dst[]);
 static void parse_received_arguments(char *args[]);
@@ -105,6 +106,7 @@ static int need_to_switch_active_pane(const char lwin_path[],
 		const char rwin_path[]);
 static void load_scheme(void);
 static void exec_startup_commands(const args_t *args);
+static void finish_startup_profile(void);
 static void _gnuc_noreturn vifm_leave(int exit_code, int cquit);
 
 /* Command-line arguments in parsed form. */
@@ -169,6 +171,12 @@ vifm_main(int argc, char *argv[])
 	args_parse(&vifm_args, argc, argv, dir);
 	args_process(&vifm_args, 1);
 
+	if(vifm_args.startup_profile[0] != '\0')
+	{
+		(void)trace_start(vifm_args.startup_profile);
+	}
+	trace_begin("startup", NULL);
+
 	lwin_cv = (strcmp(vifm_args.lwin_path, "-") == 0 && vifm_args.lwin_handle);
 	rwin_cv = (strcmp(vifm_args.rwin_path, "-") == 0 && vifm_args.rwin_handle);
 	if(lwin_cv || rwin_cv)
@@ -184,7 +192,9 @@ vifm_main(int argc, char *argv[])
 	(void)setlocale(LC_ALL, "");
 	srand(time(NULL));
 
+	trace_begin("cfg_init", NULL);
 	cfg_init();
+	trace_end();
 
 	if(vifm_args.logging)
 	{
@@ -222,10 +232,15 @@ vifm_main(int argc, char *argv[])
 	{
 		/* vifminfo must be processed this early so that it can restore last visited
 		 * directory. */
+		trace_begin("read_info_file", NULL);
 		read_info_file(0);
+		trace_end();
 	}
 
-	ipc_init(vifm_args.server_name, &parse_received_arguments);
+	event_loop_init();
+
+	ipc_init(vifm_args.server_name, &parse_received_arguments,
+			&ipc_handle_request);
 	/* Export chosen server name to parsing unit. */
 	{
 		var_val_t value = { .string = (char *)ipc_get_name() };
@@ -248,8 +263,12 @@ vifm_main(int argc, char *argv[])
 		swap_view_roles();
 	}
 
+	trace_begin("load_initial_directory", lwin.curr_dir);
 	load_initial_directory(&lwin, dir);
+	trace_end();
+	trace_begin("load_initial_directory", rwin.curr_dir);
 	load_initial_directory(&rwin, dir);
+	trace_end();
 
 	/* Force split view when two paths are specified on command-line. */
 	if(vifm_args.lwin_path[0] != '\0' && vifm_args.rwin_path[0] != '\0')
@@ -265,6 +284,7 @@ vifm_main(int argc, char *argv[])
 		return -1;
 	}
 
+	trace_begin("setup_ncurses_interface", NULL);
 	if(!setup_ncurses_interface())
 	{
 		free_string_array(files, nfiles);
@@ -276,12 +296,11 @@ vifm_main(int argc, char *argv[])
 			.max_color_pairs = COLOR_PAIRS,
 			.max_colors = COLORS,
 			.init_pair = &init_pair,
-			.pair_content = &pair_content,
 			.pair_in_use = &pair_in_use,
-			.move_pair = &move_pair,
 		};
 		colmgr_init(&colmgr_conf);
 	}
+	trace_end();
 
 	init_modes();
 	init_undo_list(&undo_perform_func, NULL, &ui_cancellation_requested,
@@ -292,8 +311,12 @@ vifm_main(int argc, char *argv[])
 
 	if(!vifm_args.no_configs)
 	{
+		trace_begin("load_scheme", NULL);
 		load_scheme();
+		trace_end();
+		trace_begin("cfg_load", NULL);
 		cfg_load();
+		trace_end();
 	}
 
 	if(lwin_cv)
@@ -306,14 +329,22 @@ vifm_main(int argc, char *argv[])
 	}
 	free_string_array(files, nfiles);
 
+	/* Configuration is applied and locations are known, so start reading
+	 * directories of visible panes on worker threads while initialization goes
+	 * on.  File lists are built out of these listings on the first screen
+	 * update or right after it if they aren't ready by then. */
+	flist_prefetch(curr_view);
+	if(curr_stats.number_of_windows == 2 && !curr_stats.view)
+	{
+		flist_prefetch(other_view);
+	}
+
+	trace_begin("cs_load_pairs", NULL);
 	cs_load_pairs();
+	trace_end();
 	cs_write();
 	setup_signals();
 
-	/* Ensure trash directories exist, it might not have been called during
-	 * configuration file sourcing if there is no `set trashdir=...` command. */
-	(void)set_trash_dir(cfg.trash_dir);
-
 	check_path_for_file(&lwin, vifm_args.lwin_path, vifm_args.lwin_handle);
 	check_path_for_file(&rwin, vifm_args.rwin_path, vifm_args.rwin_handle);
 
@@ -328,20 +359,48 @@ vifm_main(int argc, char *argv[])
 	flist_hist_save(&rwin, NULL, NULL, -1);
 
 	/* Trigger auto-commands for initial directories. */
+	trace_begin("DirEnter", NULL);
 	(void)vifm_chdir(flist_get_dir(&lwin));
 	vle_aucmd_execute("DirEnter", flist_get_dir(&lwin), &lwin);
 	(void)vifm_chdir(flist_get_dir(&rwin));
 	vle_aucmd_execute("DirEnter", flist_get_dir(&rwin), &rwin);
+	trace_end();
 
 	update_screen(UT_FULL);
 	modes_update();
 
+	/* File lists that weren't ready for the first frame are loaded now, other
+	 * listings that weren't consumed by the update are of no use anymore. */
+	flist_prefetch_finish(&lwin);
+	flist_prefetch_finish(&rwin);
+
+	/* Ensure trash directories exist, it might not have been called during
+	 * configuration file sourcing if there is no `set trashdir=...` command.
+	 * This is done after the first draw as it might need to create
+	 * directories. */
+	trace_begin("set_trash_dir", cfg.trash_dir);
+	(void)set_trash_dir(cfg.trash_dir);
+	trace_end();
+
 	/* Run startup commands after loading file lists into views, so that commands
 	 * like +1 work. */
+	trace_begin("startup_commands", NULL);
 	exec_startup_commands(&vifm_args);
+	trace_end();
 
 	curr_stats.load_stage = 3;
 
+	/* Quick view isn't drawn until now as viewers might be slow and shouldn't
+	 * delay the first frame. */
+	if(curr_stats.view)
+	{
+		qv_draw(curr_view);
+		update_all_windows();
+	}
+
+	trace_end();
+	finish_startup_profile();
+
 	event_loop(&quit);
 
 	return 0;
@@ -366,28 +425,6 @@ pair_in_use(short int pair)
 	return 0;
 }
 
-/* Substitutes old pair number with the new one. */
-static void
-move_pair(short int from, short int to)
-{
-	int i;
-	for(i = 0; i < MAXNUM_COLOR; ++i)
-	{
-		if(cfg.cs.pair[i] == from)
-		{
-			cfg.cs.pair[i] = to;
-		}
-		if(lwin.cs.pair[i] == from)
-		{
-			lwin.cs.pair[i] = to;
-		}
-		if(rwin.cs.pair[i] == from)
-		{
-			rwin.cs.pair[i] = to;
-		}
-	}
-}
-
 /* perform_operation() interface adaptor for the undo unit. */
 static int
 undo_perform_func(OPS op, void *data, const char src[], const char dst[])
@@ -629,6 +666,25 @@ exec_startup_commands(const args_t *args)
 	}
 }
 
+/* Writes out profile of startup if it was requested and wasn't replaced by
+ * :profile command. */
+static void
+finish_startup_profile(void)
+{
+	const char *const path = trace_get_path();
+	if(path == NULL || vifm_args.startup_profile[0] == '\0' ||
+			strcmp(path, vifm_args.startup_profile) != 0)
+	{
+		return;
+	}
+
+	if(trace_finish() != 0)
+	{
+		show_error_msgf("Profiling", "Failed to write startup profile to %s",
+				vifm_args.startup_profile);
+	}
+}
+
 void
 vifm_try_leave(int write_info, int cquit, int force)
 {
@@ -648,6 +704,12 @@ vifm_try_leave(int write_info, int cquit, int force)
 		write_info_file();
 	}
 
+	/* Don't lose profile that wasn't explicitly finished. */
+	if(trace_is_active())
+	{
+		(void)trace_finish();
+	}
+
 	if(stats_file_choose_action_set())
 	{
 		vim_write_empty_file_list();
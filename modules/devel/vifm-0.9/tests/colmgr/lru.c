@@ -0,0 +1,75 @@
+#include <stic.h>
+
+#include "../../src/ui/color_manager.h"
+
+#include "test.h"
+
+static void fill_all_pairs(int fg, int pairs[]);
+
+SETUP()
+{
+	colmgr_reset();
+}
+
+TEST(least_recently_used_pair_is_reused)
+{
+	int pairs[CUSTOM_COLOR_PAIRS];
+	fill_all_pairs(UNUSED_SEED, pairs);
+
+	assert_int_equal(pairs[0], colmgr_get_pair(UNUSED_SEED, 0));
+
+	assert_int_equal(pairs[1], colmgr_get_pair(INUSE_SEED, 0));
+	assert_int_equal(pairs[2], colmgr_get_pair(INUSE_SEED, 1));
+}
+
+TEST(reused_pair_is_forgotten)
+{
+	int pairs[CUSTOM_COLOR_PAIRS];
+	fill_all_pairs(UNUSED_SEED, pairs);
+
+	assert_int_equal(pairs[0], colmgr_get_pair(INUSE_SEED, 0));
+	assert_int_equal(pairs[1], colmgr_get_pair(UNUSED_SEED, 0));
+	assert_int_equal(pairs[1], colmgr_get_pair(UNUSED_SEED, 0));
+}
+
+TEST(pairs_in_use_are_not_reused)
+{
+	int pairs[CUSTOM_COLOR_PAIRS];
+	fill_all_pairs(INUSE_SEED, pairs);
+
+	assert_int_equal(0, colmgr_get_pair(UNUSED_SEED, 0));
+	assert_int_equal(pairs[0], colmgr_get_pair(INUSE_SEED, 0));
+}
+
+TEST(lookups_in_full_table_find_pairs_and_update_their_order)
+{
+	int pairs[CUSTOM_COLOR_PAIRS];
+	int i;
+
+	fill_all_pairs(UNUSED_SEED, pairs);
+
+	for(i = CUSTOM_COLOR_PAIRS - 1; i >= 0; --i)
+	{
+		assert_int_equal(pairs[i], colmgr_get_pair(UNUSED_SEED, i));
+	}
+
+	assert_int_equal(pairs[CUSTOM_COLOR_PAIRS - 1],
+			colmgr_get_pair(INUSE_SEED, 0));
+	assert_int_equal(pairs[CUSTOM_COLOR_PAIRS - 2],
+			colmgr_get_pair(INUSE_SEED, 1));
+}
+
+/* Allocates all pairs with the foreground color and different backgrounds. */
+static void
+fill_all_pairs(int fg, int pairs[])
+{
+	int i;
+	for(i = 0; i < CUSTOM_COLOR_PAIRS; ++i)
+	{
+		pairs[i] = colmgr_get_pair(fg, i);
+		assert_true(pairs[i] != 0);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
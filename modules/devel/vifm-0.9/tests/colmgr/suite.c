@@ -6,9 +6,7 @@
 #include "test.h"
 
 static int init_pair(short pair, short f, short b);
-static int pair_content(short pair, short *f, short *b);
 static int pair_in_use(short int pair);
-static void move_pair(short int from, short int to);
 
 static int colors[TOTAL_COLOR_PAIRS][2];
 
@@ -26,9 +24,7 @@ SETUP_ONCE()
 		.max_color_pairs = ARRAY_LEN(colors),
 		.max_colors = 8,
 		.init_pair = &init_pair,
-		.pair_content = &pair_content,
 		.pair_in_use = &pair_in_use,
-		.move_pair = &move_pair,
 	};
 	colmgr_init(&colmgr_conf);
 }
@@ -41,28 +37,11 @@ init_pair(short pair, short f, short b)
 	return 0;
 }
 
-static int
-pair_content(short pair, short *f, short *b)
-{
-	*f = colors[pair][0];
-	*b = colors[pair][1];
-	return 0;
-}
-
 static int
 pair_in_use(short int pair)
 {
 	return colors[pair][0] == INUSE_SEED;
 }
 
-static void
-move_pair(short int from, short int to)
-{
-	colors[to][0] = colors[from][0];
-	colors[to][1] = colors[from][1];
-
-	colors[from][0] = UNUSED_SEED;
-}
-
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,128 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+
+#include "../../src/engine/cmds.h"
+
+static int args_cmd(const cmd_info_t *cmd_info);
+
+extern cmds_conf_t cmds_conf;
+extern cmd_info_t user_cmd_info;
+
+static int args_argc;
+static char args_argv[2][16];
+static int args_bg;
+
+SETUP()
+{
+	static const cmd_add_t args = {
+	  .name = "args",       .abbr = NULL,  .id = -1,            .descr = "descr",
+	  .flags = HAS_BG_FLAG | HAS_QUOTED_ARGS,
+	  .handler = &args_cmd, .min_args = 0, .max_args = NOT_DEF,
+	};
+
+	add_builtin_commands(&args, 1);
+}
+
+TEST(arguments_are_the_same_on_repeated_execution)
+{
+	int i;
+	for(i = 0; i < 3; ++i)
+	{
+		args_argc = 0;
+		args_bg = 0;
+		assert_success(execute_cmd("args 'a b' c &"));
+		assert_int_equal(2, args_argc);
+		assert_string_equal("a b", args_argv[0]);
+		assert_string_equal("c", args_argv[1]);
+		assert_true(args_bg);
+	}
+}
+
+TEST(invalid_arguments_are_reported_on_repeated_execution)
+{
+	assert_int_equal(CMDS_ERR_INVALID_ARG, execute_cmd("args 'a"));
+	assert_int_equal(CMDS_ERR_INVALID_ARG, execute_cmd("args 'a"));
+}
+
+TEST(range_is_evaluated_on_every_execution)
+{
+	assert_success(execute_cmd("command udf a"));
+
+	cmds_conf.begin = 5;
+	cmds_conf.current = 55;
+	cmds_conf.end = 550;
+	assert_success(execute_cmd("%udf"));
+	assert_int_equal(5, user_cmd_info.begin);
+	assert_int_equal(550, user_cmd_info.end);
+
+	cmds_conf.begin = 10;
+	cmds_conf.current = 50;
+	cmds_conf.end = 100;
+	assert_success(execute_cmd("%udf"));
+	assert_int_equal(10, user_cmd_info.begin);
+	assert_int_equal(100, user_cmd_info.end);
+}
+
+TEST(redefinition_of_user_command_is_picked_up)
+{
+	assert_success(execute_cmd("command udf a"));
+	assert_success(execute_cmd("udf"));
+	assert_string_equal("a", user_cmd_info.cmd);
+
+	assert_success(execute_cmd("command! udf b"));
+	assert_success(execute_cmd("udf"));
+	assert_string_equal("b", user_cmd_info.cmd);
+}
+
+TEST(removed_user_command_is_not_executed)
+{
+	assert_success(execute_cmd("command udf a"));
+	assert_success(execute_cmd("udf"));
+
+	assert_success(execute_cmd("delcommand udf"));
+	assert_int_equal(CMDS_ERR_INVALID_CMD, execute_cmd("udf"));
+
+	assert_success(execute_cmd("command udf a"));
+	assert_success(execute_cmd("udf"));
+
+	assert_success(execute_cmd("comclear"));
+	assert_int_equal(CMDS_ERR_INVALID_CMD, execute_cmd("udf"));
+}
+
+TEST(new_command_with_exact_name_takes_precedence)
+{
+	assert_success(execute_cmd("command udfa a"));
+	assert_success(execute_cmd("udf"));
+	assert_string_equal("a", user_cmd_info.cmd);
+
+	assert_success(execute_cmd("command udf b"));
+	assert_success(execute_cmd("udf"));
+	assert_string_equal("b", user_cmd_info.cmd);
+}
+
+TEST(ambiguity_is_detected_after_new_command_is_added)
+{
+	assert_success(execute_cmd("command udfa a"));
+	assert_success(execute_cmd("udf"));
+
+	assert_success(execute_cmd("command udfb b"));
+	assert_int_equal(CMDS_ERR_UDF_IS_AMBIGUOUS, execute_cmd("udf"));
+}
+
+static int
+args_cmd(const cmd_info_t *cmd_info)
+{
+	int i;
+
+	args_argc = cmd_info->argc;
+	args_bg = cmd_info->bg;
+	for(i = 0; i < cmd_info->argc && i < 2; ++i)
+	{
+		snprintf(args_argv[i], sizeof(args_argv[i]), "%s", cmd_info->argv[i]);
+	}
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
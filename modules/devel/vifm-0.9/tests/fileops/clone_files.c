@@ -2,6 +2,8 @@
 
 #include <unistd.h> /* chdir() symlink() unlink() */
 
+#include <limits.h> /* INT_MAX */
+
 #include "../../src/cfg/config.h"
 #include "../../src/utils/fs.h"
 #include "../../src/filelist.h"
@@ -64,7 +66,7 @@ TEST(files_are_cloned_according_to_tree_structure)
 
 	/* Clone at the top level. */
 
-	flist_load_tree(&lwin, ".");
+	flist_load_tree(&lwin, ".", INT_MAX);
 	lwin.list_pos = 0;
 
 	lwin.dir_entry[0].marked = 1;
@@ -75,7 +77,7 @@ TEST(files_are_cloned_according_to_tree_structure)
 
 	/* Clone at nested level. */
 
-	flist_load_tree(&lwin, ".");
+	flist_load_tree(&lwin, ".", INT_MAX);
 	lwin.list_pos = 0;
 
 	lwin.dir_entry[0].marked = 0;
@@ -85,7 +87,7 @@ TEST(files_are_cloned_according_to_tree_structure)
 
 	/* Clone at both levels. */
 
-	flist_load_tree(&lwin, ".");
+	flist_load_tree(&lwin, ".", INT_MAX);
 	lwin.list_pos = 0;
 
 	lwin.dir_entry[0].marked = 1;
@@ -97,7 +99,7 @@ TEST(files_are_cloned_according_to_tree_structure)
 
 	/* Cloning same file twice. */
 
-	flist_load_tree(&lwin, ".");
+	flist_load_tree(&lwin, ".", INT_MAX);
 	lwin.list_pos = 0;
 	lwin.dir_entry[1].marked = 1;
 	assert_string_equal("a", lwin.dir_entry[1].name);
@@ -144,7 +146,7 @@ TEST(cloning_of_broken_symlink, IF(not_windows))
 	assert_success(symlink("no-such-file", "broken-link"));
 #endif
 
-	flist_load_tree(&lwin, ".");
+	flist_load_tree(&lwin, ".", INT_MAX);
 
 	/* Without specifying new name. */
 	lwin.dir_entry[0].marked = 1;
@@ -1,18 +1,120 @@
 #include <stic.h>
 
+#ifndef _WIN32
+#include <sys/wait.h> /* WEXITSTATUS() waitpid() */
+#endif
+#include <unistd.h> /* usleep() */
+
+#include <stddef.h> /* NULL */
+
 #include "../../src/cfg/config.h"
+#include "../../src/compat/pthread.h"
 #include "../../src/utils/cancellation.h"
 #include "../../src/utils/str.h"
 #include "../../src/background.h"
 
 #include "utils.h"
 
-TEST(background_redirects_streams_properly, IF(not_windows))
+/* Maximum number of checks of a job's state before giving up waiting for it,
+ * checks are done once a millisecond. */
+#define MAX_WAIT_CHECKS 5000
+
+static void wait_for_job(bg_job_t *job);
+static int job_is_in_use(bg_job_t *job);
+static void nop_task(bg_op_t *bg_op, void *arg);
+
+SETUP_ONCE()
+{
+	bg_init();
+}
+
+SETUP()
 {
 	update_string(&cfg.shell, "/bin/sh");
-	assert_success(bg_and_wait_for_errors("echo a", &no_cancellation));
+}
+
+TEARDOWN()
+{
 	update_string(&cfg.shell, NULL);
 }
 
+TEST(background_redirects_streams_properly, IF(not_windows))
+{
+	assert_success(bg_and_wait_for_errors("echo a", &no_cancellation));
+}
+
+TEST(errors_of_external_commands_are_collected, IF(not_windows))
+{
+	bg_job_t *job;
+
+	assert_success(bg_run_external("echo err 1>&2", 1));
+	job = bg_jobs;
+	assert_non_null(job);
+
+	wait_for_job(job);
+	assert_string_equal("err\n", job->errors);
+
+	bg_check();
+	assert_null(bg_jobs);
+}
+
+TEST(finished_tasks_are_removed, IF(not_windows))
+{
+	int i;
+
+	assert_success(bg_execute("task", "", BG_UNDEFINED_TOTAL, 0, &nop_task,
+				NULL));
+	assert_non_null(bg_jobs);
+
+	for(i = 0; i < MAX_WAIT_CHECKS && bg_job_is_running(bg_jobs); ++i)
+	{
+		usleep(1000);
+	}
+	assert_false(bg_job_is_running(bg_jobs));
+
+	bg_check();
+	assert_null(bg_jobs);
+}
+
+/* Waits for process of the job to finish and for its error stream to be
+ * processed. */
+static void
+wait_for_job(bg_job_t *job)
+{
+#ifndef _WIN32
+	int status;
+	int i;
+
+	/* There is no SIGCHLD handler in tests, so report process exit manually the
+	 * same way it's done by the handler. */
+	assert_int_equal(job->pid, waitpid(job->pid, &status, 0));
+	bg_process_finished_cb(job->pid, WEXITSTATUS(status));
+
+	for(i = 0; i < MAX_WAIT_CHECKS && job_is_in_use(job); ++i)
+	{
+		usleep(1000);
+	}
+	assert_false(job_is_in_use(job));
+#endif
+}
+
+/* Checks whether error stream of the job is still being processed.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+job_is_in_use(bg_job_t *job)
+{
+	int in_use;
+	pthread_spin_lock(&job->status_lock);
+	in_use = job->in_use;
+	pthread_spin_unlock(&job->status_lock);
+	return in_use;
+}
+
+/* Background task that does nothing. */
+static void
+nop_task(bg_op_t *bg_op, void *arg)
+{
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
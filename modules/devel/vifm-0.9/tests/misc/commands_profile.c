@@ -0,0 +1,74 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/trace.h"
+#include "../../src/cmd_core.h"
+
+#include "utils.h"
+
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &lwin;
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+
+	init_commands();
+}
+
+TEARDOWN()
+{
+	trace_stop();
+
+	view_teardown(&lwin);
+
+	reset_cmds();
+}
+
+TEST(profile_requires_valid_arguments)
+{
+	assert_failure(exec_commands("profile", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("profile begin", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("profile start", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("profile stop file", &lwin, CIT_COMMAND));
+	assert_false(trace_is_active());
+}
+
+TEST(profile_stop_fails_if_not_started)
+{
+	assert_failure(exec_commands("profile stop", &lwin, CIT_COMMAND));
+}
+
+TEST(profile_path_is_relative_to_current_directory)
+{
+	char path[PATH_MAX + 1];
+	make_abs_path(path, sizeof(path), SANDBOX_PATH, "profile.json", cwd);
+
+	assert_success(exec_commands("profile start profile.json", &lwin,
+				CIT_COMMAND));
+	assert_true(trace_is_active());
+	assert_string_equal(path, trace_get_path());
+
+	/* Message about written profile is reported as a failure to keep it on the
+	 * screen. */
+	(void)exec_commands("profile stop", &lwin, CIT_COMMAND);
+	assert_false(trace_is_active());
+
+	assert_success(unlink(path));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
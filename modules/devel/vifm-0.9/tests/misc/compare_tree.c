@@ -0,0 +1,83 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strcpy() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/path.h"
+#include "../../src/compare.h"
+#include "../../src/filelist.h"
+
+#include "utils.h"
+
+static void check_entry(int i, const char name[], const char dir[]);
+
+SETUP()
+{
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	opt_handlers_setup();
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	opt_handlers_teardown();
+}
+
+TEST(files_of_subdirectories_go_first_in_sorted_order)
+{
+	lwin.hide_dot = 0;
+	strcpy(lwin.curr_dir, TEST_DATA_PATH "/tree");
+	compare_one_pane(&lwin, CT_NAME, LT_ALL, 0);
+
+	assert_int_equal(CV_COMPARE, lwin.custom.type);
+	assert_int_equal(7, lwin.list_rows);
+	check_entry(0, "file1", "/dir1/dir2/dir3");
+	check_entry(1, "file2", "/dir1/dir2/dir3");
+	check_entry(2, "file3", "/dir1/dir2/dir4");
+	check_entry(3, "file4", "/dir1");
+	check_entry(4, ".nested_hidden", "/dir5");
+	check_entry(5, "file5", "/dir5");
+	check_entry(6, ".hidden", "");
+}
+
+TEST(dot_directories_are_not_traversed)
+{
+	lwin.hide_dot = 1;
+	strcpy(lwin.curr_dir, TEST_DATA_PATH "/tree");
+	compare_one_pane(&lwin, CT_NAME, LT_ALL, 0);
+
+	assert_int_equal(5, lwin.list_rows);
+	check_entry(3, "file4", "/dir1");
+	check_entry(4, "file5", "/dir5");
+}
+
+TEST(comparison_of_missing_directory_does_nothing)
+{
+	strcpy(lwin.curr_dir, SANDBOX_PATH "/no-such-dir");
+	compare_one_pane(&lwin, CT_NAME, LT_ALL, 0);
+	assert_false(flist_custom_active(&lwin));
+}
+
+static void
+check_entry(int i, const char name[], const char dir[])
+{
+	char expected_origin[PATH_MAX];
+	snprintf(expected_origin, sizeof(expected_origin), "%s/tree%s",
+			TEST_DATA_PATH, dir);
+
+	assert_string_equal(name, lwin.dir_entry[i].name);
+	assert_true(paths_are_equal(expected_origin, lwin.dir_entry[i].origin));
+	assert_int_equal(i + 1, lwin.dir_entry[i].id);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
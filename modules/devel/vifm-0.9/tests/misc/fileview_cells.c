@@ -0,0 +1,140 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() */
+
+#include <string.h> /* strcpy() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/column_view.h"
+#include "../../src/ui/fileview.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/status.h"
+#include "utils.h"
+
+static void column_line_print(const void *data, int column_id, const char buf[],
+		size_t offset, AlignType align, const char full_column[]);
+
+static char *saved_cwd;
+static char time_text[128];
+
+SETUP()
+{
+	saved_cwd = save_cwd();
+
+	view_setup(&lwin);
+	columns_set_line_print_func(&column_line_print);
+	lwin.columns = columns_create();
+	lwin.window_rows = 9;
+	lwin.window_width = 40;
+
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	assert_success(chdir(TEST_DATA_PATH "/existing-files"));
+	assert_non_null(get_cwd(lwin.curr_dir, sizeof(lwin.curr_dir)));
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(3, lwin.list_rows);
+
+	curr_stats.load_stage = 2;
+	draw_dir_list_only(&lwin);
+}
+
+TEARDOWN()
+{
+	curr_stats.load_stage = 0;
+
+	fview_reset_cells(&lwin);
+	view_teardown(&lwin);
+	columns_free(lwin.columns);
+	lwin.columns = NULL;
+	columns_set_line_print_func(NULL);
+
+	restore_cwd(saved_cwd);
+}
+
+TEST(all_cells_are_drawn_initially)
+{
+	assert_int_equal(3, lwin.cells_redrawn);
+}
+
+TEST(unchanged_cells_are_not_redrawn)
+{
+	draw_dir_list_only(&lwin);
+	assert_int_equal(0, lwin.cells_redrawn);
+}
+
+TEST(selection_change_redraws_only_its_cell)
+{
+	lwin.dir_entry[1].selected = 1;
+	draw_dir_list_only(&lwin);
+	assert_int_equal(1, lwin.cells_redrawn);
+}
+
+TEST(cursor_movement_redraws_old_and_new_cells)
+{
+	lwin.list_pos = 2;
+	draw_dir_list_only(&lwin);
+	assert_int_equal(2, lwin.cells_redrawn);
+}
+
+TEST(renaming_entry_redraws_its_cell)
+{
+	fentry_rename(&lwin, &lwin.dir_entry[1], "renamed");
+	draw_dir_list_only(&lwin);
+	assert_int_equal(1, lwin.cells_redrawn);
+}
+
+TEST(reset_causes_redraw_of_all_cells)
+{
+	fview_reset_cells(&lwin);
+	draw_dir_list_only(&lwin);
+	assert_int_equal(3, lwin.cells_redrawn);
+}
+
+TEST(layout_change_causes_redraw_of_all_cells)
+{
+	lwin.window_width = 60;
+	draw_dir_list_only(&lwin);
+	assert_int_equal(3, lwin.cells_redrawn);
+}
+
+TEST(change_of_time_format_is_not_hidden_by_caching)
+{
+	static column_info_t info = {
+		.column_id = SK_BY_TIME_MODIFIED, .full_width = 0UL, .text_width = 0UL,
+		.align = AT_LEFT, .sizing = ST_AUTO, .cropping = CT_TRUNCATE,
+	};
+
+	fview_init();
+	columns_set_line_print_func(&column_line_print);
+	columns_add_column(lwin.columns, info);
+
+	update_string(&cfg.time_format, "+a");
+	fview_reset_cells(&lwin);
+	draw_dir_list_only(&lwin);
+	assert_string_equal("+a", time_text);
+
+	update_string(&cfg.time_format, "+b");
+	fview_reset_cells(&lwin);
+	draw_dir_list_only(&lwin);
+	assert_string_equal("+b", time_text);
+
+	update_string(&cfg.time_format, NULL);
+	columns_clear_column_descs();
+}
+
+static void
+column_line_print(const void *data, int column_id, const char buf[],
+		size_t offset, AlignType align, const char full_column[])
+{
+	if(column_id == SK_BY_TIME_MODIFIED)
+	{
+		strcpy(time_text, full_column);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
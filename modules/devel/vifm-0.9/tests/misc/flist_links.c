@@ -0,0 +1,111 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() symlink() */
+
+#include <stdio.h> /* remove() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+#include "utils.h"
+
+static char *saved_cwd;
+
+SETUP()
+{
+	saved_cwd = save_cwd();
+	update_string(&cfg.slow_fs_list, "");
+	update_string(&cfg.fuse_home, "no");
+
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	assert_success(chdir(SANDBOX_PATH));
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+
+	create_file(SANDBOX_PATH "/target");
+#ifndef _WIN32
+	assert_success(symlink("target", SANDBOX_PATH "/good"));
+	assert_success(symlink("missing", SANDBOX_PATH "/bad"));
+#endif
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+	update_string(&cfg.slow_fs_list, NULL);
+	update_string(&cfg.fuse_home, NULL);
+
+	(void)remove(SANDBOX_PATH "/target");
+	assert_success(remove(SANDBOX_PATH "/good"));
+	assert_success(remove(SANDBOX_PATH "/bad"));
+
+	restore_cwd(saved_cwd);
+}
+
+TEST(state_of_links_is_determined_on_loading, IF(not_windows))
+{
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(3, lwin.list_rows);
+
+	assert_string_equal("bad", lwin.dir_entry[0].name);
+	assert_true(lwin.dir_entry[0].broken_link);
+	assert_string_equal("good", lwin.dir_entry[1].name);
+	assert_false(lwin.dir_entry[1].broken_link);
+	assert_string_equal("target", lwin.dir_entry[2].name);
+	assert_false(lwin.dir_entry[2].broken_link);
+}
+
+TEST(state_of_links_is_updated_on_reload, IF(not_windows))
+{
+	populate_dir_list(&lwin, 0);
+	assert_false(lwin.dir_entry[1].broken_link);
+
+	assert_success(remove(SANDBOX_PATH "/target"));
+	populate_dir_list(&lwin, 1);
+	assert_int_equal(2, lwin.list_rows);
+	assert_true(lwin.dir_entry[0].broken_link);
+	assert_true(lwin.dir_entry[1].broken_link);
+}
+
+TEST(links_are_not_marked_broken_in_view_on_slow_fs, IF(not_windows))
+{
+	populate_dir_list(&lwin, 0);
+	assert_true(lwin.dir_entry[0].broken_link);
+
+	lwin.on_slow_fs = 1;
+	populate_dir_list(&lwin, 1);
+	assert_string_equal("bad", lwin.dir_entry[0].name);
+	assert_false(lwin.dir_entry[0].broken_link);
+
+	lwin.on_slow_fs = 0;
+}
+
+TEST(state_of_links_in_custom_view_does_not_depend_on_cwd, IF(not_windows))
+{
+	assert_success(chdir(TEST_DATA_PATH));
+
+	opt_handlers_setup();
+
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, SANDBOX_PATH "/bad");
+	flist_custom_add(&lwin, SANDBOX_PATH "/good");
+	assert_success(flist_custom_finish(&lwin, CV_VERY, 0));
+	assert_int_equal(2, lwin.list_rows);
+
+	assert_string_equal("bad", lwin.dir_entry[0].name);
+	assert_true(lwin.dir_entry[0].broken_link);
+	assert_string_equal("good", lwin.dir_entry[1].name);
+	assert_false(lwin.dir_entry[1].broken_link);
+
+	opt_handlers_teardown();
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
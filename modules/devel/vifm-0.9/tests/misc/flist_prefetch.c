@@ -0,0 +1,186 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() */
+
+#include <stdio.h> /* FILE fclose() fopen() remove() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/fswatch.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+#include "utils.h"
+
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	update_string(&cfg.slow_fs_list, "");
+	update_string(&cfg.fuse_home, "no");
+	memset(&cfg.type_decs, '\0', sizeof(cfg.type_decs));
+
+	view_setup(&lwin);
+	lwin.hide_dot = 1;
+
+	curr_view = &lwin;
+	other_view = &lwin;
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), TEST_DATA_PATH, "tree",
+			cwd);
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+
+	update_string(&cfg.slow_fs_list, NULL);
+	update_string(&cfg.fuse_home, NULL);
+
+	assert_success(chdir(cwd));
+}
+
+TEST(prefetched_listing_is_used_and_filtered)
+{
+	flist_prefetch(&lwin);
+	assert_non_null(lwin.prefetch);
+
+	populate_dir_list(&lwin, 0);
+	assert_null(lwin.prefetch);
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+	assert_string_equal("dir1", lwin.dir_entry[0].name);
+	assert_int_equal(FT_DIR, lwin.dir_entry[0].type);
+	assert_string_equal("dir5", lwin.dir_entry[1].name);
+	assert_int_equal(FT_DIR, lwin.dir_entry[1].type);
+}
+
+TEST(prefetched_listing_matches_regular_one)
+{
+	int i;
+	char *names[3];
+
+	lwin.hide_dot = 0;
+
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(3, lwin.list_rows);
+	for(i = 0; i < 3; ++i)
+	{
+		names[i] = lwin.dir_entry[i].name;
+		lwin.dir_entry[i].name = NULL;
+	}
+
+	flist_prefetch(&lwin);
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(3, lwin.list_rows);
+	for(i = 0; i < 3; ++i)
+	{
+		assert_string_equal(names[i], lwin.dir_entry[i].name);
+		free(names[i]);
+	}
+}
+
+TEST(listing_of_another_directory_is_not_used)
+{
+	flist_prefetch(&lwin);
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), TEST_DATA_PATH,
+			"existing-files", cwd);
+
+	populate_dir_list(&lwin, 0);
+	assert_null(lwin.prefetch);
+
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("b", lwin.dir_entry[1].name);
+	assert_string_equal("c", lwin.dir_entry[2].name);
+}
+
+TEST(listing_is_used_only_by_the_next_load)
+{
+	flist_prefetch(&lwin);
+	lwin.curr_dir[0] = '\0';
+	populate_dir_list(&lwin, 0);
+	assert_null(lwin.prefetch);
+}
+
+TEST(unused_listing_can_be_discarded)
+{
+	flist_prefetch(&lwin);
+	flist_prefetch_discard(&lwin);
+	assert_null(lwin.prefetch);
+
+	flist_prefetch_discard(&lwin);
+	assert_null(lwin.prefetch);
+}
+
+TEST(postponed_load_is_performed_on_finish)
+{
+	flist_prefetch(&lwin);
+	lwin.load_postponed = 1;
+	lwin.postponed_load_reload = 0;
+
+	flist_prefetch_finish(&lwin);
+	assert_null(lwin.prefetch);
+	assert_false(lwin.load_postponed);
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("dir1", lwin.dir_entry[0].name);
+	assert_string_equal("dir5", lwin.dir_entry[1].name);
+}
+
+TEST(unused_listing_is_discarded_on_finish)
+{
+	flist_prefetch(&lwin);
+	flist_prefetch_finish(&lwin);
+	assert_null(lwin.prefetch);
+	assert_int_equal(0, lwin.list_rows);
+}
+
+TEST(changes_made_while_reading_are_noticed)
+{
+	FILE *f;
+	int error;
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+
+	flist_prefetch(&lwin);
+	f = fopen(SANDBOX_PATH "/file", "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+	populate_dir_list(&lwin, 0);
+
+	assert_non_null(lwin.watch);
+	assert_true(fswatch_changed(lwin.watch, &error));
+	assert_false(error);
+
+	assert_success(remove(SANDBOX_PATH "/file"));
+}
+
+TEST(custom_views_are_not_prefetched)
+{
+	char path[PATH_MAX + 1];
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "existing-files/a", cwd);
+
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, path);
+	assert_success(flist_custom_finish(&lwin, CV_REGULAR, 0));
+
+	flist_prefetch(&lwin);
+	assert_null(lwin.prefetch);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -2,6 +2,7 @@
 
 #include <unistd.h> /* rmdir() symlink() */
 
+#include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* remove() */
 #include <string.h> /* memset() */
@@ -796,7 +797,7 @@ static int
 load_tree(FileView *view, const char path[])
 {
 	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), path, "", cwd);
-	return flist_load_tree(&lwin, lwin.curr_dir);
+	return flist_load_tree(&lwin, lwin.curr_dir, INT_MAX);
 }
 
 static void
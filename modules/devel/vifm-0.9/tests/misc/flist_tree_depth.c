@@ -0,0 +1,118 @@
+#include <stic.h>
+
+#include <limits.h> /* INT_MAX */
+#include <string.h> /* memset() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/column_view.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/cmd_core.h"
+#include "../../src/filelist.h"
+
+#include "utils.h"
+
+static void column_line_print(const void *data, int column_id, const char buf[],
+		size_t offset, AlignType align, const char full_column[]);
+
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	update_string(&cfg.fuse_home, "no");
+	update_string(&cfg.slow_fs_list, "");
+	memset(&cfg.type_decs, '\0', sizeof(cfg.type_decs));
+
+	view_setup(&lwin);
+	lwin.hide_dot = 1;
+
+	curr_view = &lwin;
+	other_view = &lwin;
+
+	columns_set_line_print_func(&column_line_print);
+	lwin.columns = columns_create();
+
+	init_commands();
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), TEST_DATA_PATH, "tree",
+			cwd);
+}
+
+TEARDOWN()
+{
+	reset_cmds();
+
+	update_string(&cfg.slow_fs_list, NULL);
+	update_string(&cfg.fuse_home, NULL);
+
+	view_teardown(&lwin);
+
+	columns_set_line_print_func(NULL);
+	columns_free(lwin.columns);
+	lwin.columns = NULL;
+}
+
+TEST(depth_of_one_lists_only_root)
+{
+	assert_success(flist_load_tree(&lwin, flist_get_dir(&lwin), 1));
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("dir1", lwin.dir_entry[0].name);
+	assert_int_equal(0, lwin.dir_entry[0].child_count);
+	assert_string_equal("dir5", lwin.dir_entry[1].name);
+	assert_int_equal(0, lwin.dir_entry[1].child_count);
+}
+
+TEST(depth_limits_number_of_levels)
+{
+	assert_success(flist_load_tree(&lwin, flist_get_dir(&lwin), 2));
+	assert_int_equal(5, lwin.list_rows);
+
+	assert_success(flist_load_tree(&lwin, flist_get_dir(&lwin), INT_MAX));
+	assert_int_equal(10, lwin.list_rows);
+}
+
+TEST(depth_is_preserved_on_reload)
+{
+	assert_success(flist_load_tree(&lwin, flist_get_dir(&lwin), 2));
+	assert_int_equal(5, lwin.list_rows);
+
+	load_dir_list(&lwin, 1);
+	assert_int_equal(5, lwin.list_rows);
+}
+
+TEST(tree_command_accepts_depth)
+{
+	assert_success(exec_commands("tree depth=1", &lwin, CIT_COMMAND));
+	assert_true(flist_custom_active(&lwin));
+	assert_int_equal(2, lwin.list_rows);
+
+	assert_success(exec_commands("tree", &lwin, CIT_COMMAND));
+	assert_int_equal(10, lwin.list_rows);
+}
+
+TEST(tree_command_rejects_invalid_depth)
+{
+	assert_failure(exec_commands("tree depth=0", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("tree depth=", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("tree depth=1x", &lwin, CIT_COMMAND));
+	assert_failure(exec_commands("tree level=1", &lwin, CIT_COMMAND));
+	assert_false(flist_custom_active(&lwin));
+}
+
+static void
+column_line_print(const void *data, int column_id, const char buf[],
+		size_t offset, AlignType align, const char full_column[])
+{
+	/* Do nothing. */
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
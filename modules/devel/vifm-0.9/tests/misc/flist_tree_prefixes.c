@@ -0,0 +1,165 @@
+#include <stic.h>
+
+#include <unistd.h> /* rmdir() */
+
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* remove() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strcat() strcpy() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/column_view.h"
+#include "../../src/ui/fileview.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+
+#include "utils.h"
+
+/* Number of nested directories in a deep tree, which is more than tree prefixes
+ * can describe. */
+#define DEEP_TREE_DEPTH 70
+
+static void check_prefixes(FileView *view);
+static int load_tree(FileView *view, const char path[]);
+static void column_line_print(const void *data, int column_id, const char buf[],
+		size_t offset, AlignType align, const char full_column[]);
+
+static char cwd[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+}
+
+SETUP()
+{
+	update_string(&cfg.fuse_home, "no");
+	update_string(&cfg.slow_fs_list, "");
+	memset(&cfg.type_decs, '\0', sizeof(cfg.type_decs));
+
+	view_setup(&lwin);
+	lwin.hide_dot = 1;
+
+	curr_view = &lwin;
+	other_view = &lwin;
+
+	columns_set_line_print_func(&column_line_print);
+
+	lwin.columns = columns_create();
+}
+
+TEARDOWN()
+{
+	update_string(&cfg.slow_fs_list, NULL);
+	update_string(&cfg.fuse_home, NULL);
+
+	view_teardown(&lwin);
+
+	columns_set_line_print_func(NULL);
+
+	columns_free(lwin.columns);
+	lwin.columns = NULL;
+}
+
+TEST(no_tree_prefixes_outside_of_tree)
+{
+	assert_null(get_tree_prefixes(&lwin, 0, lwin.list_rows));
+}
+
+TEST(tree_prefixes_match_the_ones_found_by_walking_tree)
+{
+	assert_success(load_tree(&lwin, TEST_DATA_PATH "/tree"));
+	assert_int_equal(10, lwin.list_rows);
+
+	check_prefixes(&lwin);
+}
+
+TEST(too_deep_nodes_are_left_without_prefixes)
+{
+	char path[PATH_MAX + 1];
+	tree_prefix_t *prefixes;
+	int i;
+
+	strcpy(path, SANDBOX_PATH);
+	for(i = 0; i < DEEP_TREE_DEPTH; ++i)
+	{
+		strcat(path, "/d");
+		assert_success(os_mkdir(path, 0700));
+	}
+	strcat(path, "/f");
+	create_file(path);
+
+	assert_success(load_tree(&lwin, SANDBOX_PATH));
+	assert_int_equal(DEEP_TREE_DEPTH + 1, lwin.list_rows);
+
+	prefixes = get_tree_prefixes(&lwin, 0, lwin.list_rows);
+	assert_non_null(prefixes);
+	assert_int_equal(64, prefixes[64].depth);
+	assert_int_equal(-1, prefixes[65].depth);
+	assert_int_equal(-1, prefixes[DEEP_TREE_DEPTH].depth);
+	free(prefixes);
+
+	check_prefixes(&lwin);
+
+	assert_success(remove(path));
+	for(i = 0; i < DEEP_TREE_DEPTH; ++i)
+	{
+		remove_last_path_component(path);
+		assert_success(rmdir(path));
+	}
+}
+
+/* Checks that precomputed prefixes are correct no matter where the computation
+ * starts. */
+static void
+check_prefixes(FileView *view)
+{
+	int top;
+	size_t prefix_len = 0U;
+	column_data_t cdt = { .view = view, .prefix_len = &prefix_len };
+
+	for(top = 0; top < view->list_rows; ++top)
+	{
+		int i;
+		tree_prefix_t *const prefixes = get_tree_prefixes(view, top,
+				view->list_rows - top);
+		assert_non_null(prefixes);
+
+		for(i = top; i < view->list_rows; ++i)
+		{
+			char walked[PATH_MAX + 1], precomputed[PATH_MAX + 1];
+
+			cdt.line_pos = i;
+			cdt.tree_prefix = NULL;
+			format_name(-1, &cdt, sizeof(walked), walked);
+			cdt.tree_prefix = &prefixes[i - top];
+			format_name(-1, &cdt, sizeof(precomputed), precomputed);
+			assert_string_equal(walked, precomputed);
+		}
+
+		free(prefixes);
+	}
+}
+
+static int
+load_tree(FileView *view, const char path[])
+{
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), path, "", cwd);
+	return flist_load_tree(view, view->curr_dir, INT_MAX);
+}
+
+static void
+column_line_print(const void *data, int column_id, const char buf[],
+		size_t offset, AlignType align, const char full_column[])
+{
+	/* Do nothing. */
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,181 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memmove() strcmp() */
+
+#include "../../src/cfg/hist.h"
+#include "../../src/utils/macros.h"
+
+#define SIZE 10U
+#define BIG_SIZE 100U
+
+static hist_t hist;
+
+SETUP()
+{
+	assert_success(hist_init(&hist, SIZE));
+}
+
+TEARDOWN()
+{
+	hist_reset(&hist, SIZE);
+}
+
+TEST(items_are_added_to_the_front)
+{
+	assert_success(hist_add(&hist, "a", SIZE));
+	assert_success(hist_add(&hist, "b", SIZE));
+
+	assert_int_equal(1, hist.pos);
+	assert_string_equal("b", hist.items[0]);
+	assert_string_equal("a", hist.items[1]);
+}
+
+TEST(empty_items_are_rejected)
+{
+	assert_success(hist_add(&hist, "", SIZE));
+	assert_true(hist_is_empty(&hist));
+	assert_false(hist_contains(&hist, ""));
+}
+
+TEST(duplicates_are_moved_to_the_front)
+{
+	assert_success(hist_add(&hist, "a", SIZE));
+	assert_success(hist_add(&hist, "b", SIZE));
+	assert_success(hist_add(&hist, "c", SIZE));
+	assert_success(hist_add(&hist, "a", SIZE));
+
+	assert_int_equal(2, hist.pos);
+	assert_string_equal("a", hist.items[0]);
+	assert_string_equal("c", hist.items[1]);
+	assert_string_equal("b", hist.items[2]);
+}
+
+TEST(oldest_item_is_dropped_when_full)
+{
+	char item[16];
+	unsigned int i;
+
+	for(i = 0U; i <= SIZE; ++i)
+	{
+		snprintf(item, sizeof(item), "%u", i);
+		assert_success(hist_add(&hist, item, SIZE));
+	}
+
+	assert_int_equal(SIZE - 1U, hist.pos);
+	assert_false(hist_contains(&hist, "0"));
+	assert_true(hist_contains(&hist, "1"));
+	assert_string_equal("1", hist.items[SIZE - 1U]);
+
+	/* Dropped item is inserted anew. */
+	assert_success(hist_add(&hist, "0", SIZE));
+	assert_string_equal("0", hist.items[0]);
+	assert_false(hist_contains(&hist, "1"));
+}
+
+TEST(truncation_removes_items_from_lookups)
+{
+	assert_success(hist_add(&hist, "a", SIZE));
+	assert_success(hist_add(&hist, "b", SIZE));
+	assert_success(hist_add(&hist, "c", SIZE));
+
+	hist_trunc(&hist, 1U, SIZE - 1U);
+
+	assert_int_equal(0, hist.pos);
+	assert_true(hist_contains(&hist, "c"));
+	assert_false(hist_contains(&hist, "b"));
+	assert_false(hist_contains(&hist, "a"));
+
+	assert_success(hist_add(&hist, "a", 1U));
+	assert_string_equal("a", hist.items[0]);
+	assert_false(hist_contains(&hist, "c"));
+
+	/* Truncated items are freed without clearing their slots. */
+	hist_reset(&hist, 1U);
+	assert_success(hist_init(&hist, SIZE));
+}
+
+TEST(reset_empties_history)
+{
+	assert_success(hist_add(&hist, "a", SIZE));
+	hist_reset(&hist, SIZE);
+
+	assert_true(hist_is_empty(&hist));
+	assert_false(hist_contains(&hist, "a"));
+
+	assert_success(hist_init(&hist, SIZE));
+}
+
+TEST(order_matches_plain_list_over_many_operations)
+{
+	/* Shadow list that is updated in an obvious way. */
+	char shadow[SIZE][16];
+	int len = 0;
+	unsigned int i;
+
+	for(i = 0U; i < 2000U; ++i)
+	{
+		char item[16];
+		int j;
+
+		snprintf(item, sizeof(item), "%u", (i*7919U)%37U);
+		assert_success(hist_add(&hist, item, SIZE));
+
+		for(j = 0; j < len; ++j)
+		{
+			if(strcmp(shadow[j], item) == 0)
+			{
+				break;
+			}
+		}
+		if(j == len)
+		{
+			len = MIN(len + 1, (int)SIZE);
+			j = len - 1;
+		}
+		memmove(shadow[1], shadow[0], sizeof(shadow[0])*j);
+		snprintf(shadow[0], sizeof(shadow[0]), "%s", item);
+
+		assert_int_equal(len - 1, hist.pos);
+		for(j = 0; j < len; ++j)
+		{
+			assert_string_equal(shadow[j], hist.items[j]);
+			assert_true(hist_contains(&hist, shadow[j]));
+		}
+	}
+}
+
+TEST(lookups_work_after_index_grows)
+{
+	hist_t big;
+	char item[16];
+	unsigned int i;
+
+	assert_success(hist_init(&big, BIG_SIZE));
+
+	for(i = 0U; i < BIG_SIZE; ++i)
+	{
+		snprintf(item, sizeof(item), "item %u", i);
+		assert_success(hist_add(&big, item, BIG_SIZE));
+	}
+
+	assert_success(hist_add(&big, "item 0", BIG_SIZE));
+	assert_string_equal("item 0", big.items[0]);
+	assert_string_equal("item 1", big.items[BIG_SIZE - 1U]);
+
+	assert_success(hist_add(&big, "new item", BIG_SIZE));
+	assert_int_equal(BIG_SIZE - 1U, big.pos);
+	assert_false(hist_contains(&big, "item 1"));
+	assert_true(hist_contains(&big, "new item"));
+
+	for(i = 2U; i < BIG_SIZE; ++i)
+	{
+		snprintf(item, sizeof(item), "item %u", i);
+		assert_true(hist_contains(&big, item));
+	}
+
+	hist_reset(&big, BIG_SIZE);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "../../src/cfg/config.h"
+#include "../../src/cfg/hist.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/str.h"
 #include "../../src/cmd_core.h"
@@ -193,5 +194,27 @@ TEST(history_size_reduction_leaves_correct_number_of_elements)
 	assert_int_equal(2, lwin.history[1].rel_pos);
 }
 
+TEST(unsaved_items_are_counted)
+{
+	cfg_save_search_history("a");
+	cfg_save_search_history("b");
+	hist_mark_saved(&cfg.search_hist);
+	assert_int_equal(0, cfg.search_hist.unsaved);
+
+	cfg_save_search_history("c");
+	assert_int_equal(1, cfg.search_hist.unsaved);
+
+	/* Moving saved item to the front makes it unsaved. */
+	cfg_save_search_history("a");
+	assert_int_equal(2, cfg.search_hist.unsaved);
+
+	/* Moving unsaved item doesn't change the count. */
+	cfg_save_search_history("c");
+	assert_int_equal(2, cfg.search_hist.unsaved);
+
+	cfg_resize_histories(1);
+	assert_int_equal(1, cfg.search_hist.unsaved);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,289 @@
+#include <stic.h>
+
+#ifndef _WIN32
+#include <sys/socket.h> /* AF_UNIX MSG_DONTWAIT SOCK_STREAM connect() recv()
+                           send() socket() */
+#include <sys/un.h> /* sockaddr_un */
+#endif
+#include <unistd.h> /* close() */
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint32_t */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memcpy() strlen() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/selector.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/ipc.h"
+
+#include "utils.h"
+
+static void args_callback(char *args[]);
+static strlist_t request_callback(char *request[]);
+static int server_is_running(void);
+static int connect_to_server(void);
+static void send_strings(int fd, char *strings[], int count);
+static void send_data(int fd, const void *data, size_t len);
+static strlist_t receive_reply(int fd);
+
+/* Copy of arguments passed to args_callback(). */
+static strlist_t received_args;
+
+SETUP_ONCE()
+{
+	ipc_init("vifm-tests", &args_callback, &request_callback);
+}
+
+TEARDOWN()
+{
+	free_string_array(received_args.items, received_args.nitems);
+	received_args.items = NULL;
+	received_args.nitems = 0;
+}
+
+TEST(requests_are_pipelined, IF(server_is_running))
+{
+	char *first[] = { "echo", "a", "b" };
+	char *second[] = { "echo", "" };
+	strlist_t reply;
+
+	const int fd = connect_to_server();
+	send_strings(fd, first, 3);
+	send_strings(fd, second, 2);
+
+	ipc_check();
+
+	reply = receive_reply(fd);
+	assert_int_equal(4, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("echo", reply.items[1]);
+	assert_string_equal("a", reply.items[2]);
+	assert_string_equal("b", reply.items[3]);
+	free_string_array(reply.items, reply.nitems);
+
+	reply = receive_reply(fd);
+	assert_int_equal(3, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("echo", reply.items[1]);
+	assert_string_equal("", reply.items[2]);
+	free_string_array(reply.items, reply.nitems);
+
+	close(fd);
+}
+
+TEST(partial_requests_are_buffered, IF(server_is_running))
+{
+#ifndef _WIN32
+	char buf[16];
+	const uint32_t size = sizeof("echo");
+	strlist_t reply;
+
+	const int fd = connect_to_server();
+	send_data(fd, &size, sizeof(size));
+	send_data(fd, "ec", 2U);
+
+	ipc_check();
+	assert_true(recv(fd, buf, sizeof(buf), MSG_DONTWAIT) < 0);
+
+	send_data(fd, "ho", 3U);
+	ipc_check();
+
+	reply = receive_reply(fd);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("echo", reply.items[1]);
+	free_string_array(reply.items, reply.nitems);
+
+	close(fd);
+#endif
+}
+
+TEST(empty_request_is_an_error, IF(server_is_running))
+{
+	strlist_t reply;
+
+	const int fd = connect_to_server();
+	send_strings(fd, NULL, 0);
+	ipc_check();
+
+	reply = receive_reply(fd);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("error", reply.items[0]);
+	assert_string_equal("Empty request", reply.items[1]);
+	free_string_array(reply.items, reply.nitems);
+
+	close(fd);
+}
+
+TEST(oversized_request_closes_connection, IF(server_is_running))
+{
+#ifndef _WIN32
+	char buf[16];
+	const uint32_t size = 0xffffffffU;
+
+	const int fd = connect_to_server();
+	send_data(fd, &size, sizeof(size));
+	ipc_check();
+
+	assert_int_equal(0, recv(fd, buf, sizeof(buf), 0));
+	close(fd);
+#endif
+}
+
+TEST(arguments_are_passed_with_cwd, IF(server_is_running))
+{
+	char cwd[PATH_MAX];
+	char *data[] = { "-c", "cmd", NULL };
+
+	assert_success(ipc_send(ipc_get_name(), data));
+	ipc_check();
+
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	assert_int_equal(4, received_args.nitems);
+	assert_string_equal(cwd, received_args.items[0]);
+	assert_string_equal("-c", received_args.items[1]);
+	assert_string_equal("cmd", received_args.items[2]);
+	assert_string_equal(NULL, received_args.items[3]);
+}
+
+TEST(request_to_missing_server_fails, IF(server_is_running))
+{
+	char *request[] = { "echo", NULL };
+	const strlist_t reply = ipc_request("vifm-tests-no-such-server", request);
+	assert_int_equal(0, reply.nitems);
+}
+
+TEST(connected_clients_need_periodic_checks, IF(server_is_running))
+{
+#ifndef _WIN32
+	int fd;
+	selector_t *const selector = selector_alloc(0);
+	assert_non_null(selector);
+
+	ipc_check();
+	assert_false(ipc_watch(selector));
+
+	fd = connect_to_server();
+	ipc_check();
+	assert_true(ipc_watch(selector));
+
+	close(fd);
+	ipc_check();
+	assert_false(ipc_watch(selector));
+
+	selector_free(selector);
+#endif
+}
+
+/* Remembers received arguments. */
+static void
+args_callback(char *args[])
+{
+	received_args.nitems = add_to_string_array(&received_args.items, 0, 1,
+			args[0]);
+	while(*++args != NULL)
+	{
+		received_args.nitems = add_to_string_array(&received_args.items,
+				received_args.nitems, 1, *args);
+	}
+	received_args.nitems = put_into_string_array(&received_args.items,
+			received_args.nitems, NULL);
+}
+
+/* Replies with the request itself.  Returns the reply. */
+static strlist_t
+request_callback(char *request[])
+{
+	strlist_t reply = {};
+	reply.nitems = add_to_string_array(&reply.items, 0, 1, "ok");
+	while(*request != NULL)
+	{
+		reply.nitems = add_to_string_array(&reply.items, reply.nitems, 1,
+				*request++);
+	}
+	return reply;
+}
+
+/* Checks whether server for tests is available.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+server_is_running(void)
+{
+	return not_windows() && ipc_enabled();
+}
+
+/* Connects to server of this process.  Returns connected socket. */
+static int
+connect_to_server(void)
+{
+#ifndef _WIN32
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert_true(fd >= 0);
+
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/vifm-ipc-%s",
+			get_tmpdir(), ipc_get_name());
+	assert_success(connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+/* Sends package made of the strings. */
+static void
+send_strings(int fd, char *strings[], int count)
+{
+	char payload[1024];
+	uint32_t size = 0U;
+	int i;
+
+	for(i = 0; i < count; ++i)
+	{
+		const size_t len = strlen(strings[i]) + 1U;
+		memcpy(payload + size, strings[i], len);
+		size += len;
+	}
+
+	send_data(fd, &size, sizeof(size));
+	send_data(fd, payload, size);
+}
+
+/* Sends data checking that all of it was sent. */
+static void
+send_data(int fd, const void *data, size_t len)
+{
+#ifndef _WIN32
+	assert_int_equal(len, send(fd, data, len, 0));
+#endif
+}
+
+/* Reads single reply.  Returns the reply. */
+static strlist_t
+receive_reply(int fd)
+{
+	strlist_t reply = {};
+#ifndef _WIN32
+	char payload[1024];
+	const char *p = payload;
+	uint32_t size;
+
+	assert_int_equal(sizeof(size), recv(fd, &size, sizeof(size), MSG_WAITALL));
+	assert_true(size <= sizeof(payload));
+	assert_int_equal(size, recv(fd, payload, size, MSG_WAITALL));
+
+	while(p < payload + size)
+	{
+		reply.nitems = add_to_string_array(&reply.items, reply.nitems, 1, p);
+		p += strlen(p) + 1U;
+	}
+#endif
+	return reply;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,210 @@
+#include <stic.h>
+
+#include <string.h> /* strcpy() strdup() */
+
+#include "../../src/engine/variables.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/env.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/cmd_core.h"
+#include "../../src/ipc_handlers.h"
+
+#include "utils.h"
+
+static void add_some_files_to_view(FileView *view);
+
+static strlist_t reply;
+
+SETUP()
+{
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	strcpy(lwin.curr_dir, "/path");
+
+	init_commands();
+	init_variables();
+}
+
+TEARDOWN()
+{
+	free_string_array(reply.items, reply.nitems);
+	reply.items = NULL;
+	reply.nitems = 0;
+
+	env_remove("IPC_A");
+	env_remove("IPC_B");
+
+	clear_variables();
+	reset_cmds();
+
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+}
+
+TEST(commands_of_a_batch_are_executed_in_order)
+{
+	char *request[] = { "cmd", "let $IPC_A = 'x'", "let $IPC_B = $IPC_A . 'y'",
+	                    NULL };
+	char *query[] = { "expr", "$IPC_B", NULL };
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(1, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	free_string_array(reply.items, reply.nitems);
+
+	reply = ipc_handle_request(query);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("xy", reply.items[1]);
+}
+
+TEST(batch_stops_at_first_failed_command)
+{
+	char *request[] = { "cmd", "let $IPC_A = 1", "nosuchcmd", "let $IPC_B = 2",
+	                    NULL };
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("error", reply.items[0]);
+	assert_string_equal("nosuchcmd: Invalid command name", reply.items[1]);
+
+	assert_string_equal("1", env_get("IPC_A"));
+	assert_null(env_get("IPC_B"));
+}
+
+TEST(all_expressions_are_evaluated)
+{
+	char *request[] = { "expr", "'a' . 'b'", "'c'", "''", NULL };
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(4, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("ab", reply.items[1]);
+	assert_string_equal("c", reply.items[2]);
+	assert_string_equal("", reply.items[3]);
+}
+
+TEST(invalid_expression_is_reported)
+{
+	char *request[] = { "expr", "'a'", "'b' .", NULL };
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("error", reply.items[0]);
+	assert_string_equal("Invalid expression: 'b' .", reply.items[1]);
+}
+
+TEST(empty_expression_is_an_error)
+{
+	char *request[] = { "expr", "", NULL };
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("error", reply.items[0]);
+}
+
+TEST(cwd_is_queried)
+{
+	char *request[] = { "query", "cwd", NULL };
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("/path", reply.items[1]);
+}
+
+TEST(current_file_is_queried)
+{
+	char *request[] = { "query", "current", NULL };
+
+	add_some_files_to_view(&lwin);
+	lwin.list_pos = 1;
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("/path/b", reply.items[1]);
+}
+
+TEST(selection_is_queried)
+{
+	char *request[] = { "query", "selection", NULL };
+
+	add_some_files_to_view(&lwin);
+	lwin.dir_entry[0].selected = 1;
+	lwin.dir_entry[2].selected = 1;
+	lwin.selected_files = 2;
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(3, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("/path/a", reply.items[1]);
+	assert_string_equal("/path/c", reply.items[2]);
+}
+
+TEST(list_is_queried_without_parent_dir)
+{
+	char *request[] = { "query", "list", NULL };
+
+	add_some_files_to_view(&lwin);
+	replace_string(&lwin.dir_entry[0].name, "..");
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(3, reply.nitems);
+	assert_string_equal("ok", reply.items[0]);
+	assert_string_equal("/path/b", reply.items[1]);
+	assert_string_equal("/path/c", reply.items[2]);
+}
+
+TEST(wrong_queries_are_errors)
+{
+	char *unknown[] = { "query", "something", NULL };
+	char *no_args[] = { "query", NULL };
+	char *many_args[] = { "query", "cwd", "list", NULL };
+
+	reply = ipc_handle_request(unknown);
+	assert_string_equal("error", reply.items[0]);
+	free_string_array(reply.items, reply.nitems);
+
+	reply = ipc_handle_request(no_args);
+	assert_string_equal("error", reply.items[0]);
+	free_string_array(reply.items, reply.nitems);
+
+	reply = ipc_handle_request(many_args);
+	assert_string_equal("error", reply.items[0]);
+}
+
+TEST(unknown_request_is_an_error)
+{
+	char *request[] = { "something", NULL };
+
+	reply = ipc_handle_request(request);
+	assert_int_equal(2, reply.nitems);
+	assert_string_equal("error", reply.items[0]);
+	assert_string_equal("Unknown request", reply.items[1]);
+}
+
+static void
+add_some_files_to_view(FileView *view)
+{
+	view->list_rows = 3;
+	view->list_pos = 0;
+	view->dir_entry = dynarray_cextend(NULL,
+			view->list_rows*sizeof(*view->dir_entry));
+	view->dir_entry[0].name = strdup("a");
+	view->dir_entry[0].origin = &view->curr_dir[0];
+	view->dir_entry[1].name = strdup("b");
+	view->dir_entry[1].origin = &view->curr_dir[0];
+	view->dir_entry[2].name = strdup("c");
+	view->dir_entry[2].origin = &view->curr_dir[0];
+	view->selected_files = 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
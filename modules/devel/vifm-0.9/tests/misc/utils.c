@@ -159,6 +159,8 @@ view_teardown(FileView *view)
 
 	fswatch_free(view->watch);
 	view->watch = NULL;
+
+	flist_prefetch_discard(view);
 }
 
 void
@@ -1,8 +1,10 @@
 #include <stic.h>
 
+#include <sys/types.h> /* utimbuf */
 #include <unistd.h> /* rmdir() symlink() */
+#include <utime.h> /* utime() */
 
-#include <stdio.h> /* remove() */
+#include <stdio.h> /* remove() snprintf() */
 
 #include "../../src/compat/os.h"
 #include "../../src/ui/quickview.h"
@@ -192,6 +194,98 @@ TEST(multiple_non_empty_dirs_have_correct_prefixes_plus_sorting)
 	assert_success(rmdir("dir"));
 }
 
+TEST(entries_of_huge_nested_dirs_are_omitted)
+{
+	int i;
+	int nlines;
+	FILE *fp;
+	char **lines;
+
+	assert_success(os_mkdir("dir", 0777));
+	assert_success(os_mkdir("dir/nested", 0777));
+	for(i = 0; i < 300; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "dir/nested/%03d", i);
+		create_file(name);
+	}
+
+	fp = qv_view_dir("dir");
+	lines = read_file_lines(fp, &nlines);
+
+	assert_int_equal(262, nlines);
+	assert_string_equal("dir/", lines[0]);
+	assert_string_equal("`-- nested/", lines[1]);
+	assert_string_equal("    |-- 000", lines[2]);
+	assert_string_equal("    |-- 255", lines[257]);
+	assert_string_equal("    `-- ... (44 more)", lines[258]);
+	assert_string_equal("(truncated)", lines[259]);
+	assert_string_equal("", lines[260]);
+	assert_string_equal("1 directory, 256 files", lines[261]);
+
+	free_string_array(lines, nlines);
+	fclose(fp);
+
+	for(i = 0; i < 300; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "dir/nested/%03d", i);
+		assert_success(remove(name));
+	}
+	assert_success(rmdir("dir/nested"));
+	assert_success(rmdir("dir"));
+}
+
+TEST(cached_listings_are_reused_and_evicted)
+{
+	struct utimbuf times = { .actime = 1, .modtime = 1 };
+	int i, j;
+	int nlines;
+	FILE *fp;
+	char **lines;
+
+	/* More directories than there are cache entries. */
+	assert_success(os_mkdir("dir", 0777));
+	for(i = 0; i < 100; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "dir/%02d", i);
+		assert_success(os_mkdir(name, 0777));
+		snprintf(name, sizeof(name), "dir/%02d/file", i);
+		create_file(name);
+		snprintf(name, sizeof(name), "dir/%02d", i);
+		assert_success(utime(name, &times));
+	}
+	assert_success(utime("dir", &times));
+
+	for(j = 0; j < 2; ++j)
+	{
+		fp = qv_view_dir("dir");
+		lines = read_file_lines(fp, &nlines);
+
+		assert_int_equal(203, nlines);
+		assert_string_equal("dir/", lines[0]);
+		assert_string_equal("|-- 00/", lines[1]);
+		assert_string_equal("|   `-- file", lines[2]);
+		assert_string_equal("`-- 99/", lines[199]);
+		assert_string_equal("    `-- file", lines[200]);
+		assert_string_equal("100 directories, 100 files", lines[202]);
+
+		free_string_array(lines, nlines);
+		fclose(fp);
+	}
+
+	for(i = 0; i < 100; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "dir/%02d/file", i);
+		assert_success(remove(name));
+		snprintf(name, sizeof(name), "dir/%02d", i);
+		assert_success(rmdir(name));
+	}
+	assert_success(rmdir("dir"));
+}
+
 TEST(symlinks_are_not_resolved_in_tree_preview, IF(not_windows))
 {
 	int nlines;
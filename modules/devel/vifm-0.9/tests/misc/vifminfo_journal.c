@@ -0,0 +1,275 @@
+#include <stic.h>
+
+#include <sys/types.h> /* utimbuf */
+#include <unistd.h> /* W_OK access() getpid() rmdir() symlink() unlink() */
+#include <utime.h> /* utime() */
+
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* FILE fclose() fopen() fread() fputs() snprintf() */
+#include <string.h> /* strchr() strlen() strstr() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/cfg/hist.h"
+#include "../../src/cfg/info.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/str.h"
+#include "../../src/cmd_core.h"
+#include "../../src/opt_handlers.h"
+
+#include "utils.h"
+
+#define HEADER "# vifminfo history journal, version 1\n"
+
+static void write_journal(const char contents[]);
+static void write_file(const char path[], const char contents[]);
+static int dev_full_exists(void);
+static const char * read_file(const char path[]);
+
+SETUP()
+{
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	copy_str(cfg.config_dir, sizeof(cfg.config_dir), SANDBOX_PATH);
+	cfg.vifm_info = VIFMINFO_SHISTORY | VIFMINFO_JOURNAL;
+
+	/* Emulate proper history initialization. */
+	cfg_resize_histories(0);
+	cfg_resize_histories(5);
+
+	init_commands();
+}
+
+TEARDOWN()
+{
+	reset_cmds();
+
+	cfg_resize_histories(0);
+	cfg.vifm_info = 0;
+
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	(void)unlink(SANDBOX_PATH "/vifminfo");
+	(void)unlink(SANDBOX_PATH "/vifminfo.journal");
+}
+
+TEST(vifminfo_refers_to_journal)
+{
+	cfg_save_search_history("a");
+	write_info_file();
+
+	assert_non_null(strstr(read_file(SANDBOX_PATH "/vifminfo"), "\nj\n"));
+}
+
+TEST(journal_is_created_with_all_items)
+{
+	cfg_save_search_history("a");
+	cfg_save_search_history("b");
+	write_info_file();
+
+	assert_string_equal(HEADER "/a\n/b\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+	assert_null(strchr(read_file(SANDBOX_PATH "/vifminfo"), '/'));
+}
+
+TEST(only_new_items_are_appended)
+{
+	write_journal(HEADER "/a\n/b\n");
+	read_info_file(1);
+	assert_int_equal(0, cfg.search_hist.unsaved);
+
+	cfg_save_search_history("c");
+	cfg_save_search_history("a");
+	write_info_file();
+
+	assert_string_equal(HEADER "/a\n/b\n/c\n/a\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+	assert_int_equal(0, cfg.search_hist.unsaved);
+
+	write_info_file();
+	assert_string_equal(HEADER "/a\n/b\n/c\n/a\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+}
+
+TEST(journal_is_replayed_in_order)
+{
+	write_journal(HEADER "/a\n/b\n/c\n/a\n:cmd\n");
+	read_info_file(1);
+
+	assert_int_equal(2, cfg.search_hist.pos);
+	assert_string_equal("a", cfg.search_hist.items[0]);
+	assert_string_equal("c", cfg.search_hist.items[1]);
+	assert_string_equal("b", cfg.search_hist.items[2]);
+}
+
+TEST(journal_of_unknown_version_is_ignored_and_replaced)
+{
+	write_journal("# vifminfo history journal, version 100\n/a\n");
+	read_info_file(1);
+	assert_true(hist_is_empty(&cfg.search_hist));
+
+	cfg_save_search_history("b");
+	write_info_file();
+
+	assert_string_equal(HEADER "/b\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+}
+
+TEST(long_journal_is_compacted)
+{
+	write_journal(HEADER "/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n"
+	                     "/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n"
+	                     "/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n");
+	read_info_file(1);
+
+	write_info_file();
+
+	assert_string_equal(HEADER "/a\n/b\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+}
+
+TEST(journal_changed_by_others_is_not_compacted)
+{
+	struct utimbuf times = { .actime = 1, .modtime = 1 };
+
+	write_journal(HEADER "/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n"
+	                     "/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n"
+	                     "/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n/a\n/b\n");
+	read_info_file(1);
+
+	assert_success(utime(SANDBOX_PATH "/vifminfo.journal", &times));
+	cfg_save_search_history("c");
+	write_info_file();
+
+	assert_true(ends_with(read_file(SANDBOX_PATH "/vifminfo.journal"),
+				"/a\n/b\n/c\n"));
+	assert_true(strlen(read_file(SANDBOX_PATH "/vifminfo.journal")) >
+			strlen(HEADER "/a\n/b\n/c\n"));
+}
+
+TEST(disabled_histories_are_not_journaled)
+{
+	cfg.vifm_info = VIFMINFO_CHISTORY | VIFMINFO_JOURNAL;
+
+	cfg_save_search_history("a");
+	write_info_file();
+
+	assert_string_equal(HEADER, read_file(SANDBOX_PATH "/vifminfo.journal"));
+}
+
+TEST(journal_is_kept_when_not_used)
+{
+	write_journal(HEADER "/a\n");
+	read_info_file(1);
+
+	cfg.vifm_info = VIFMINFO_SHISTORY;
+	write_info_file();
+
+	assert_string_equal(HEADER "/a\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+	assert_non_null(strstr(read_file(SANDBOX_PATH "/vifminfo"), "\n/a\n"));
+	assert_null(strstr(read_file(SANDBOX_PATH "/vifminfo"), "\nj\n"));
+}
+
+TEST(journal_is_not_replayed_if_vifminfo_does_not_refer_to_it)
+{
+	write_file(SANDBOX_PATH "/vifminfo.journal", HEADER "/a\n");
+	write_file(SANDBOX_PATH "/vifminfo", "/b\n");
+	read_info_file(1);
+
+	assert_int_equal(0, cfg.search_hist.pos);
+	assert_string_equal("b", cfg.search_hist.items[0]);
+
+	cfg_save_search_history("c");
+	write_info_file();
+
+	assert_string_equal(HEADER "/b\n/c\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+}
+
+TEST(failed_rewrite_keeps_journal_and_stores_histories_in_vifminfo,
+		IF(dev_full_exists))
+{
+	char tmp_file[PATH_MAX + 64];
+	snprintf(tmp_file, sizeof(tmp_file), "%s/vifminfo.journal_%u",
+			SANDBOX_PATH, (unsigned int)getpid());
+	assert_success(symlink("/dev/full", tmp_file));
+
+	write_journal("# vifminfo history journal, version 100\n/a\n");
+	read_info_file(1);
+
+	cfg_save_search_history("b");
+	write_info_file();
+
+	assert_string_equal("# vifminfo history journal, version 100\n/a\n",
+			read_file(SANDBOX_PATH "/vifminfo.journal"));
+	assert_non_null(strstr(read_file(SANDBOX_PATH "/vifminfo"), "\n/b\n"));
+	assert_null(strstr(read_file(SANDBOX_PATH "/vifminfo"), "\nj\n"));
+	assert_int_equal(1, cfg.search_hist.unsaved);
+	assert_failure(unlink(tmp_file));
+}
+
+TEST(histories_are_stored_in_vifminfo_if_journal_can_not_be_written)
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/vifminfo.journal", 0700));
+
+	cfg_save_search_history("a");
+	write_info_file();
+
+	assert_non_null(strstr(read_file(SANDBOX_PATH "/vifminfo"), "\n/a\n"));
+	assert_int_equal(1, cfg.search_hist.unsaved);
+
+	assert_success(rmdir(SANDBOX_PATH "/vifminfo.journal"));
+}
+
+/* Creates journal file with specified contents and vifminfo that refers to
+ * it. */
+static void
+write_journal(const char contents[])
+{
+	write_file(SANDBOX_PATH "/vifminfo.journal", contents);
+	write_file(SANDBOX_PATH "/vifminfo", "j\n");
+}
+
+/* Creates file with specified contents. */
+static void
+write_file(const char path[], const char contents[])
+{
+	FILE *const fp = fopen(path, "w");
+	fputs(contents, fp);
+	fclose(fp);
+}
+
+/* Checks whether writes to /dev/full can be used to emulate lack of space.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+dev_full_exists(void)
+{
+	return access("/dev/full", W_OK) == 0;
+}
+
+/* Reads contents of the file.  Returns pointer to statically allocated
+ * buffer. */
+static const char *
+read_file(const char path[])
+{
+	static char buf[4096];
+	size_t len;
+	FILE *const fp = fopen(path, "r");
+	if(fp == NULL)
+	{
+		buf[0] = '\0';
+		return buf;
+	}
+
+	len = fread(buf, 1, sizeof(buf) - 1U, fp);
+	buf[len] = '\0';
+	fclose(fp);
+	return buf;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,146 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/classifier.h"
+#include "../../src/utils/macros.h"
+#include "../../src/utils/matchers.h"
+
+static void add_rules(const char *rules[], int count);
+static int find_linearly(const char path[], int from);
+
+static classifier_t *c;
+static matchers_t *ms[32];
+static int nms;
+
+SETUP()
+{
+	c = classifier_create();
+	assert_non_null(c);
+}
+
+TEARDOWN()
+{
+	int i;
+
+	classifier_free(c);
+	c = NULL;
+
+	for(i = 0; i < nms; ++i)
+	{
+		matchers_free(ms[i]);
+	}
+	nms = 0;
+}
+
+TEST(freeing_null_classifier_does_nothing)
+{
+	classifier_free(NULL);
+}
+
+TEST(empty_classifier_matches_nothing)
+{
+	assert_int_equal(-1, classifier_find(c, "file", 0));
+}
+
+TEST(suffixes_and_names_are_matched_ignoring_case)
+{
+	const char *rules[] = { "{*.c,*.h}", "{Makefile}", "*.TXT" };
+	add_rules(rules, ARRAY_LEN(rules));
+
+	assert_int_equal(0, classifier_find(c, "a.C", 0));
+	assert_int_equal(0, classifier_find(c, "dir/a.h", 0));
+	assert_int_equal(1, classifier_find(c, "makefile", 0));
+	assert_int_equal(2, classifier_find(c, "notes.txt", 0));
+	assert_int_equal(-1, classifier_find(c, "Makefile.in", 0));
+}
+
+TEST(first_matching_rule_is_found)
+{
+	const char *rules[] = { "{*.tar.gz}", "/\\.gz$/", "{*.gz}", "{*}" };
+	add_rules(rules, ARRAY_LEN(rules));
+
+	assert_int_equal(0, classifier_find(c, "a.tar.gz", 0));
+	assert_int_equal(1, classifier_find(c, "a.gz", 0));
+	assert_int_equal(2, classifier_find(c, "a.gz", 2));
+	assert_int_equal(3, classifier_find(c, "a.gz", 3));
+	assert_int_equal(3, classifier_find(c, "a", 0));
+	assert_int_equal(-1, classifier_find(c, "a", 4));
+}
+
+TEST(leading_asterisk_does_not_match_dot_or_empty_string)
+{
+	const char *rules[] = { "{*rc}", "{*}" };
+	add_rules(rules, ARRAY_LEN(rules));
+
+	assert_int_equal(1, classifier_find(c, "rc", 0));
+	assert_int_equal(-1, classifier_find(c, ".vimrc", 0));
+	assert_int_equal(0, classifier_find(c, "vimrc", 0));
+	assert_int_equal(-1, classifier_find(c, "", 0));
+}
+
+TEST(trailing_slash_of_directories_is_matched)
+{
+	const char *rules[] = { "{*/}", "{dir}" };
+	add_rules(rules, ARRAY_LEN(rules));
+
+	assert_int_equal(0, classifier_find(c, "/path/dir/", 0));
+	assert_int_equal(1, classifier_find(c, "/path/dir", 0));
+}
+
+TEST(results_are_the_same_as_for_linear_search)
+{
+	static const char *rules[] = {
+		"{*.c}", "{!*.c}", "{*.[ch]}", "{[Mm]akefile}", "{{*/src/*.c}}",
+		"/^a/", "{a*}", "{*.c,*.C,b}", "{?.c}", "*.c", "{*.c}{a*}", "{*.d}",
+		"{*}",
+	};
+	static const char *paths[] = {
+		"a.c", "b", "B", "a.d", "makefile", "Makefile", ".c", "c", "x.c",
+		"/src/x.c", "ab.c", "src/dir/", "a", "",
+	};
+
+	int i, j;
+	add_rules(rules, ARRAY_LEN(rules));
+
+	for(i = 0; i < (int)ARRAY_LEN(paths); ++i)
+	{
+		for(j = 0; j < (int)ARRAY_LEN(rules); ++j)
+		{
+			assert_int_equal(find_linearly(paths[i], j),
+					classifier_find(c, paths[i], j));
+		}
+	}
+}
+
+static void
+add_rules(const char *rules[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char *error;
+		ms[nms] = matchers_alloc(rules[i], 0, 1, "", &error);
+		assert_non_null(ms[nms]);
+		assert_success(classifier_add(c, ms[nms]));
+		++nms;
+	}
+}
+
+static int
+find_linearly(const char path[], int from)
+{
+	int i;
+	for(i = from; i < nms; ++i)
+	{
+		if(matchers_match(ms[i], path))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,142 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() remove() snprintf() */
+
+#include "../../src/compat/os.h"
+#include "../../src/utils/dircache.h"
+
+static void create_file(const char path[]);
+
+SETUP()
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	create_file(SANDBOX_PATH "/dir/bb");
+	create_file(SANDBOX_PATH "/dir/ab");
+	create_file(SANDBOX_PATH "/dir/ba");
+	create_file(SANDBOX_PATH "/dir/a");
+}
+
+TEARDOWN()
+{
+	dircache_reset();
+
+	(void)remove(SANDBOX_PATH "/dir/a");
+	(void)remove(SANDBOX_PATH "/dir/ab");
+	(void)remove(SANDBOX_PATH "/dir/ba");
+	(void)remove(SANDBOX_PATH "/dir/bb");
+	(void)remove(SANDBOX_PATH "/dir/new");
+	(void)remove(SANDBOX_PATH "/dir/sub");
+	assert_success(remove(SANDBOX_PATH "/dir"));
+}
+
+TEST(missing_directory_has_no_listing)
+{
+	assert_null(dircache_get(SANDBOX_PATH "/no-such-dir"));
+}
+
+TEST(listing_is_sorted)
+{
+	const dircache_listing_t *const listing = dircache_get(SANDBOX_PATH "/dir");
+	assert_non_null(listing);
+
+	assert_int_equal(4, listing->count);
+	assert_string_equal("a", listing->entries[0].name);
+	assert_string_equal("ab", listing->entries[1].name);
+	assert_string_equal("ba", listing->entries[2].name);
+	assert_string_equal("bb", listing->entries[3].name);
+}
+
+TEST(types_are_reported)
+{
+	const dircache_listing_t *listing;
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir/sub", 0700));
+
+	listing = dircache_get(SANDBOX_PATH "/dir");
+	assert_non_null(listing);
+	assert_int_equal(5, listing->count);
+	assert_string_equal("sub", listing->entries[4].name);
+	assert_true(listing->entries[4].type == DCT_DIR ||
+	            listing->entries[4].type == DCT_UNKNOWN);
+	assert_true(listing->entries[0].type == DCT_OTHER ||
+	            listing->entries[0].type == DCT_UNKNOWN);
+}
+
+TEST(prefix_range_is_found)
+{
+	int first;
+	const dircache_listing_t *const listing = dircache_get(SANDBOX_PATH "/dir");
+	assert_non_null(listing);
+
+	assert_int_equal(2, dircache_find_prefix(listing, "a", &first));
+	assert_int_equal(0, first);
+
+	assert_int_equal(2, dircache_find_prefix(listing, "b", &first));
+	assert_int_equal(2, first);
+
+	assert_int_equal(1, dircache_find_prefix(listing, "ab", &first));
+	assert_int_equal(1, first);
+
+	assert_int_equal(0, dircache_find_prefix(listing, "c", &first));
+	assert_int_equal(0, dircache_find_prefix(listing, "aa", &first));
+
+	assert_int_equal(4, dircache_find_prefix(listing, "", &first));
+	assert_int_equal(0, first);
+}
+
+TEST(changes_are_noticed)
+{
+	const dircache_listing_t *listing = dircache_get(SANDBOX_PATH "/dir");
+	assert_non_null(listing);
+	assert_int_equal(4, listing->count);
+
+	create_file(SANDBOX_PATH "/dir/new");
+
+	listing = dircache_get(SANDBOX_PATH "/dir");
+	assert_non_null(listing);
+	assert_int_equal(5, listing->count);
+}
+
+TEST(evicted_listing_is_read_again)
+{
+	char path[64];
+	int i;
+
+	assert_non_null(dircache_get(SANDBOX_PATH "/dir"));
+
+	/* List more directories than the cache can hold. */
+	for(i = 0; i < 16; ++i)
+	{
+		const dircache_listing_t *listing;
+
+		snprintf(path, sizeof(path), "%s/e%d", SANDBOX_PATH, i);
+		assert_success(os_mkdir(path, 0700));
+
+		listing = dircache_get(path);
+		assert_non_null(listing);
+		assert_int_equal(0, listing->count);
+	}
+
+	for(i = 0; i < 16; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/e%d", SANDBOX_PATH, i);
+		assert_success(remove(path));
+	}
+
+	assert_int_equal(4, dircache_get(SANDBOX_PATH "/dir")->count);
+}
+
+/* Creates empty file. */
+static void
+create_file(const char path[])
+{
+	FILE *const f = fopen(path, "w");
+	assert_non_null(f);
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,203 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() remove() snprintf() */
+#include <string.h> /* strcmp() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/utils/execcache.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+
+static void wait_for_index(void);
+static void count_dirs(const char dir[], char *names[], int count, void *arg);
+static void collect_names(const char dir[], char *names[], int count,
+		void *arg);
+static void make_file(const char path[], int mode);
+static int not_windows(void);
+
+static char sandbox[PATH_MAX];
+static char dir_a[PATH_MAX];
+static char dir_b[PATH_MAX];
+
+SETUP_ONCE()
+{
+	char cwd[PATH_MAX];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+
+	if(is_path_absolute(SANDBOX_PATH))
+	{
+		snprintf(sandbox, sizeof(sandbox), "%s", SANDBOX_PATH);
+	}
+	else
+	{
+		snprintf(sandbox, sizeof(sandbox), "%s/%s", cwd, SANDBOX_PATH);
+	}
+
+	snprintf(dir_a, sizeof(dir_a), "%s/a", sandbox);
+	snprintf(dir_b, sizeof(dir_b), "%s/b", sandbox);
+}
+
+SETUP()
+{
+	char *dirs[] = { dir_a, dir_b };
+
+	assert_success(os_mkdir(dir_a, 0700));
+	assert_success(os_mkdir(dir_b, 0700));
+
+	execcache_set_dirs(dirs, 2);
+}
+
+TEARDOWN()
+{
+	execcache_reset();
+
+	(void)remove(SANDBOX_PATH "/a/prog");
+	(void)remove(SANDBOX_PATH "/b/prog");
+	(void)remove(SANDBOX_PATH "/b/other");
+	assert_success(remove(SANDBOX_PATH "/a"));
+	assert_success(remove(SANDBOX_PATH "/b"));
+}
+
+TEST(index_is_unavailable_until_directories_are_set)
+{
+	int count = 0;
+
+	execcache_reset();
+
+	assert_true(execcache_find("prog", 0U, NULL) < 0);
+	assert_failure(execcache_list(&count_dirs, &count));
+}
+
+TEST(names_with_slashes_are_not_looked_up, IF(not_windows))
+{
+	wait_for_index();
+	assert_true(execcache_find("a/prog", 0U, NULL) < 0);
+}
+
+TEST(all_directories_are_listed, IF(not_windows))
+{
+	int count = 0;
+	assert_success(execcache_list(&count_dirs, &count));
+	assert_int_equal(2, count);
+}
+
+TEST(directories_are_searched_in_order, IF(not_windows))
+{
+	char path[PATH_MAX];
+	char expected[PATH_MAX];
+
+	make_file(SANDBOX_PATH "/a/prog", 0700);
+	make_file(SANDBOX_PATH "/b/prog", 0700);
+	wait_for_index();
+
+	snprintf(expected, sizeof(expected), "%s/prog", dir_a);
+	assert_success(execcache_find("prog", sizeof(path), path));
+	assert_string_equal(expected, path);
+
+	assert_int_equal(1, execcache_find("no-such-prog", sizeof(path), path));
+}
+
+TEST(non_executable_files_are_skipped, IF(not_windows))
+{
+	char path[PATH_MAX];
+	char expected[PATH_MAX];
+
+	make_file(SANDBOX_PATH "/a/prog", 0600);
+	make_file(SANDBOX_PATH "/b/prog", 0700);
+	wait_for_index();
+
+	snprintf(expected, sizeof(expected), "%s/prog", dir_b);
+	assert_success(execcache_find("prog", sizeof(path), path));
+	assert_string_equal(expected, path);
+}
+
+TEST(new_files_are_noticed, IF(not_windows))
+{
+	wait_for_index();
+	assert_int_equal(1, execcache_find("prog", 0U, NULL));
+
+	make_file(SANDBOX_PATH "/b/prog", 0700);
+	assert_success(execcache_find("prog", 0U, NULL));
+}
+
+TEST(changes_of_permissions_are_noticed, IF(not_windows))
+{
+	make_file(SANDBOX_PATH "/b/prog", 0600);
+	wait_for_index();
+	assert_int_equal(1, execcache_find("prog", 0U, NULL));
+
+	assert_success(os_chmod(SANDBOX_PATH "/b/prog", 0700));
+	assert_success(execcache_find("prog", 0U, NULL));
+}
+
+TEST(listing_is_sorted, IF(not_windows))
+{
+	char names[2][16] = {};
+
+	make_file(SANDBOX_PATH "/b/prog", 0700);
+	make_file(SANDBOX_PATH "/b/other", 0700);
+
+	assert_success(execcache_list(&collect_names, names));
+	assert_string_equal("other", names[0]);
+	assert_string_equal("prog", names[1]);
+}
+
+/* Waits for index to be built. */
+static void
+wait_for_index(void)
+{
+	int count = 0;
+	assert_success(execcache_list(&count_dirs, &count));
+}
+
+/* Counts visited directories. */
+static void
+count_dirs(const char dir[], char *names[], int count, void *arg)
+{
+	int *const ndirs = arg;
+	++*ndirs;
+}
+
+/* Copies up to two names of second directory. */
+static void
+collect_names(const char dir[], char *names[], int count, void *arg)
+{
+	char (*const collected)[16] = arg;
+	int i;
+
+	if(strcmp(dir, dir_b) != 0)
+	{
+		return;
+	}
+
+	for(i = 0; i < count && i < 2; ++i)
+	{
+		snprintf(collected[i], sizeof(collected[i]), "%s", names[i]);
+	}
+}
+
+/* Creates file with specified permissions. */
+static void
+make_file(const char path[], int mode)
+{
+	FILE *const f = fopen(path, "w");
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+	assert_success(os_chmod(path, mode));
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,476 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fprintf() fputs() fwrite() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strchr() */
+
+#include "../../src/utils/filemap.h"
+
+static void write_file(const char contents[]);
+static void append_file(const char contents[]);
+static int contains_x(const char line[], void *arg);
+static int cancel_search(void *arg);
+
+static filemap_t *fm;
+
+TEARDOWN()
+{
+	filemap_close(fm);
+	fm = NULL;
+	(void)unlink(SANDBOX_PATH "/file");
+}
+
+TEST(missing_file_is_not_opened)
+{
+	assert_null(filemap_open(SANDBOX_PATH "/no-such-file"));
+}
+
+TEST(directory_is_not_opened)
+{
+	assert_null(filemap_open(SANDBOX_PATH));
+}
+
+TEST(empty_file_has_no_lines)
+{
+	write_file("");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	filemap_index(fm);
+	assert_true(filemap_indexed(fm));
+	assert_int_equal(0, filemap_line_count(fm));
+	assert_true(filemap_at_end(fm, 0U));
+}
+
+TEST(last_line_without_newline_is_counted)
+{
+	write_file("a\nbb\nccc");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	filemap_index(fm);
+	assert_int_equal(3, filemap_line_count(fm));
+
+	assert_int_equal(0, filemap_line_offset(fm, 0));
+	assert_int_equal(2, filemap_line_offset(fm, 1));
+	assert_int_equal(5, filemap_line_offset(fm, 2));
+	assert_int_equal(8, filemap_line_offset(fm, 3));
+}
+
+TEST(trailing_newline_does_not_add_line)
+{
+	write_file("a\nbb\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	filemap_index(fm);
+	assert_int_equal(2, filemap_line_count(fm));
+}
+
+TEST(navigation_between_lines)
+{
+	write_file("first\nsecond\n\nlast");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(6, filemap_next_line(fm, 0U));
+	assert_int_equal(13, filemap_next_line(fm, 6U));
+	assert_int_equal(14, filemap_next_line(fm, 13U));
+	assert_int_equal(18, filemap_next_line(fm, 14U));
+	assert_true(filemap_at_end(fm, 18U));
+
+	assert_int_equal(14, filemap_prev_line(fm, 18U));
+	assert_int_equal(13, filemap_prev_line(fm, 14U));
+	assert_int_equal(6, filemap_prev_line(fm, 13U));
+	assert_int_equal(0, filemap_prev_line(fm, 6U));
+	assert_int_equal(0, filemap_prev_line(fm, 0U));
+
+	assert_int_equal(6, filemap_line_start(fm, 9U));
+}
+
+TEST(lines_are_copied_without_separators)
+{
+	char *line;
+
+	write_file("dos\r\nunix\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	line = filemap_get_line(fm, 0U, 100U);
+	assert_string_equal("dos", line);
+	free(line);
+
+	line = filemap_get_line(fm, 5U, 100U);
+	assert_string_equal("unix", line);
+	free(line);
+
+	line = filemap_get_line(fm, 5U, 2U);
+	assert_string_equal("un", line);
+	free(line);
+}
+
+TEST(null_characters_are_replaced)
+{
+	char *line;
+	FILE *const f = fopen(SANDBOX_PATH "/file", "wb");
+	fwrite("nul\0char", 1U, 8U, f);
+	fclose(f);
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	line = filemap_get_line(fm, 0U, 100U);
+	assert_string_equal("nul?char", line);
+	free(line);
+}
+
+TEST(bom_is_skipped)
+{
+	char *line;
+
+	write_file("\xef\xbb\xbf" "line");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(4, filemap_size(fm));
+	line = filemap_get_line(fm, 0U, 100U);
+	assert_string_equal("line", line);
+	free(line);
+}
+
+TEST(many_lines_are_indexed_in_background)
+{
+	int i;
+	FILE *const f = fopen(SANDBOX_PATH "/file", "w");
+	for(i = 0; i < 10000; ++i)
+	{
+		fprintf(f, "%d\n", i);
+	}
+	fclose(f);
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_success(filemap_index_async(fm));
+	filemap_index(fm);
+
+	assert_true(filemap_indexed(fm));
+	assert_int_equal(10000, filemap_line_count(fm));
+
+	for(i = 0; i < 10000; i += 997)
+	{
+		char num[16];
+		char *line;
+		const size_t off = filemap_line_offset(fm, i);
+
+		assert_int_equal(i, filemap_line_num(fm, off));
+
+		snprintf(num, sizeof(num), "%d", i);
+		line = filemap_get_line(fm, off, 100U);
+		assert_string_equal(num, line);
+		free(line);
+	}
+}
+
+TEST(line_number_is_unknown_before_indexing)
+{
+	write_file("a\nb\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(0, filemap_line_num(fm, 0U));
+	assert_int_equal(-1, filemap_line_num(fm, 2U));
+	assert_int_equal(2, filemap_line_offset(fm, 1));
+}
+
+TEST(same_file_is_not_changed_on_follow)
+{
+	write_file("a\nb\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(0, filemap_follow(fm, SANDBOX_PATH "/file"));
+	assert_int_equal(4, filemap_size(fm));
+}
+
+TEST(appended_data_is_indexed_on_follow)
+{
+	char *line;
+
+	write_file("\xef\xbb\xbf" "a\nb");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+	filemap_index(fm);
+	assert_int_equal(2, filemap_line_count(fm));
+
+	append_file("c\nd\n");
+	assert_true(filemap_follow(fm, SANDBOX_PATH "/file") > 0);
+	assert_false(filemap_indexed(fm));
+
+	filemap_index(fm);
+	assert_true(filemap_indexed(fm));
+	assert_int_equal(3, filemap_line_count(fm));
+	assert_int_equal(7, filemap_size(fm));
+
+	line = filemap_get_line(fm, 2U, 100U);
+	assert_string_equal("bc", line);
+	free(line);
+
+	assert_int_equal(5, filemap_line_offset(fm, 2));
+}
+
+TEST(truncation_is_detected_on_follow)
+{
+	write_file("abc\ndef\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	write_file("abc\n");
+	assert_true(filemap_follow(fm, SANDBOX_PATH "/file") < 0);
+}
+
+TEST(truncated_file_is_not_accessed_past_its_end)
+{
+	filemap_search_t search = { .match = &contains_x, .max_len = 100U };
+	char *line;
+	int i;
+
+	/* Make file span several pages, so that some of them get past the end. */
+	FILE *const f = fopen(SANDBOX_PATH "/file", "wb");
+	for(i = 0; i < 4096; ++i)
+	{
+		fputs("line x\n", f);
+	}
+	fclose(f);
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	write_file("abc\nx\n");
+	assert_int_equal(7*4096, filemap_size(fm));
+	filemap_refresh(fm);
+
+	assert_int_equal(6, filemap_size(fm));
+	assert_true(filemap_at_end(fm, 20000U));
+	assert_int_equal(6, filemap_next_line(fm, 4U));
+	assert_int_equal(6, filemap_line_start(fm, 20000U));
+	assert_int_equal(6, filemap_line_offset(fm, 3000));
+
+	line = filemap_get_line(fm, 20000U, 100U);
+	assert_string_equal("", line);
+	free(line);
+
+	assert_int_equal(4, filemap_find(fm, 0U, 0, &search));
+	assert_int_equal(6, filemap_find(fm, 20000U, 0, &search));
+	assert_int_equal(4, filemap_find(fm, 20000U, 1, &search));
+
+	filemap_index(fm);
+	assert_true(filemap_indexed(fm));
+	assert_int_equal(2, filemap_line_count(fm));
+
+	assert_true(filemap_follow(fm, SANDBOX_PATH "/file") < 0);
+}
+
+TEST(line_start_is_found_far_back)
+{
+	int i;
+
+	FILE *const f = fopen(SANDBOX_PATH "/file", "wb");
+	fputs("ab\n", f);
+	for(i = 0; i < 1000; ++i)
+	{
+		fputs("0123456789", f);
+	}
+	fputs("\nc", f);
+	fclose(f);
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(0, filemap_line_start(fm, 1U));
+	assert_int_equal(3, filemap_line_start(fm, 3U));
+	assert_int_equal(3, filemap_line_start(fm, 10002U));
+	assert_int_equal(3, filemap_line_start(fm, 10003U));
+	assert_int_equal(10004, filemap_line_start(fm, 10004U));
+	assert_int_equal(10004, filemap_line_start(fm, 10005U));
+	assert_int_equal(3, filemap_prev_line(fm, 10004U));
+}
+
+TEST(line_start_uses_index_marks)
+{
+	int i;
+	size_t mark;
+
+	FILE *const f = fopen(SANDBOX_PATH "/file", "wb");
+	for(i = 0; i < 1024; ++i)
+	{
+		fputs("a\n", f);
+	}
+	fputs("bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\n", f);
+	fclose(f);
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+	filemap_index(fm);
+
+	mark = filemap_line_offset(fm, 1024);
+	assert_int_equal(2*1024, mark);
+	assert_int_equal(mark, filemap_line_start(fm, mark));
+	assert_int_equal(mark, filemap_line_start(fm, mark + 30U));
+	assert_int_equal(mark - 2U, filemap_line_start(fm, mark - 1U));
+	assert_int_equal(mark - 2U, filemap_prev_line(fm, mark));
+}
+
+TEST(truncation_is_reported_without_path)
+{
+	write_file("abc\ndef\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+	assert_false(filemap_truncated(fm));
+
+	append_file("ghi\n");
+	assert_false(filemap_truncated(fm));
+
+	write_file("abc\n");
+	assert_true(filemap_truncated(fm));
+}
+
+TEST(replacement_is_detected_on_follow)
+{
+	write_file("abc\ndef\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_success(unlink(SANDBOX_PATH "/file"));
+	write_file("abc\ndef\nghi\n");
+	assert_true(filemap_follow(fm, SANDBOX_PATH "/file") < 0);
+}
+
+TEST(search_finds_lines_in_both_directions)
+{
+	filemap_search_t search = { .match = &contains_x, .max_len = 100U };
+
+	write_file("x1\na\nx2\nb\nx3\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(5, filemap_find(fm, 0U, 0, &search));
+	assert_int_equal(10, filemap_find(fm, 5U, 0, &search));
+	assert_int_equal(filemap_size(fm), filemap_find(fm, 10U, 0, &search));
+
+	assert_int_equal(5, filemap_find(fm, 10U, 1, &search));
+	assert_int_equal(0, filemap_find(fm, 5U, 1, &search));
+	assert_int_equal(filemap_size(fm), filemap_find(fm, 0U, 1, &search));
+}
+
+TEST(literal_prefilter_skips_lines)
+{
+	int calls = 0;
+	filemap_search_t search = {
+		.match = &contains_x, .arg = &calls, .max_len = 100U, .literal = "x",
+	};
+
+	write_file("a\nb\nc\nxd\ne\nf\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(6, filemap_find(fm, 0U, 0, &search));
+	assert_int_equal(1, calls);
+
+	assert_int_equal(6, filemap_find(fm, 11U, 1, &search));
+	assert_int_equal(2, calls);
+}
+
+TEST(literal_is_compared_ignoring_case)
+{
+	filemap_search_t search = {
+		.match = &contains_x, .max_len = 100U, .literal = "AbC", .icase = 1,
+	};
+
+	write_file("a\nxabc\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(2, filemap_find(fm, 0U, 0, &search));
+}
+
+TEST(special_bytes_bypass_prefilter)
+{
+	filemap_search_t search = {
+		.match = &contains_x, .max_len = 100U, .literal = "xy", .special = "\033",
+	};
+
+	write_file("a\nx\033[1my\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(2, filemap_find(fm, 0U, 0, &search));
+}
+
+TEST(search_can_be_cancelled)
+{
+	filemap_search_t search = {
+		.match = &contains_x, .max_len = 100U,
+		.cancel = { .hook = &cancel_search },
+	};
+
+	write_file("a\nx\n");
+
+	fm = filemap_open(SANDBOX_PATH "/file");
+	assert_non_null(fm);
+
+	assert_int_equal(filemap_size(fm), filemap_find(fm, 0U, 0, &search));
+}
+
+static int
+contains_x(const char line[], void *arg)
+{
+	if(arg != NULL)
+	{
+		++*(int *)arg;
+	}
+	return strchr(line, 'x') != NULL;
+}
+
+static int
+cancel_search(void *arg)
+{
+	return 1;
+}
+
+static void
+write_file(const char contents[])
+{
+	FILE *const f = fopen(SANDBOX_PATH "/file", "wb");
+	fputs(contents, f);
+	fclose(f);
+}
+
+static void
+append_file(const char contents[])
+{
+	FILE *const f = fopen(SANDBOX_PATH "/file", "ab");
+	fputs(contents, f);
+	fclose(f);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
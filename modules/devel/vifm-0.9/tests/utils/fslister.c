@@ -0,0 +1,201 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* S_ISLNK() S_ISREG() */
+#include <unistd.h> /* symlink() unlink() */
+
+#include <stddef.h> /* NULL */
+#include <string.h> /* strcmp() */
+
+#include "../../src/utils/fslister.h"
+
+static int find_entry(const fslister_entry_t entries[], int count,
+		const char name[]);
+static int always_cancelled(void);
+static int not_windows(void);
+
+static fslister_t *lister;
+
+SETUP()
+{
+	lister = fslister_create(2, NULL);
+	assert_non_null(lister);
+}
+
+TEARDOWN()
+{
+	fslister_free(lister);
+	lister = NULL;
+}
+
+TEST(freeing_null_lister_does_nothing)
+{
+	fslister_free(NULL);
+}
+
+TEST(directory_is_listed)
+{
+	int count, i;
+	fslister_entry_t *entries;
+	fslister_req_t *const req = fslister_request(lister, TEST_DATA_PATH "/tree");
+	assert_non_null(req);
+
+	entries = fslister_take(lister, req, &count);
+	assert_int_equal(3, count);
+
+	i = find_entry(entries, count, "dir1");
+	assert_true(i >= 0);
+	assert_true(entries[i].is_dir);
+	assert_false(entries[i].is_link);
+
+	assert_true(find_entry(entries, count, "dir5") >= 0);
+	assert_true(find_entry(entries, count, ".hidden") >= 0);
+
+	fslister_free_entries(entries, count);
+}
+
+TEST(files_are_not_directories)
+{
+	int count;
+	fslister_entry_t *entries;
+	fslister_req_t *const req = fslister_request(lister,
+			TEST_DATA_PATH "/tree/dir1/dir2/dir4");
+	assert_non_null(req);
+
+	entries = fslister_take(lister, req, &count);
+	assert_int_equal(1, count);
+	assert_string_equal("file3", entries[0].name);
+	assert_false(entries[0].is_dir);
+	assert_false(entries[0].is_link);
+#ifndef _WIN32
+	assert_true(S_ISREG(entries[0].info.st_mode));
+#endif
+
+	fslister_free_entries(entries, count);
+}
+
+TEST(files_are_lstated, IF(not_windows))
+{
+	int count, i;
+	fslister_entry_t *entries;
+	fslister_req_t *req;
+
+	/* symlink() is not available on Windows, but the rest of the code is fine. */
+#ifndef _WIN32
+	assert_success(symlink(TEST_DATA_PATH "/tree/dir1", SANDBOX_PATH "/link"));
+	assert_success(symlink("no-such-file", SANDBOX_PATH "/broken"));
+#endif
+
+	req = fslister_request(lister, SANDBOX_PATH);
+	assert_non_null(req);
+	entries = fslister_take(lister, req, &count);
+	assert_int_equal(2, count);
+
+	i = find_entry(entries, count, "link");
+	assert_true(i >= 0);
+	assert_true(entries[i].is_dir);
+	assert_true(entries[i].is_link);
+	assert_true(S_ISLNK(entries[i].info.st_mode));
+
+	i = find_entry(entries, count, "broken");
+	assert_true(i >= 0);
+	assert_false(entries[i].is_dir);
+	assert_true(entries[i].is_link);
+	assert_true(S_ISLNK(entries[i].info.st_mode));
+
+	fslister_free_entries(entries, count);
+
+	assert_success(unlink(SANDBOX_PATH "/link"));
+	assert_success(unlink(SANDBOX_PATH "/broken"));
+}
+
+TEST(failure_to_list_is_reported)
+{
+	int count;
+	fslister_req_t *const req = fslister_request(lister,
+			SANDBOX_PATH "/no-such-dir");
+	assert_non_null(req);
+
+	assert_null(fslister_take(lister, req, &count));
+	assert_int_equal(-1, count);
+}
+
+TEST(requests_can_be_taken_in_any_order)
+{
+	int count1, count2;
+	fslister_entry_t *entries1, *entries2;
+	fslister_req_t *const req1 = fslister_request(lister,
+			TEST_DATA_PATH "/tree/dir1");
+	fslister_req_t *const req2 = fslister_request(lister,
+			TEST_DATA_PATH "/tree/dir5");
+
+	entries2 = fslister_take(lister, req2, &count2);
+	entries1 = fslister_take(lister, req1, &count1);
+
+	assert_int_equal(2, count1);
+	assert_true(find_entry(entries1, count1, "dir2") >= 0);
+	assert_true(find_entry(entries1, count1, "file4") >= 0);
+	assert_int_equal(2, count2);
+	assert_true(find_entry(entries2, count2, "file5") >= 0);
+
+	fslister_free_entries(entries1, count1);
+	fslister_free_entries(entries2, count2);
+}
+
+TEST(requests_that_were_not_taken_are_freed)
+{
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		assert_non_null(fslister_request(lister, TEST_DATA_PATH "/tree"));
+	}
+}
+
+TEST(lister_without_threads_lists_on_taking)
+{
+	int count;
+	fslister_entry_t *entries;
+	fslister_t *const sync_lister = fslister_create(0, &always_cancelled);
+	fslister_req_t *const req = fslister_request(sync_lister,
+			TEST_DATA_PATH "/tree");
+
+	/* Cancellation doesn't affect requests that weren't picked up by
+	 * workers. */
+	entries = fslister_take(sync_lister, req, &count);
+	assert_int_equal(3, count);
+
+	fslister_free_entries(entries, count);
+	fslister_free(sync_lister);
+}
+
+static int
+find_entry(const fslister_entry_t entries[], int count, const char name[])
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(strcmp(entries[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int
+always_cancelled(void)
+{
+	return 1;
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,89 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* S_ISDIR() S_ISREG() */
+
+#include <stddef.h> /* NULL */
+#include <string.h> /* strcmp() */
+
+#include "../../src/utils/fsprefetch.h"
+
+static int find_entry(const fsprefetch_entry_t entries[], int count,
+		const char name[]);
+
+TEST(freeing_null_prefetch_does_nothing)
+{
+	fsprefetch_free(NULL);
+}
+
+TEST(directory_is_listed_with_file_information)
+{
+	int count, i;
+	fsprefetch_entry_t *entries;
+	fsprefetch_t *const prefetch = fsprefetch_start(TEST_DATA_PATH "/tree");
+	assert_non_null(prefetch);
+	assert_string_equal(TEST_DATA_PATH "/tree", fsprefetch_get_path(prefetch));
+
+	entries = fsprefetch_take(prefetch, &count);
+	assert_int_equal(3, count);
+
+	i = find_entry(entries, count, "dir1");
+	assert_true(i >= 0);
+	assert_true(S_ISDIR(entries[i].info.st_mode));
+
+	i = find_entry(entries, count, ".hidden");
+	assert_true(i >= 0);
+	assert_true(S_ISREG(entries[i].info.st_mode));
+
+	assert_true(find_entry(entries, count, "dir5") >= 0);
+
+	fsprefetch_free_entries(entries, count);
+}
+
+TEST(listing_becomes_available)
+{
+	int count;
+	fsprefetch_entry_t *entries;
+	fsprefetch_t *const prefetch = fsprefetch_start(TEST_DATA_PATH "/tree");
+	assert_non_null(prefetch);
+
+	while(!fsprefetch_is_done(prefetch))
+	{
+		/* Wait. */
+	}
+
+	entries = fsprefetch_take(prefetch, &count);
+	assert_int_equal(3, count);
+	fsprefetch_free_entries(entries, count);
+}
+
+TEST(failure_to_list_is_reported)
+{
+	int count;
+	fsprefetch_t *const prefetch = fsprefetch_start(SANDBOX_PATH "/no-such-dir");
+	assert_non_null(prefetch);
+
+	assert_null(fsprefetch_take(prefetch, &count));
+	assert_int_equal(-1, count);
+}
+
+TEST(prefetch_can_be_freed_without_taking)
+{
+	fsprefetch_free(fsprefetch_start(TEST_DATA_PATH "/tree"));
+}
+
+static int
+find_entry(const fsprefetch_entry_t entries[], int count, const char name[])
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(strcmp(entries[i].name, name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -7,6 +7,7 @@
 #include "../../src/utils/fs.h"
 #include "../../src/utils/fswatch.h"
 #include "../../src/utils/path.h"
+#include "../../src/utils/selector.h"
 
 static int using_inotify(void);
 
@@ -155,6 +156,29 @@ TEST(file_recreation_removes_ban, IF(using_inotify))
 	assert_success(remove(SANDBOX_PATH "/testdir"));
 }
 
+TEST(descriptor_signals_changes, IF(using_inotify))
+{
+	fswatch_t *watch;
+	selector_t *selector;
+	int error;
+
+	assert_non_null(watch = fswatch_create(sandbox));
+	assert_non_null(selector = selector_alloc(0));
+
+	assert_success(selector_add(selector, fswatch_get_fd(watch), SEL_READ));
+	assert_false(selector_wait(selector, 0));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+	assert_true(selector_wait(selector, 0));
+
+	assert_true(fswatch_changed(watch, &error));
+	assert_false(selector_wait(selector, 0));
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+	selector_free(selector);
+	fswatch_free(watch);
+}
+
 static int
 using_inotify(void)
 {
@@ -0,0 +1,23 @@
+#include <stic.h>
+
+#include "../../src/utils/str.h"
+
+TEST(empty_string_has_offset_basis_as_hash)
+{
+	assert_true(hash_str("") == 2166136261U);
+}
+
+TEST(equal_strings_have_equal_hashes)
+{
+	char str[] = "string";
+	assert_true(hash_str("string") == hash_str(str));
+}
+
+TEST(order_of_characters_matters)
+{
+	assert_true(hash_str("ab") != hash_str("ba"));
+	assert_true(hash_str("a") != hash_str("aa"));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
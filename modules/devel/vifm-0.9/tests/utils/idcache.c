@@ -0,0 +1,124 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <grp.h> /* getgrgid() */
+#include <pwd.h> /* getpwuid() */
+#include <unistd.h> /* getgid() getuid() */
+
+#include <string.h> /* strcmp() */
+
+#include "../../src/utils/idcache.h"
+#include "../../src/utils/string_array.h"
+
+static int is_in_list(char *names[], int count, const char name[]);
+
+TEARDOWN()
+{
+	idcache_reset();
+}
+
+TEST(name_of_current_user_is_found)
+{
+	char buf[128];
+	struct passwd *const pw = getpwuid(getuid());
+	assert_non_null(pw);
+
+	idcache_user_name(getuid(), sizeof(buf), buf);
+	assert_string_equal(pw->pw_name, buf);
+
+	/* Second time it comes from the cache. */
+	idcache_user_name(getuid(), sizeof(buf), buf);
+	assert_string_equal(pw->pw_name, buf);
+}
+
+TEST(name_of_current_group_is_found)
+{
+	char buf[128];
+	struct group *const gr = getgrgid(getgid());
+	assert_non_null(gr);
+
+	idcache_group_name(getgid(), sizeof(buf), buf);
+	assert_string_equal(gr->gr_name, buf);
+}
+
+TEST(unknown_ids_are_formatted_as_numbers)
+{
+	char buf[128];
+
+	idcache_user_name(1234567, sizeof(buf), buf);
+	assert_string_equal("1234567", buf);
+	idcache_user_name(1234567, sizeof(buf), buf);
+	assert_string_equal("1234567", buf);
+
+	idcache_group_name(7654321, sizeof(buf), buf);
+	assert_string_equal("7654321", buf);
+}
+
+TEST(invalid_id_is_formatted_as_signed_number)
+{
+	char buf[128];
+
+	idcache_user_name((uid_t)-1, sizeof(buf), buf);
+	assert_string_equal("-1", buf);
+
+	idcache_group_name((gid_t)-1, sizeof(buf), buf);
+	assert_string_equal("-1", buf);
+}
+
+TEST(names_are_truncated_to_fit_buffer)
+{
+	char buf[3];
+	idcache_user_name(1234567, sizeof(buf), buf);
+	assert_string_equal("12", buf);
+}
+
+TEST(lists_contain_current_user_and_group)
+{
+	int count;
+	char **names;
+
+	struct passwd *const pw = getpwuid(getuid());
+	struct group *const gr = getgrgid(getgid());
+	assert_non_null(pw);
+	assert_non_null(gr);
+
+	names = idcache_list_users(&count);
+	assert_true(is_in_list(names, count, pw->pw_name));
+	free_string_array(names, count);
+
+	names = idcache_list_groups(&count);
+	assert_true(is_in_list(names, count, gr->gr_name));
+	free_string_array(names, count);
+}
+
+TEST(cache_is_usable_after_reset)
+{
+	char buf[128];
+	struct passwd *const pw = getpwuid(getuid());
+	assert_non_null(pw);
+
+	idcache_user_name(getuid(), sizeof(buf), buf);
+	idcache_reset();
+	idcache_user_name(getuid(), sizeof(buf), buf);
+	assert_string_equal(pw->pw_name, buf);
+}
+
+static int
+is_in_list(char *names[], int count, const char name[])
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(strcmp(names[i], name) == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
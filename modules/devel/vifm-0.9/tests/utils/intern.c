@@ -0,0 +1,64 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
+
+#include "../../src/utils/intern.h"
+
+TEST(freeing_null_does_nothing)
+{
+	intern_free(NULL);
+}
+
+TEST(equal_strings_are_shared)
+{
+	char *const a = intern_str("/some/path");
+	char *const b = intern_str("/some/path");
+	char *const c = intern_str("/some/other/path");
+
+	assert_string_equal("/some/path", a);
+	assert_true(a == b);
+	assert_string_equal("/some/other/path", c);
+	assert_false(a == c);
+
+	intern_free(a);
+	intern_free(b);
+	intern_free(c);
+}
+
+TEST(string_lives_while_it_has_users)
+{
+	char *const a = intern_str("/path");
+	char *const b = intern_str("/path");
+
+	intern_free(a);
+	assert_string_equal("/path", b);
+
+	intern_free(b);
+}
+
+TEST(many_strings_can_be_interned)
+{
+	int i;
+	char *strs[1000];
+	char buf[32];
+
+	for(i = 0; i < 1000; ++i)
+	{
+		snprintf(buf, sizeof(buf), "%d", i);
+		strs[i] = intern_str(buf);
+		assert_non_null(strs[i]);
+	}
+
+	for(i = 0; i < 1000; ++i)
+	{
+		snprintf(buf, sizeof(buf), "%d", i);
+		assert_string_equal(buf, strs[i]);
+		assert_true(intern_str(buf) == strs[i]);
+		intern_free(strs[i]);
+		intern_free(strs[i]);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,90 @@
+#include <stic.h>
+
+#include <regex.h> /* REG_EXTENDED REG_ICASE */
+
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/regexp.h"
+
+static void check(const char pattern[], int cflags, const char expected[]);
+
+TEST(plain_string_is_literal)
+{
+	check("needle", REG_EXTENDED, "needle");
+}
+
+TEST(basic_syntax_is_not_supported)
+{
+	check("needle", 0, NULL);
+}
+
+TEST(alternation_disables_literal)
+{
+	check("abc|def", REG_EXTENDED, NULL);
+	check("(abc|def)ghij", REG_EXTENDED, "ghij");
+}
+
+TEST(longest_piece_is_picked)
+{
+	check("ab.cdef.g", REG_EXTENDED, "cdef");
+	check("^abc$", REG_EXTENDED, "abc");
+}
+
+TEST(optional_characters_are_dropped)
+{
+	check("abcd*", REG_EXTENDED, "abc");
+	check("abcd?e", REG_EXTENDED, "abc");
+	check("abcd{0,3}", REG_EXTENDED, "abc");
+	check("abc+de", REG_EXTENDED, "abc");
+	check("x*", REG_EXTENDED, NULL);
+}
+
+TEST(brackets_and_groups_are_skipped)
+{
+	check("ab[cdefgh]ij", REG_EXTENDED, "ab");
+	check("a[]xyz]bc", REG_EXTENDED, "bc");
+	check("a[[:alpha:]]bc", REG_EXTENDED, "bc");
+	check("(abcdef)+gh", REG_EXTENDED, "gh");
+}
+
+TEST(escaped_punctuation_is_literal)
+{
+	check("a\\.b\\*c", REG_EXTENDED, "a.b*c");
+	check("ab\\wcde", REG_EXTENDED, "cde");
+}
+
+TEST(non_ascii_is_excluded_when_ignoring_case)
+{
+	check("ab\xd1\x8f" "c", REG_EXTENDED, "ab\xd1\x8f" "c");
+	check("ab\xd1\x8f" "c", REG_EXTENDED | REG_ICASE, "ab");
+}
+
+TEST(optional_multibyte_character_is_dropped_entirely)
+{
+	check("ab\xd1\x8f?", REG_EXTENDED, "ab");
+}
+
+TEST(broken_patterns_have_no_literal)
+{
+	check("abc\\", REG_EXTENDED, NULL);
+	check("abc[de", REG_EXTENDED, NULL);
+	check("abc(de", REG_EXTENDED, NULL);
+}
+
+static void
+check(const char pattern[], int cflags, const char expected[])
+{
+	char *const literal = regexp_get_literal(pattern, cflags);
+	if(expected == NULL)
+	{
+		assert_null(literal);
+	}
+	else
+	{
+		assert_string_equal(expected, literal);
+	}
+	free(literal);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,200 @@
+#include <stic.h>
+
+#include <unistd.h> /* close() pipe() write() */
+
+#include <stddef.h> /* NULL */
+
+#include "../../src/utils/selector.h"
+
+static int selector_is_supported(void);
+static void make_pipe(int fds[2]);
+
+static selector_t *selector;
+static int fds[2];
+
+SETUP()
+{
+	selector = selector_alloc(0);
+	if(selector != NULL)
+	{
+		make_pipe(fds);
+	}
+}
+
+TEARDOWN()
+{
+	if(selector != NULL)
+	{
+		close(fds[0]);
+		if(fds[1] != -1)
+		{
+			close(fds[1]);
+		}
+	}
+	selector_free(selector);
+}
+
+TEST(freeing_null_selector_does_nothing)
+{
+	selector_free(NULL);
+}
+
+TEST(empty_pipe_times_out, IF(selector_is_supported))
+{
+	assert_success(selector_add(selector, fds[0], SEL_READ));
+	assert_false(selector_wait(selector, 0));
+	assert_false(selector_is_ready(selector, fds[0]));
+}
+
+TEST(pipe_with_data_is_ready_for_reading, IF(selector_is_supported))
+{
+	assert_int_equal(1, write(fds[1], "x", 1U));
+
+	assert_success(selector_add(selector, fds[0], SEL_READ));
+	assert_true(selector_wait(selector, -1));
+	assert_true(selector_is_ready(selector, fds[0]));
+}
+
+TEST(pipe_is_ready_for_writing, IF(selector_is_supported))
+{
+	assert_success(selector_add(selector, fds[1], SEL_WRITE));
+	assert_true(selector_wait(selector, 0));
+	assert_true(selector_is_ready(selector, fds[1]));
+}
+
+TEST(pipe_without_writers_is_ready_for_reading, IF(selector_is_supported))
+{
+	close(fds[1]);
+	fds[1] = -1;
+
+	assert_success(selector_add(selector, fds[0], SEL_READ));
+	assert_true(selector_wait(selector, -1));
+	assert_true(selector_is_ready(selector, fds[0]));
+}
+
+TEST(reset_removes_descriptors, IF(selector_is_supported))
+{
+	assert_int_equal(1, write(fds[1], "x", 1U));
+
+	assert_success(selector_add(selector, fds[0], SEL_READ));
+	selector_reset(selector);
+	assert_false(selector_wait(selector, 0));
+	assert_false(selector_is_ready(selector, fds[0]));
+}
+
+TEST(many_descriptors_can_be_added, IF(selector_is_supported))
+{
+	int i;
+
+	for(i = 0; i < 100; ++i)
+	{
+		assert_success(selector_add(selector, fds[0], SEL_READ));
+	}
+	assert_success(selector_add(selector, fds[1], SEL_WRITE));
+
+	assert_true(selector_wait(selector, 0));
+	assert_false(selector_is_ready(selector, fds[0]));
+	assert_true(selector_is_ready(selector, fds[1]));
+}
+
+TEST(removed_descriptor_is_not_reported, IF(selector_is_supported))
+{
+	assert_int_equal(1, write(fds[1], "x", 1U));
+
+	assert_success(selector_add(selector, fds[0], SEL_READ));
+	assert_success(selector_add(selector, fds[1], SEL_WRITE));
+	selector_remove(selector, fds[0]);
+
+	assert_true(selector_wait(selector, 0));
+	assert_false(selector_is_ready(selector, fds[0]));
+	assert_true(selector_is_ready(selector, fds[1]));
+}
+
+TEST(events_of_descriptor_are_merged, IF(selector_is_supported))
+{
+	assert_success(selector_add(selector, fds[1], SEL_READ));
+	assert_success(selector_add(selector, fds[1], SEL_WRITE));
+
+	assert_true(selector_wait(selector, 0));
+	assert_true(selector_is_ready(selector, fds[1]));
+}
+
+TEST(ready_descriptors_are_enumerated, IF(selector_is_supported))
+{
+	int pos = 0;
+	int first, second;
+
+	assert_int_equal(1, write(fds[1], "x", 1U));
+
+	assert_success(selector_add(selector, fds[0], SEL_READ));
+	assert_success(selector_add(selector, fds[1], SEL_WRITE));
+	assert_true(selector_wait(selector, 0));
+
+	first = selector_next_ready(selector, &pos);
+	second = selector_next_ready(selector, &pos);
+	assert_int_equal(-1, selector_next_ready(selector, &pos));
+
+	assert_true(first == fds[0] || first == fds[1]);
+	assert_true(second == fds[0] || second == fds[1]);
+	assert_true(first != second);
+}
+
+TEST(long_lived_selector_reports_ready_descriptors, IF(selector_is_supported))
+{
+	selector_t *const long_lived = selector_alloc(1);
+	assert_non_null(long_lived);
+
+	assert_int_equal(1, write(fds[1], "x", 1U));
+
+	assert_success(selector_add(long_lived, fds[0], SEL_READ));
+	assert_success(selector_add(long_lived, fds[1], SEL_WRITE));
+	assert_true(selector_wait(long_lived, 0));
+	assert_true(selector_is_ready(long_lived, fds[0]));
+	assert_true(selector_is_ready(long_lived, fds[1]));
+
+	selector_remove(long_lived, fds[1]);
+	assert_true(selector_wait(long_lived, 0));
+	assert_true(selector_is_ready(long_lived, fds[0]));
+	assert_false(selector_is_ready(long_lived, fds[1]));
+
+	selector_free(long_lived);
+}
+
+TEST(long_lived_selector_is_reusable_after_reset, IF(selector_is_supported))
+{
+	selector_t *const long_lived = selector_alloc(1);
+	assert_non_null(long_lived);
+
+	assert_int_equal(1, write(fds[1], "x", 1U));
+
+	assert_success(selector_add(long_lived, fds[0], SEL_READ));
+	selector_reset(long_lived);
+	assert_false(selector_wait(long_lived, 0));
+	assert_false(selector_is_ready(long_lived, fds[0]));
+
+	assert_success(selector_add(long_lived, fds[0], SEL_READ));
+	assert_true(selector_wait(long_lived, 0));
+	assert_true(selector_is_ready(long_lived, fds[0]));
+
+	selector_free(long_lived);
+}
+
+static int
+selector_is_supported(void)
+{
+	selector_t *const selector = selector_alloc(0);
+	selector_free(selector);
+	return (selector != NULL);
+}
+
+/* Creates a pipe. */
+static void
+make_pipe(int fds[2])
+{
+#ifndef _WIN32
+	assert_success(pipe(fds));
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,188 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fclose() fopen() fread() */
+#include <string.h> /* strstr() */
+
+#include "../../src/utils/trace.h"
+
+static const char * read_trace(void);
+
+TEARDOWN()
+{
+	trace_stop();
+	(void)unlink(SANDBOX_PATH "/trace.json");
+}
+
+TEST(tracing_is_inactive_by_default)
+{
+	assert_false(trace_is_active());
+	assert_null(trace_get_path());
+	assert_failure(trace_finish());
+}
+
+TEST(spans_are_ignored_when_inactive)
+{
+	trace_begin("span", NULL);
+	trace_end();
+	assert_false(trace_is_active());
+}
+
+TEST(start_activates_tracing)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	assert_true(trace_is_active());
+	assert_string_equal(SANDBOX_PATH "/trace.json", trace_get_path());
+
+	trace_stop();
+	assert_false(trace_is_active());
+	assert_null(trace_get_path());
+}
+
+TEST(finish_writes_spans_and_stops)
+{
+	const char *trace;
+
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_begin("outer", NULL);
+	trace_begin("inner", "argument");
+	trace_end();
+	trace_end();
+	assert_success(trace_finish());
+	assert_false(trace_is_active());
+
+	trace = read_trace();
+	assert_non_null(strstr(trace, "{\"traceEvents\":["));
+	assert_non_null(strstr(trace, "{\"name\":\"outer\",\"ph\":\"X\","));
+	assert_non_null(strstr(trace, "{\"name\":\"inner\",\"ph\":\"X\","));
+	assert_non_null(strstr(trace, "\"args\":{\"arg\":\"argument\"}"));
+	assert_true(strstr(trace, "outer") < strstr(trace, "inner"));
+}
+
+TEST(counts_are_written_as_arguments)
+{
+	const char *trace;
+
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_begin("with-arg", "argument");
+	trace_set_count("items", 1);
+	trace_set_count("items", 12);
+	trace_end();
+	trace_begin("without-arg", NULL);
+	trace_set_count("cells", 3);
+	trace_end();
+	assert_success(trace_finish());
+
+	trace = read_trace();
+	assert_non_null(strstr(trace, "\"args\":{\"arg\":\"argument\",\"items\":12}"));
+	assert_non_null(strstr(trace, "\"args\":{\"cells\":3}"));
+}
+
+TEST(counts_are_ignored_without_open_span)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_set_count("items", 1);
+	trace_begin("span", NULL);
+	trace_end();
+	trace_set_count("items", 1);
+	assert_success(trace_finish());
+
+	assert_null(strstr(read_trace(), "items"));
+}
+
+TEST(open_spans_are_written)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_begin("open", NULL);
+	assert_success(trace_finish());
+
+	assert_non_null(strstr(read_trace(), "\"name\":\"open\""));
+}
+
+TEST(extra_ends_are_ignored)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_end();
+	trace_begin("span", NULL);
+	trace_end();
+	trace_end();
+	assert_success(trace_finish());
+
+	assert_non_null(strstr(read_trace(), "\"name\":\"span\""));
+}
+
+TEST(deeply_nested_spans_are_dropped)
+{
+	int i;
+
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	for(i = 0; i < 100; ++i)
+	{
+		trace_begin(i == 99 ? "deepest" : "level", NULL);
+	}
+	for(i = 0; i < 100; ++i)
+	{
+		trace_end();
+	}
+	trace_begin("after", NULL);
+	trace_end();
+	assert_success(trace_finish());
+
+	assert_null(strstr(read_trace(), "deepest"));
+	assert_non_null(strstr(read_trace(), "\"name\":\"after\""));
+}
+
+TEST(arguments_are_escaped)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_begin("span", "\"quoted\"\\\n");
+	trace_end();
+	assert_success(trace_finish());
+
+	assert_non_null(strstr(read_trace(), "\"arg\":\"\\\"quoted\\\"\\\\\\u000a\""));
+}
+
+TEST(restart_discards_spans)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_begin("discarded", NULL);
+	assert_success(trace_start(SANDBOX_PATH "/trace.json"));
+	trace_begin("kept", NULL);
+	trace_end();
+	assert_success(trace_finish());
+
+	assert_null(strstr(read_trace(), "discarded"));
+	assert_non_null(strstr(read_trace(), "kept"));
+}
+
+TEST(failure_to_write_is_reported)
+{
+	assert_success(trace_start(SANDBOX_PATH "/no-such-dir/trace.json"));
+	assert_failure(trace_finish());
+	assert_false(trace_is_active());
+}
+
+/* Reads contents of the trace file.  Returns pointer to statically allocated
+ * buffer. */
+static const char *
+read_trace(void)
+{
+	static char buf[64*1024];
+	size_t len;
+	FILE *const fp = fopen(SANDBOX_PATH "/trace.json", "r");
+	if(fp == NULL)
+	{
+		buf[0] = '\0';
+		return buf;
+	}
+
+	len = fread(buf, 1, sizeof(buf) - 1U, fp);
+	buf[len] = '\0';
+	fclose(fp);
+	return buf;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */